@@ -0,0 +1,218 @@
+/*
+ * aes-cbc.h: AES Cipher Block Chaining (AES-CBC) and Electronic Codebook (AES-ECB) modes
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/aes-cbc.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Implements the CBC and ECB modes of operation with AES-128, for whole
+ * blocks (aes_cbc_encrypt_blocks, aes_cbc_decrypt_blocks, aes_ecb_encrypt
+ * and aes_ecb_decrypt) and for messages of any length with the PKCS#7
+ * padding (aes_cbc_encrypt and aes_cbc_decrypt), with a key schedule
+ * expanded once with aes_set_key.
+ *
+ * The CBC encryption is serial (each block is encrypted after the previous
+ * ciphertext block is known), but the CBC decryption is not: each plaintext
+ * block only needs its ciphertext block and the previous one, so the blocks
+ * are decrypted many at a time with aes_decrypt_blocks (8 in flight with
+ * AES-NI) and then xored with the previous ciphertext blocks. The ECB mode
+ * is aes_encrypt_blocks and aes_decrypt_blocks over a whole buffer.
+ *
+ * The CBC mode does not authenticate the messages, and a party that tells
+ * whether the padding of altered messages is valid (a padding oracle)
+ * reveals their plaintext; the messages should be authenticated (as with
+ * HMAC or AES-CMAC over the IV and the ciphertext) before they are decrypted.
+ * The ECB mode leaks equal plaintext blocks, and is only meant for building
+ * other modes and for random data.
+ *
+ * Uses the functions in aes.h and aes-decrypt.h, so you need to include those too:
+ * #include "aes.h"
+ * #include "aes-decrypt.h"
+ * #include "aes-cbc.h"
+ *
+ * References:
+ * [MODES] Recommendation for Block Cipher Modes of Operation: Methods and
+ *         Techniques, NIST Special Publication 800-38A, Dec 2001
+ * [RFC5652] Cryptographic Message Syntax (CMS), Sep 2009,
+ *           section 6.3 Content-encryption Process (the PKCS#7 padding)
+ */
+
+/*
+ * Encrypts whole blocks in the ECB mode.
+ * output: pointer to length bytes of memory to store the ciphertext
+ * input: pointer to length bytes of memory with the plaintext
+ * length: number of bytes, a multiple of 16
+ * key: pointer to the key schedule, initialized with aes_set_key
+ * The output and input may point to the same memory.
+ *
+ * [MODES] 6.1 The Electronic Codebook Mode
+ */
+static void aes_ecb_encrypt(void *output, const void *input, int length, const struct aes_key *key) {
+  aes_encrypt_blocks(output, input, length / 16, key);
+}
+
+/*
+ * Decrypts whole blocks in the ECB mode.
+ * output: pointer to length bytes of memory to store the plaintext
+ * input: pointer to length bytes of memory with the ciphertext
+ * length: number of bytes, a multiple of 16
+ * key: pointer to the key schedule, initialized with aes_set_key
+ * The output and input may point to the same memory.
+ *
+ * [MODES] 6.1 The Electronic Codebook Mode
+ */
+static void aes_ecb_decrypt(void *output, const void *input, int length, const struct aes_key *key) {
+  aes_decrypt_blocks(output, input, length / 16, key);
+}
+
+/*
+ * Encrypts whole blocks in the CBC mode.
+ * output: pointer to length bytes of memory to store the ciphertext
+ * iv: pointer to the 16-byte initialization vector, which is replaced by the
+ *     last ciphertext block, to continue with the next blocks of the message
+ * input: pointer to length bytes of memory with the plaintext
+ * length: number of bytes, a multiple of 16
+ * key: pointer to the key schedule, initialized with aes_set_key
+ * The output and input may point to the same memory.
+ *
+ * [MODES] 6.2 The Cipher Block Chaining Mode
+ */
+static void aes_cbc_encrypt_blocks(void *output, unsigned char *iv, const void *input, int length, const struct aes_key *key) {
+  const unsigned char *p = (const unsigned char *)input;
+  unsigned char *c = (unsigned char *)output;
+  unsigned char x[16];  /* not overlapping the input or the output */
+  int i;
+
+  /* C_j = CIPH_K(P_j xor C_j-1), with C_0 = IV */
+  for (i = 0; i < 16; i++) {
+    x[i] = iv[i];
+  }
+  for (; length >= 16; length -= 16, p += 16, c += 16) {
+    for (i = 0; i < 16; i++) {
+      x[i] ^= p[i];
+    }
+    aes_encrypt_block(x, x, key);
+    for (i = 0; i < 16; i++) {
+      c[i] = x[i];
+    }
+  }
+  for (i = 0; i < 16; i++) {
+    iv[i] = x[i];
+  }
+}
+
+/*
+ * Decrypts whole blocks in the CBC mode, up to 32 blocks at a time.
+ * output: pointer to length bytes of memory to store the plaintext
+ * iv: pointer to the 16-byte initialization vector, which is replaced by the
+ *     last ciphertext block, to continue with the next blocks of the message
+ * input: pointer to length bytes of memory with the ciphertext
+ * length: number of bytes, a multiple of 16
+ * key: pointer to the key schedule, initialized with aes_set_key
+ * The output and input may point to the same memory.
+ *
+ * [MODES] 6.2 The Cipher Block Chaining Mode
+ */
+static void aes_cbc_decrypt_blocks(void *output, unsigned char *iv, const void *input, int length, const struct aes_key *key) {
+  const unsigned char *c = (const unsigned char *)input;
+  unsigned char *p = (unsigned char *)output;
+  unsigned char d[32 * 16];
+  int i, n;
+
+  for (; length >= 16; length -= n, c += n, p += n) {
+    n = length < 32 * 16 ? length & ~15 : 32 * 16;
+
+    /* P_j = CIPH^-1_K(C_j) xor C_j-1, in a buffer that does not overlap the
+       input or the output, so that the loops can be vectorized, and the
+       output can be the input */
+    aes_decrypt_blocks(d, c, n / 16, key);
+    for (i = 0; i < 16; i++) {
+      d[i] ^= iv[i];
+    }
+    for (i = 16; i < n; i++) {
+      d[i] ^= c[i - 16];
+    }
+    for (i = 0; i < 16; i++) {
+      iv[i] = c[n - 16 + i];
+    }
+    for (i = 0; i < n; i++) {
+      p[i] = d[i];
+    }
+  }
+}
+
+/*
+ * Encrypts a message in the CBC mode with the PKCS#7 padding: 1 to 16 bytes,
+ * each with the number of bytes of the padding, up to a multiple of 16 bytes.
+ * output: pointer to (length / 16 + 1) * 16 bytes of memory to store the ciphertext
+ * iv: pointer to the 16-byte initialization vector, unpredictable for each message
+ * input: pointer to length bytes of memory with the plaintext
+ * length: number of bytes of the plaintext
+ * key: pointer to the key schedule, initialized with aes_set_key
+ * Returns the number of bytes of the ciphertext, (length / 16 + 1) * 16.
+ * The output and input may point to the same memory.
+ *
+ * [RFC5652] 6.3 Content-encryption Process
+ */
+static int aes_cbc_encrypt(void *output, const void *iv, const void *input, int length, const struct aes_key *key) {
+  unsigned char x[16], last[16];
+  int i, n;
+
+  for (i = 0; i < 16; i++) {
+    x[i] = ((const unsigned char *)iv)[i];
+  }
+  n = length & ~15;
+  aes_cbc_encrypt_blocks(output, x, input, n, key);
+  for (i = 0; i < length - n; i++) {
+    last[i] = ((const unsigned char *)input)[n + i];
+  }
+  for (; i < 16; i++) {
+    last[i] = (unsigned char)(16 - (length - n));
+  }
+  aes_cbc_encrypt_blocks((unsigned char *)output + n, x, last, 16, key);
+  return n + 16;
+}
+
+/*
+ * Decrypts a message in the CBC mode with the PKCS#7 padding, and removes the padding.
+ * output: pointer to length bytes of memory to store the plaintext (and the padding)
+ * iv: pointer to the 16-byte initialization vector
+ * input: pointer to length bytes of memory with the ciphertext
+ * length: number of bytes of the ciphertext
+ * key: pointer to the key schedule, initialized with aes_set_key
+ * Returns the number of bytes of the plaintext, or -1 if the length is not
+ * a positive multiple of 16 or the padding is not valid.
+ * The output and input may point to the same memory.
+ *
+ * The padding is checked in constant time, but a caller that reveals the
+ * failure is still a padding oracle (see above).
+ *
+ * [RFC5652] 6.3 Content-encryption Process
+ */
+static int aes_cbc_decrypt(void *output, const void *iv, const void *input, int length, const struct aes_key *key) {
+  unsigned char *p = (unsigned char *)output;
+  unsigned char x[16];
+  unsigned pad, bad;
+  int i;
+
+  if (length < 16 || length % 16) {
+    return -1;
+  }
+  for (i = 0; i < 16; i++) {
+    x[i] = ((const unsigned char *)iv)[i];
+  }
+  aes_cbc_decrypt_blocks(output, x, input, length, key);
+
+  /* The last pad bytes must be pad, with 1 <= pad <= 16 */
+  pad = p[length - 1];
+  bad = (pad - 1) >> 4 & 0xff;  /* nonzero if pad is 0 or more than 16 */
+  for (i = 1; i <= 16; i++) {
+    /* (i - pad - 1) >> 8 is all ones for the bytes of the padding (i <= pad) */
+    bad |= (p[length - i] ^ pad) & ((unsigned)(i - (int)pad - 1) >> 8);
+  }
+  bad = 0 - ((bad + 255) >> 8);  /* all ones if the padding is not valid */
+  return (int)((unsigned)(length - (int)pad) | bad);
+}
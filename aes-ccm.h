@@ -8,7 +8,12 @@
  */
 
 /*
- * Implements the AES-CCM encryption and decryption for 128-bit keys.
+ * Implements the AES-CCM encryption and decryption for 128-bit keys,
+ * for contiguous texts (aes_ccm_encrypt, aes_ccm_decrypt) and for texts
+ * in lists of fragments (aes_ccm_encrypt_v, aes_ccm_decrypt_v).
+ *
+ * Both directions can be done in place, with the same memory for the input
+ * and the output (the MAC is appended right after the encrypted payload).
  *
  * Uses the aes_encrypt function in aes.h, so you need to include that too:
  * #include "aes.h"
@@ -29,20 +34,22 @@
  * output: pointer to input_length bytes to store the ciphertext/payload
  * nonce: pointer to the nonce
  * nonce_length: number of bytes of the nonce
+ * counter: the counter of the block before the input (0 at the start of the payload)
  * input: pointer to the payload/ciphertext to encrypt/decrypt
  * input_length: number of bytes of the input payload/ciphertext
  * key: pointer to the 16-byte (128-bit) block cipher key
  *
+ * Each key stream block is generated into a scratch block and then XORed
+ * into the output, so the output and input may point to the same memory.
+ *
  * References:
  * [CCM] 6.1 Generation-Encryption Process
  * [CCM] A.3 Formatting of the Counter Blocks
  */
-static void aes_ccm_ctr(void *output, const void *nonce, int nonce_length, const void *input, int input_length, const void *key) {
+static void aes_ccm_ctr(void *output, const void *nonce, int nonce_length, int counter, const void *input, int input_length, const void *key) {
   char x[16];
-  int counter;
   int i, n;
 
-  counter = 0;
   for (n = 0; n < input_length; n += 16) {
     /* Generate the counter block CTRj */
     x[0] = 14 - nonce_length;
@@ -67,15 +74,15 @@ static void aes_ccm_ctr(void *output, const void *nonce, int nonce_length, const
 }
 
 /*
- * Internal function that generates and encrypts a MAC.
+ * Internal function that starts the generation of a MAC
+ * with the control information, the nonce and the associated data.
  *
- * mac: pointer to mac_length bytes to store the encrypted MAC
+ * x: pointer to 16 bytes to store the state of the CBC-MAC
  * mac_length: number of bytes of the MAC
  * nonce: pointer to the nonce
  * nonce_length: number of bytes of the nonce
  * ad: pointer to the associated data
  * ad_length: number of bytes of the associated data
- * payload: pointer to the payload
  * payload_length: number of bytes of the payload
  * key: pointer to the 16-byte (128-bit) block cipher key
  *
@@ -83,8 +90,7 @@ static void aes_ccm_ctr(void *output, const void *nonce, int nonce_length, const
  * [CCM] 6.1 Generation-Encryption Process
  * [CCM] A.2 Formatting of the Input Data
  */
-static void aes_ccm_mac(void *mac, int mac_length, const void *nonce, int nonce_length, const void *ad, int ad_length, const void *payload, int payload_length, const void *key) {
-  char x[16];
+static void aes_ccm_mac_init(char *x, int mac_length, const void *nonce, int nonce_length, const void *ad, int ad_length, int payload_length, const void *key) {
   int i, n;
 
   /* [CCM] A.2.1 Formatting of the Control Information and the Nonce */
@@ -129,8 +135,23 @@ static void aes_ccm_mac(void *mac, int mac_length, const void *nonce, int nonce_
       aes_encrypt(x, x, key);
     }
   }
+}
+
+/*
+ * Internal function that adds a part of the payload to the generation of a MAC.
+ * Only the last part of the payload can have a partial block.
+ *
+ * x: pointer to the 16-byte state of the CBC-MAC
+ * payload: pointer to the part of the payload
+ * payload_length: number of bytes of the part of the payload
+ * key: pointer to the 16-byte (128-bit) block cipher key
+ *
+ * Reference:
+ * [CCM] A.2.3 Formatting of the Payload
+ */
+static void aes_ccm_mac_update(char *x, const void *payload, int payload_length, const void *key) {
+  int i, n;
 
-  /* [CCM] A.2.3 Formatting of the Payload */
   for (i = 0, n = 0; n < payload_length; n++) {
     /* Yi = CIPHk(Bi xor Yi-1) */
     x[i++] ^= ((char *)payload)[n];
@@ -142,6 +163,23 @@ static void aes_ccm_mac(void *mac, int mac_length, const void *nonce, int nonce_
   if (i) {
     aes_encrypt(x, x, key);
   }
+}
+
+/*
+ * Internal function that finishes the generation of a MAC, and encrypts it.
+ *
+ * mac: pointer to mac_length bytes to store the encrypted MAC
+ * mac_length: number of bytes of the MAC
+ * x: pointer to the 16-byte state of the CBC-MAC
+ * nonce: pointer to the nonce
+ * nonce_length: number of bytes of the nonce
+ * key: pointer to the 16-byte (128-bit) block cipher key
+ *
+ * Reference:
+ * [CCM] 6.1 Generation-Encryption Process
+ */
+static void aes_ccm_mac_final(void *mac, int mac_length, char *x, const void *nonce, int nonce_length, const void *key) {
+  int i;
 
   /* Get the MAC: T = MSBtlen(Yr) */
   for (i = 0; i < mac_length; i++) {
@@ -163,10 +201,9 @@ static void aes_ccm_mac(void *mac, int mac_length, const void *nonce, int nonce_
 }
 
 /*
- * Performs the AES-CCM generation-encryption process
- * (encrypts the payload and the appended MAC).
+ * Internal function that generates and encrypts a MAC.
  *
- * ciphertext: pointer to (payload_length + mac_length) bytes to store the ciphertext
+ * mac: pointer to mac_length bytes to store the encrypted MAC
  * mac_length: number of bytes of the MAC
  * nonce: pointer to the nonce
  * nonce_length: number of bytes of the nonce
@@ -176,53 +213,241 @@ static void aes_ccm_mac(void *mac, int mac_length, const void *nonce, int nonce_
  * payload_length: number of bytes of the payload
  * key: pointer to the 16-byte (128-bit) block cipher key
  *
+ * References:
+ * [CCM] 6.1 Generation-Encryption Process
+ * [CCM] A.2 Formatting of the Input Data
+ */
+static void aes_ccm_mac(void *mac, int mac_length, const void *nonce, int nonce_length, const void *ad, int ad_length, const void *payload, int payload_length, const void *key) {
+  char x[16];
+
+  aes_ccm_mac_init(x, mac_length, nonce, nonce_length, ad, ad_length, payload_length, key);
+  aes_ccm_mac_update(x, payload, payload_length, key);
+  aes_ccm_mac_final(mac, mac_length, x, nonce, nonce_length, key);
+}
+
+/*
+ * Copies bytes between a buffer and a list of fragments (scatter-gather).
+ * buffer: pointer to length bytes of memory
+ * length: number of bytes to copy
+ * parts: pointers to the fragments
+ * lengths: number of bytes of each fragment
+ * at: the position in the fragments, at[0] the fragment and at[1] the byte
+ *     in it, which is advanced by length bytes
+ * scatter: nonzero to copy from the buffer to the fragments,
+ *          or 0 to copy from the fragments to the buffer
+ */
+static void aes_ccm_copy_v(char *buffer, int length, void **parts, const int *lengths, int *at, int scatter) {
+  char *p;
+  int i;
+
+  while (length > 0) {
+    if (at[1] >= lengths[at[0]]) {  /* next fragment */
+      at[0]++;
+      at[1] = 0;
+      continue;
+    }
+    p = (char *)parts[at[0]] + at[1];
+    for (i = 0; i < length && at[1] < lengths[at[0]]; i++, at[1]++) {
+      if (scatter) {
+        p[i] = buffer[i];
+      } else {
+        buffer[i] = p[i];
+      }
+    }
+    buffer += i;
+    length -= i;
+  }
+}
+
+/*
+ * Performs the AES-CCM generation-encryption process, like aes_ccm_encrypt,
+ * with the payload and the ciphertext in lists of fragments (as with readv
+ * and writev), with any boundaries. The text goes through a small buffer,
+ * 8 blocks at a time (or directly, with a single fragment), so there is no
+ * need to copy the fragments into a contiguous buffer.
+ *
+ * ciphertext: pointers to the fragments to store the ciphertext
+ * ciphertext_lengths: number of bytes of each ciphertext fragment
+ *                     (adding up to at least the payload length + mac_length)
+ * mac_length: number of bytes of the MAC
+ * nonce: pointer to the nonce
+ * nonce_length: number of bytes of the nonce
+ * ad: pointer to the associated data
+ * ad_length: number of bytes of the associated data
+ * payload: pointers to the fragments of the payload
+ * payload_lengths: number of bytes of each payload fragment
+ * payload_count: number of payload fragments
+ * key: pointer to the 16-byte (128-bit) block cipher key
+ *
+ * The ciphertext fragments may be the same as the payload fragments (in place),
+ * with room for the MAC after the payload.
+ *
  * Reference:
  * [CCM] 6.1 Generation-Encryption Process
  */
-static void aes_ccm_encrypt(void *ciphertext, int mac_length, const void *nonce, int nonce_length, const void *ad, int ad_length, const void *payload, int payload_length, const void *key) {
+static void aes_ccm_encrypt_v(void **ciphertext, const int *ciphertext_lengths, int mac_length, const void *nonce, int nonce_length,
+    const void *ad, int ad_length, const void **payload, const int *payload_lengths, int payload_count, const void *key) {
+  char x[16], buffer[8 * 16];
+  int in[2] = {0, 0}, out[2] = {0, 0};
+  int i, n, length;
+
+  length = 0;
+  for (i = 0; i < payload_count; i++) {
+    length += payload_lengths[i];
+  }
+
+  if (payload_count == 1 && ciphertext_lengths[0] >= length + mac_length) {
+    /* Contiguous: encrypt and append the MAC (first, while the payload is intact) */
+    aes_ccm_mac((char *)ciphertext[0] + length, mac_length, nonce, nonce_length, ad, ad_length, payload[0], length, key);
+    /* Encrypt the payload */
+    aes_ccm_ctr(ciphertext[0], nonce, nonce_length, 0, payload[0], length, key);
+    return;
+  }
+
+  /* Generate the MAC (first, while the payload is intact) */
+  aes_ccm_mac_init(x, mac_length, nonce, nonce_length, ad, ad_length, length, key);
+  for (i = 0; i < length; i += n) {
+    n = length - i < 8 * 16 ? length - i : 8 * 16;
+    aes_ccm_copy_v(buffer, n, (void **)payload, payload_lengths, in, 0);
+    aes_ccm_mac_update(x, buffer, n, key);
+  }
+
   /* Encrypt the payload */
-  aes_ccm_ctr(ciphertext, nonce, nonce_length, payload, payload_length, key);
+  in[0] = 0;
+  in[1] = 0;
+  for (i = 0; i < length; i += n) {
+    n = length - i < 8 * 16 ? length - i : 8 * 16;
+    aes_ccm_copy_v(buffer, n, (void **)payload, payload_lengths, in, 0);
+    aes_ccm_ctr(buffer, nonce, nonce_length, i / 16, buffer, n, key);
+    aes_ccm_copy_v(buffer, n, ciphertext, ciphertext_lengths, out, 1);
+  }
+
   /* Encrypt and append the MAC */
-  aes_ccm_mac((char *)ciphertext + payload_length, mac_length, nonce, nonce_length, ad, ad_length, payload, payload_length, key);
+  aes_ccm_mac_final(buffer, mac_length, x, nonce, nonce_length, key);
+  aes_ccm_copy_v(buffer, mac_length, ciphertext, ciphertext_lengths, out, 1);
 }
 
 /*
- * Performs the AES-CCM decryption-validation process
- * (decrypts the ciphertext and checks and removes the MAC).
+ * Performs the AES-CCM decryption-validation process, like aes_ccm_decrypt,
+ * with the ciphertext and the payload in lists of fragments (as with readv
+ * and writev), with any boundaries.
  * Returns 0 if the MAC verification succeeds, or -1 if it fails.
  *
- * payload: pointer to (ciphertext_length - mac_length) bytes to store the decrypted payload
+ * payload: pointers to the fragments to store the decrypted payload
+ * payload_lengths: number of bytes of each payload fragment
+ *                  (adding up to at least the ciphertext length - mac_length)
  * mac_length: number of bytes of the MAC
  * nonce: pointer to the nonce
  * nonce_length: number of bytes of the nonce
  * ad: pointer to the associated data
  * ad_length: number of bytes of the associated data
- * ciphertext: pointer to the ciphertext
- * ciphertext_length: number of bytes of the ciphertext (including the encrypted MAC)
+ * ciphertext: pointers to the fragments of the ciphertext (including the encrypted MAC)
+ * ciphertext_lengths: number of bytes of each ciphertext fragment
+ * ciphertext_count: number of ciphertext fragments
  * key: pointer to the 16-byte (128-bit) block cipher key
  *
+ * The payload fragments may be the same as the ciphertext fragments (in place).
+ *
  * Reference:
  * [CCM] 6.2 Decryption-Validation Process
  */
-static int aes_ccm_decrypt(void *payload, int mac_length, const void *nonce, int nonce_length, const void *ad, int ad_length, const void *ciphertext, int ciphertext_length, const void *key) {
-  char mac[16];
-  int payload_length;
-  int i;
+static int aes_ccm_decrypt_v(void **payload, const int *payload_lengths, int mac_length, const void *nonce, int nonce_length,
+    const void *ad, int ad_length, const void **ciphertext, const int *ciphertext_lengths, int ciphertext_count, const void *key) {
+  char x[16], mac[16], buffer[8 * 16];
+  int in[2] = {0, 0}, out[2] = {0, 0};
+  int i, n, length;
 
-  payload_length = ciphertext_length - mac_length;
+  length = -mac_length;
+  for (i = 0; i < ciphertext_count; i++) {
+    length += ciphertext_lengths[i];
+  }
 
-  /* Decrypt the payload part of the ciphertext */
-  aes_ccm_ctr(payload, nonce, nonce_length, ciphertext, payload_length, key);
+  if (ciphertext_count == 1 && payload_lengths[0] >= length) {
+    /* Contiguous: decrypt the payload part of the ciphertext */
+    aes_ccm_ctr(payload[0], nonce, nonce_length, 0, ciphertext[0], length, key);
+    /* Calculate the encrypted MAC */
+    aes_ccm_mac(mac, mac_length, nonce, nonce_length, ad, ad_length, payload[0], length, key);
+    /* Check the received and calculated MACs */
+    for (i = 0; i < mac_length; i++) {
+      if (mac[i] != ((char *)ciphertext[0])[length + i]) {
+        return -1;
+      }
+    }
+    return 0;
+  }
 
-  /* Calculate the encrypted MAC */
-  aes_ccm_mac(mac, mac_length, nonce, nonce_length, ad, ad_length, payload, payload_length, key);
+  /* Decrypt the payload part of the ciphertext, and generate the MAC */
+  aes_ccm_mac_init(x, mac_length, nonce, nonce_length, ad, ad_length, length, key);
+  for (i = 0; i < length; i += n) {
+    n = length - i < 8 * 16 ? length - i : 8 * 16;
+    aes_ccm_copy_v(buffer, n, (void **)ciphertext, ciphertext_lengths, in, 0);
+    aes_ccm_ctr(buffer, nonce, nonce_length, i / 16, buffer, n, key);
+    aes_ccm_mac_update(x, buffer, n, key);
+    aes_ccm_copy_v(buffer, n, payload, payload_lengths, out, 1);
+  }
+  aes_ccm_mac_final(mac, mac_length, x, nonce, nonce_length, key);
 
   /* Check the received and calculated MACs */
+  aes_ccm_copy_v(buffer, mac_length, (void **)ciphertext, ciphertext_lengths, in, 0);
   for (i = 0; i < mac_length; i++) {
-    if (mac[i] != ((char *)ciphertext)[payload_length + i]) {
+    if (mac[i] != buffer[i]) {
       return -1;
     }
   }
 
   return 0;
 }
+
+/*
+ * Performs the AES-CCM generation-encryption process
+ * (encrypts the payload and the appended MAC).
+ *
+ * ciphertext: pointer to (payload_length + mac_length) bytes to store the ciphertext
+ * mac_length: number of bytes of the MAC
+ * nonce: pointer to the nonce
+ * nonce_length: number of bytes of the nonce
+ * ad: pointer to the associated data
+ * ad_length: number of bytes of the associated data
+ * payload: pointer to the payload
+ * payload_length: number of bytes of the payload
+ * key: pointer to the 16-byte (128-bit) block cipher key
+ *
+ * The ciphertext may point to the same memory as the payload (in place),
+ * with room for the MAC after the payload.
+ *
+ * Reference:
+ * [CCM] 6.1 Generation-Encryption Process
+ */
+static void aes_ccm_encrypt(void *ciphertext, int mac_length, const void *nonce, int nonce_length, const void *ad, int ad_length, const void *payload, int payload_length, const void *key) {
+  void *output = ciphertext;
+  int length = payload_length + mac_length;
+
+  aes_ccm_encrypt_v(&output, &length, mac_length, nonce, nonce_length, ad, ad_length, &payload, &payload_length, 1, key);
+}
+
+/*
+ * Performs the AES-CCM decryption-validation process
+ * (decrypts the ciphertext and checks and removes the MAC).
+ * Returns 0 if the MAC verification succeeds, or -1 if it fails.
+ *
+ * payload: pointer to (ciphertext_length - mac_length) bytes to store the decrypted payload
+ * mac_length: number of bytes of the MAC
+ * nonce: pointer to the nonce
+ * nonce_length: number of bytes of the nonce
+ * ad: pointer to the associated data
+ * ad_length: number of bytes of the associated data
+ * ciphertext: pointer to the ciphertext
+ * ciphertext_length: number of bytes of the ciphertext (including the encrypted MAC)
+ * key: pointer to the 16-byte (128-bit) block cipher key
+ *
+ * The payload may point to the same memory as the ciphertext (in place).
+ *
+ * Reference:
+ * [CCM] 6.2 Decryption-Validation Process
+ */
+static int aes_ccm_decrypt(void *payload, int mac_length, const void *nonce, int nonce_length, const void *ad, int ad_length, const void *ciphertext, int ciphertext_length, const void *key) {
+  void *output = payload;
+  int length = ciphertext_length - mac_length;
+
+  return aes_ccm_decrypt_v(&output, &length, mac_length, nonce, nonce_length, ad, ad_length, &ciphertext, &ciphertext_length, 1, key);
+}
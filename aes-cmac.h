@@ -0,0 +1,289 @@
+/*
+ * aes-cmac.h: AES Cipher-based Message Authentication Code (AES-CMAC) algorithm
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/aes-cmac.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Implements AES-CMAC (OMAC1) with AES-128, as the one-shot aes_cmac
+ * function, as the incremental aes_cmac_init, aes_cmac_update and
+ * aes_cmac_final functions, and as the aes_cmac_many function for many
+ * messages at once.
+ *
+ * The key is prepared once with aes_cmac_set_key, which expands the AES key
+ * and derives the subkeys K1 and K2, so that each MAC only encrypts the
+ * message blocks, read directly from the message.
+ *
+ * The CBC chain of a message is inherently serial (each block needs the
+ * encryption of the previous one), so aes_cmac_many runs the chains of up
+ * to 8 messages in lockstep, encrypting the next block of each with one
+ * call to aes_encrypt_blocks, which keeps the AES-NI pipeline full.
+ *
+ * Uses the functions in aes.h, so you need to include that too:
+ * #include "aes.h"
+ * #include "aes-cmac.h"
+ *
+ * References:
+ * [RFC4493] The AES-CMAC Algorithm, Jun 2006
+ * [CMAC] Recommendation for Block Cipher Modes of Operation: the CMAC Mode
+ *        for Authentication, NIST Special Publication 800-38B, May 2005
+ */
+
+/*
+ * A prepared AES-CMAC key.
+ * aes: the key schedule of the AES key
+ * k1: the subkey for a complete last block
+ * k2: the subkey for an incomplete (padded) last block
+ */
+struct aes_cmac_key {
+  struct aes_key aes;
+  unsigned char k1[16];
+  unsigned char k2[16];
+};
+
+/*
+ * Context of an incremental AES-CMAC computation.
+ * key: the prepared key, which must be kept until aes_cmac_final
+ * x: the CBC chain value of the processed blocks
+ * block: the last bytes of the message, up to a complete block, held back
+ *        until it is known whether they are the last block
+ * n: number of bytes in block (0 to 16)
+ */
+struct aes_cmac_context {
+  const struct aes_cmac_key *key;
+  unsigned char x[16];
+  unsigned char block[16];
+  int n;
+};
+
+/*
+ * Multiplies a 128-bit string by x in GF(2^128): shifts it left by one bit
+ * and, if its most significant bit was 1, adds (xors) the constant Rb.
+ * output: pointer to 16 bytes of memory to store the result
+ * input: pointer to the 16 bytes of the string
+ *
+ * [RFC4493] 2.3 Subkey Generation Algorithm
+ */
+static void aes_cmac_double(unsigned char *output, const unsigned char *input) {
+  unsigned char carry = input[0] >> 7;
+  int i;
+
+  for (i = 0; i < 15; i++) {
+    output[i] = (unsigned char)(input[i] << 1 | input[i + 1] >> 7);
+  }
+  output[15] = (unsigned char)((input[15] << 1) ^ ((0 - carry) & 0x87));
+}
+
+/*
+ * Prepares an AES-CMAC key.
+ * key: pointer to the prepared key to initialize
+ * secret: pointer to the 16-byte (128-bit) AES key
+ *
+ * [RFC4493] 2.3 Subkey Generation Algorithm
+ */
+static void aes_cmac_set_key(struct aes_cmac_key *key, const void *secret) {
+  unsigned char l[16];
+  int i;
+
+  aes_set_key(&key->aes, secret);
+  for (i = 0; i < 16; i++) {
+    l[i] = 0;
+  }
+  aes_encrypt(l, l, secret);  /* L = AES-128(K, const_Zero) */
+  aes_cmac_double(key->k1, l);
+  aes_cmac_double(key->k2, key->k1);
+}
+
+/*
+ * Builds the last block of a message, M_last: the complete last block xor K1,
+ * or the incomplete one padded with 10...0 xor K2.
+ * last: pointer to 16 bytes of memory to store the block
+ * rest: pointer to the n bytes of the last block of the message
+ * n: number of bytes of the last block (0 for an empty message, up to 16)
+ * key: pointer to the prepared key
+ *
+ * [RFC4493] 2.4 MAC Generation Algorithm, steps 3 and 4
+ */
+static void aes_cmac_last(unsigned char *last, const unsigned char *rest, int n, const struct aes_cmac_key *key) {
+  const unsigned char *k = n == 16 ? key->k1 : key->k2;
+  int i;
+
+  for (i = 0; i < n; i++) {
+    last[i] = rest[i] ^ k[i];
+  }
+  for (; i < 16; i++) {
+    last[i] = (i == n ? 0x80 : 0) ^ k[i];
+  }
+}
+
+/*
+ * Adds blocks to a CBC chain: X := AES-128(K, X xor M_i) for each block.
+ * x: pointer to the 16 bytes of the chain value to update
+ * blocks: pointer to count * 16 bytes of message blocks
+ * count: number of 16-byte blocks
+ * key: pointer to the key schedule
+ *
+ * [RFC4493] 2.4 MAC Generation Algorithm, step 6
+ */
+static void aes_cmac_chain(unsigned char *x, const unsigned char *blocks, int count, const struct aes_key *key) {
+  int i;
+
+  for (; count > 0; count--, blocks += 16) {
+    for (i = 0; i < 16; i++) {
+      x[i] ^= blocks[i];
+    }
+    aes_encrypt_block(x, x, key);
+  }
+}
+
+/*
+ * Starts an incremental AES-CMAC computation.
+ * ctx: pointer to the context to initialize
+ * key: pointer to the key prepared with aes_cmac_set_key
+ */
+static void aes_cmac_init(struct aes_cmac_context *ctx, const struct aes_cmac_key *key) {
+  int i;
+
+  ctx->key = key;
+  for (i = 0; i < 16; i++) {
+    ctx->x[i] = 0;
+  }
+  ctx->n = 0;
+}
+
+/*
+ * Adds a part of the message to an incremental AES-CMAC computation.
+ * The message can be split at any byte boundary.
+ * ctx: pointer to the context
+ * data: pointer to the next part of the message
+ * length: number of bytes of the part of the message
+ */
+static void aes_cmac_update(struct aes_cmac_context *ctx, const void *data, int length) {
+  const unsigned char *p = (const unsigned char *)data;
+  int n;
+
+  for (;;) {
+    /* Fill the held back block */
+    for (; ctx->n < 16 && length > 0; length--) {
+      ctx->block[ctx->n++] = *p++;
+    }
+    if (length == 0) {
+      return;
+    }
+
+    /* More data follows, so the block is not the last one */
+    aes_cmac_chain(ctx->x, ctx->block, 1, &ctx->key->aes);
+    ctx->n = 0;
+
+    /* Process the full blocks directly from the message, but the last one */
+    n = (length - 1) / 16;
+    aes_cmac_chain(ctx->x, p, n, &ctx->key->aes);
+    p += n * 16;
+    length -= n * 16;
+  }
+}
+
+/*
+ * Finishes an incremental AES-CMAC computation.
+ * ctx: pointer to the context
+ * mac: pointer to 16 bytes (128 bits) of memory to store the MAC
+ *      (which may be truncated to its first bytes, [RFC4493] 2.4)
+ */
+static void aes_cmac_final(struct aes_cmac_context *ctx, void *mac) {
+  unsigned char last[16];
+  int i;
+
+  aes_cmac_last(last, ctx->block, ctx->n, ctx->key);
+  aes_cmac_chain(ctx->x, last, 1, &ctx->key->aes);
+  for (i = 0; i < 16; i++) {
+    ((unsigned char *)mac)[i] = ctx->x[i];
+  }
+}
+
+/*
+ * Computes the AES-CMAC of a message.
+ * mac: pointer to 16 bytes (128 bits) of memory to store the MAC
+ * key: pointer to the key prepared with aes_cmac_set_key
+ * message: pointer to the message
+ * length: number of bytes of the message
+ */
+static void aes_cmac(void *mac, const struct aes_cmac_key *key, const void *message, int length) {
+  struct aes_cmac_context ctx;
+
+  aes_cmac_init(&ctx, key);
+  aes_cmac_update(&ctx, message, length);
+  aes_cmac_final(&ctx, mac);
+}
+
+/*
+ * Computes the AES-CMAC of many independent messages with the same key,
+ * running the CBC chains of up to 8 messages in lockstep: every step
+ * encrypts the next block of each message at once with aes_encrypt_blocks.
+ * The messages can have different lengths; the lane of a message is taken
+ * by the next one as soon as it is done.
+ * macs: pointer to count * 16 bytes of memory to store the MACs
+ * key: pointer to the key prepared with aes_cmac_set_key
+ * messages: pointers to the count messages
+ * lengths: number of bytes of each of the count messages
+ * count: number of messages
+ */
+static void aes_cmac_many(void *macs, const struct aes_cmac_key *key, const void **messages, const int *lengths, int count) {
+  unsigned char x[8 * 16], lasts[8][16];
+  const unsigned char *p;
+  int message[8], block[8], total[8];  /* per lane */
+  int i, l, lanes, next;
+
+  lanes = 0;
+  next = 0;
+  for (;;) {
+    /* Start the next messages on the free lanes */
+    for (; lanes < 8 && next < count; lanes++, next++) {
+      message[lanes] = next;
+      block[lanes] = 0;
+      total[lanes] = lengths[next] > 0 ? (lengths[next] - 1) / 16 + 1 : 1;
+      aes_cmac_last(lasts[lanes], (const unsigned char *)messages[next] + (total[lanes] - 1) * 16,
+                    lengths[next] - (total[lanes] - 1) * 16, key);
+      for (i = 0; i < 16; i++) {
+        x[lanes * 16 + i] = 0;
+      }
+    }
+    if (lanes == 0) {
+      break;
+    }
+
+    /* X := AES-128(K, X xor M_i), for the next block of each lane */
+    for (l = 0; l < lanes; l++) {
+      if (block[l] < total[l] - 1) {
+        p = (const unsigned char *)messages[message[l]] + block[l] * 16;
+      } else {
+        p = lasts[l];
+      }
+      for (i = 0; i < 16; i++) {
+        x[l * 16 + i] ^= p[i];
+      }
+    }
+    aes_encrypt_blocks(x, x, lanes, &key->aes);
+
+    /* Store the MACs of the finished messages, and free their lanes */
+    for (l = lanes - 1; l >= 0; l--) {
+      if (++block[l] < total[l]) {
+        continue;
+      }
+      for (i = 0; i < 16; i++) {
+        ((unsigned char *)macs)[message[l] * 16 + i] = x[l * 16 + i];
+      }
+      if (l < --lanes) {  /* move the last lane into this one */
+        for (i = 0; i < 16; i++) {
+          x[l * 16 + i] = x[lanes * 16 + i];
+          lasts[l][i] = lasts[lanes][i];
+        }
+        message[l] = message[lanes];
+        block[l] = block[lanes];
+        total[l] = total[lanes];
+      }
+    }
+  }
+}
@@ -0,0 +1,217 @@
+/*
+ * aes-decrypt.h: Advanced Encryption Standard (AES) inverse cipher
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/aes-decrypt.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Implements the AES decryption algorithm for 128-bit keys (AES-128),
+ * for the modes of operation that need it (most only need the encryption).
+ * It uses the same key schedule as the encryption, in reverse order, and
+ * the AES-NI instructions when aes.h does, with up to 8 independent blocks
+ * in flight for aes_decrypt_blocks.
+ *
+ * Uses the functions in aes.h, so you need to include that too:
+ * #include "aes.h"
+ * #include "aes-decrypt.h"
+ *
+ * References:
+ * [AES] Advanced Encryption Standard (AES), FIPS 197, Nov 26 2001.
+ *       http://csrc.nist.gov/publications/fips/fips197/fips-197.pdf
+ * [AESNI] Intel Advanced Encryption Standard (AES) New Instructions Set,
+ *         Shay Gueron, Intel, Rev 3.01, Sep 2012
+ */
+
+/* [AES] 5.3.2 InvSubBytes() transformation: inverse S-box */
+static const unsigned char aes_inv_sbox[256] = {
+  0x52,0x09,0x6a,0xd5,0x30,0x36,0xa5,0x38,0xbf,0x40,0xa3,0x9e,0x81,0xf3,0xd7,0xfb,
+  0x7c,0xe3,0x39,0x82,0x9b,0x2f,0xff,0x87,0x34,0x8e,0x43,0x44,0xc4,0xde,0xe9,0xcb,
+  0x54,0x7b,0x94,0x32,0xa6,0xc2,0x23,0x3d,0xee,0x4c,0x95,0x0b,0x42,0xfa,0xc3,0x4e,
+  0x08,0x2e,0xa1,0x66,0x28,0xd9,0x24,0xb2,0x76,0x5b,0xa2,0x49,0x6d,0x8b,0xd1,0x25,
+  0x72,0xf8,0xf6,0x64,0x86,0x68,0x98,0x16,0xd4,0xa4,0x5c,0xcc,0x5d,0x65,0xb6,0x92,
+  0x6c,0x70,0x48,0x50,0xfd,0xed,0xb9,0xda,0x5e,0x15,0x46,0x57,0xa7,0x8d,0x9d,0x84,
+  0x90,0xd8,0xab,0x00,0x8c,0xbc,0xd3,0x0a,0xf7,0xe4,0x58,0x05,0xb8,0xb3,0x45,0x06,
+  0xd0,0x2c,0x1e,0x8f,0xca,0x3f,0x0f,0x02,0xc1,0xaf,0xbd,0x03,0x01,0x13,0x8a,0x6b,
+  0x3a,0x91,0x11,0x41,0x4f,0x67,0xdc,0xea,0x97,0xf2,0xcf,0xce,0xf0,0xb4,0xe6,0x73,
+  0x96,0xac,0x74,0x22,0xe7,0xad,0x35,0x85,0xe2,0xf9,0x37,0xe8,0x1c,0x75,0xdf,0x6e,
+  0x47,0xf1,0x1a,0x71,0x1d,0x29,0xc5,0x89,0x6f,0xb7,0x62,0x0e,0xaa,0x18,0xbe,0x1b,
+  0xfc,0x56,0x3e,0x4b,0xc6,0xd2,0x79,0x20,0x9a,0xdb,0xc0,0xfe,0x78,0xcd,0x5a,0xf4,
+  0x1f,0xdd,0xa8,0x33,0x88,0x07,0xc7,0x31,0xb1,0x12,0x10,0x59,0x27,0x80,0xec,0x5f,
+  0x60,0x51,0x7f,0xa9,0x19,0xb5,0x4a,0x0d,0x2d,0xe5,0x7a,0x9f,0x93,0xc9,0x9c,0xef,
+  0xa0,0xe0,0x3b,0x4d,0xae,0x2a,0xf5,0xb0,0xc8,0xeb,0xbb,0x3c,0x83,0x53,0x99,0x61,
+  0x17,0x2b,0x04,0x7e,0xba,0x77,0xd6,0x26,0xe1,0x69,0x14,0x63,0x55,0x21,0x0c,0x7d
+};
+
+/*
+ * Portable implementation of the AES inverse cipher transform (decryption)
+ * of one block with an expanded key.
+ * output: pointer to 16 bytes (128 bits) of memory to store the plaintext
+ * input: pointer to 16 bytes (128 bits) of memory with the ciphertext
+ * key: pointer to the key schedule, initialized with aes_set_key
+ * The output and input may point to the same memory.
+ *
+ * [AES] 5.3 Inverse Cipher
+ */
+static void aes_decrypt_generic(void *output, const void *input, const struct aes_key *key) {
+  const unsigned char *w = key->w;
+  unsigned char *state;
+  unsigned char a, b, c, d;
+  unsigned char a2, a4, a8, b2, b4, b8, c2, c4, c8, d2, d4, d8;
+  int i, round;
+
+  /* [AES] 5.1.4 AddRoundKey() transformation (last round key) */
+  state = (unsigned char *)output;
+  for (i = 0; i < 16; i++) {
+    state[i] = ((unsigned char *)input)[i] ^ w[160 + i];
+  }
+
+  for (round = 9; round >= 0; round--) {
+    /* [AES] 5.3.1 InvShiftRows() transformation */
+    a = state[1]; b = state[5]; c = state[9]; d = state[13];
+    state[1] = d; state[5] = a; state[9] = b; state[13] = c;
+    a = state[2]; b = state[6]; c = state[10]; d = state[14];
+    state[2] = c; state[6] = d; state[10] = a; state[14] = b;
+    a = state[3]; b = state[7]; c = state[11]; d = state[15];
+    state[3] = b; state[7] = c; state[11] = d; state[15] = a;
+
+    /* [AES] 5.3.2 InvSubBytes() transformation */
+    for (i = 0; i < 16; i++) {
+      state[i] = aes_inv_sbox[state[i]];
+    }
+
+    /* [AES] 5.1.4 AddRoundKey() transformation */
+    for (i = 0; i < 16; i++) {
+      state[i] ^= w[round * 16 + i];
+    }
+
+    /* [AES] 5.3.3 InvMixColumns() transformation: {0e}, {0b}, {0d}, {09} */
+    if (round > 0) {
+      for (i = 0; i < 16; i += 4) {
+        a = state[i + 0]; a2 = aes_xtime(a); a4 = aes_xtime(a2); a8 = aes_xtime(a4);
+        b = state[i + 1]; b2 = aes_xtime(b); b4 = aes_xtime(b2); b8 = aes_xtime(b4);
+        c = state[i + 2]; c2 = aes_xtime(c); c4 = aes_xtime(c2); c8 = aes_xtime(c4);
+        d = state[i + 3]; d2 = aes_xtime(d); d4 = aes_xtime(d2); d8 = aes_xtime(d4);
+        state[i + 0] = (a8 ^ a4 ^ a2) ^ (b8 ^ b2 ^ b) ^ (c8 ^ c4 ^ c) ^ (d8 ^ d);
+        state[i + 1] = (a8 ^ a) ^ (b8 ^ b4 ^ b2) ^ (c8 ^ c2 ^ c) ^ (d8 ^ d4 ^ d);
+        state[i + 2] = (a8 ^ a4 ^ a) ^ (b8 ^ b) ^ (c8 ^ c4 ^ c2) ^ (d8 ^ d2 ^ d);
+        state[i + 3] = (a8 ^ a2 ^ a) ^ (b8 ^ b4 ^ b) ^ (c8 ^ c) ^ (d8 ^ d4 ^ d2);
+      }
+    }
+  }
+}
+
+#ifdef AES_NI
+/*
+ * Implementation of the AES inverse cipher transform with the AES-NI
+ * instructions, for count independent blocks, 8 (or 4) at a time.
+ * Same parameters as aes_decrypt_blocks.
+ *
+ * AESDEC implements the equivalent inverse cipher, whose round keys
+ * (other than the first and last) go through InvMixColumns (AESIMC).
+ *
+ * [AES] 5.3.5 Equivalent Inverse Cipher
+ * [AESNI] Figure 39: AES-128 Decryption (parallelizing 8 blocks)
+ */
+__attribute__((target("aes")))
+static void aes_decrypt_aesni(void *output, const void *input, int count, const struct aes_key *key) {
+  const __m128i *in = (const __m128i *)input;
+  __m128i *out = (__m128i *)output;
+  __m128i k[11], b0, b1, b2, b3, b4, b5, b6, b7;
+  int i;
+
+  k[0] = _mm_loadu_si128((const __m128i *)(const void *)(key->w + 160));
+  for (i = 1; i < 10; i++) {
+    k[i] = _mm_aesimc_si128(_mm_loadu_si128((const __m128i *)(const void *)(key->w + 160 - i * 16)));
+  }
+  k[10] = _mm_loadu_si128((const __m128i *)(const void *)key->w);
+  for (; count >= 8; count -= 8, in += 8, out += 8) {
+    b0 = _mm_xor_si128(_mm_loadu_si128(in + 0), k[0]);
+    b1 = _mm_xor_si128(_mm_loadu_si128(in + 1), k[0]);
+    b2 = _mm_xor_si128(_mm_loadu_si128(in + 2), k[0]);
+    b3 = _mm_xor_si128(_mm_loadu_si128(in + 3), k[0]);
+    b4 = _mm_xor_si128(_mm_loadu_si128(in + 4), k[0]);
+    b5 = _mm_xor_si128(_mm_loadu_si128(in + 5), k[0]);
+    b6 = _mm_xor_si128(_mm_loadu_si128(in + 6), k[0]);
+    b7 = _mm_xor_si128(_mm_loadu_si128(in + 7), k[0]);
+    for (i = 1; i < 10; i++) {
+      b0 = _mm_aesdec_si128(b0, k[i]);
+      b1 = _mm_aesdec_si128(b1, k[i]);
+      b2 = _mm_aesdec_si128(b2, k[i]);
+      b3 = _mm_aesdec_si128(b3, k[i]);
+      b4 = _mm_aesdec_si128(b4, k[i]);
+      b5 = _mm_aesdec_si128(b5, k[i]);
+      b6 = _mm_aesdec_si128(b6, k[i]);
+      b7 = _mm_aesdec_si128(b7, k[i]);
+    }
+    _mm_storeu_si128(out + 0, _mm_aesdeclast_si128(b0, k[10]));
+    _mm_storeu_si128(out + 1, _mm_aesdeclast_si128(b1, k[10]));
+    _mm_storeu_si128(out + 2, _mm_aesdeclast_si128(b2, k[10]));
+    _mm_storeu_si128(out + 3, _mm_aesdeclast_si128(b3, k[10]));
+    _mm_storeu_si128(out + 4, _mm_aesdeclast_si128(b4, k[10]));
+    _mm_storeu_si128(out + 5, _mm_aesdeclast_si128(b5, k[10]));
+    _mm_storeu_si128(out + 6, _mm_aesdeclast_si128(b6, k[10]));
+    _mm_storeu_si128(out + 7, _mm_aesdeclast_si128(b7, k[10]));
+  }
+  for (; count >= 4; count -= 4, in += 4, out += 4) {
+    b0 = _mm_xor_si128(_mm_loadu_si128(in + 0), k[0]);
+    b1 = _mm_xor_si128(_mm_loadu_si128(in + 1), k[0]);
+    b2 = _mm_xor_si128(_mm_loadu_si128(in + 2), k[0]);
+    b3 = _mm_xor_si128(_mm_loadu_si128(in + 3), k[0]);
+    for (i = 1; i < 10; i++) {
+      b0 = _mm_aesdec_si128(b0, k[i]);
+      b1 = _mm_aesdec_si128(b1, k[i]);
+      b2 = _mm_aesdec_si128(b2, k[i]);
+      b3 = _mm_aesdec_si128(b3, k[i]);
+    }
+    _mm_storeu_si128(out + 0, _mm_aesdeclast_si128(b0, k[10]));
+    _mm_storeu_si128(out + 1, _mm_aesdeclast_si128(b1, k[10]));
+    _mm_storeu_si128(out + 2, _mm_aesdeclast_si128(b2, k[10]));
+    _mm_storeu_si128(out + 3, _mm_aesdeclast_si128(b3, k[10]));
+  }
+  for (; count > 0; count--, in++, out++) {
+    b0 = _mm_xor_si128(_mm_loadu_si128(in), k[0]);
+    for (i = 1; i < 10; i++) {
+      b0 = _mm_aesdec_si128(b0, k[i]);
+    }
+    _mm_storeu_si128(out, _mm_aesdeclast_si128(b0, k[10]));
+  }
+}
+#endif
+
+/*
+ * Performs the AES inverse cipher transform (decryption) of independent
+ * blocks with the same expanded key (as in the ECB mode), using the fastest
+ * implementation available on the processor.
+ * output: pointer to count * 16 bytes of memory to store the plaintext blocks
+ * input: pointer to count * 16 bytes of memory with the ciphertext blocks
+ * count: number of 16-byte blocks
+ * key: pointer to the key schedule, initialized with aes_set_key
+ * The output and input may point to the same memory.
+ */
+static void aes_decrypt_blocks(void *output, const void *input, int count, const struct aes_key *key) {
+  int i;
+
+#ifdef AES_NI
+  if (crumbs_cpu_has(CRUMBS_CPU_AESNI)) {
+    aes_decrypt_aesni(output, input, count, key);
+    return;
+  }
+#endif
+  for (i = 0; i < count; i++) {
+    aes_decrypt_generic((unsigned char *)output + i * 16, (const unsigned char *)input + i * 16, key);
+  }
+}
+
+/*
+ * Performs the AES inverse cipher transform (decryption) of one block with an expanded key.
+ * output: pointer to 16 bytes (128 bits) of memory to store the plaintext
+ * input: pointer to 16 bytes (128 bits) of memory with the ciphertext
+ * key: pointer to the key schedule, initialized with aes_set_key
+ * The output and input may point to the same memory.
+ */
+static void aes_decrypt_block(void *output, const void *input, const struct aes_key *key) {
+  aes_decrypt_blocks(output, input, 1, key);
+}
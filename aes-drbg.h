@@ -0,0 +1,296 @@
+/*
+ * aes-drbg.h: AES Counter mode Deterministic Random Bit Generator (CTR_DRBG)
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/aes-drbg.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Implements the CTR_DRBG of NIST SP 800-90A with AES-128, without the
+ * derivation function (so the entropy input must have full entropy), as a
+ * fast generator of random bytes for nonces, keys, padding and test data.
+ *
+ * The generator takes its entropy from a function given by the caller
+ * (reading /dev/urandom or getrandom, a hardware source, or fixed bytes for
+ * tests), when it is instantiated and then every reseed_interval requests.
+ *
+ * aes_drbg_generate serves the bytes from a buffer of AES_DRBG_BUFFER bytes,
+ * which is refilled with one Generate request of the DRBG, whose keystream
+ * blocks (the encrypted counters V + 1, V + 2, ...) are encrypted together
+ * with aes_encrypt_blocks, 8 in flight with AES-NI. The bytes are erased
+ * from the buffer as they are returned, but the bytes still in the buffer
+ * are exposed along with the state if it is compromised. Larger requests
+ * are generated directly into the output.
+ *
+ * There is no global state and no locking: each struct aes_drbg is an
+ * independent instance, to be used by one thread at a time (as one per thread).
+ *
+ * Uses the functions in aes.h, so you need to include that too:
+ * #include "aes.h"
+ * #include "aes-drbg.h"
+ *
+ * References:
+ * [DRBG] Recommendation for Random Number Generation Using Deterministic
+ *        Random Bit Generators, NIST Special Publication 800-90A Rev. 1,
+ *        Jun 2015, section 10.2.1 CTR_DRBG
+ */
+
+#define AES_DRBG_BUFFER 4096  /* bytes of keystream generated at a time */
+#define AES_DRBG_SEED 32  /* seedlen: bytes of entropy input, of personalization string and of additional input */
+#define AES_DRBG_MAX_REQUEST 65536  /* bytes of a Generate request, 2^19 bits */
+
+/*
+ * State of a CTR_DRBG instance.
+ * key: the key schedule of Key
+ * v: the counter V
+ * reseed_counter: number of Generate requests since the last reseed, plus 1
+ * reseed_interval: maximum number of Generate requests between reseeds
+ * entropy: function that stores length bytes of full entropy in buffer,
+ *          with arg, and returns 0 on success or nonzero on failure
+ * arg: the first argument of entropy
+ * buffer: the generated bytes, of which the last available are not yet returned
+ * available: number of bytes not yet returned at the end of buffer
+ */
+struct aes_drbg {
+  struct aes_key key;
+  unsigned char v[16];
+  unsigned long reseed_counter;
+  unsigned long reseed_interval;
+  int (*entropy)(void *arg, void *buffer, int length);
+  void *arg;
+  unsigned char buffer[AES_DRBG_BUFFER];
+  int available;
+};
+
+/*
+ * Generates count keystream blocks: encrypts the counters V + 1 to V + count,
+ * and leaves V at the last one. The counters are written with the last 32
+ * bits of V in a word, which is much faster than incrementing V byte by byte
+ * in memory.
+ * output: pointer to count * 16 bytes of memory to store the blocks
+ * count: number of blocks
+ * drbg: pointer to the state
+ */
+static void aes_drbg_blocks(unsigned char *output, int count, struct aes_drbg *drbg) {
+  unsigned char *o = output;
+  unsigned char v[12];  /* the first 96 bits of V, not overlapping the output */
+  unsigned long low;  /* the last 32 bits of V, as a word */
+  int i, j;
+
+  for (i = 0; i < 12; i++) {
+    v[i] = drbg->v[i];
+  }
+  low = (unsigned long)drbg->v[12] << 24 | (unsigned long)drbg->v[13] << 16 | (unsigned long)drbg->v[14] << 8 | drbg->v[15];
+  for (j = 0; j < count; j++, o += 16) {
+    low = (low + 1) & 0xffffffff;  /* V = (V + 1) mod 2^128 */
+    if (low == 0) {
+      for (i = 11; i >= 0; i--) {
+        if (++v[i] != 0) {
+          break;
+        }
+      }
+    }
+    for (i = 0; i < 12; i++) {
+      o[i] = v[i];
+    }
+    o[12] = (unsigned char)(low >> 24);
+    o[13] = (unsigned char)(low >> 16);
+    o[14] = (unsigned char)(low >> 8);
+    o[15] = (unsigned char)low;
+  }
+  for (i = 0; i < 12; i++) {
+    drbg->v[i] = v[i];
+  }
+  drbg->v[12] = (unsigned char)(low >> 24);
+  drbg->v[13] = (unsigned char)(low >> 16);
+  drbg->v[14] = (unsigned char)(low >> 8);
+  drbg->v[15] = (unsigned char)low;
+  aes_encrypt_blocks(output, output, count, &drbg->key);
+}
+
+/*
+ * Updates the state with provided data.
+ * drbg: pointer to the state
+ * data: pointer to AES_DRBG_SEED bytes of provided data
+ *
+ * [DRBG] 10.2.1.2 The Update Function (CTR_DRBG_Update)
+ */
+static void aes_drbg_update(struct aes_drbg *drbg, const unsigned char *data) {
+  unsigned char temp[32];
+  int i;
+
+  aes_drbg_blocks(temp, 2, drbg);
+  for (i = 0; i < 32; i++) {
+    temp[i] ^= data[i];
+  }
+  aes_set_key(&drbg->key, temp);
+  for (i = 0; i < 16; i++) {
+    drbg->v[i] = temp[16 + i];
+  }
+}
+
+/*
+ * Xors an input (personalization string or additional input), padded with
+ * zeros to AES_DRBG_SEED bytes, into the seed material.
+ * seed: pointer to the AES_DRBG_SEED bytes of the entropy input, or of zeros
+ * input: pointer to the input
+ * length: number of bytes of the input, at most AES_DRBG_SEED
+ */
+static void aes_drbg_seed(unsigned char *seed, const void *input, int length) {
+  int i;
+
+  for (i = 0; i < length; i++) {
+    seed[i] ^= ((const unsigned char *)input)[i];
+  }
+}
+
+/*
+ * Reseeds an instance with new entropy input, and discards the buffered bytes.
+ * drbg: pointer to the state
+ * additional: pointer to the additional input, or NULL
+ * additional_length: number of bytes of the additional input, at most AES_DRBG_SEED
+ * Returns 0 on success, or -1 if the entropy function fails (the state is then unchanged).
+ *
+ * [DRBG] 10.2.1.4.1 Reseeding When a Derivation Function is Not Used
+ */
+static int aes_drbg_reseed(struct aes_drbg *drbg, const void *additional, int additional_length) {
+  unsigned char seed[AES_DRBG_SEED];
+  int i;
+
+  if (additional_length < 0 || additional_length > AES_DRBG_SEED ||
+      drbg->entropy(drbg->arg, seed, AES_DRBG_SEED)) {
+    return -1;
+  }
+  aes_drbg_seed(seed, additional, additional_length);
+  aes_drbg_update(drbg, seed);
+  drbg->reseed_counter = 1;
+  for (i = 0; i < AES_DRBG_BUFFER; i++) {
+    drbg->buffer[i] = 0;
+  }
+  drbg->available = 0;
+  for (i = 0; i < AES_DRBG_SEED; i++) {
+    seed[i] = 0;
+  }
+  return 0;
+}
+
+/*
+ * Instantiates a CTR_DRBG with entropy input from a function.
+ * drbg: pointer to the state to initialize
+ * entropy: function that stores length bytes of full entropy in buffer,
+ *          with arg, and returns 0 on success or nonzero on failure
+ * arg: the first argument of entropy
+ * personalization: pointer to the personalization string, or NULL
+ * personalization_length: number of bytes of the personalization string, at most AES_DRBG_SEED
+ * reseed_interval: number of Generate requests (of up to AES_DRBG_BUFFER bytes
+ *                  each through aes_drbg_generate) between reseeds, 1 to 2^48
+ * Returns 0 on success, or -1 if the entropy function fails.
+ *
+ * [DRBG] 10.2.1.3.1 Instantiation When a Derivation Function is Not Used
+ */
+static int aes_drbg_init(struct aes_drbg *drbg, int (*entropy)(void *arg, void *buffer, int length), void *arg,
+                         const void *personalization, int personalization_length, unsigned long reseed_interval) {
+  const unsigned char zero[16] = {0};
+  int i;
+
+  aes_set_key(&drbg->key, zero);
+  for (i = 0; i < 16; i++) {
+    drbg->v[i] = 0;
+  }
+  drbg->reseed_interval = reseed_interval;
+  drbg->entropy = entropy;
+  drbg->arg = arg;
+  return aes_drbg_reseed(drbg, personalization, personalization_length);
+}
+
+/*
+ * Generates pseudorandom bytes with one Generate request, unbuffered.
+ * drbg: pointer to the state
+ * output: pointer to length bytes of memory to store the bytes
+ * length: number of bytes, at most AES_DRBG_MAX_REQUEST
+ * additional: pointer to the additional input, or NULL
+ * additional_length: number of bytes of the additional input, at most AES_DRBG_SEED
+ * Returns 0 on success, or -1 if the arguments are not valid or a
+ * necessary reseed fails.
+ *
+ * [DRBG] 10.2.1.5.1 Generating Pseudorandom Bits When a Derivation Function is Not Used
+ */
+static int aes_drbg_request(struct aes_drbg *drbg, void *output, int length, const void *additional, int additional_length) {
+  unsigned char *o = (unsigned char *)output;
+  unsigned char data[AES_DRBG_SEED], last[16];
+  int i;
+
+  if (length < 0 || length > AES_DRBG_MAX_REQUEST || additional_length < 0 || additional_length > AES_DRBG_SEED) {
+    return -1;
+  }
+  if (drbg->reseed_counter > drbg->reseed_interval) {
+    if (aes_drbg_reseed(drbg, additional, additional_length)) {
+      return -1;
+    }
+    additional_length = 0;
+  }
+  for (i = 0; i < AES_DRBG_SEED; i++) {
+    data[i] = 0;
+  }
+  if (additional_length > 0) {
+    aes_drbg_seed(data, additional, additional_length);
+    aes_drbg_update(drbg, data);
+  }
+
+  aes_drbg_blocks(o, length / 16, drbg);
+  if (length % 16) {
+    aes_drbg_blocks(last, 1, drbg);
+    for (i = 0; i < length % 16; i++) {
+      o[length - length % 16 + i] = last[i];
+    }
+  }
+
+  aes_drbg_update(drbg, data);
+  drbg->reseed_counter++;
+  return 0;
+}
+
+/*
+ * Generates pseudorandom bytes, from the buffer.
+ * drbg: pointer to the state
+ * output: pointer to length bytes of memory to store the bytes
+ * length: number of bytes
+ * Returns 0 on success, or -1 if a necessary reseed fails.
+ */
+static int aes_drbg_generate(struct aes_drbg *drbg, void *output, int length) {
+  unsigned char *o = (unsigned char *)output;
+  unsigned char *p;
+  int i, n;
+
+  while (length > 0) {
+    if (drbg->available == 0) {
+      if (length >= AES_DRBG_BUFFER) {  /* directly into the output */
+        n = length < AES_DRBG_MAX_REQUEST ? length & ~15 : AES_DRBG_MAX_REQUEST;
+        if (aes_drbg_request(drbg, o, n, 0, 0)) {
+          return -1;
+        }
+        o += n;
+        length -= n;
+        continue;
+      }
+      if (aes_drbg_request(drbg, drbg->buffer, AES_DRBG_BUFFER, 0, 0)) {
+        return -1;
+      }
+      drbg->available = AES_DRBG_BUFFER;
+    }
+    n = length < drbg->available ? length : drbg->available;
+    p = drbg->buffer + AES_DRBG_BUFFER - drbg->available;
+    for (i = 0; i < n; i++) {
+      o[i] = p[i];
+    }
+    for (i = 0; i < n; i++) {
+      p[i] = 0;
+    }
+    drbg->available -= n;
+    o += n;
+    length -= n;
+  }
+  return 0;
+}
@@ -0,0 +1,260 @@
+/*
+ * aes-gcm-stream.h: segmented, seekable AES-GCM encryption (STREAM)
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/aes-gcm-stream.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Implements a format for large messages encrypted and authenticated with
+ * AES-GCM in fixed-size segments, in the way of the STREAM construction,
+ * so that a range of bytes can be decrypted and verified by reading only
+ * the segments that hold it, and the segments can be sealed in parallel.
+ *
+ * Format of a sealed message:
+ * header (AES_GCM_STREAM_HEADER = 12 bytes):
+ *   segment size in bytes (4 bytes, big-endian)
+ *   nonce prefix (7 bytes, which must never be repeated with the same key)
+ *   reserved (1 byte, 0)
+ * segments 0 to n-1, each with:
+ *   ciphertext (segment size bytes, or 0 to segment size bytes in the last one)
+ *   tag (16 bytes)
+ *
+ * Every segment is encrypted with aes_gcm_encrypt, with the header as the
+ * additional authenticated data and with the 12-byte IV:
+ *   nonce prefix (7 bytes) || segment index (4 bytes, big-endian) || last (1 byte)
+ * where last is 1 for the last segment and 0 for the others, so segments
+ * cannot be reordered, dropped from the end, or moved between messages.
+ * There is always at least one segment (an empty last one for an empty message).
+ *
+ * Uses the functions in aes.h and aes-gcm.h, so you need to include those too:
+ * #include "aes.h"
+ * #include "aes-gcm.h"
+ * #include "aes-gcm-stream.h"
+ *
+ * References:
+ * [STREAM] Online Authenticated-Encryption and its Nonce-Reuse
+ *          Misuse-Resistance, Hoang, Reyhanitabar, Rogaway and Vizar,
+ *          CRYPTO 2015, section 7 (nonce-based OAE from a nonce-based AE)
+ * [GCM] Recommendation for Block Cipher Modes of Operation:
+ *       Galois/Counter Mode (GCM) and GMAC,
+ *       NIST Special Publication 800-38D, November 2007
+ */
+
+#define AES_GCM_STREAM_HEADER 12
+
+/*
+ * Builds the header of a sealed message.
+ * header: pointer to AES_GCM_STREAM_HEADER bytes of memory to store the header
+ * segment_size: number of bytes of plaintext in each segment (but the last), at least 1
+ * nonce: pointer to the 7-byte nonce prefix, unique for each message sealed with a key
+ */
+static void aes_gcm_stream_init(void *header, int segment_size, const void *nonce) {
+  unsigned char *h = (unsigned char *)header;
+  int i;
+
+  h[0] = (unsigned char)(segment_size >> 24);
+  h[1] = (unsigned char)(segment_size >> 16);
+  h[2] = (unsigned char)(segment_size >> 8);
+  h[3] = (unsigned char)segment_size;
+  for (i = 0; i < 7; i++) {
+    h[4 + i] = ((const unsigned char *)nonce)[i];
+  }
+  h[11] = 0;
+}
+
+/*
+ * Returns the segment size stored in a header.
+ * header: pointer to the AES_GCM_STREAM_HEADER bytes of the header
+ */
+static int aes_gcm_stream_segment_size(const void *header) {
+  const unsigned char *h = (const unsigned char *)header;
+
+  return (int)((unsigned)h[0] << 24 | h[1] << 16 | h[2] << 8 | h[3]);
+}
+
+/*
+ * Returns the number of bytes of a sealed message, with the header.
+ * length: number of bytes of the plaintext
+ * segment_size: number of bytes of plaintext in each segment
+ */
+static int aes_gcm_stream_sealed_length(int length, int segment_size) {
+  int segments = length > 0 ? (length - 1) / segment_size + 1 : 1;
+
+  return AES_GCM_STREAM_HEADER + length + segments * 16;
+}
+
+/*
+ * Returns the number of bytes of the plaintext of a sealed message,
+ * or -1 if the header or the length of the sealed message are not valid.
+ * header: pointer to the AES_GCM_STREAM_HEADER bytes of the header
+ * sealed_length: number of bytes of the sealed message, with the header
+ */
+static int aes_gcm_stream_length(const void *header, int sealed_length) {
+  int segment_size, segments, rest;
+
+  segment_size = aes_gcm_stream_segment_size(header);
+  rest = sealed_length - AES_GCM_STREAM_HEADER;
+  if (segment_size < 1 || segment_size > 0x7fffffff - 16 || ((const unsigned char *)header)[11] || rest < 16) {
+    return -1;
+  }
+  segments = (rest - 1) / (segment_size + 16) + 1;
+  if (rest - (segments - 1) * (segment_size + 16) < 16) {  /* a last segment without a tag */
+    return -1;
+  }
+  return rest - segments * 16;
+}
+
+/*
+ * Builds the IV of a segment: nonce prefix || segment index || last.
+ * iv: pointer to 12 bytes of memory to store the IV
+ * header: pointer to the AES_GCM_STREAM_HEADER bytes of the header
+ * index: index of the segment
+ * last: nonzero for the last segment
+ */
+static void aes_gcm_stream_iv(unsigned char *iv, const void *header, int index, int last) {
+  int i;
+
+  for (i = 0; i < 7; i++) {
+    iv[i] = ((const unsigned char *)header)[4 + i];
+  }
+  iv[7] = (unsigned char)(index >> 24);
+  iv[8] = (unsigned char)(index >> 16);
+  iv[9] = (unsigned char)(index >> 8);
+  iv[10] = (unsigned char)index;
+  iv[11] = last ? 1 : 0;
+}
+
+/*
+ * Seals one segment. The segments of a message are independent, so they
+ * can be sealed in any order, or in parallel by several threads.
+ * output: pointer to length + 16 bytes of memory to store the ciphertext and the tag
+ * header: pointer to the AES_GCM_STREAM_HEADER bytes of the header
+ * index: index of the segment
+ * last: nonzero for the last segment
+ * plaintext: pointer to the plaintext of the segment
+ * length: number of bytes of the plaintext (the segment size but in the last segment)
+ * key: pointer to the 16-byte (128-bit) key
+ * The output may point to the same memory as the plaintext (in place).
+ */
+static void aes_gcm_stream_seal_segment(void *output, const void *header, int index, int last, const void *plaintext, int length, const void *key) {
+  unsigned char iv[12];
+
+  aes_gcm_stream_iv(iv, header, index, last);
+  aes_gcm_encrypt(output, (unsigned char *)output + length, iv, plaintext, length, header, AES_GCM_STREAM_HEADER, key);
+}
+
+/*
+ * Opens (verifies and decrypts) one segment.
+ * output: pointer to segment_length - 16 bytes of memory to store the plaintext
+ * header: pointer to the AES_GCM_STREAM_HEADER bytes of the header
+ * index: index of the segment
+ * last: nonzero for the last segment
+ * segment: pointer to the ciphertext and the tag of the segment
+ * segment_length: number of bytes of the ciphertext and the tag
+ * key: pointer to the 16-byte (128-bit) key
+ * Returns 0 on success, or -1 if the verification fails.
+ * The output may point to the same memory as the segment (in place).
+ */
+static int aes_gcm_stream_open_segment(void *output, const void *header, int index, int last, const void *segment, int segment_length, const void *key) {
+  unsigned char iv[12];
+
+  if (segment_length < 16) {
+    return -1;
+  }
+  aes_gcm_stream_iv(iv, header, index, last);
+  return aes_gcm_decrypt(output, iv, segment, segment_length - 16, header, AES_GCM_STREAM_HEADER,
+                         (const unsigned char *)segment + segment_length - 16, 16, key);
+}
+
+/*
+ * Seals a whole message.
+ * output: pointer to aes_gcm_stream_sealed_length(length, segment_size) bytes
+ *         of memory to store the sealed message
+ * segment_size: number of bytes of plaintext in each segment, at least 1
+ * nonce: pointer to the 7-byte nonce prefix, unique for each message sealed with a key
+ * plaintext: pointer to the plaintext
+ * length: number of bytes of the plaintext
+ * key: pointer to the 16-byte (128-bit) key
+ * Returns the number of bytes of the sealed message.
+ */
+static int aes_gcm_stream_seal(void *output, int segment_size, const void *nonce, const void *plaintext, int length, const void *key) {
+  unsigned char *o = (unsigned char *)output;
+  int index, n, m;
+
+  aes_gcm_stream_init(o, segment_size, nonce);
+  for (index = 0, m = 0; index == 0 || m < length; index++, m += n) {
+    n = length - m < segment_size ? length - m : segment_size;
+    aes_gcm_stream_seal_segment(o + AES_GCM_STREAM_HEADER + m + index * 16, o, index, m + n == length,
+                                (const unsigned char *)plaintext + m, n, key);
+  }
+  return AES_GCM_STREAM_HEADER + m + index * 16;
+}
+
+/*
+ * Reads a range of bytes of the plaintext of a sealed message: verifies
+ * only the segments that hold it, and decrypts only the bytes of the range.
+ * output: pointer to length bytes of memory to store the plaintext
+ * sealed: pointer to the sealed message, with the header
+ * sealed_length: number of bytes of the sealed message
+ * offset: offset in the plaintext of the first byte to read
+ * length: number of bytes to read
+ * key: pointer to the 16-byte (128-bit) key
+ * Returns 0 on success, or -1 if the range is not within the plaintext, or
+ * the verification of a segment fails (the output is then undefined).
+ *
+ * A range that does not reach the last segment cannot tell a message
+ * truncated at a segment boundary; reading the last byte (or an empty range
+ * at the end) verifies that.
+ */
+static int aes_gcm_stream_read(void *output, const void *sealed, int sealed_length, int offset, int length, const void *key) {
+  const unsigned char *header = (const unsigned char *)sealed;
+  const unsigned char *segment;
+  unsigned char *o = (unsigned char *)output;
+  unsigned char iv[12], tag[16], block[16];
+  struct aes_key expanded;
+  int segment_size, total, index, last, n, a, b, i;
+
+  total = aes_gcm_stream_length(header, sealed_length);
+  if (total < 0 || offset < 0 || length < 0 || offset > total - length) {
+    return -1;
+  }
+  segment_size = aes_gcm_stream_segment_size(header);
+  last = total > 0 ? (total - 1) / segment_size : 0;
+  aes_set_key(&expanded, key);
+
+  /* Each segment from the one with the first byte, or the last one for an empty range at the end */
+  index = offset / segment_size < last ? offset / segment_size : last;
+  do {
+    segment = header + AES_GCM_STREAM_HEADER + index * (segment_size + 16);
+    n = index < last ? segment_size : total - index * segment_size;
+
+    /* Verify the whole segment */
+    aes_gcm_stream_iv(iv, header, index, index == last);
+    aes_gcm_tag(tag, iv, header, AES_GCM_STREAM_HEADER, segment, n, key);
+    for (i = 0; i < 16; i++) {
+      if (tag[i] != segment[n + i]) {
+        return -1;
+      }
+    }
+
+    /* Decrypt the bytes a to b of the segment (with the counter of block a / 16) */
+    a = offset > index * segment_size ? offset - index * segment_size : 0;
+    b = offset + length - index * segment_size < n ? offset + length - index * segment_size : n;
+    if (a % 16 && a < b) {  /* a partial first block */
+      i = n - (a & ~15) < 16 ? n - (a & ~15) : 16;
+      aes_gcm_encrypt_or_decrypt(block, iv, 1 + a / 16, segment + (a & ~15), i, &expanded);
+      for (i = a % 16; i < 16 && a < b; i++, a++) {
+        *o++ = block[i];
+      }
+    }
+    if (a < b) {
+      aes_gcm_encrypt_or_decrypt(o, iv, 1 + a / 16, segment + a, b - a, &expanded);
+      o += b - a;
+    }
+    index++;
+  } while (index <= last && index * segment_size < offset + length);
+  return 0;
+}
@@ -9,27 +9,47 @@
 
 /*
  * Implements the AES-GCM authenticated encryption and decryption functions
- * for 128-bit keys.
+ * for 128-bit keys, for contiguous texts (aes_gcm_encrypt, aes_gcm_decrypt)
+ * and for texts in lists of fragments (aes_gcm_encrypt_v, aes_gcm_decrypt_v).
  *
- * Uses the aes_encrypt function in aes.h, so you need to include that too:
+ * On x86 processors, when compiled with GCC or Clang, the GHASH
+ * multiplications are done with the carry-less multiplication instruction
+ * (PCLMULQDQ) if the processor has it.
+ *
+ * Both directions can be done in place, with the same memory for the input
+ * and the output, and the tag can be stored right after the ciphertext.
+ *
+ * Uses the aes_encrypt and aes_encrypt_blocks functions in aes.h, so you need to include that too:
  * #include "aes.h"
  * #include "aes-gcm.h"
  *
+ * The processor features are detected with crumbs-cpu.h, which needs to be
+ * in the same directory (and where the code paths can be pinned).
+ *
  * References:
  * [GCM] Recommendation for Block Cipher Modes of Operation:
  *       Galois/Counter Mode (GCM) and GMAC,
  *       NIST Special Publication 800-38D, November 2007
  *       http://csrc.nist.gov/publications/nistpubs/800-38D/SP-800-38D.pdf
+ * [CLMUL] Intel Carry-Less Multiplication Instruction and its Usage for
+ *         Computing the GCM Mode, Gueron and Kounavis, Intel, Rev 2.02, Apr 2014
  */
 
+#include "crumbs-cpu.h"
+
+#ifdef CRUMBS_CPU_X86
+#define AES_GCM_CLMUL
+#endif
+
 /*
- * Computes the multiplication of blocks X and Y and stores the result in X.
+ * Portable implementation of the multiplication of blocks X and Y,
+ * which stores the result in X.
  * x: pointer to 16 bytes (128 bits) of memory with X
  * y: pointer to 16 bytes (128 bits) of memory with Y
  *
  * [GCM] 6.3 Multiplication Operation on Blocks
  */
-static void aes_gcm_mul(void *x, const void *y) {
+static void aes_gcm_mul_generic(void *x, const void *y) {
   unsigned char z[16];
   unsigned char v[16];
   unsigned char lsb1;
@@ -70,28 +90,104 @@ static void aes_gcm_mul(void *x, const void *y) {
   }
 }
 
+#ifdef AES_GCM_CLMUL
 /*
- * Calculates an authentication tag.
- * tag: pointer to 16 bytes (128 bits) of memory to store the calculated tag
- * iv: pointer to the initialization vector (12 bytes (96 bits))
+ * Implementation of the multiplication of blocks X and Y with PCLMULQDQ.
+ * Same parameters as aes_gcm_mul_generic.
+ *
+ * The blocks are byte-reflected into the bit order of the instruction, the
+ * 256-bit carry-less product of the 4 64-bit halves is shifted left by one
+ * bit (for the bit-reflected field), and reduced modulo the GCM polynomial.
+ *
+ * [CLMUL] Algorithm 1 and Figure 5 (gfmul)
+ */
+__attribute__((target("pclmul,ssse3")))
+static void aes_gcm_mul_clmul(void *x, const void *y) {
+  const __m128i mask = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  __m128i a, b, lo, mid, hi, t, u, v;
+
+  a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)x), mask);
+  b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)y), mask);
+
+  /* The 256-bit product hi:lo of the 4 products of the 64-bit halves */
+  lo = _mm_clmulepi64_si128(a, b, 0x00);
+  hi = _mm_clmulepi64_si128(a, b, 0x11);
+  mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+  lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+  hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+  /* Shift the 256-bit product hi:lo left by one bit */
+  t = _mm_srli_epi32(lo, 31);
+  u = _mm_srli_epi32(hi, 31);
+  lo = _mm_slli_epi32(lo, 1);
+  hi = _mm_slli_epi32(hi, 1);
+  v = _mm_srli_si128(t, 12);
+  u = _mm_slli_si128(u, 4);
+  t = _mm_slli_si128(t, 4);
+  lo = _mm_or_si128(lo, t);
+  hi = _mm_or_si128(_mm_or_si128(hi, u), v);
+
+  /* Reduce modulo x^128 + x^7 + x^2 + x + 1 */
+  t = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30)), _mm_slli_epi32(lo, 25));
+  u = _mm_srli_si128(t, 4);
+  lo = _mm_xor_si128(lo, _mm_slli_si128(t, 12));
+  t = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2)), _mm_srli_epi32(lo, 7));
+  hi = _mm_xor_si128(hi, _mm_xor_si128(lo, _mm_xor_si128(t, u)));
+
+  _mm_storeu_si128((__m128i *)x, _mm_shuffle_epi8(hi, mask));
+}
+#endif
+
+/*
+ * Computes the multiplication of blocks X and Y and stores the result in X,
+ * using the fastest implementation available on the processor.
+ * x: pointer to 16 bytes (128 bits) of memory with X
+ * y: pointer to 16 bytes (128 bits) of memory with Y
+ */
+static void aes_gcm_mul(void *x, const void *y) {
+#ifdef AES_GCM_CLMUL
+  if (crumbs_cpu_has(CRUMBS_CPU_PCLMUL | CRUMBS_CPU_SSSE3)) {
+    aes_gcm_mul_clmul(x, y);
+    return;
+  }
+#endif
+  aes_gcm_mul_generic(x, y);
+}
+
+/*
+ * Adds data to a GHASH computation, in 16-byte blocks (the last one padded
+ * with zero bits, so only the last part of the data can have a partial block).
+ * s: pointer to the 16-byte GHASH value to update
+ * h: pointer to the 16-byte hash subkey
+ * data: pointer to the data
+ * length: number of bytes of the data
+ *
+ * [GCM] 6.4 GHASH Function
+ */
+static void aes_gcm_ghash(unsigned char *s, const unsigned char *h, const void *data, int length) {
+  int i, j;
+
+  for (i = 0; i < length; i += 16) {
+    for (j = 0; j < 16 && i + j < length; j++) {
+      s[j] ^= ((const unsigned char *)data)[i + j];
+    }
+    aes_gcm_mul(s, h);
+  }
+}
+
+/*
+ * Starts the calculation of an authentication tag with the additional
+ * authenticated data, for the text to be added with aes_gcm_ghash.
+ * s: pointer to 16 bytes of memory to store the GHASH value
+ * h: pointer to 16 bytes of memory to store the hash subkey
  * aad: pointer to the additional authenticated data
  * aad_length: number of bytes of the additional authenticated data
- * text: pointer to the text (plaintext or ciphertext)
- * text_length: number of bytes of the text
  * key: pointer to the encryption key (16 bytes (128 bits))
  *
- * Used internally by the aes_gcm_encrypt and aes_gcm_decrypt functions.
- * Can also be called externally to calculate just a GMAC:
- * aes_gcm_tag(gmac, iv, aad, aad_length, NULL, 0, key)
- *
- * [GCM] 6.4 GHASH Function
- * [GCM] 6.5 GCTR Function
  * [GCM] 7.1 Algorithm for the Authenticated Encryption Function
  */
-static void aes_gcm_tag(void *tag, const void *iv, const void *aad, int aad_length, const void *text, int text_length, const void *key) {
-  unsigned char h[16];  /* the hash subkey */
-  unsigned char j0[16];  /* the pre-counter block */
-  int i, j;
+static void aes_gcm_tag_init(unsigned char *s, unsigned char *h, const void *aad, int aad_length, const void *key) {
+  int i;
 
   /* [GCM] 7.1 Step 1. H = CIPH_K(0^128) */
   for (i = 0; i < 16; i++) {
@@ -101,41 +197,48 @@ static void aes_gcm_tag(void *tag, const void *iv, const void *aad, int aad_leng
 
   /* [GCM] 7.1 Step 5. S = GHASH_H(A || 0^v || C || 0^u || len(A)64 || len(C)64) */
   for (i = 0; i < 16; i++) {
-    ((unsigned char *)tag)[i] = 0;
-  }
-  for (i = 0; i < aad_length; i += 16) {
-    for (j = 0; j < 16 && i + j < aad_length; j++) {
-      ((unsigned char *)tag)[j] ^= ((unsigned char *)aad)[i + j];
-    }
-    aes_gcm_mul(tag, h);
-  }
-  for (i = 0; i < text_length; i += 16) {
-    for (j = 0; j < 16 && i + j < text_length; j++) {
-      ((unsigned char *)tag)[j] ^= ((unsigned char *)text)[i + j];
-    }
-    aes_gcm_mul(tag, h);
+    s[i] = 0;
   }
+  aes_gcm_ghash(s, h, aad, aad_length);
+}
+
+/*
+ * Finishes the calculation of an authentication tag.
+ * tag: pointer to 16 bytes (128 bits) of memory to store the calculated tag
+ * s: pointer to the 16-byte GHASH value of the AAD and text
+ * h: pointer to the 16-byte hash subkey
+ * iv: pointer to the initialization vector (12 bytes (96 bits))
+ * aad_length: number of bytes of the additional authenticated data
+ * text_length: number of bytes of the text
+ * key: pointer to the encryption key (16 bytes (128 bits))
+ *
+ * [GCM] 7.1 Algorithm for the Authenticated Encryption Function
+ */
+static void aes_gcm_tag_final(void *tag, unsigned char *s, const unsigned char *h, const void *iv, int aad_length, int text_length, const void *key) {
+  unsigned char j0[16];  /* the pre-counter block */
+  int i;
+
   /*
-  ((unsigned char *)tag)[0] ^= aad_length >> 53;
-  ((unsigned char *)tag)[1] ^= aad_length >> 45;
-  ((unsigned char *)tag)[2] ^= aad_length >> 37;
+  s[0] ^= aad_length >> 53;
+  s[1] ^= aad_length >> 45;
+  s[2] ^= aad_length >> 37;
   */
-  ((unsigned char *)tag)[3] ^= aad_length >> 29;
-  ((unsigned char *)tag)[4] ^= aad_length >> 21;
-  ((unsigned char *)tag)[5] ^= aad_length >> 13;
-  ((unsigned char *)tag)[6] ^= aad_length >> 5;
-  ((unsigned char *)tag)[7] ^= aad_length << 3;
+  s[3] ^= aad_length >> 29;
+  s[4] ^= aad_length >> 21;
+  s[5] ^= aad_length >> 13;
+  s[6] ^= aad_length >> 5;
+  s[7] ^= aad_length << 3;
   /*
-  ((unsigned char *)tag)[8] ^= text_length >> 53;
-  ((unsigned char *)tag)[9] ^= text_length >> 45;
-  ((unsigned char *)tag)[10] ^= text_length >> 37;
+  s[8] ^= text_length >> 53;
+  s[9] ^= text_length >> 45;
+  s[10] ^= text_length >> 37;
   */
-  ((unsigned char *)tag)[11] ^= text_length >> 29;
-  ((unsigned char *)tag)[12] ^= text_length >> 21;
-  ((unsigned char *)tag)[13] ^= text_length >> 13;
-  ((unsigned char *)tag)[14] ^= text_length >> 5;
-  ((unsigned char *)tag)[15] ^= text_length << 3;
-  aes_gcm_mul(tag, h);
+  s[11] ^= text_length >> 29;
+  s[12] ^= text_length >> 21;
+  s[13] ^= text_length >> 13;
+  s[14] ^= text_length >> 5;
+  s[15] ^= text_length << 3;
+  aes_gcm_mul(s, h);
 
   /* [GCM] 7.1 Step 6. T = MSBt(GCTRk(J0,S)) */
   for (i = 0; i < 12; i++) {
@@ -147,61 +250,249 @@ static void aes_gcm_tag(void *tag, const void *iv, const void *aad, int aad_leng
   j0[15] = 1;
   aes_encrypt(j0, j0, key);
   for (i = 0; i < 16; i++) {
-    ((unsigned char *)tag)[i] ^= j0[i];
+    ((unsigned char *)tag)[i] = s[i] ^ j0[i];
   }
 }
 
+/*
+ * Calculates an authentication tag.
+ * tag: pointer to 16 bytes (128 bits) of memory to store the calculated tag
+ * iv: pointer to the initialization vector (12 bytes (96 bits))
+ * aad: pointer to the additional authenticated data
+ * aad_length: number of bytes of the additional authenticated data
+ * text: pointer to the text (plaintext or ciphertext)
+ * text_length: number of bytes of the text
+ * key: pointer to the encryption key (16 bytes (128 bits))
+ *
+ * Used internally by the aes_gcm_encrypt and aes_gcm_decrypt functions.
+ * Can also be called externally to calculate just a GMAC:
+ * aes_gcm_tag(gmac, iv, aad, aad_length, NULL, 0, key)
+ *
+ * [GCM] 6.4 GHASH Function
+ * [GCM] 6.5 GCTR Function
+ * [GCM] 7.1 Algorithm for the Authenticated Encryption Function
+ */
+static void aes_gcm_tag(void *tag, const void *iv, const void *aad, int aad_length, const void *text, int text_length, const void *key) {
+  unsigned char h[16];  /* the hash subkey */
+  unsigned char s[16];  /* the GHASH value */
+
+  aes_gcm_tag_init(s, h, aad, aad_length, key);
+  aes_gcm_ghash(s, h, text, text_length);
+  aes_gcm_tag_final(tag, s, h, iv, aad_length, text_length, key);
+}
+
 /*
  * Implements the steps that are common to the encryption and decryption:
  * steps 2 and 3 of the authenticated encryption function and
  * steps 3 and 4 of the authenticated decryption function.
- * 
+ *
  * output: pointer to input_length bytes of memory to store the ciphertext/plaintext
  * iv: pointer to the 12-byte (96-bit) initialization vector
+ * counter: the counter of the block before the input (1, J0, at the start of the text)
  * input: pointer to the plaintext/ciphertext
  * input_length: number of bytes of the input
+ * key: pointer to the key schedule, initialized with aes_set_key
+ *
+ * The key stream is generated into a scratch buffer, 8 blocks at a time,
+ * and then XORed into the output, so the output and input may point to the
+ * same memory (in-place operation), but must not otherwise overlap.
+ *
+ * [GCM] 7.1 Algorithm for the Authenticated Encryption Function
+ * [GCM] 7.2 Algorithm for the Authenticated Decryption Function
+ */
+static void aes_gcm_encrypt_or_decrypt(void *output, const void *iv, unsigned counter, const void *input, int input_length, const struct aes_key *key) {
+  unsigned char ks[8 * 16];  /* the counter blocks CBi, then the key stream */
+  int i, j, m, n;
+
+  /* C = GCTR_K(inc32(J0), P), with J0 = IV || 0^31 || 1 */
+  for (m = 0; m < input_length; m += n) {
+    n = input_length - m < 8 * 16 ? input_length - m : 8 * 16;
+    for (i = 0; i < n; i += 16) {
+      /* [GCM] 6.5 GCTR Function, 5. For i = 2 to n, let CBi = inc32(CBi-1) */
+      counter++;
+      for (j = 0; j < 12; j++) {
+        ks[i + j] = ((unsigned char *)iv)[j];
+      }
+      ks[i + 12] = counter >> 24;
+      ks[i + 13] = counter >> 16;
+      ks[i + 14] = counter >> 8;
+      ks[i + 15] = counter;
+    }
+    aes_encrypt_blocks(ks, ks, i / 16, key);
+    /*
+     * [GCM] 6.5 GCTR Function, 6. For i = 1 to n - 1, let Yi = Xi ^ CIPHk(CBi)
+     * and 7. Let Yn = Xn ^ MSBlen(Xn)(CIPHk(CBn))
+     */
+    for (i = 0; i < n; i++) {
+      ((unsigned char *)output)[m + i] = ((unsigned char *)input)[m + i] ^ ks[i];
+    }
+  }
+}
+
+/*
+ * Copies bytes between a buffer and a list of fragments (scatter-gather).
+ * buffer: pointer to length bytes of memory
+ * length: number of bytes to copy
+ * parts: pointers to the fragments
+ * lengths: number of bytes of each fragment
+ * at: the position in the fragments, at[0] the fragment and at[1] the byte
+ *     in it, which is advanced by length bytes
+ * scatter: nonzero to copy from the buffer to the fragments,
+ *          or 0 to copy from the fragments to the buffer
+ */
+static void aes_gcm_copy_v(unsigned char *buffer, int length, void **parts, const int *lengths, int *at, int scatter) {
+  unsigned char *p;
+  int i;
+
+  while (length > 0) {
+    if (at[1] >= lengths[at[0]]) {  /* next fragment */
+      at[0]++;
+      at[1] = 0;
+      continue;
+    }
+    p = (unsigned char *)parts[at[0]] + at[1];
+    for (i = 0; i < length && at[1] < lengths[at[0]]; i++, at[1]++) {
+      if (scatter) {
+        p[i] = buffer[i];
+      } else {
+        buffer[i] = p[i];
+      }
+    }
+    buffer += i;
+    length -= i;
+  }
+}
+
+/*
+ * Implements the AES-GCM authenticated encryption algorithm, like
+ * aes_gcm_encrypt, with the plaintext and the ciphertext in lists of
+ * fragments (as with readv and writev), with any boundaries. The text goes
+ * through a small buffer, 8 blocks at a time (or directly, with a single
+ * fragment), so there is no need to copy the fragments into a contiguous buffer.
+ *
+ * Outputs:
+ * ciphertext: pointers to the fragments to store the ciphertext
+ * ciphertext_lengths: number of bytes of each ciphertext fragment
+ *                     (adding up to at least the length of the plaintext)
+ * tag: pointer to 16 bytes (128 bits) of memory to store the authentication tag
+ *
+ * Inputs:
+ * iv: pointer to the initialization vector (12 bytes (96 bits))
+ * plaintext: pointers to the fragments of the plaintext
+ * plaintext_lengths: number of bytes of each plaintext fragment
+ * plaintext_count: number of plaintext fragments
  * aad: pointer to the additional authenticated data
  * aad_length: number of bytes of the additional authenticated data
  * key: pointer to the 16-byte (128-bit) key
  *
+ * The ciphertext fragments may be the same as the plaintext fragments (in place).
+ *
  * [GCM] 7.1 Algorithm for the Authenticated Encryption Function
+ */
+static void aes_gcm_encrypt_v(void **ciphertext, const int *ciphertext_lengths, void *tag, const void *iv,
+    const void **plaintext, const int *plaintext_lengths, int plaintext_count, const void *aad, int aad_length, const void *key) {
+  struct aes_key expanded;
+  unsigned char h[16], s[16], buffer[8 * 16];
+  int in[2] = {0, 0}, out[2] = {0, 0};
+  int i, n, length;
+
+  length = 0;
+  for (i = 0; i < plaintext_count; i++) {
+    length += plaintext_lengths[i];
+  }
+
+  aes_set_key(&expanded, key);
+  if (plaintext_count == 1 && ciphertext_lengths[0] >= length) {
+    /* Contiguous: encrypt the plaintext, then calculate the tag */
+    aes_gcm_encrypt_or_decrypt(ciphertext[0], iv, 1, plaintext[0], length, &expanded);
+    aes_gcm_tag(tag, iv, aad, aad_length, ciphertext[0], length, key);
+    return;
+  }
+
+  aes_gcm_tag_init(s, h, aad, aad_length, key);
+  for (i = 0; i < length; i += n) {
+    n = length - i < 8 * 16 ? length - i : 8 * 16;
+    aes_gcm_copy_v(buffer, n, (void **)plaintext, plaintext_lengths, in, 0);
+    aes_gcm_encrypt_or_decrypt(buffer, iv, 1 + i / 16, buffer, n, &expanded);
+    aes_gcm_ghash(s, h, buffer, n);
+    aes_gcm_copy_v(buffer, n, ciphertext, ciphertext_lengths, out, 1);
+  }
+  aes_gcm_tag_final(tag, s, h, iv, aad_length, length, key);
+}
+
+/*
+ * Implements the AES-GCM authenticated decryption algorithm, like
+ * aes_gcm_decrypt, with the ciphertext and the plaintext in lists of
+ * fragments (as with readv and writev), with any boundaries.
+ *
+ * Outputs:
+ * plaintext: pointers to the fragments to store the plaintext
+ * plaintext_lengths: number of bytes of each plaintext fragment
+ *                    (adding up to at least the length of the ciphertext)
+ *
+ * Inputs:
+ * iv: pointer to the initialization vector (12 bytes (96 bits))
+ * ciphertext: pointers to the fragments of the ciphertext
+ * ciphertext_lengths: number of bytes of each ciphertext fragment
+ * ciphertext_count: number of ciphertext fragments
+ * aad: pointer to the additional authenticated data
+ * aad_length: number of bytes of the additional authenticated data
+ * tag: pointer to the authentication tag
+ * tag_length: number of bytes of the authentication tag
+ * key: pointer to the 16-byte (128-bit) key
+ *
+ * Returns 0 on success, or -1 if the verification of the tag fails
+ * (and then the plaintext is left unchanged).
+ * The plaintext fragments may be the same as the ciphertext fragments (in place).
+ *
  * [GCM] 7.2 Algorithm for the Authenticated Decryption Function
  */
-static void aes_gcm_encrypt_or_decrypt(void *output, const void *iv, const void *input, int input_length, const void *key) {
-  unsigned char cb[16];  /* the counter block CBi */
-  unsigned counter;
-  int i, m;
+static int aes_gcm_decrypt_v(void **plaintext, const int *plaintext_lengths, const void *iv,
+    const void **ciphertext, const int *ciphertext_lengths, int ciphertext_count, const void *aad, int aad_length,
+    const void *tag, int tag_length, const void *key) {
+  struct aes_key expanded;
+  unsigned char h[16], s[16], buffer[8 * 16];
+  int in[2] = {0, 0}, out[2] = {0, 0};
+  int i, n, length;
 
-  /* J0 = IV || 0^31 || 1 */
-  for (i = 0; i < 12; i++) {
-    cb[i] = ((unsigned char *)iv)[i];
+  length = 0;
+  for (i = 0; i < ciphertext_count; i++) {
+    length += ciphertext_lengths[i];
+  }
+
+  /* Check the tag */
+  if (ciphertext_count == 1) {
+    aes_gcm_tag(buffer, iv, aad, aad_length, ciphertext[0], length, key);
+  } else {
+    aes_gcm_tag_init(s, h, aad, aad_length, key);
+    for (i = 0; i < length; i += n) {
+      n = length - i < 8 * 16 ? length - i : 8 * 16;
+      aes_gcm_copy_v(buffer, n, (void **)ciphertext, ciphertext_lengths, in, 0);
+      aes_gcm_ghash(s, h, buffer, n);
+    }
+    aes_gcm_tag_final(buffer, s, h, iv, aad_length, length, key);
   }
-  counter = 1;
-
-  /* C = GCTR_K(inc32(J0), P) */
-  for (m = 0; m < input_length - 16; m += 16) {
-    /* [GCM] 6.5 GCTR Function, 5. For i = 2 to n, let CBi = inc32(CBi-1) */
-    counter++;
-    cb[12] = counter >> 24;
-    cb[13] = counter >> 16;
-    cb[14] = counter >> 8;
-    cb[15] = counter;
-    /* [GCM] 6.5 GCTR Function, 6. For i = 1 to n - 1, let Yi = Xi ^ CIPHk(CBi) */
-    aes_encrypt((unsigned char *)output + m, cb, key);
-    for (i = 0; i < 16; i++) {
-      ((unsigned char *)output)[m + i] ^= ((unsigned char *)input)[m + i];
+  for (i = 0; i < tag_length; i++) {
+    if (buffer[i] != ((unsigned char *)tag)[i]) {
+      return -1;
     }
   }
-  /* [GCM] 6.5 GCTR Function, Step 7. Let Yn = Xn ^ MSBlen(Xn)(CIPHk(CBn)) */
-  counter++;
-  cb[12] = counter >> 24;
-  cb[13] = counter >> 16;
-  cb[14] = counter >> 8;
-  cb[15] = counter;
-  aes_encrypt(cb, cb, key);
-  for (i = 0; i < input_length - m; i++) {
-    ((unsigned char *)output)[m + i] = ((unsigned char *)input)[m + i] ^ cb[i];
+
+  /* Decrypt the ciphertext */
+  aes_set_key(&expanded, key);
+  if (ciphertext_count == 1 && plaintext_lengths[0] >= length) {
+    aes_gcm_encrypt_or_decrypt(plaintext[0], iv, 1, ciphertext[0], length, &expanded);
+    return 0;
+  }
+  in[0] = 0;
+  in[1] = 0;
+  for (i = 0; i < length; i += n) {
+    n = length - i < 8 * 16 ? length - i : 8 * 16;
+    aes_gcm_copy_v(buffer, n, (void **)ciphertext, ciphertext_lengths, in, 0);
+    aes_gcm_encrypt_or_decrypt(buffer, iv, 1 + i / 16, buffer, n, &expanded);
+    aes_gcm_copy_v(buffer, n, plaintext, plaintext_lengths, out, 1);
   }
+  return 0;
 }
 
 /*
@@ -219,13 +510,15 @@ static void aes_gcm_encrypt_or_decrypt(void *output, const void *iv, const void
  * aad_length: number of bytes of the additional authenticated data
  * key: pointer to the 16-byte (128-bit) key
  *
+ * The ciphertext may point to the same memory as the plaintext (in place),
+ * and the tag may point right after the ciphertext (ciphertext + plaintext_length).
+ *
  * [GCM] 7.1 Algorithm for the Authenticated Encryption Function
  */
 static void aes_gcm_encrypt(void *ciphertext, void *tag, const void *iv, const void *plaintext, int plaintext_length, const void *aad, int aad_length, const void *key) {
-  /* Encrypt the plaintext */
-  aes_gcm_encrypt_or_decrypt(ciphertext, iv, plaintext, plaintext_length, key);
-  /* Calculate the tag */
-  aes_gcm_tag(tag, iv, aad, aad_length, ciphertext, plaintext_length, key);
+  void *output = ciphertext;
+
+  aes_gcm_encrypt_v(&output, &plaintext_length, tag, iv, &plaintext, &plaintext_length, 1, aad, aad_length, key);
 }
 
 /*
@@ -244,24 +537,14 @@ static void aes_gcm_encrypt(void *ciphertext, void *tag, const void *iv, const v
  * tag_length: number of bytes of the authentication tag
  * key: pointer to the 16-byte (128-bit () key
  *
- * Returns 0 on success, or -1 if the verification of the tag fails.
+ * Returns 0 on success, or -1 if the verification of the tag fails
+ * (and then the plaintext is left unchanged).
+ * The plaintext may point to the same memory as the ciphertext (in place).
  *
  * [GCM] 7.2 Algorithm for the Authenticated Decryption Function
  */
 static int aes_gcm_decrypt(void *plaintext, const void *iv, const void *ciphertext, int ciphertext_length, const void *aad, int aad_length, const void *tag, int tag_length, const void *key) {
-  unsigned char t[16];  /* the calculated tag */
-  int i;
-
-  /* Check the tag */
-  aes_gcm_tag(t, iv, aad, aad_length, ciphertext, ciphertext_length, key);
-  for (i = 0; i < tag_length; i++) {
-    if (t[i] != ((unsigned char *)tag)[i]) {
-      return -1;
-    }
-  }
+  void *output = plaintext;
 
-  /* Decrypt the ciphertext */
-  aes_gcm_encrypt_or_decrypt(plaintext, iv, ciphertext, ciphertext_length, key);
-
-  return 0;
+  return aes_gcm_decrypt_v(&output, &ciphertext_length, iv, &ciphertext, &ciphertext_length, 1, aad, aad_length, tag, tag_length, key);
 }
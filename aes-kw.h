@@ -8,49 +8,362 @@
  */
 
 /*
- * Computes the AES Key Wrap algorithm.
- * ciphertext: pointer to ((n + 1) * 8) bytes to store the ciphertext
- * plaintext: pointer to (n * 8) bytes with the plaintext
- * n: number of 8-byte blocks of the plaintext (n = length(plaintext) / 8)
- * key: pointer to 16 bytes (128 bits) with the key encryption key
+ * Implements the AES Key Wrap algorithm (AES-KW) and the AES Key Wrap with
+ * Padding algorithm (AES-KWP), wrapping and unwrapping, with a key schedule
+ * expanded once with aes_set_key for all the 6n block operations.
+ *
+ * The 6n block operations of a wrapping are strictly sequential, so the
+ * aes_kw_*_many functions wrap or unwrap many keys at once, advancing up
+ * to 8 of them together so that aes_encrypt_blocks or aes_decrypt_blocks
+ * has 8 independent blocks to work on at each step.
  *
- * Uses the aes_encrypt function in aes.h, so you need to include that too:
+ * Uses the functions in aes.h and aes-decrypt.h, so you need to include those too:
  * #include "aes.h"
+ * #include "aes-decrypt.h"
  * #include "aes-kw.h"
  *
  * References:
  * [RFC3394] Advanced Encryption Standard (AES) Key Wrap Algorithm, 2002.
+ * [RFC5649] Advanced Encryption Standard (AES) Key Wrap with Padding Algorithm, 2009.
  */
-static void aes_kw(void *ciphertext, const void *plaintext, int n, const void *key) {
-  unsigned char x[16];
-  unsigned char *r;
-  unsigned char *c;
-  int i, j, w;
+
+/*
+ * Internal function that computes the wrapping process W in place
+ * for count (up to 8) independent wrappings.
+ * a: pointer to count * 8 bytes with the initial values, replaced by the final A values
+ * r: pointer to the n * 8 bytes of plaintext blocks of the first wrapping,
+ *    replaced by R[1..n], followed by those of the others every stride bytes
+ * stride: number of bytes from the blocks of a wrapping to those of the next
+ * n: number of 8-byte blocks of each wrapping
+ * count: number of wrappings (1 to 8)
+ * key: pointer to the key schedule of the key encryption key
+ *
+ * The counter t = n * j + i is XORed into A as a 64-bit big-endian value.
+ * Since n * 8 fits in an int, t < 6 * 2^28 and its upper 32 bits are zero.
+ *
+ * [RFC3394] 2.2.1 Key Wrap (index based)
+ */
+static void aes_kw_w(unsigned char *a, unsigned char *r, int stride, int n, int count, const struct aes_key *key) {
+  unsigned char x[8 * 16];  /* A | R[i] of each wrapping */
+  unsigned t;
+  int i, j, l, w;
 
   /* 1) Initialize variables. */
-  for (w = 0; w < 8; w++) {  /* A0 = IV = 0xa6a6a6a6a6a6a6a6 */
-    x[w] = 0xa6;
+  for (l = 0; l < count; l++) {
+    for (w = 0; w < 8; w++) {
+      x[l * 16 + w] = a[l * 8 + w];
+    }
   }
-  r = (unsigned char *)plaintext;  /* R[i] = P[i] */
 
   /* 2) Calculate intermediate values. */
   for (j = 0; j <= 5; j++) {
-    c = (unsigned char *)ciphertext + 8;
     for (i = 1; i <= n; i++) {
-      for (w = 8; w < 16; w++) {  /* A | R[i] */
-        x[w] = *r++;
+      for (l = 0; l < count; l++) {
+        for (w = 0; w < 8; w++) {  /* A | R[i] */
+          x[l * 16 + 8 + w] = r[l * stride + (i - 1) * 8 + w];
+        }
       }
-      aes_encrypt(x, x, key);  /* B = AES(K, A | R[i]) */
-      x[7] ^= n * j + i;  /* A = MSB(64, B) ^ t  (assume n < 43) */
-      for (w = 8; w < 16; w++) {  /* R[i] = LSB(64, B) */
-        *c++ = x[w];
+      aes_encrypt_blocks(x, x, count, key);  /* B = AES(K, A | R[i]) */
+      t = (unsigned)n * j + i;
+      for (l = 0; l < count; l++) {
+        x[l * 16 + 4] ^= t >> 24;  /* A = MSB(64, B) ^ t */
+        x[l * 16 + 5] ^= t >> 16;
+        x[l * 16 + 6] ^= t >> 8;
+        x[l * 16 + 7] ^= t;
+        for (w = 0; w < 8; w++) {  /* R[i] = LSB(64, B) */
+          r[l * stride + (i - 1) * 8 + w] = x[l * 16 + 8 + w];
+        }
       }
     }
-    r = (unsigned char *)ciphertext + 8;
   }
 
   /* 3) Output the results. */
-  for (w = 0; w < 8; w++) {
-    ((unsigned char *)ciphertext)[w] = x[w];
+  for (l = 0; l < count; l++) {
+    for (w = 0; w < 8; w++) {
+      a[l * 8 + w] = x[l * 16 + w];
+    }
+  }
+}
+
+/*
+ * Internal function that computes the unwrapping process W^-1 in place
+ * for count (up to 8) independent unwrappings.
+ * a: pointer to count * 8 bytes with the C[0] values, replaced by the recovered initial values
+ * r: pointer to the n * 8 bytes of C[1..n] of the first unwrapping,
+ *    replaced by the plaintext blocks, followed by those of the others every stride bytes
+ * stride: number of bytes from the blocks of an unwrapping to those of the next
+ * n: number of 8-byte blocks of each unwrapping
+ * count: number of unwrappings (1 to 8)
+ * key: pointer to the key schedule of the key encryption key
+ *
+ * [RFC3394] 2.2.2 Key Unwrap (index based)
+ */
+static void aes_kw_w_inverse(unsigned char *a, unsigned char *r, int stride, int n, int count, const struct aes_key *key) {
+  unsigned char x[8 * 16];  /* (A ^ t) | R[i] of each unwrapping */
+  unsigned t;
+  int i, j, l, w;
+
+  /* 1) Initialize variables. */
+  for (l = 0; l < count; l++) {
+    for (w = 0; w < 8; w++) {
+      x[l * 16 + w] = a[l * 8 + w];
+    }
+  }
+
+  /* 2) Compute intermediate values. */
+  for (j = 5; j >= 0; j--) {
+    for (i = n; i >= 1; i--) {
+      t = (unsigned)n * j + i;
+      for (l = 0; l < count; l++) {
+        x[l * 16 + 4] ^= t >> 24;  /* (A ^ t) | R[i] */
+        x[l * 16 + 5] ^= t >> 16;
+        x[l * 16 + 6] ^= t >> 8;
+        x[l * 16 + 7] ^= t;
+        for (w = 0; w < 8; w++) {
+          x[l * 16 + 8 + w] = r[l * stride + (i - 1) * 8 + w];
+        }
+      }
+      aes_decrypt_blocks(x, x, count, key);  /* B = AES-1(K, (A ^ t) | R[i]) */
+      for (l = 0; l < count; l++) {
+        for (w = 0; w < 8; w++) {  /* R[i] = LSB(64, B) */
+          r[l * stride + (i - 1) * 8 + w] = x[l * 16 + 8 + w];
+        }
+      }
+    }
+  }
+
+  /* 3) Output results. */
+  for (l = 0; l < count; l++) {
+    for (w = 0; w < 8; w++) {
+      a[l * 8 + w] = x[l * 16 + w];
+    }
   }
 }
+
+/*
+ * Wraps many keys with the AES Key Wrap algorithm, under the same key
+ * encryption key.
+ * ciphertexts: pointer to count * ((n + 1) * 8) bytes to store the ciphertexts, in order
+ * plaintexts: pointer to count * (n * 8) bytes with the plaintexts, in order
+ * n: number of 8-byte blocks of each plaintext (n >= 2)
+ * count: number of plaintexts
+ * key: pointer to the key schedule of the key encryption key
+ *
+ * [RFC3394] 2.2.1 Key Wrap, 2.2.3.1 Default Initial Value
+ */
+static void aes_kw_wrap_many(void *ciphertexts, const void *plaintexts, int n, int count, const struct aes_key *key) {
+  unsigned char *c = (unsigned char *)ciphertexts;
+  const unsigned char *p = (const unsigned char *)plaintexts;
+  unsigned char a[8 * 8];
+  int i, l, m;
+
+  for (; count > 0; count -= m, c += m * (n + 1) * 8, p += m * n * 8) {
+    m = count < 8 ? count : 8;
+    for (l = 0; l < m; l++) {
+      for (i = 0; i < 8; i++) {  /* A0 = IV = 0xa6a6a6a6a6a6a6a6 */
+        a[l * 8 + i] = 0xa6;
+      }
+      for (i = 0; i < n * 8; i++) {  /* R[i] = P[i] */
+        c[l * (n + 1) * 8 + 8 + i] = p[l * n * 8 + i];
+      }
+    }
+    aes_kw_w(a, c + 8, (n + 1) * 8, n, m, key);
+    for (l = 0; l < m; l++) {
+      for (i = 0; i < 8; i++) {
+        c[l * (n + 1) * 8 + i] = a[l * 8 + i];
+      }
+    }
+  }
+}
+
+/*
+ * Unwraps many keys with the AES Key Wrap algorithm, under the same key
+ * encryption key, checking the integrity of each.
+ * plaintexts: pointer to count * (n * 8) bytes to store the plaintexts, in order
+ * ciphertexts: pointer to count * ((n + 1) * 8) bytes with the ciphertexts, in order
+ * n: number of 8-byte blocks of each plaintext (n >= 2)
+ * count: number of ciphertexts
+ * key: pointer to the key schedule of the key encryption key
+ * results: pointer to count ints to store the result of each unwrapping:
+ *          0 on success, or -1 if the integrity check fails
+ *          (in which case that plaintext is cleared)
+ * Returns the number of unwrappings whose integrity check failed.
+ *
+ * The recovered initial values are compared in constant time.
+ *
+ * [RFC3394] 2.2.2 Key Unwrap, 2.2.3 Key Data Integrity -- the Initial Value
+ */
+static int aes_kw_unwrap_many(void *plaintexts, const void *ciphertexts, int n, int count,
+    const struct aes_key *key, int *results) {
+  unsigned char *p = (unsigned char *)plaintexts;
+  const unsigned char *c = (const unsigned char *)ciphertexts;
+  unsigned char a[8 * 8];
+  unsigned diff;
+  int failures, i, l, m;
+
+  failures = 0;
+  for (; count > 0; count -= m, c += m * (n + 1) * 8, p += m * n * 8, results += m) {
+    m = count < 8 ? count : 8;
+    for (l = 0; l < m; l++) {
+      for (i = 0; i < 8; i++) {
+        a[l * 8 + i] = c[l * (n + 1) * 8 + i];
+      }
+      for (i = 0; i < n * 8; i++) {
+        p[l * n * 8 + i] = c[l * (n + 1) * 8 + 8 + i];
+      }
+    }
+    aes_kw_w_inverse(a, p, n * 8, n, m, key);
+    for (l = 0; l < m; l++) {
+      diff = 0;
+      for (i = 0; i < 8; i++) {
+        diff |= a[l * 8 + i] ^ 0xa6;
+      }
+      diff = 0 - ((diff + 255) >> 8);  /* all ones if the check fails, else zero */
+      for (i = 0; i < n * 8; i++) {
+        p[l * n * 8 + i] &= ~diff;
+      }
+      results[l] = (int)diff;
+      failures += diff & 1;
+    }
+  }
+  return failures;
+}
+
+/*
+ * Wraps key data with the AES Key Wrap algorithm.
+ * ciphertext: pointer to ((n + 1) * 8) bytes to store the ciphertext
+ * plaintext: pointer to (n * 8) bytes with the plaintext
+ * n: number of 8-byte blocks of the plaintext (n >= 2)
+ * key: pointer to the key schedule of the key encryption key
+ */
+static void aes_kw_wrap(void *ciphertext, const void *plaintext, int n, const struct aes_key *key) {
+  aes_kw_wrap_many(ciphertext, plaintext, n, 1, key);
+}
+
+/*
+ * Unwraps key data with the AES Key Wrap algorithm, checking its integrity.
+ * plaintext: pointer to (n * 8) bytes to store the plaintext
+ * ciphertext: pointer to ((n + 1) * 8) bytes with the ciphertext
+ * n: number of 8-byte blocks of the plaintext (n >= 2)
+ * key: pointer to the key schedule of the key encryption key
+ * Returns 0 on success, or -1 if the integrity check fails
+ * (in which case the plaintext is cleared).
+ */
+static int aes_kw_unwrap(void *plaintext, const void *ciphertext, int n, const struct aes_key *key) {
+  int result;
+
+  aes_kw_unwrap_many(plaintext, ciphertext, n, 1, key, &result);
+  return result;
+}
+
+/*
+ * Wraps key data of any length with the AES Key Wrap with Padding algorithm.
+ * ciphertext: pointer to ((length + 7) / 8 * 8 + 8) bytes to store the ciphertext
+ * plaintext: pointer to the plaintext
+ * length: number of bytes of the plaintext (length >= 1)
+ * key: pointer to the key schedule of the key encryption key
+ * Returns the number of bytes stored in ciphertext, (length + 7) / 8 * 8 + 8.
+ *
+ * [RFC5649] 3 Alternative Initial Value, 4.1 Extended Key Wrapping Process
+ */
+static int aes_kwp_wrap(void *ciphertext, const void *plaintext, int length, const struct aes_key *key) {
+  unsigned char *c = (unsigned char *)ciphertext;
+  int i, n;
+
+  n = (length + 7) / 8;
+
+  /* AIV = A65959A6 || MLI (32-bit big-endian message length indicator) */
+  c[0] = 0xa6;
+  c[1] = 0x59;
+  c[2] = 0x59;
+  c[3] = 0xa6;
+  c[4] = (unsigned)length >> 24;
+  c[5] = length >> 16;
+  c[6] = length >> 8;
+  c[7] = length;
+
+  /* P = plaintext with zero padding to a multiple of 8 bytes */
+  for (i = 0; i < length; i++) {
+    c[8 + i] = ((const unsigned char *)plaintext)[i];
+  }
+  for (; i < n * 8; i++) {
+    c[8 + i] = 0;
+  }
+
+  if (n == 1) {  /* C[0] | C[1] = ENC(K, A | P[1]) */
+    aes_encrypt_block(c, c, key);
+  } else {
+    aes_kw_w(c, c + 8, 0, n, 1, key);
+  }
+  return n * 8 + 8;
+}
+
+/*
+ * Unwraps key data with the AES Key Wrap with Padding algorithm,
+ * checking its integrity.
+ * plaintext: pointer to (length - 8) bytes to store the plaintext
+ * ciphertext: pointer to the ciphertext
+ * length: number of bytes of the ciphertext
+ * key: pointer to the key schedule of the key encryption key
+ * Returns the number of bytes of the plaintext, or -1 if the ciphertext
+ * length is invalid or the integrity check fails (in which case the
+ * plaintext is cleared).
+ *
+ * The checks of the recovered initial value and padding don't branch on
+ * the recovered data.
+ *
+ * [RFC5649] 4.2 Extended Key Unwrapping Process, 3 Alternative Initial Value
+ */
+static int aes_kwp_unwrap(void *plaintext, const void *ciphertext, int length, const struct aes_key *key) {
+  unsigned char *p = (unsigned char *)plaintext;
+  unsigned char a[16];
+  unsigned diff, mli;
+  int i, n;
+
+  if (length % 8 != 0 || length < 16) {
+    return -1;
+  }
+  n = length / 8 - 1;
+
+  if (n == 1) {  /* A | P[1] = DEC(K, C[0] | C[1]) */
+    aes_decrypt_block(a, ciphertext, key);
+    for (i = 0; i < 8; i++) {
+      p[i] = a[8 + i];
+    }
+  } else {
+    for (i = 0; i < 8; i++) {
+      a[i] = ((const unsigned char *)ciphertext)[i];
+    }
+    for (i = 0; i < n * 8; i++) {
+      p[i] = ((const unsigned char *)ciphertext)[8 + i];
+    }
+    aes_kw_w_inverse(a, p, 0, n, 1, key);
+  }
+
+  /* MSB(32, A) = A65959A6, 8 * (n - 1) < MLI <= 8 * n, zero padding */
+  diff = (a[0] ^ 0xa6) | (a[1] ^ 0x59) | (a[2] ^ 0x59) | (a[3] ^ 0xa6);
+  mli = (unsigned)a[4] << 24 | a[5] << 16 | a[6] << 8 | a[7];
+  diff |= (mli <= (unsigned)(n - 1) * 8) | (mli > (unsigned)n * 8);
+  for (i = (n - 1) * 8; i < n * 8; i++) {
+    diff |= p[i] & (0 - ((unsigned)i >= mli));
+  }
+  diff = 0 - ((diff + 255) >> 8);  /* all ones if a check fails, else zero */
+  for (i = 0; i < n * 8; i++) {
+    p[i] &= ~diff;
+  }
+  return (int)((mli & ~diff) | diff);
+}
+
+/*
+ * Computes the AES Key Wrap algorithm.
+ * ciphertext: pointer to ((n + 1) * 8) bytes to store the ciphertext
+ * plaintext: pointer to (n * 8) bytes with the plaintext
+ * n: number of 8-byte blocks of the plaintext (n = length(plaintext) / 8)
+ * key: pointer to 16 bytes (128 bits) with the key encryption key
+ */
+static void aes_kw(void *ciphertext, const void *plaintext, int n, const void *key) {
+  struct aes_key expanded;
+
+  aes_set_key(&expanded, key);
+  aes_kw_wrap(ciphertext, plaintext, n, &expanded);
+}
@@ -8,74 +8,255 @@
  */
 
 /*
- * Computes the Matyas-Meyer-Oseas hash function based on the AES-128 block cipher.
+ * Implements the Matyas-Meyer-Oseas hash function based on the AES-128 block
+ * cipher, as the one-shot aes_mmo function, as the incremental
+ * aes_mmo_init, aes_mmo_update and aes_mmo_final functions, and as the
+ * aes_mmo_many function for many messages at once.
+ *
+ * Each message block is encrypted with the previous hash value as the key,
+ * so there is a new key for every block; with AES-NI, aes_encrypt expands
+ * it in registers along with the encryption.
  *
- * Uses the aes_encrypt function in aes.h, so you need to include that too:
+ * Uses the aes_encrypt and aes_encrypt_keys functions in aes.h, so you need to include that too:
  * #include "aes.h"
  * #include "aes-mmo.h"
  *
- * digest: pointer to 16 bytes (128 bits) of memory to store the message digest output
- * message: input message
- * length: number of bytes of the input message
- *
  * Reference:
  * ZigBee specification, document 05-3474-21, Aug 2015,
  * section B.6 Block-Cipher-Based Cryptographic Hash Function.
  */
-static void aes_mmo(void *digest, const void *message, int length) {
-  int i, r;
-  unsigned char p[16];
 
-  /* Hash0 = 0^(8n)  n-octet all-zero bit string */
-  for (i = 0; i < 16; i++) {
-    ((char *)digest)[i] = 0;
-  }
+/*
+ * Context of an incremental AES-MMO computation.
+ * digest: the intermediate hash value
+ * block: the bytes of the current partial block
+ * length: number of bytes hashed so far (less than 2^29)
+ */
+struct aes_mmo_context {
+  unsigned char digest[16];
+  unsigned char block[16];
+  unsigned long length;
+};
+
+/*
+ * Updates the intermediate hash value with count 16-byte message blocks.
+ * digest: pointer to the 16 bytes of the intermediate hash value to update
+ * blocks: pointer to count * 16 bytes of message blocks
+ * count: number of 16-byte message blocks
+ */
+static void aes_mmo_compress(unsigned char *digest, const void *blocks, int count) {
+  const unsigned char *p = (const unsigned char *)blocks;
+  int i;
 
   /* Hashj = E(Hashj-1,Mj) xor Mj */
-  for (r = 0; r <= length - 16; r += 16) {
-    aes_encrypt(digest, (char *)message + r, digest);
+  for (; count > 0; count--, p += 16) {
+    aes_encrypt(digest, p, digest);
     for (i = 0; i < 16; i++) {
-      ((char *)digest)[i] ^= ((char *)message)[r + i];
+      digest[i] ^= p[i];
     }
   }
+}
+
+/*
+ * Starts an incremental AES-MMO computation.
+ * ctx: pointer to the context to initialize
+ */
+static void aes_mmo_init(struct aes_mmo_context *ctx) {
+  int i;
 
-  /* Build and process the final padded block(s) */
-  r = length & 15;
-  for (i = 0; i < r; i++) {
-    p[i] = ((char *)message)[(length & ~15) + i];
+  /* Hash0 = 0^(8n)  n-octet all-zero bit string */
+  for (i = 0; i < 16; i++) {
+    ctx->digest[i] = 0;
   }
-  p[r++] = 0x80;
-  if ((length < 8192 && r > 14) || (length >= 8192 && r > 10)) {
-    /* The first of 2 padded blocks */
-    for (i = r; i < 16; i++) {
-      p[i] = 0;
+  ctx->length = 0;
+}
+
+/*
+ * Adds a part of the message to an incremental AES-MMO computation.
+ * The message can be split at any byte boundary.
+ * ctx: pointer to the context
+ * data: pointer to the next part of the message
+ * length: number of bytes of the part of the message
+ */
+static void aes_mmo_update(struct aes_mmo_context *ctx, const void *data, int length) {
+  const unsigned char *p;
+  int i, n;
+
+  p = (const unsigned char *)data;
+  n = ctx->length & 15;  /* bytes in the partial block */
+  ctx->length += length;
+
+  /* Complete the partial block */
+  if (n > 0) {
+    for (i = 0; n < 16 && i < length; i++) {
+      ctx->block[n++] = p[i];
     }
-    aes_encrypt(digest, p, digest);
-    for (i = 0; i < 16; i++) {
-      ((char *)digest)[i] ^= p[i];
+    if (n < 16) {
+      return;
     }
-    r = 0;
+    aes_mmo_compress(ctx->digest, ctx->block, 1);
+    p += i;
+    length -= i;
+  }
+
+  /* Process the full blocks directly from the message */
+  if (length >= 16) {
+    aes_mmo_compress(ctx->digest, p, length / 16);
+    p += length & ~15;
+    length &= 15;
+  }
+
+  /* Keep the remaining bytes for the next call */
+  for (i = 0; i < length; i++) {
+    ctx->block[i] = p[i];
+  }
+}
+
+/*
+ * Builds the final padded block(s) of a message.
+ * tail: pointer to 32 bytes of memory to store the padded blocks
+ * rest: pointer to the length % 16 bytes at the end of the message
+ * length: number of bytes of the whole message (less than 2^29)
+ * Returns the number of padded blocks, 1 or 2.
+ *
+ * The message length in bits is encoded in 16 bits for messages shorter than
+ * 2^16 bits (8192 bytes), or else in 32 bits followed by 16 zero bits, which
+ * depends only on the total length, not on how the message was split.
+ */
+static int aes_mmo_pad(unsigned char *tail, const void *rest, unsigned long length) {
+  unsigned long bits = length << 3;
+  int n, end;
+
+  end = length < 8192 ? 14 : 10;  /* start of the length field */
+  for (n = 0; n < (int)(length & 15); n++) {
+    tail[n] = ((const unsigned char *)rest)[n];
   }
-  /* The final padded block with the length in bits */
-  if (length < 8192) {
-    for (i = r; i < 14; i++) {
-      p[i] = 0;
+  tail[n++] = 0x80;
+  if (n > end) {  /* the first of 2 padded blocks */
+    while (n < 16) {
+      tail[n++] = 0;
     }
-    p[14] = length >> 5;
-    p[15] = length << 3;
+    end += 16;
+  }
+  while (n < end) {  /* the final padded block with the length in bits */
+    tail[n++] = 0;
+  }
+  if ((end & 15) == 14) {
+    tail[n++] = (unsigned char)(bits >> 8);
+    tail[n++] = (unsigned char)bits;
   } else {
-    for (i = r; i < 10; i++) {
-      p[i] = 0;
-    }
-    p[10] = length >> 21;
-    p[11] = length >> 13;
-    p[12] = length >> 5;
-    p[13] = length << 3;
-    p[14] = 0;
-    p[15] = 0;
+    tail[n++] = (unsigned char)(bits >> 24);
+    tail[n++] = (unsigned char)(bits >> 16);
+    tail[n++] = (unsigned char)(bits >> 8);
+    tail[n++] = (unsigned char)bits;
+    tail[n++] = 0;
+    tail[n++] = 0;
   }
-  aes_encrypt(digest, p, digest);
+  return n / 16;
+}
+
+/*
+ * Finishes an incremental AES-MMO computation.
+ * ctx: pointer to the context
+ * digest: pointer to 16 bytes (128 bits) of memory to store the message digest
+ */
+static void aes_mmo_final(struct aes_mmo_context *ctx, void *digest) {
+  unsigned char tail[32];
+  int i;
+
+  aes_mmo_compress(ctx->digest, tail, aes_mmo_pad(tail, ctx->block, ctx->length));
   for (i = 0; i < 16; i++) {
-    ((char *)digest)[i] ^= p[i];
+    ((unsigned char *)digest)[i] = ctx->digest[i];
+  }
+}
+
+/*
+ * Computes the Matyas-Meyer-Oseas hash function based on the AES-128 block cipher.
+ * digest: pointer to 16 bytes (128 bits) of memory to store the message digest output
+ * message: input message
+ * length: number of bytes of the input message
+ */
+static void aes_mmo(void *digest, const void *message, int length) {
+  struct aes_mmo_context ctx;
+
+  aes_mmo_init(&ctx);
+  aes_mmo_update(&ctx, message, length);
+  aes_mmo_final(&ctx, digest);
+}
+
+/*
+ * Computes the AES-MMO hash function of many independent messages, running
+ * the hash chains of up to 8 messages in lockstep: every step encrypts the
+ * next block of each message at once with aes_encrypt_keys, so that the
+ * latencies of the (inherently serial) blocks of one message are hidden
+ * behind those of the other messages. The messages can have different
+ * lengths; each one has its own padded blocks at the end of its chain, and
+ * its lane is taken by the next message as soon as it is done.
+ * digests: pointer to count * 16 bytes of memory to store the message digests
+ * messages: pointers to the count input messages
+ * lengths: number of bytes of each of the count input messages
+ * count: number of messages
+ */
+static void aes_mmo_many(void *digests, const void **messages, const int *lengths, int count) {
+  unsigned char keys[8 * 16], blocks[8 * 16], tails[8][32];
+  const unsigned char *p;
+  int message[8], block[8], full[8], total[8];  /* per lane */
+  int i, l, lanes, next;
+
+  lanes = 0;
+  next = 0;
+  for (;;) {
+    /* Start the next messages on the free lanes */
+    for (; lanes < 8 && next < count; lanes++, next++) {
+      p = (const unsigned char *)messages[next];
+      message[lanes] = next;
+      block[lanes] = 0;
+      full[lanes] = lengths[next] / 16;
+      total[lanes] = full[lanes] + aes_mmo_pad(tails[lanes], p + (lengths[next] & ~15), lengths[next]);
+      for (i = 0; i < 16; i++) {
+        keys[lanes * 16 + i] = 0;  /* Hash0 */
+      }
+    }
+    if (lanes == 0) {
+      break;
+    }
+
+    /* Hashj = E(Hashj-1,Mj) xor Mj, for the next block of each lane */
+    for (l = 0; l < lanes; l++) {
+      if (block[l] < full[l]) {
+        p = (const unsigned char *)messages[message[l]] + block[l] * 16;
+      } else {
+        p = tails[l] + (block[l] - full[l]) * 16;
+      }
+      for (i = 0; i < 16; i++) {
+        blocks[l * 16 + i] = p[i];
+      }
+    }
+    aes_encrypt_keys(keys, blocks, keys, lanes);
+    for (i = 0; i < lanes * 16; i++) {
+      keys[i] ^= blocks[i];
+    }
+
+    /* Store the digests of the finished messages, and free their lanes */
+    for (l = lanes - 1; l >= 0; l--) {
+      if (++block[l] < total[l]) {
+        continue;
+      }
+      for (i = 0; i < 16; i++) {
+        ((unsigned char *)digests)[message[l] * 16 + i] = keys[l * 16 + i];
+      }
+      if (l < --lanes) {  /* move the last lane into this one */
+        for (i = 0; i < 16; i++) {
+          keys[l * 16 + i] = keys[lanes * 16 + i];
+        }
+        for (i = 0; i < 32; i++) {
+          tails[l][i] = tails[lanes][i];
+        }
+        message[l] = message[lanes];
+        block[l] = block[lanes];
+        full[l] = full[lanes];
+        total[l] = total[lanes];
+      }
+    }
   }
 }
@@ -0,0 +1,342 @@
+/*
+ * aes-xts.h: AES XEX-based Tweaked-codebook mode with ciphertext Stealing (AES-XTS)
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/aes-xts.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Implements the XTS-AES-128 mode for the encryption of storage sectors
+ * (data units), with aes_xts_encrypt and aes_xts_decrypt for one sector and
+ * aes_xts_encrypt_sectors and aes_xts_decrypt_sectors for many consecutive
+ * sectors, with the two key schedules expanded once with aes_xts_set_key.
+ *
+ * Each block j of a sector is encrypted as CIPH_Key1(P_j xor T_j) xor T_j,
+ * with the tweaks T_0 = CIPH_Key2(sector number) and T_j+1 = T_j * x, so
+ * the blocks are independent: the tweaks of a run of up to 32 blocks are
+ * computed first (a shift and a conditional xor each, on 32-bit words, or
+ * in SSE2 registers along with AES-NI), and the blocks are then encrypted
+ * together with aes_encrypt_blocks (or decrypted with aes_decrypt_blocks),
+ * 8 in flight with AES-NI. The tweaks T_0 of up to 8 sectors are likewise
+ * encrypted together.
+ *
+ * A sector whose length is not a multiple of 16 bytes ends with ciphertext
+ * stealing, so the ciphertext has the same length as the plaintext.
+ *
+ * Uses the functions in aes.h and aes-decrypt.h, so you need to include those too:
+ * #include "aes.h"
+ * #include "aes-decrypt.h"
+ * #include "aes-xts.h"
+ *
+ * References:
+ * [XTS] IEEE Standard for Cryptographic Protection of Data on Block-Oriented
+ *       Storage Devices, IEEE Std 1619-2007
+ * [SP800-38E] Recommendation for Block Cipher Modes of Operation: the
+ *             XTS-AES Mode for Confidentiality on Storage Devices,
+ *             NIST Special Publication 800-38E, Jan 2010
+ */
+
+/*
+ * The two expanded keys of XTS-AES-128.
+ * key1: the key schedule of Key1, for the data
+ * key2: the key schedule of Key2, for the tweaks
+ */
+struct aes_xts_key {
+  struct aes_key key1;
+  struct aes_key key2;
+};
+
+/*
+ * Expands the two keys of XTS-AES-128 (the 256-bit XTS key Key1 || Key2).
+ * key: pointer to the keys to initialize
+ * key1: pointer to the 16 bytes of Key1, the first half of the XTS key
+ * key2: pointer to the 16 bytes of Key2, the second half of the XTS key,
+ *       which must differ from Key1 ([SP800-38E] 5.1)
+ */
+static void aes_xts_set_key(struct aes_xts_key *key, const void *key1, const void *key2) {
+  aes_set_key(&key->key1, key1);
+  aes_set_key(&key->key2, key2);
+}
+
+/*
+ * Multiplies a tweak by the primitive element alpha (x) in GF(2^128):
+ * shifts it left by one bit, and xors 0x87 into it on a carry.
+ * t: the tweak, as 4 32-bit words, least significant first
+ *
+ * [XTS] 5.2 Multiplication by a primitive element alpha
+ */
+static void aes_xts_double(unsigned *t) {
+  unsigned carry = t[3] >> 31;
+
+  t[3] = (t[3] << 1 | t[2] >> 31) & 0xffffffff;
+  t[2] = (t[2] << 1 | t[1] >> 31) & 0xffffffff;
+  t[1] = (t[1] << 1 | t[0] >> 31) & 0xffffffff;
+  t[0] = ((t[0] << 1) ^ ((0 - carry) & 0x87)) & 0xffffffff;
+}
+
+/*
+ * Portable implementation of aes_xts_blocks.
+ */
+static void aes_xts_blocks_generic(unsigned char *output, const unsigned char *input, int n, unsigned *t, int decrypt, const struct aes_key *key) {
+  unsigned char tweaks[32 * 16], blocks[32 * 16];
+  unsigned w[4];
+  int i, j;
+
+  /* T_j+1 = T_j * alpha, in local words */
+  for (i = 0; i < 4; i++) {
+    w[i] = t[i];
+  }
+  for (j = 0; j < n; j++) {
+    for (i = 0; i < 16; i++) {
+      tweaks[j * 16 + i] = (unsigned char)(w[i / 4] >> (i % 4 * 8));
+    }
+    aes_xts_double(w);
+  }
+  for (i = 0; i < 4; i++) {
+    t[i] = w[i];
+  }
+
+  /* C_j = CIPH_Key1(P_j xor T_j) xor T_j */
+  for (i = 0; i < n * 16; i++) {
+    blocks[i] = input[i] ^ tweaks[i];
+  }
+  if (decrypt) {
+    aes_decrypt_blocks(blocks, blocks, n, key);
+  } else {
+    aes_encrypt_blocks(blocks, blocks, n, key);
+  }
+  for (i = 0; i < n * 16; i++) {
+    output[i] = blocks[i] ^ tweaks[i];
+  }
+}
+
+#ifdef AES_NI
+/*
+ * Implementation of aes_xts_blocks with SSE2 (which all the processors with
+ * AES-NI have), with the tweaks in 128-bit registers and the xors 16 bytes
+ * at a time; the portable code spends more time on those than on the AES-NI
+ * rounds. The tweak is multiplied by alpha with a shift of its two 64-bit
+ * halves, and the bits shifted out of them moved to the other half (the
+ * carry out of the whole tweak as 0x87).
+ */
+__attribute__((target("sse2")))
+static void aes_xts_blocks_sse2(unsigned char *output, const unsigned char *input, int n, unsigned *t, int decrypt, const struct aes_key *key) {
+  __m128i tweaks[32], blocks[32], w, carries;
+  const __m128i alpha = _mm_set_epi32(0, 1, 0, 0x87);
+  int j;
+
+  w = _mm_set_epi32((int)t[3], (int)t[2], (int)t[1], (int)t[0]);
+  for (j = 0; j < n; j++) {
+    tweaks[j] = w;
+    blocks[j] = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(const void *)(input + j * 16)), w);
+    carries = _mm_shuffle_epi32(_mm_srai_epi32(w, 31), 0x13);  /* the top bits of words 3 and 1 into 0 and 2 */
+    w = _mm_xor_si128(_mm_add_epi64(w, w), _mm_and_si128(carries, alpha));
+  }
+  t[0] = (unsigned)_mm_cvtsi128_si32(w);
+  t[1] = (unsigned)_mm_cvtsi128_si32(_mm_shuffle_epi32(w, 0x01));
+  t[2] = (unsigned)_mm_cvtsi128_si32(_mm_shuffle_epi32(w, 0x02));
+  t[3] = (unsigned)_mm_cvtsi128_si32(_mm_shuffle_epi32(w, 0x03));
+
+  if (decrypt) {
+    aes_decrypt_blocks(blocks, blocks, n, key);
+  } else {
+    aes_encrypt_blocks(blocks, blocks, n, key);
+  }
+  for (j = 0; j < n; j++) {
+    _mm_storeu_si128((__m128i *)(void *)(output + j * 16), _mm_xor_si128(blocks[j], tweaks[j]));
+  }
+}
+#endif
+
+/*
+ * Internal function that encrypts or decrypts up to 32 blocks of a sector,
+ * and advances the tweak past them, using the fastest implementation
+ * available on the processor.
+ * output: pointer to n * 16 bytes of memory to store the output blocks
+ * input: pointer to n * 16 bytes with the input blocks
+ * n: number of blocks (1 to 32)
+ * t: the tweak of the first block, as 4 32-bit words, least significant first
+ * decrypt: nonzero to decrypt, zero to encrypt
+ * key: pointer to the key schedule of Key1
+ * The output and input may point to the same memory.
+ */
+static void aes_xts_blocks(unsigned char *output, const unsigned char *input, int n, unsigned *t, int decrypt, const struct aes_key *key) {
+#ifdef AES_NI
+  if (crumbs_cpu_has(CRUMBS_CPU_AESNI)) {
+    aes_xts_blocks_sse2(output, input, n, t, decrypt, key);
+    return;
+  }
+#endif
+  aes_xts_blocks_generic(output, input, n, t, decrypt, key);
+}
+
+/*
+ * Internal function that encrypts or decrypts a sector with its encrypted tweak.
+ * output: pointer to length bytes of memory to store the output
+ * input: pointer to length bytes with the input
+ * length: number of bytes of the sector, at least 16
+ * tweak: pointer to the 16 bytes of T_0, the encrypted sector number
+ * decrypt: nonzero to decrypt, zero to encrypt
+ * key: pointer to the expanded keys
+ * The output and input may point to the same memory.
+ *
+ * [XTS] 5.3.2 XTS-AES encryption procedure, 5.4.2 XTS-AES decryption procedure
+ */
+static void aes_xts_sector(unsigned char *output, const unsigned char *input, int length, const unsigned char *tweak, int decrypt, const struct aes_xts_key *key) {
+  unsigned char block[16], stolen[16];
+  unsigned t[4], u[4];
+  int i, j, n, full, r;
+
+  for (i = 0; i < 4; i++) {
+    t[i] = (unsigned)tweak[i * 4] | (unsigned)tweak[i * 4 + 1] << 8 |
+           (unsigned)tweak[i * 4 + 2] << 16 | (unsigned)tweak[i * 4 + 3] << 24;
+  }
+
+  /* The whole blocks, but the last one when it is followed by a partial block */
+  r = length % 16;
+  full = r ? length / 16 - 1 : length / 16;
+  for (j = 0; j < full; j += n) {
+    n = full - j < 32 ? full - j : 32;
+    aes_xts_blocks(output + j * 16, input + j * 16, n, t, decrypt, &key->key1);
+  }
+  if (r == 0) {
+    return;
+  }
+
+  /* Ciphertext stealing: the partial block m takes the tail of the output
+     of block m-1, which moves to the partial block (read first, in place) */
+  input += full * 16;
+  output += full * 16;
+  for (i = 0; i < r; i++) {
+    stolen[i] = input[16 + i];
+  }
+  if (!decrypt) {
+    /* CC with T_m-1; C_m = the head of CC; C_m-1 = (P_m || the tail of CC) with T_m */
+    aes_xts_blocks(block, input, 1, t, 0, &key->key1);
+  } else {
+    /* PP with T_m; P_m = the head of PP; P_m-1 = (C_m || the tail of PP) with T_m-1 */
+    for (i = 0; i < 4; i++) {
+      u[i] = t[i];
+    }
+    aes_xts_double(t);
+    aes_xts_blocks(block, input, 1, t, 1, &key->key1);
+    for (i = 0; i < 4; i++) {
+      t[i] = u[i];
+    }
+  }
+  for (i = r; i < 16; i++) {
+    stolen[i] = block[i];
+  }
+  for (i = 0; i < r; i++) {
+    output[16 + i] = block[i];
+  }
+  aes_xts_blocks(output, stolen, 1, t, decrypt, &key->key1);
+}
+
+/*
+ * Internal function that encrypts or decrypts consecutive sectors.
+ * Same parameters as aes_xts_encrypt_sectors, and decrypt: nonzero to
+ * decrypt, zero to encrypt.
+ */
+static int aes_xts_sectors(void *output, const void *input, int sector_size, int count, const void *sector,
+                           int decrypt, const struct aes_xts_key *key) {
+  const unsigned char *in = (const unsigned char *)input;
+  unsigned char *out = (unsigned char *)output;
+  unsigned char tweaks[8 * 16], number[16];
+  int i, l, m;
+
+  if (sector_size < 16) {
+    return -1;
+  }
+  for (i = 0; i < 16; i++) {
+    number[i] = ((const unsigned char *)sector)[i];
+  }
+  for (; count > 0; count -= m) {
+    /* T_0 = CIPH_Key2(i) for the next 8 sectors at once */
+    m = count < 8 ? count : 8;
+    for (l = 0; l < m; l++) {
+      for (i = 0; i < 16; i++) {
+        tweaks[l * 16 + i] = number[i];
+      }
+      for (i = 0; i < 16; i++) {  /* the next sector number */
+        if (++number[i] != 0) {
+          break;
+        }
+      }
+    }
+    aes_encrypt_blocks(tweaks, tweaks, m, &key->key2);
+    for (l = 0; l < m; l++, in += sector_size, out += sector_size) {
+      aes_xts_sector(out, in, sector_size, tweaks + l * 16, decrypt, key);
+    }
+  }
+  return 0;
+}
+
+/*
+ * Encrypts consecutive sectors with XTS-AES-128.
+ * output: pointer to count * sector_size bytes of memory to store the ciphertext
+ * input: pointer to count * sector_size bytes with the plaintext
+ * sector_size: number of bytes of each sector (data unit), at least 16
+ *              (as 512 or 4096, or not a multiple of 16)
+ * count: number of sectors
+ * sector: pointer to the 16-byte number of the first sector (the tweak i),
+ *         little-endian, incremented for each of the next sectors
+ * key: pointer to the keys expanded with aes_xts_set_key
+ * Returns 0 on success, or -1 if sector_size is less than 16.
+ * The output and input may point to the same memory.
+ *
+ * [XTS] 5.3 XTS-AES encryption procedure
+ */
+static int aes_xts_encrypt_sectors(void *output, const void *input, int sector_size, int count, const void *sector,
+                                   const struct aes_xts_key *key) {
+  return aes_xts_sectors(output, input, sector_size, count, sector, 0, key);
+}
+
+/*
+ * Decrypts consecutive sectors with XTS-AES-128.
+ * output: pointer to count * sector_size bytes of memory to store the plaintext
+ * input: pointer to count * sector_size bytes with the ciphertext
+ * sector_size: number of bytes of each sector (data unit), at least 16
+ * count: number of sectors
+ * sector: pointer to the 16-byte number of the first sector (the tweak i),
+ *         little-endian, incremented for each of the next sectors
+ * key: pointer to the keys expanded with aes_xts_set_key
+ * Returns 0 on success, or -1 if sector_size is less than 16.
+ * The output and input may point to the same memory.
+ *
+ * [XTS] 5.4 XTS-AES decryption procedure
+ */
+static int aes_xts_decrypt_sectors(void *output, const void *input, int sector_size, int count, const void *sector,
+                                   const struct aes_xts_key *key) {
+  return aes_xts_sectors(output, input, sector_size, count, sector, 1, key);
+}
+
+/*
+ * Encrypts one sector with XTS-AES-128.
+ * output: pointer to length bytes of memory to store the ciphertext
+ * input: pointer to length bytes with the plaintext
+ * length: number of bytes of the sector, at least 16
+ * sector: pointer to the 16-byte number of the sector (the tweak i), little-endian
+ * key: pointer to the keys expanded with aes_xts_set_key
+ * Returns 0 on success, or -1 if length is less than 16.
+ * The output and input may point to the same memory.
+ */
+static int aes_xts_encrypt(void *output, const void *input, int length, const void *sector, const struct aes_xts_key *key) {
+  return aes_xts_encrypt_sectors(output, input, length, 1, sector, key);
+}
+
+/*
+ * Decrypts one sector with XTS-AES-128.
+ * output: pointer to length bytes of memory to store the plaintext
+ * input: pointer to length bytes with the ciphertext
+ * length: number of bytes of the sector, at least 16
+ * sector: pointer to the 16-byte number of the sector (the tweak i), little-endian
+ * key: pointer to the keys expanded with aes_xts_set_key
+ * Returns 0 on success, or -1 if length is less than 16.
+ * The output and input may point to the same memory.
+ */
+static int aes_xts_decrypt(void *output, const void *input, int length, const void *sector, const struct aes_xts_key *key) {
+  return aes_xts_decrypt_sectors(output, input, length, 1, sector, key);
+}
@@ -10,11 +10,36 @@
 /*
  * Implements the AES encryption algorithm for 128-bit keys (AES-128).
  *
+ * The key expansion can be done once with aes_set_key, for the functions
+ * that encrypt many blocks with the same key (aes_encrypt_block and
+ * aes_encrypt_blocks), or along with the encryption of each block, for
+ * the functions that encrypt one block per key (aes_encrypt and
+ * aes_encrypt_keys).
+ *
+ * The blocks are encrypted with the AES-NI instructions on x86 processors
+ * that have them (detected at run time, with GCC or Clang), with up to 8
+ * independent blocks in flight for aes_encrypt_blocks, and with the round
+ * keys generated in registers just ahead of the rounds that use them for
+ * aes_encrypt and aes_encrypt_keys (with up to 8 different keys in flight).
+ * This makes a new key for every block (as in the AES-MMO hash function)
+ * almost as cheap as an expanded one.
+ *
+ * The processor features are detected with crumbs-cpu.h, which needs to be
+ * in the same directory (and where the code paths can be pinned).
+ *
  * References:
  * [AES] Advanced Encryption Standard (AES), FIPS 197, Nov 26 2001.
  *       http://csrc.nist.gov/publications/fips/fips197/fips-197.pdf
+ * [AESNI] Intel Advanced Encryption Standard (AES) New Instructions Set,
+ *         Shay Gueron, Intel, Rev 3.01, Sep 2012
  */
 
+#include "crumbs-cpu.h"
+
+#ifdef CRUMBS_CPU_X86
+#define AES_NI
+#endif
+
 /*
  * Multiply the binary polynomial b with the polynomial x.
  * [AES] 4.2.1 Multiplication by x.
@@ -27,51 +52,93 @@ static unsigned char aes_xtime(unsigned char b) {
   return bx;
 }
 
+/* [AES] 5.1.1 SubBytes() transformation: S-box */
+static const unsigned char aes_sbox[256] = {
+  0x63,0x7c,0x77,0x7b,0xf2,0x6b,0x6f,0xc5,0x30,0x01,0x67,0x2b,0xfe,0xd7,0xab,0x76,
+  0xca,0x82,0xc9,0x7d,0xfa,0x59,0x47,0xf0,0xad,0xd4,0xa2,0xaf,0x9c,0xa4,0x72,0xc0,
+  0xb7,0xfd,0x93,0x26,0x36,0x3f,0xf7,0xcc,0x34,0xa5,0xe5,0xf1,0x71,0xd8,0x31,0x15,
+  0x04,0xc7,0x23,0xc3,0x18,0x96,0x05,0x9a,0x07,0x12,0x80,0xe2,0xeb,0x27,0xb2,0x75,
+  0x09,0x83,0x2c,0x1a,0x1b,0x6e,0x5a,0xa0,0x52,0x3b,0xd6,0xb3,0x29,0xe3,0x2f,0x84,
+  0x53,0xd1,0x00,0xed,0x20,0xfc,0xb1,0x5b,0x6a,0xcb,0xbe,0x39,0x4a,0x4c,0x58,0xcf,
+  0xd0,0xef,0xaa,0xfb,0x43,0x4d,0x33,0x85,0x45,0xf9,0x02,0x7f,0x50,0x3c,0x9f,0xa8,
+  0x51,0xa3,0x40,0x8f,0x92,0x9d,0x38,0xf5,0xbc,0xb6,0xda,0x21,0x10,0xff,0xf3,0xd2,
+  0xcd,0x0c,0x13,0xec,0x5f,0x97,0x44,0x17,0xc4,0xa7,0x7e,0x3d,0x64,0x5d,0x19,0x73,
+  0x60,0x81,0x4f,0xdc,0x22,0x2a,0x90,0x88,0x46,0xee,0xb8,0x14,0xde,0x5e,0x0b,0xdb,
+  0xe0,0x32,0x3a,0x0a,0x49,0x06,0x24,0x5c,0xc2,0xd3,0xac,0x62,0x91,0x95,0xe4,0x79,
+  0xe7,0xc8,0x37,0x6d,0x8d,0xd5,0x4e,0xa9,0x6c,0x56,0xf4,0xea,0x65,0x7a,0xae,0x08,
+  0xba,0x78,0x25,0x2e,0x1c,0xa6,0xb4,0xc6,0xe8,0xdd,0x74,0x1f,0x4b,0xbd,0x8b,0x8a,
+  0x70,0x3e,0xb5,0x66,0x48,0x03,0xf6,0x0e,0x61,0x35,0x57,0xb9,0x86,0xc1,0x1d,0x9e,
+  0xe1,0xf8,0x98,0x11,0x69,0xd9,0x8e,0x94,0x9b,0x1e,0x87,0xe9,0xce,0x55,0x28,0xdf,
+  0x8c,0xa1,0x89,0x0d,0xbf,0xe6,0x42,0x68,0x41,0x99,0x2d,0x0f,0xb0,0x54,0xbb,0x16
+};
+
 /*
- * Performs the AES cipher transform (encryption) for Nk=4 (AES-128).
- * output: pointer to 64 bytes (128 bits) of memory to store the ciphertext
- * intput: pointer to 64 bytes (128 bits) of memory with the plaintext
- * key: pointer to 64 bytes (128 bits) of memory with the cipher key
+ * Expanded cipher key (key schedule) for AES-128.
+ * w: the 44 words of the key schedule, 4 bytes each, in 11 round keys of 16 bytes
  */
-static void aes_encrypt(void *output, const void *input, const void *key) {
-  /* [AES] 5.1.1 SubBytes() transformation */
-  const unsigned char sbox[256] = {
-    0x63,0x7c,0x77,0x7b,0xf2,0x6b,0x6f,0xc5,0x30,0x01,0x67,0x2b,0xfe,0xd7,0xab,0x76,
-    0xca,0x82,0xc9,0x7d,0xfa,0x59,0x47,0xf0,0xad,0xd4,0xa2,0xaf,0x9c,0xa4,0x72,0xc0,
-    0xb7,0xfd,0x93,0x26,0x36,0x3f,0xf7,0xcc,0x34,0xa5,0xe5,0xf1,0x71,0xd8,0x31,0x15,
-    0x04,0xc7,0x23,0xc3,0x18,0x96,0x05,0x9a,0x07,0x12,0x80,0xe2,0xeb,0x27,0xb2,0x75,
-    0x09,0x83,0x2c,0x1a,0x1b,0x6e,0x5a,0xa0,0x52,0x3b,0xd6,0xb3,0x29,0xe3,0x2f,0x84,
-    0x53,0xd1,0x00,0xed,0x20,0xfc,0xb1,0x5b,0x6a,0xcb,0xbe,0x39,0x4a,0x4c,0x58,0xcf,
-    0xd0,0xef,0xaa,0xfb,0x43,0x4d,0x33,0x85,0x45,0xf9,0x02,0x7f,0x50,0x3c,0x9f,0xa8,
-    0x51,0xa3,0x40,0x8f,0x92,0x9d,0x38,0xf5,0xbc,0xb6,0xda,0x21,0x10,0xff,0xf3,0xd2,
-    0xcd,0x0c,0x13,0xec,0x5f,0x97,0x44,0x17,0xc4,0xa7,0x7e,0x3d,0x64,0x5d,0x19,0x73,
-    0x60,0x81,0x4f,0xdc,0x22,0x2a,0x90,0x88,0x46,0xee,0xb8,0x14,0xde,0x5e,0x0b,0xdb,
-    0xe0,0x32,0x3a,0x0a,0x49,0x06,0x24,0x5c,0xc2,0xd3,0xac,0x62,0x91,0x95,0xe4,0x79,
-    0xe7,0xc8,0x37,0x6d,0x8d,0xd5,0x4e,0xa9,0x6c,0x56,0xf4,0xea,0x65,0x7a,0xae,0x08,
-    0xba,0x78,0x25,0x2e,0x1c,0xa6,0xb4,0xc6,0xe8,0xdd,0x74,0x1f,0x4b,0xbd,0x8b,0x8a,
-    0x70,0x3e,0xb5,0x66,0x48,0x03,0xf6,0x0e,0x61,0x35,0x57,0xb9,0x86,0xc1,0x1d,0x9e,
-    0xe1,0xf8,0x98,0x11,0x69,0xd9,0x8e,0x94,0x9b,0x1e,0x87,0xe9,0xce,0x55,0x28,0xdf,
-    0x8c,0xa1,0x89,0x0d,0xbf,0xe6,0x42,0x68,0x41,0x99,0x2d,0x0f,0xb0,0x54,0xbb,0x16
-  };
+struct aes_key {
+  unsigned char w[176];
+};
+
+/*
+ * Expands a cipher key into the key schedule.
+ * expanded: pointer to the key schedule to initialize
+ * key: pointer to 16 bytes (128 bits) of memory with the cipher key
+ *
+ * [AES] 5.2 Key Expansion
+ */
+static void aes_set_key(struct aes_key *expanded, const void *key) {
+  unsigned char *w = expanded->w;
+  unsigned char rcon;
+  int i;
+
+  for (i = 0; i < 16; i++) {
+    w[i] = ((unsigned char *)key)[i];
+  }
+  rcon = 1;
+  for (i = 16; i < 176; i += 4) {
+    if (i % 16 == 0) {  /* temp = SubWord(RotWord(temp)) xor Rcon[i/Nk] */
+      w[i + 0] = w[i - 16] ^ aes_sbox[w[i - 3]] ^ rcon;
+      w[i + 1] = w[i - 15] ^ aes_sbox[w[i - 2]];
+      w[i + 2] = w[i - 14] ^ aes_sbox[w[i - 1]];
+      w[i + 3] = w[i - 13] ^ aes_sbox[w[i - 4]];
+      rcon = aes_xtime(rcon);
+    } else {
+      w[i + 0] = w[i - 16] ^ w[i - 4];
+      w[i + 1] = w[i - 15] ^ w[i - 3];
+      w[i + 2] = w[i - 14] ^ w[i - 2];
+      w[i + 3] = w[i - 13] ^ w[i - 1];
+    }
+  }
+}
+
+/*
+ * Portable implementation of the AES cipher transform (encryption)
+ * of one block with an expanded key.
+ * output: pointer to 16 bytes (128 bits) of memory to store the ciphertext
+ * input: pointer to 16 bytes (128 bits) of memory with the plaintext
+ * key: pointer to the key schedule, initialized with aes_set_key
+ * The output and input may point to the same memory.
+ *
+ * [AES] 5.1 Cipher
+ */
+static void aes_encrypt_generic(void *output, const void *input, const struct aes_key *key) {
+  const unsigned char *w = key->w;
   unsigned char *state;
-  unsigned char key_schedule[16];
   unsigned char a, b, c, d;
   unsigned char a1, a2, a3, b1, b2, b3, c1, c2, c3, d1, d2, d3;
-  unsigned char rcon;
   int i, round;
 
   /* [AES] 5.1.4 AddRoundKey() transformation (initial round key addition) */
   state = (unsigned char *)output;
   for (i = 0; i < 16; i++) {
-    key_schedule[i] = ((unsigned char *)key)[i];
-    state[i] = ((unsigned char *)input)[i] ^ key_schedule[i];
+    state[i] = ((unsigned char *)input)[i] ^ w[i];
   }
 
-  rcon = 1;
   for (round = 1; round <= 10; round++) {
     /* [AES] 5.1.1 SubBytes() transformation */
     for (i = 0; i < 16; i++) {
-      state[i] = sbox[state[i]];
+      state[i] = aes_sbox[state[i]];
     }
 
     /* [AES] 5.1.2 ShiftRows() transformation */
@@ -96,20 +163,281 @@ static void aes_encrypt(void *output, const void *input, const void *key) {
       }
     }
 
-    /* [AES] 5.2 Key expansion */
-    key_schedule[0] ^= rcon;
-    rcon = aes_xtime(rcon);
-    key_schedule[0] ^= sbox[key_schedule[13]];
-    key_schedule[1] ^= sbox[key_schedule[14]];
-    key_schedule[2] ^= sbox[key_schedule[15]];
-    key_schedule[3] ^= sbox[key_schedule[12]];
-    for (i = 4; i < 16; i++) {
-      key_schedule[i] ^= key_schedule[i - 4];
-    }
-
     /* [AES] 5.1.4 AddRoundKey() transformation */
     for (i = 0; i < 16; i++) {
-      state[i] ^= key_schedule[i];
+      state[i] ^= w[round * 16 + i];
     }
   }
 }
+
+#ifdef AES_NI
+/*
+ * Implementation of the AES cipher transform with the AES-NI instructions,
+ * for count independent blocks, 8 (or 4) at a time so that the latency of
+ * each AESENC instruction is hidden behind those of the other blocks.
+ * Same parameters as aes_encrypt_blocks.
+ *
+ * [AESNI] Figure 38: AES-128 Encryption (parallelizing 8 blocks)
+ */
+__attribute__((target("aes")))
+static void aes_encrypt_aesni(void *output, const void *input, int count, const struct aes_key *key) {
+  const __m128i *in = (const __m128i *)input;
+  __m128i *out = (__m128i *)output;
+  __m128i k[11], b0, b1, b2, b3, b4, b5, b6, b7;
+  int i;
+
+  for (i = 0; i < 11; i++) {
+    k[i] = _mm_loadu_si128((const __m128i *)(const void *)(key->w + i * 16));
+  }
+  for (; count >= 8; count -= 8, in += 8, out += 8) {
+    b0 = _mm_xor_si128(_mm_loadu_si128(in + 0), k[0]);
+    b1 = _mm_xor_si128(_mm_loadu_si128(in + 1), k[0]);
+    b2 = _mm_xor_si128(_mm_loadu_si128(in + 2), k[0]);
+    b3 = _mm_xor_si128(_mm_loadu_si128(in + 3), k[0]);
+    b4 = _mm_xor_si128(_mm_loadu_si128(in + 4), k[0]);
+    b5 = _mm_xor_si128(_mm_loadu_si128(in + 5), k[0]);
+    b6 = _mm_xor_si128(_mm_loadu_si128(in + 6), k[0]);
+    b7 = _mm_xor_si128(_mm_loadu_si128(in + 7), k[0]);
+    for (i = 1; i < 10; i++) {
+      b0 = _mm_aesenc_si128(b0, k[i]);
+      b1 = _mm_aesenc_si128(b1, k[i]);
+      b2 = _mm_aesenc_si128(b2, k[i]);
+      b3 = _mm_aesenc_si128(b3, k[i]);
+      b4 = _mm_aesenc_si128(b4, k[i]);
+      b5 = _mm_aesenc_si128(b5, k[i]);
+      b6 = _mm_aesenc_si128(b6, k[i]);
+      b7 = _mm_aesenc_si128(b7, k[i]);
+    }
+    _mm_storeu_si128(out + 0, _mm_aesenclast_si128(b0, k[10]));
+    _mm_storeu_si128(out + 1, _mm_aesenclast_si128(b1, k[10]));
+    _mm_storeu_si128(out + 2, _mm_aesenclast_si128(b2, k[10]));
+    _mm_storeu_si128(out + 3, _mm_aesenclast_si128(b3, k[10]));
+    _mm_storeu_si128(out + 4, _mm_aesenclast_si128(b4, k[10]));
+    _mm_storeu_si128(out + 5, _mm_aesenclast_si128(b5, k[10]));
+    _mm_storeu_si128(out + 6, _mm_aesenclast_si128(b6, k[10]));
+    _mm_storeu_si128(out + 7, _mm_aesenclast_si128(b7, k[10]));
+  }
+  for (; count >= 4; count -= 4, in += 4, out += 4) {
+    b0 = _mm_xor_si128(_mm_loadu_si128(in + 0), k[0]);
+    b1 = _mm_xor_si128(_mm_loadu_si128(in + 1), k[0]);
+    b2 = _mm_xor_si128(_mm_loadu_si128(in + 2), k[0]);
+    b3 = _mm_xor_si128(_mm_loadu_si128(in + 3), k[0]);
+    for (i = 1; i < 10; i++) {
+      b0 = _mm_aesenc_si128(b0, k[i]);
+      b1 = _mm_aesenc_si128(b1, k[i]);
+      b2 = _mm_aesenc_si128(b2, k[i]);
+      b3 = _mm_aesenc_si128(b3, k[i]);
+    }
+    _mm_storeu_si128(out + 0, _mm_aesenclast_si128(b0, k[10]));
+    _mm_storeu_si128(out + 1, _mm_aesenclast_si128(b1, k[10]));
+    _mm_storeu_si128(out + 2, _mm_aesenclast_si128(b2, k[10]));
+    _mm_storeu_si128(out + 3, _mm_aesenclast_si128(b3, k[10]));
+  }
+  for (; count > 0; count--, in++, out++) {
+    b0 = _mm_xor_si128(_mm_loadu_si128(in), k[0]);
+    for (i = 1; i < 10; i++) {
+      b0 = _mm_aesenc_si128(b0, k[i]);
+    }
+    _mm_storeu_si128(out, _mm_aesenclast_si128(b0, k[10]));
+  }
+}
+
+/*
+ * Computes the next round key from the previous one and SubWord(RotWord(temp))
+ * xor Rcon in the last word of assist (as computed by AESKEYGENASSIST).
+ *
+ * [AESNI] AES-128 Key Expansion
+ */
+__attribute__((target("aes")))
+static __m128i aes_next_key_aesni(__m128i key, __m128i assist) {
+  assist = _mm_shuffle_epi32(assist, 0xff);
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  return _mm_xor_si128(key, assist);
+}
+
+/*
+ * Implementation of the AES cipher transform with the AES-NI instructions,
+ * for count blocks with a different cipher key each, 8 (or 4) at a time so
+ * that the latencies of the key expansions and of the rounds of each block
+ * are hidden behind those of the other blocks. Same parameters as
+ * aes_encrypt_keys.
+ *
+ * Instead of AESKEYGENASSIST, which takes the round constant as an
+ * immediate operand and has about twice the latency on some processors,
+ * SubWord(RotWord(temp)) xor Rcon is computed with AESENCLAST on the last
+ * word of the previous round key broadcast to all columns (on which
+ * ShiftRows has no effect), with the round constant in a register.
+ */
+__attribute__((target("aes,ssse3")))
+static void aes_encrypt_keys_aesni(void *output, const void *input, const void *keys, int count) {
+  const unsigned char rcon[10] = {0x01,0x02,0x04,0x08,0x10,0x20,0x40,0x80,0x1b,0x36};
+  const __m128i *in = (const __m128i *)input;
+  const __m128i *key = (const __m128i *)keys;
+  __m128i *out = (__m128i *)output;
+  __m128i rotword, r, k0, k1, k2, k3, k4, k5, k6, k7, b0, b1, b2, b3, b4, b5, b6, b7;
+  int i;
+
+  rotword = _mm_set_epi8(12,15,14,13, 12,15,14,13, 12,15,14,13, 12,15,14,13);
+  for (; count >= 8; count -= 8, in += 8, key += 8, out += 8) {
+    k0 = _mm_loadu_si128(key + 0);
+    k1 = _mm_loadu_si128(key + 1);
+    k2 = _mm_loadu_si128(key + 2);
+    k3 = _mm_loadu_si128(key + 3);
+    k4 = _mm_loadu_si128(key + 4);
+    k5 = _mm_loadu_si128(key + 5);
+    k6 = _mm_loadu_si128(key + 6);
+    k7 = _mm_loadu_si128(key + 7);
+    b0 = _mm_xor_si128(_mm_loadu_si128(in + 0), k0);
+    b1 = _mm_xor_si128(_mm_loadu_si128(in + 1), k1);
+    b2 = _mm_xor_si128(_mm_loadu_si128(in + 2), k2);
+    b3 = _mm_xor_si128(_mm_loadu_si128(in + 3), k3);
+    b4 = _mm_xor_si128(_mm_loadu_si128(in + 4), k4);
+    b5 = _mm_xor_si128(_mm_loadu_si128(in + 5), k5);
+    b6 = _mm_xor_si128(_mm_loadu_si128(in + 6), k6);
+    b7 = _mm_xor_si128(_mm_loadu_si128(in + 7), k7);
+    for (i = 0; i < 10; i++) {
+      r = _mm_set1_epi32(rcon[i]);
+      k0 = aes_next_key_aesni(k0, _mm_aesenclast_si128(_mm_shuffle_epi8(k0, rotword), r));
+      k1 = aes_next_key_aesni(k1, _mm_aesenclast_si128(_mm_shuffle_epi8(k1, rotword), r));
+      k2 = aes_next_key_aesni(k2, _mm_aesenclast_si128(_mm_shuffle_epi8(k2, rotword), r));
+      k3 = aes_next_key_aesni(k3, _mm_aesenclast_si128(_mm_shuffle_epi8(k3, rotword), r));
+      k4 = aes_next_key_aesni(k4, _mm_aesenclast_si128(_mm_shuffle_epi8(k4, rotword), r));
+      k5 = aes_next_key_aesni(k5, _mm_aesenclast_si128(_mm_shuffle_epi8(k5, rotword), r));
+      k6 = aes_next_key_aesni(k6, _mm_aesenclast_si128(_mm_shuffle_epi8(k6, rotword), r));
+      k7 = aes_next_key_aesni(k7, _mm_aesenclast_si128(_mm_shuffle_epi8(k7, rotword), r));
+      if (i < 9) {
+        b0 = _mm_aesenc_si128(b0, k0);
+        b1 = _mm_aesenc_si128(b1, k1);
+        b2 = _mm_aesenc_si128(b2, k2);
+        b3 = _mm_aesenc_si128(b3, k3);
+        b4 = _mm_aesenc_si128(b4, k4);
+        b5 = _mm_aesenc_si128(b5, k5);
+        b6 = _mm_aesenc_si128(b6, k6);
+        b7 = _mm_aesenc_si128(b7, k7);
+      }
+    }
+    _mm_storeu_si128(out + 0, _mm_aesenclast_si128(b0, k0));
+    _mm_storeu_si128(out + 1, _mm_aesenclast_si128(b1, k1));
+    _mm_storeu_si128(out + 2, _mm_aesenclast_si128(b2, k2));
+    _mm_storeu_si128(out + 3, _mm_aesenclast_si128(b3, k3));
+    _mm_storeu_si128(out + 4, _mm_aesenclast_si128(b4, k4));
+    _mm_storeu_si128(out + 5, _mm_aesenclast_si128(b5, k5));
+    _mm_storeu_si128(out + 6, _mm_aesenclast_si128(b6, k6));
+    _mm_storeu_si128(out + 7, _mm_aesenclast_si128(b7, k7));
+  }
+  for (; count >= 4; count -= 4, in += 4, key += 4, out += 4) {
+    k0 = _mm_loadu_si128(key + 0);
+    k1 = _mm_loadu_si128(key + 1);
+    k2 = _mm_loadu_si128(key + 2);
+    k3 = _mm_loadu_si128(key + 3);
+    b0 = _mm_xor_si128(_mm_loadu_si128(in + 0), k0);
+    b1 = _mm_xor_si128(_mm_loadu_si128(in + 1), k1);
+    b2 = _mm_xor_si128(_mm_loadu_si128(in + 2), k2);
+    b3 = _mm_xor_si128(_mm_loadu_si128(in + 3), k3);
+    for (i = 0; i < 10; i++) {
+      r = _mm_set1_epi32(rcon[i]);
+      k0 = aes_next_key_aesni(k0, _mm_aesenclast_si128(_mm_shuffle_epi8(k0, rotword), r));
+      k1 = aes_next_key_aesni(k1, _mm_aesenclast_si128(_mm_shuffle_epi8(k1, rotword), r));
+      k2 = aes_next_key_aesni(k2, _mm_aesenclast_si128(_mm_shuffle_epi8(k2, rotword), r));
+      k3 = aes_next_key_aesni(k3, _mm_aesenclast_si128(_mm_shuffle_epi8(k3, rotword), r));
+      if (i < 9) {
+        b0 = _mm_aesenc_si128(b0, k0);
+        b1 = _mm_aesenc_si128(b1, k1);
+        b2 = _mm_aesenc_si128(b2, k2);
+        b3 = _mm_aesenc_si128(b3, k3);
+      }
+    }
+    _mm_storeu_si128(out + 0, _mm_aesenclast_si128(b0, k0));
+    _mm_storeu_si128(out + 1, _mm_aesenclast_si128(b1, k1));
+    _mm_storeu_si128(out + 2, _mm_aesenclast_si128(b2, k2));
+    _mm_storeu_si128(out + 3, _mm_aesenclast_si128(b3, k3));
+  }
+  for (; count > 0; count--, in++, key++, out++) {
+    k0 = _mm_loadu_si128(key);
+    b0 = _mm_xor_si128(_mm_loadu_si128(in), k0);
+    for (i = 0; i < 10; i++) {
+      r = _mm_set1_epi32(rcon[i]);
+      k0 = aes_next_key_aesni(k0, _mm_aesenclast_si128(_mm_shuffle_epi8(k0, rotword), r));
+      if (i < 9) {
+        b0 = _mm_aesenc_si128(b0, k0);
+      }
+    }
+    _mm_storeu_si128(out, _mm_aesenclast_si128(b0, k0));
+  }
+}
+#endif
+
+/*
+ * Performs the AES cipher transform (encryption) of independent blocks
+ * with the same expanded key (as in the ECB mode), using the fastest
+ * implementation available on the processor.
+ * output: pointer to count * 16 bytes of memory to store the ciphertext blocks
+ * input: pointer to count * 16 bytes of memory with the plaintext blocks
+ * count: number of 16-byte blocks
+ * key: pointer to the key schedule, initialized with aes_set_key
+ * The output and input may point to the same memory.
+ */
+static void aes_encrypt_blocks(void *output, const void *input, int count, const struct aes_key *key) {
+  int i;
+
+#ifdef AES_NI
+  if (crumbs_cpu_has(CRUMBS_CPU_AESNI)) {
+    aes_encrypt_aesni(output, input, count, key);
+    return;
+  }
+#endif
+  for (i = 0; i < count; i++) {
+    aes_encrypt_generic((unsigned char *)output + i * 16, (const unsigned char *)input + i * 16, key);
+  }
+}
+
+/*
+ * Performs the AES cipher transform (encryption) of one block with an expanded key.
+ * output: pointer to 16 bytes (128 bits) of memory to store the ciphertext
+ * input: pointer to 16 bytes (128 bits) of memory with the plaintext
+ * key: pointer to the key schedule, initialized with aes_set_key
+ * The output and input may point to the same memory.
+ */
+static void aes_encrypt_block(void *output, const void *input, const struct aes_key *key) {
+  aes_encrypt_blocks(output, input, 1, key);
+}
+
+/*
+ * Performs the AES cipher transform (encryption) of blocks with a different
+ * cipher key each (as in hash functions built on AES, where the key is the
+ * previous hash value), expanding each key along with the encryption of its
+ * block, using the fastest implementation available on the processor.
+ * output: pointer to count * 16 bytes of memory to store the ciphertext blocks
+ * input: pointer to count * 16 bytes of memory with the plaintext blocks
+ * keys: pointer to count * 16 bytes of memory with the cipher keys
+ * count: number of 16-byte blocks (and keys)
+ * Each output block may point to the same memory as its input block or key.
+ */
+static void aes_encrypt_keys(void *output, const void *input, const void *keys, int count) {
+  struct aes_key expanded;
+  int i;
+
+#ifdef AES_NI
+  if (crumbs_cpu_has(CRUMBS_CPU_AESNI | CRUMBS_CPU_SSSE3)) {
+    aes_encrypt_keys_aesni(output, input, keys, count);
+    return;
+  }
+#endif
+  for (i = 0; i < count; i++) {
+    aes_set_key(&expanded, (const unsigned char *)keys + i * 16);
+    aes_encrypt_block((unsigned char *)output + i * 16, (const unsigned char *)input + i * 16, &expanded);
+  }
+}
+
+/*
+ * Performs the AES cipher transform (encryption) for Nk=4 (AES-128).
+ * output: pointer to 16 bytes (128 bits) of memory to store the ciphertext
+ * intput: pointer to 16 bytes (128 bits) of memory with the plaintext
+ * key: pointer to 16 bytes (128 bits) of memory with the cipher key
+ * The output may point to the same memory as the input or the key.
+ */
+static void aes_encrypt(void *output, const void *input, const void *key) {
+  aes_encrypt_keys(output, input, key, 1);
+}
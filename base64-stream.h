@@ -0,0 +1,282 @@
+/*
+ * base64-stream.h: incremental base 64 encoding and decoding
+ *
+ * https://github.com/andrebdo/c-crumbs/base64-stream.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Implements incremental base 64 encoding and decoding, with the input
+ * split at any byte boundary across calls, so that large data can be
+ * streamed through fixed-size buffers. The options select:
+ * - BASE64_URL: the "base64url" alphabet, with '-' and '_' instead of '+' and '/'
+ * - BASE64_NO_PADDING: no '=' padding of the last group (as in JSON Web Tokens)
+ * - BASE64_MIME: lines of 76 characters separated by CRLF (as in MIME mail);
+ *   when decoding, CR and LF characters are skipped wherever they are
+ *
+ * The whole 3-byte (or 4-character) groups of each call are encoded (or
+ * decoded) directly between the caller's buffers with the functions of
+ * base64.h, including their SIMD paths, one line at a time with BASE64_MIME;
+ * only the bytes of a group split between calls go through the context.
+ *
+ * Uses the functions in base64.h, so you need to include it too:
+ * #include "base64.h"
+ * #include "base64-stream.h"
+ *
+ * References:
+ * [RFC4648] The Base16, Base32, and Base64 Data Encodings.
+ * [RFC2045] Multipurpose Internet Mail Extensions (MIME) Part One:
+ *           Format of Internet Message Bodies, 6.8 Base64 Content-Transfer-Encoding
+ */
+
+#define BASE64_URL 1
+#define BASE64_NO_PADDING 2
+#define BASE64_MIME 4
+
+/* [RFC4648] Table 2: The "URL and Filename safe" Base 64 Alphabet */
+static const unsigned char base64url_alphabet[64] = {
+  'A','B','C','D','E','F','G','H','I','J','K','L','M',
+  'N','O','P','Q','R','S','T','U','V','W','X','Y','Z',
+  'a','b','c','d','e','f','g','h','i','j','k','l','m',
+  'n','o','p','q','r','s','t','u','v','w','x','y','z',
+  '0','1','2','3','4','5','6','7','8','9','-','_',
+};
+
+/* The decoding table of base64url_alphabet, as base64_values */
+static const unsigned char base64url_values[256] = {
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255, 62,255,255,
+   52, 53, 54, 55, 56, 57, 58, 59, 60, 61,255,255,255,255,255,255,
+  255,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+   15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25,255,255,255,255, 63,
+  255, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+   41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+};
+
+/*
+ * Context of an incremental base 64 encoding or decoding.
+ * alphabet: the 64 characters of the alphabet
+ * values: the decoding table of the alphabet (decoding only)
+ * options: the BASE64_* options
+ * group: the bytes (encoding) or characters (decoding) of the partial group
+ * count: number of bytes or characters in group
+ * column: number of characters in the current line (encoding only)
+ * done: nonzero after the padded last group (decoding only)
+ */
+struct base64_context {
+  const unsigned char *alphabet;
+  const unsigned char *values;
+  int options;
+  unsigned char group[4];
+  int count;
+  int column;
+  int done;
+};
+
+/*
+ * Starts an incremental base 64 encoding.
+ * ctx: pointer to the context to initialize
+ * options: the BASE64_* options, or 0 for the standard encoding
+ */
+static void base64_encode_init(struct base64_context *ctx, int options) {
+  ctx->alphabet = (options & BASE64_URL) ? base64url_alphabet : base64_alphabet;
+  ctx->options = options;
+  ctx->count = 0;
+  ctx->column = 0;
+  ctx->done = 0;
+}
+
+/*
+ * Encodes the next part of the input.
+ * ctx: pointer to the context
+ * output: pointer to memory to store the encoded data, (length+2)/3*4 bytes,
+ *         plus 2 bytes for each of up to (length+2)/57+1 line breaks with BASE64_MIME
+ * input: pointer to the next part of the input data
+ * length: number of bytes of the part of the input data
+ * Returns the number of bytes stored in output.
+ */
+static int base64_encode_update(struct base64_context *ctx, void *output, const void *input, int length) {
+  const unsigned char *p = (const unsigned char *)input;
+  unsigned char *q = (unsigned char *)output;
+  int i, k, n;
+
+  n = 0;
+  for (;;) {
+    /* Complete the partial group, if there is one */
+    while (ctx->count > 0 && ctx->count < 3 && length > 0) {
+      ctx->group[ctx->count++] = *p++;
+      length--;
+    }
+    if (ctx->count > 0 && ctx->count < 3) {
+      return n;
+    }
+    if (ctx->count == 0 && length < 3) {
+      break;
+    }
+
+    if ((ctx->options & BASE64_MIME) && ctx->column == 76) {
+      q[n++] = '\r';
+      q[n++] = '\n';
+      ctx->column = 0;
+    }
+    if (ctx->count == 3) {
+      n += base64_encode_groups(q + n, ctx->group, 3, ctx->alphabet);
+      ctx->column += 4;
+      ctx->count = 0;
+      continue;
+    }
+
+    /* Encode whole groups directly, up to the end of the line */
+    k = length / 3;
+    if ((ctx->options & BASE64_MIME) && k > (76 - ctx->column) / 4) {
+      k = (76 - ctx->column) / 4;
+    }
+    i = base64_encode_groups(q + n, p, k * 3, ctx->alphabet);
+    n += i;
+    ctx->column += i;
+    p += k * 3;
+    length -= k * 3;
+  }
+
+  /* Keep the remaining bytes for the next call */
+  for (i = 0; i < length; i++) {
+    ctx->group[ctx->count++] = p[i];
+  }
+  return n;
+}
+
+/*
+ * Finishes an incremental base 64 encoding, encoding the last partial group.
+ * ctx: pointer to the context
+ * output: pointer to 6 bytes of memory to store the encoded data
+ * Returns the number of bytes stored in output.
+ */
+static int base64_encode_final(struct base64_context *ctx, void *output) {
+  unsigned char *q = (unsigned char *)output;
+  int n;
+
+  n = 0;
+  if (ctx->count > 0 && (ctx->options & BASE64_MIME) && ctx->column == 76) {
+    q[n++] = '\r';
+    q[n++] = '\n';
+  }
+  n += base64_encode_last(q + n, ctx->group, ctx->count, ctx->alphabet, !(ctx->options & BASE64_NO_PADDING));
+  ctx->count = 0;
+  return n;
+}
+
+/*
+ * Starts an incremental base 64 decoding.
+ * ctx: pointer to the context to initialize
+ * options: the BASE64_* options, or 0 for the standard encoding
+ */
+static void base64_decode_init(struct base64_context *ctx, int options) {
+  ctx->alphabet = (options & BASE64_URL) ? base64url_alphabet : base64_alphabet;
+  ctx->values = (options & BASE64_URL) ? base64url_values : base64_values;
+  ctx->options = options;
+  ctx->count = 0;
+  ctx->column = 0;
+  ctx->done = 0;
+}
+
+/*
+ * Decodes the next part of the encoded data, with the same strict
+ * validation as base64_decode.
+ * ctx: pointer to the context
+ * output: pointer to (length+3)/4*3 bytes of memory to store the decoded data
+ * input: pointer to the next part of the base 64 encoded data
+ * length: number of bytes (characters) of the part of the encoded data
+ * Returns the number of bytes stored in output, or -1 if the encoded data
+ * is not valid (in which case the context must not be used any further).
+ */
+static int base64_decode_update(struct base64_context *ctx, void *output, const void *input, int length) {
+  const unsigned char *p = (const unsigned char *)input;
+  unsigned char *q = (unsigned char *)output;
+  int i, k, n;
+
+  n = 0;
+  while (length > 0) {
+    if ((ctx->options & BASE64_MIME) && (*p == '\r' || *p == '\n')) {
+      p++;
+      length--;
+      continue;
+    }
+    if (ctx->done) {  /* data after the padding */
+      return -1;
+    }
+
+    if (ctx->count == 0) {
+      /* Decode whole groups directly, up to the next line break */
+      k = length;
+      if (ctx->options & BASE64_MIME) {
+        for (k = 0; k < length && p[k] != '\r' && p[k] != '\n'; k++) {
+        }
+      }
+      k &= ~3;
+      if (k > 0 && p[k - 1] == '=') {  /* leave the padded last group */
+        k -= 4;
+      }
+      if (k > 0) {
+        i = base64_decode_groups(q + n, p, k, ctx->alphabet, ctx->values);
+        if (i < 0) {
+          return -1;
+        }
+        n += i;
+        p += k;
+        length -= k;
+        continue;
+      }
+    }
+
+    /* Add a character to the partial group */
+    ctx->group[ctx->count++] = *p++;
+    length--;
+    if (ctx->count == 4) {
+      if (ctx->group[3] == '=') {
+        if (ctx->options & BASE64_NO_PADDING) {
+          return -1;
+        }
+        ctx->done = 1;
+        i = base64_decode_last(q + n, ctx->group, 4, ctx->values);
+      } else {
+        i = base64_decode_groups(q + n, ctx->group, 4, ctx->alphabet, ctx->values);
+      }
+      if (i < 0) {
+        return -1;
+      }
+      n += i;
+      ctx->count = 0;
+    }
+  }
+  return n;
+}
+
+/*
+ * Finishes an incremental base 64 decoding, decoding the last partial
+ * group with BASE64_NO_PADDING.
+ * ctx: pointer to the context
+ * output: pointer to 2 bytes of memory to store the decoded data
+ * Returns the number of bytes stored in output, or -1 if the encoded data
+ * ended with an incomplete group (or, with BASE64_NO_PADDING, a group of
+ * a single character or with nonzero leftover bits).
+ */
+static int base64_decode_final(struct base64_context *ctx, void *output) {
+  if (ctx->count == 0) {
+    return 0;
+  }
+  if (!(ctx->options & BASE64_NO_PADDING)) {
+    return -1;
+  }
+  return base64_decode_last(output, ctx->group, ctx->count, ctx->values);
+}
@@ -8,28 +8,203 @@
  */
 
 /*
- * Encodes a sequence of bytes into base 64 format.
- * output: pointer to (length+2)/3*4 bytes of memory to store the base 64 encoded data
- * input: pointer to the input data
- * length: number of bytes of the input data
- * Returns the number of bytes stored in output, always (length+2)/3*4.
+ * Implements the base 64 encoding and decoding.
+ *
+ * The bulk of the input is encoded with SIMD instructions when available:
+ * with AVX2 (24 bytes per step) or SSSE3 (12 bytes per step) on x86
+ * processors that have them (detected once at run time, with GCC or Clang),
+ * and with NEON (48 bytes per step) on AArch64. The rest of the input,
+ * including the final padded group, is encoded one 3-byte group at a time.
+ * Decoding works the same way, validating the input as it goes, with
+ * kernels that decode 32 (AVX2), 16 (SSSE3) or 64 (NEON) characters per
+ * step and a table lookup per character for the rest.
+ *
+ * The processor features are detected with crumbs-cpu.h, which needs to be
+ * in the same directory (and where the code paths can be pinned).
  *
  * References:
  * [RFC4648] The Base16, Base32, and Base64 Data Encodings.
+ * [MULA] Faster Base64 Encoding and Decoding using AVX2 Instructions,
+ *        Wojciech Mula and Daniel Lemire, ACM Transactions on the Web, 2018
  */
-static int base64_encode(void *output, const void *input, int length) {
-  const char alphabet[64] = {
-    'A','B','C','D','E','F','G','H','I','J','K','L','M',
-    'N','O','P','Q','R','S','T','U','V','W','X','Y','Z',
-    'a','b','c','d','e','f','g','h','i','j','k','l','m',
-    'n','o','p','q','r','s','t','u','v','w','x','y','z',
-    '0','1','2','3','4','5','6','7','8','9','+','/',
-  };
+
+#include "crumbs-cpu.h"
+
+#ifdef CRUMBS_CPU_X86
+#define BASE64_X86
+#define BASE64_AVX2_FEATURES (CRUMBS_CPU_AVX2 | CRUMBS_CPU_SSSE3)
+#elif defined(CRUMBS_CPU_ARM)
+#define BASE64_NEON
+#endif
+
+/* [RFC4648] Table 1: The Base 64 Alphabet */
+static const unsigned char base64_alphabet[64] = {
+  'A','B','C','D','E','F','G','H','I','J','K','L','M',
+  'N','O','P','Q','R','S','T','U','V','W','X','Y','Z',
+  'a','b','c','d','e','f','g','h','i','j','k','l','m',
+  'n','o','p','q','r','s','t','u','v','w','x','y','z',
+  '0','1','2','3','4','5','6','7','8','9','+','/',
+};
+
+#ifdef BASE64_X86
+/*
+ * Internal function that splits 12 bytes (in the low 12 bytes of each
+ * 128-bit lane) into 16 6-bit values and maps them to the alphabet,
+ * whose last two characters are alphabet62 and alphabet63.
+ *
+ * The bytes of each 3-byte group are first shuffled to [b, a, c, b];
+ * multiplications by powers of 2 then move the four 6-bit fields into
+ * place, and the alphabet is added as offsets from the range each value
+ * falls in: A-Z, a-z, 0-9, or one of the last two characters.
+ *
+ * [MULA] 2.1 Vectorized encoding, 2.2 Lookup by pshufb
+ */
+__attribute__((target("ssse3")))
+static __m128i base64_encode_sse_step(__m128i in, int alphabet62, int alphabet63) {
+  __m128i indices, t0, t1, t2, t3, result, less;
+
+  in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+  t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+  t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+  t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+  t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+  indices = _mm_or_si128(t1, t3);
+
+  /* 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12 */
+  result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+  less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+  result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+  result = _mm_shuffle_epi8(_mm_setr_epi8(
+    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+    '0' - 52, '0' - 52, '0' - 52, alphabet62 - 62, alphabet63 - 63, 'A', 0, 0), result);
+  return _mm_add_epi8(result, indices);
+}
+
+/*
+ * Internal function that encodes 12 bytes per step with SSSE3.
+ * Reads 16 bytes per step, so it stops 4 bytes before the end of the input.
+ * Returns the number of input bytes encoded (a multiple of 12).
+ */
+__attribute__((target("ssse3")))
+static int base64_encode_ssse3(void *output, const void *input, int length, const unsigned char *alphabet) {
+  __m128i in;
+  int i, n;
+
+  for (i = 0, n = 0; i + 16 <= length; i += 12, n += 16) {
+    in = _mm_loadu_si128((const __m128i *)(const void *)((const unsigned char *)input + i));
+    _mm_storeu_si128((__m128i *)(void *)((unsigned char *)output + n), base64_encode_sse_step(in, alphabet[62], alphabet[63]));
+  }
+  return i;
+}
+
+/*
+ * Internal function that encodes 24 bytes per step with AVX2,
+ * 12 bytes in each 128-bit lane, then 12 bytes per step with SSSE3.
+ * Returns the number of input bytes encoded (a multiple of 12).
+ */
+__attribute__((target("avx2")))
+static int base64_encode_avx2(void *output, const void *input, int length, const unsigned char *alphabet) {
+  const unsigned char *p = (const unsigned char *)input;
+  __m256i in, indices, t0, t1, t2, t3, result, less;
+  int i, n;
+
+  for (i = 0, n = 0; i + 28 <= length; i += 24, n += 32) {
+    in = _mm256_inserti128_si256(_mm256_castsi128_si256(
+      _mm_loadu_si128((const __m128i *)(const void *)(p + i))),
+      _mm_loadu_si128((const __m128i *)(const void *)(p + i + 12)), 1);
+
+    in = _mm256_shuffle_epi8(in, _mm256_set_epi8(
+      10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+      10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+    t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+    t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+    t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+    indices = _mm256_or_si256(t1, t3);
+
+    result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+    result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+    result = _mm256_shuffle_epi8(_mm256_setr_epi8(
+      'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, alphabet[62] - 62, alphabet[63] - 63, 'A', 0, 0,
+      'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, alphabet[62] - 62, alphabet[63] - 63, 'A', 0, 0), result);
+    _mm256_storeu_si256((__m256i *)(void *)((unsigned char *)output + n), _mm256_add_epi8(result, indices));
+  }
+  for (; i + 16 <= length; i += 12, n += 16) {
+    _mm_storeu_si128((__m128i *)(void *)((unsigned char *)output + n),
+      base64_encode_sse_step(_mm_loadu_si128((const __m128i *)(const void *)(p + i)), alphabet[62], alphabet[63]));
+  }
+  return i;
+}
+#endif
+
+#ifdef BASE64_NEON
+/*
+ * Internal function that encodes 48 bytes per step with NEON:
+ * vld3 splits them into the first, second and third bytes of the 3-byte
+ * groups, shifts form the four 6-bit values, a 64-byte table lookup maps
+ * them to the alphabet, and vst4 interleaves the 64 characters.
+ * Returns the number of input bytes encoded (a multiple of 48).
+ */
+static int base64_encode_neon(void *output, const void *input, int length, const unsigned char *alphabet) {
+  const unsigned char *p = (const unsigned char *)input;
+  uint8x16x4_t table, out;
+  uint8x16x3_t in;
+  uint8x16_t mask;
+  int i, n;
+
+  table.val[0] = vld1q_u8(alphabet);
+  table.val[1] = vld1q_u8(alphabet + 16);
+  table.val[2] = vld1q_u8(alphabet + 32);
+  table.val[3] = vld1q_u8(alphabet + 48);
+  mask = vdupq_n_u8(63);
+  for (i = 0, n = 0; i + 48 <= length; i += 48, n += 64) {
+    in = vld3q_u8(p + i);
+    out.val[0] = vshrq_n_u8(in.val[0], 2);
+    out.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[0], 4), vshrq_n_u8(in.val[1], 4)), mask);
+    out.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[1], 2), vshrq_n_u8(in.val[2], 6)), mask);
+    out.val[3] = vandq_u8(in.val[2], mask);
+    out.val[0] = vqtbl4q_u8(table, out.val[0]);
+    out.val[1] = vqtbl4q_u8(table, out.val[1]);
+    out.val[2] = vqtbl4q_u8(table, out.val[2]);
+    out.val[3] = vqtbl4q_u8(table, out.val[3]);
+    vst4q_u8((unsigned char *)output + n, out);
+  }
+  return i;
+}
+#endif
+
+/*
+ * Internal function that encodes the whole 3-byte groups of the input.
+ * output: pointer to length/3*4 bytes of memory to store the encoded data
+ * input: pointer to the input data
+ * length: number of bytes of the input data
+ * alphabet: pointer to the 64 characters of the alphabet, which must only
+ *           differ from base64_alphabet in its last two characters
+ * Returns the number of bytes stored in output, always length/3*4.
+ */
+static int base64_encode_groups(void *output, const void *input, int length, const unsigned char *alphabet) {
   unsigned char a, b, c;
   int i, n;
 
-  n = 0;
-  for (i = 0; i <= length - 3; i += 3) {
+  i = 0;
+#ifdef BASE64_X86
+  if (length >= 28 && crumbs_cpu_has(BASE64_AVX2_FEATURES)) {
+    i = base64_encode_avx2(output, input, length, alphabet);
+  } else if (length >= 16 && crumbs_cpu_has(CRUMBS_CPU_SSSE3)) {
+    i = base64_encode_ssse3(output, input, length, alphabet);
+  }
+#endif
+#ifdef BASE64_NEON
+  if (crumbs_cpu_has(CRUMBS_CPU_NEON)) {
+    i = base64_encode_neon(output, input, length, alphabet);
+  }
+#endif
+
+  n = i / 3 * 4;
+  for (; i <= length - 3; i += 3) {
     a = ((unsigned char *)input)[i];
     b = ((unsigned char *)input)[i + 1];
     c = ((unsigned char *)input)[i + 2];
@@ -38,20 +213,332 @@ static int base64_encode(void *output, const void *input, int length) {
     ((unsigned char *)output)[n++] = alphabet[(b << 2 | c >> 6) & 63];
     ((unsigned char *)output)[n++] = alphabet[c & 63];
   }
-  if (i + 2 == length) {
-    a = ((unsigned char *)input)[i];
-    b = ((unsigned char *)input)[i + 1];
-    ((unsigned char *)output)[n++] = alphabet[(a >> 2) & 63];
-    ((unsigned char *)output)[n++] = alphabet[(a << 4 | b >> 4) & 63];
-    ((unsigned char *)output)[n++] = alphabet[(b << 2) & 63];
-    ((unsigned char *)output)[n++] = '=';
-  } else if (i + 1 == length) {
-    a = ((unsigned char *)input)[i];
-    ((unsigned char *)output)[n++] = alphabet[(a >> 2) & 63];
-    ((unsigned char *)output)[n++] = alphabet[(a << 4) & 63];
-    ((unsigned char *)output)[n++] = '=';
-    ((unsigned char *)output)[n++] = '=';
+  return n;
+}
+
+/*
+ * Internal function that encodes the last, partial group of the input.
+ * output: pointer to 4 bytes of memory to store the encoded data
+ * input: pointer to the last length bytes of the input data
+ * length: number of bytes of the partial group (0, 1 or 2)
+ * alphabet: pointer to the 64 characters of the alphabet
+ * padding: nonzero to pad the group with '=' to 4 characters
+ * Returns the number of bytes stored in output.
+ */
+static int base64_encode_last(void *output, const void *input, int length, const unsigned char *alphabet, int padding) {
+  unsigned char *q = (unsigned char *)output;
+  unsigned char a, b;
+  int n;
+
+  n = 0;
+  if (length == 2) {
+    a = ((unsigned char *)input)[0];
+    b = ((unsigned char *)input)[1];
+    q[n++] = alphabet[(a >> 2) & 63];
+    q[n++] = alphabet[(a << 4 | b >> 4) & 63];
+    q[n++] = alphabet[(b << 2) & 63];
+  } else if (length == 1) {
+    a = ((unsigned char *)input)[0];
+    q[n++] = alphabet[(a >> 2) & 63];
+    q[n++] = alphabet[(a << 4) & 63];
+  }
+  while (padding && (n & 3) != 0) {
+    q[n++] = '=';
+  }
+  return n;
+}
+
+/*
+ * Encodes a sequence of bytes into base 64 format.
+ * output: pointer to (length+2)/3*4 bytes of memory to store the base 64 encoded data
+ * input: pointer to the input data
+ * length: number of bytes of the input data
+ * Returns the number of bytes stored in output, always (length+2)/3*4.
+ */
+static int base64_encode(void *output, const void *input, int length) {
+  int n;
+
+  n = base64_encode_groups(output, input, length, base64_alphabet);
+  return n + base64_encode_last((unsigned char *)output + n,
+    (const unsigned char *)input + length / 3 * 3, length % 3, base64_alphabet, 1);
+}
+
+/*
+ * The decoding table of base64_alphabet:
+ * the 6-bit value of each character, or 255 for characters not in it.
+ */
+static const unsigned char base64_values[256] = {
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255, 62,255,255,255, 63,
+   52, 53, 54, 55, 56, 57, 58, 59, 60, 61,255,255,255,255,255,255,
+  255,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+   15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25,255,255,255,255,255,
+  255, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+   41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+  255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+};
+
+#ifdef BASE64_X86
+/*
+ * Internal function that decodes 16 characters per step with SSSE3,
+ * storing 16 bytes per step of which 12 are decoded data.
+ * It stops at the first step with a character not in the alphabet, and
+ * when fewer than 24 characters are left, so that the extra bytes stored
+ * stay within the decoded data, to be overwritten later.
+ * Returns the number of input characters decoded (a multiple of 16).
+ *
+ * The characters are validated by looking up a bit mask for their low
+ * nibble and another for their high nibble, which have no bits in common
+ * only for the characters of the alphabet; the high nibble also selects
+ * the offset that turns the character into its 6-bit value.
+ * Multiply-adds then pack each 4 6-bit values into 3 bytes.
+ *
+ * [MULA] 3.1 Vectorized decoding, 3.2 Validation by pshufb
+ */
+__attribute__((target("ssse3")))
+static int base64_decode_ssse3(void *output, const void *input, int length) {
+  const unsigned char *p = (const unsigned char *)input;
+  __m128i in, lo, hi, out;
+  int i, n;
+
+  for (i = 0, n = 0; i + 24 <= length; i += 16, n += 12) {
+    in = _mm_loadu_si128((const __m128i *)(const void *)(p + i));
+    hi = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x2f));
+    lo = _mm_shuffle_epi8(_mm_setr_epi8(
+      0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+      0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a), _mm_and_si128(in, _mm_set1_epi8(0x2f)));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, _mm_shuffle_epi8(_mm_setr_epi8(
+      0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10), hi)), _mm_setzero_si128())) != 0xffff) {
+      break;
+    }
+    /* '/' is the only character in its range with a different offset */
+    in = _mm_add_epi8(in, _mm_shuffle_epi8(_mm_setr_epi8(
+      0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0),
+      _mm_add_epi8(_mm_cmpeq_epi8(in, _mm_set1_epi8(0x2f)), hi)));
+
+    out = _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+    out = _mm_madd_epi16(out, _mm_set1_epi32(0x00011000));
+    out = _mm_shuffle_epi8(out, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    _mm_storeu_si128((__m128i *)(void *)((unsigned char *)output + n), out);
   }
+  return i;
+}
 
+/*
+ * Internal function that decodes 32 characters per step with AVX2,
+ * storing 32 bytes per step of which 24 are decoded data, like
+ * base64_decode_ssse3 does in each 128-bit lane, and then decodes the
+ * rest with base64_decode_ssse3.
+ * Returns the number of input characters decoded (a multiple of 16).
+ */
+__attribute__((target("avx2")))
+static int base64_decode_avx2(void *output, const void *input, int length) {
+  const unsigned char *p = (const unsigned char *)input;
+  __m256i in, lo, hi, out;
+  int i, n;
+
+  for (i = 0, n = 0; i + 48 <= length; i += 32, n += 24) {
+    in = _mm256_loadu_si256((const __m256i *)(const void *)(p + i));
+    hi = _mm256_and_si256(_mm256_srli_epi32(in, 4), _mm256_set1_epi8(0x2f));
+    lo = _mm256_shuffle_epi8(_mm256_setr_epi8(
+      0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+      0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+      0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+      0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a), _mm256_and_si256(in, _mm256_set1_epi8(0x2f)));
+    if (!_mm256_testz_si256(lo, _mm256_shuffle_epi8(_mm256_setr_epi8(
+      0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+      0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10), hi))) {
+      break;
+    }
+    in = _mm256_add_epi8(in, _mm256_shuffle_epi8(_mm256_setr_epi8(
+      0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+      0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0),
+      _mm256_add_epi8(_mm256_cmpeq_epi8(in, _mm256_set1_epi8(0x2f)), hi)));
+
+    out = _mm256_maddubs_epi16(in, _mm256_set1_epi32(0x01400140));
+    out = _mm256_madd_epi16(out, _mm256_set1_epi32(0x00011000));
+    out = _mm256_shuffle_epi8(out, _mm256_setr_epi8(
+      2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+      2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    out = _mm256_permutevar8x32_epi32(out, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+    _mm256_storeu_si256((__m256i *)(void *)((unsigned char *)output + n), out);
+  }
+  return i + base64_decode_ssse3((unsigned char *)output + n, p + i, length - i);
+}
+#endif
+
+#ifdef BASE64_NEON
+/*
+ * Internal function that decodes 64 characters per step with NEON:
+ * vld4 splits them into the first, second, third and fourth characters
+ * of the 4-character groups, lookups in the decoding table (first 128
+ * characters) map them to their values, and vst3 interleaves the 48 bytes.
+ * It stops at the first step with a character not in the alphabet.
+ * Returns the number of input characters decoded (a multiple of 64).
+ */
+static int base64_decode_neon(void *output, const void *input, int length, const unsigned char *values) {
+  const unsigned char *p = (const unsigned char *)input;
+  uint8x16x4_t lower, upper, in;
+  uint8x16x3_t out;
+  uint8x16_t invalid, offset;
+  int i, j, n;
+
+  for (j = 0; j < 4; j++) {
+    lower.val[j] = vld1q_u8(values + j * 16);
+    upper.val[j] = vld1q_u8(values + 64 + j * 16);
+  }
+  offset = vdupq_n_u8(64);
+  for (i = 0, n = 0; i + 64 <= length; i += 64, n += 48) {
+    in = vld4q_u8(p + i);
+    invalid = vdupq_n_u8(0);
+    for (j = 0; j < 4; j++) {
+      /* Characters 128-255 are out of range of both lookups */
+      invalid = vorrq_u8(invalid, vandq_u8(in.val[j], vdupq_n_u8(0x80)));
+      in.val[j] = vqtbx4q_u8(vqtbl4q_u8(lower, in.val[j]), upper, vsubq_u8(in.val[j], offset));
+      invalid = vorrq_u8(invalid, in.val[j]);
+    }
+    if (vmaxvq_u8(invalid) >= 64) {
+      break;
+    }
+    out.val[0] = vorrq_u8(vshlq_n_u8(in.val[0], 2), vshrq_n_u8(in.val[1], 4));
+    out.val[1] = vorrq_u8(vshlq_n_u8(in.val[1], 4), vshrq_n_u8(in.val[2], 2));
+    out.val[2] = vorrq_u8(vshlq_n_u8(in.val[2], 6), in.val[3]);
+    vst3q_u8((unsigned char *)output + n, out);
+  }
+  return i;
+}
+#endif
+
+/*
+ * Internal function that decodes whole 4-character groups without padding.
+ * output: pointer to length/4*3 bytes of memory to store the decoded data
+ * input: pointer to the base 64 encoded data
+ * length: number of characters of the encoded data, a multiple of 4
+ * alphabet: pointer to the 64 characters of the alphabet
+ * values: pointer to the decoding table of the alphabet
+ * Returns the number of bytes stored in output, always length/4*3,
+ * or -1 if a character is not in the alphabet.
+ */
+static int base64_decode_groups(void *output, const void *input, int length,
+    const unsigned char *alphabet, const unsigned char *values) {
+  const unsigned char *p = (const unsigned char *)input;
+  unsigned char *q = (unsigned char *)output;
+  unsigned a, b, c, d;
+  int i, n;
+
+  i = 0;
+#ifdef BASE64_X86
+  /* The x86 kernels validate the characters of base64_alphabet only */
+  if (alphabet == base64_alphabet) {
+    if (length >= 48 && crumbs_cpu_has(BASE64_AVX2_FEATURES)) {
+      i = base64_decode_avx2(output, input, length);
+    } else if (length >= 24 && crumbs_cpu_has(CRUMBS_CPU_SSSE3)) {
+      i = base64_decode_ssse3(output, input, length);
+    }
+  }
+#endif
+#ifdef BASE64_NEON
+  if (crumbs_cpu_has(CRUMBS_CPU_NEON)) {
+    i = base64_decode_neon(output, input, length, values);
+  }
+#endif
+
+  n = i / 4 * 3;
+  for (; i < length; i += 4) {
+    a = values[p[i]];
+    b = values[p[i + 1]];
+    c = values[p[i + 2]];
+    d = values[p[i + 3]];
+    if ((a | b | c | d) > 63) {
+      return -1;
+    }
+    q[n++] = a << 2 | b >> 4;
+    q[n++] = b << 4 | c >> 2;
+    q[n++] = c << 6 | d;
+  }
   return n;
 }
+
+/*
+ * Internal function that decodes the last group of the encoded data.
+ * output: pointer to 3 bytes of memory to store the decoded data
+ * input: pointer to the last length characters of the encoded data
+ * length: number of characters of the last group (2, 3 or 4)
+ * values: pointer to the decoding table of the alphabet
+ * Returns the number of bytes stored in output, or -1 if the group is
+ * not valid: a character not in the alphabet, misplaced padding '=', or
+ * nonzero bits left over after the last byte ([RFC4648] 3.5 Canonical
+ * Encoding).  A 4-character group may end with one or two '='.
+ */
+static int base64_decode_last(void *output, const void *input, int length, const unsigned char *values) {
+  const unsigned char *p = (const unsigned char *)input;
+  unsigned char *q = (unsigned char *)output;
+  unsigned a, b, c, d;
+
+  if (length == 4 && p[3] == '=') {
+    length = p[2] == '=' ? 2 : 3;
+  }
+  if (length < 2) {
+    return -1;
+  }
+  a = values[p[0]];
+  b = values[p[1]];
+  c = length > 2 ? values[p[2]] : 0;
+  d = length > 3 ? values[p[3]] : 0;
+  if ((a | b | c | d) > 63) {
+    return -1;
+  }
+  q[0] = a << 2 | b >> 4;
+  if (length == 2) {
+    return (b & 15) ? -1 : 1;
+  }
+  q[1] = b << 4 | c >> 2;
+  if (length == 3) {
+    return (c & 3) ? -1 : 2;
+  }
+  q[2] = c << 6 | d;
+  return 3;
+}
+
+/*
+ * Decodes base 64 encoded data, with strict validation of the input:
+ * its length must be a multiple of 4, all characters must be in the
+ * alphabet, except for one or two padding '=' characters at the end,
+ * and the unused bits of the last character before them must be zero
+ * ([RFC4648] 3.5 Canonical Encoding).
+ * output: pointer to length/4*3 bytes of memory to store the decoded data
+ * input: pointer to the base 64 encoded data
+ * length: number of bytes (characters) of the base 64 encoded data
+ * Returns the number of bytes stored in output, or -1 if the input is not
+ * valid base 64 encoded data (in which case output has unspecified contents).
+ */
+static int base64_decode(void *output, const void *input, int length) {
+  int n, m;
+
+  if (length % 4 != 0) {
+    return -1;
+  }
+  if (length == 0) {
+    return 0;
+  }
+  n = base64_decode_groups(output, input, length - 4, base64_alphabet, base64_values);
+  if (n < 0) {
+    return -1;
+  }
+  m = base64_decode_last((unsigned char *)output + n, (const unsigned char *)input + length - 4, 4, base64_values);
+  if (m < 0) {
+    return -1;
+  }
+  return n + m;
+}
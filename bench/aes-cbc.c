@@ -0,0 +1,39 @@
+/*
+ * bench/aes-cbc.c: benchmarks for ../aes-cbc.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/bench/aes-cbc.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../aes.h"
+#include "../aes-decrypt.h"
+#include "../aes-cbc.h"
+#include "bench.h"
+
+static struct aes_key key;
+
+static void bench_aes_cbc_encrypt(unsigned char *output, const unsigned char *input, int length) {
+  aes_cbc_encrypt(output, bench_key, input, length, &key);
+}
+
+/* The input as ciphertext, whose (random) padding is checked after the decryption */
+static void bench_aes_cbc_decrypt(unsigned char *output, const unsigned char *input, int length) {
+  aes_cbc_decrypt(output, bench_key, input, length, &key);
+}
+
+static void bench_aes_ecb_encrypt(unsigned char *output, const unsigned char *input, int length) {
+  aes_ecb_encrypt(output, input, length, &key);
+}
+
+int main(int argc, char **argv) {
+  if (bench_init()) {
+    return 1;
+  }
+  aes_set_key(&key, bench_key);
+  bench("aes_cbc_encrypt", bench_aes_cbc_encrypt, 16, 16L << 20);
+  bench("aes_cbc_decrypt", bench_aes_cbc_decrypt, 16, 16L << 20);
+  bench("aes_ecb_encrypt", bench_aes_ecb_encrypt, 16, 16L << 20);
+  return 0;
+}
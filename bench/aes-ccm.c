@@ -0,0 +1,30 @@
+/*
+ * bench/aes-ccm.c: benchmarks for ../aes-ccm.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/bench/aes-ccm.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../aes.h"
+#include "../aes-ccm.h"
+#include "bench.h"
+
+static void bench_aes_ccm_encrypt(unsigned char *output, const unsigned char *input, int length) {
+  aes_ccm_encrypt(output, 16, bench_key, 12, NULL, 0, input, length, bench_key);
+}
+
+/* The MAC check fails, but only after all the work (decryption and MAC) is done */
+static void bench_aes_ccm_decrypt(unsigned char *output, const unsigned char *input, int length) {
+  aes_ccm_decrypt(output, 16, bench_key, 12, NULL, 0, input, length + 16, bench_key);
+}
+
+int main(int argc, char **argv) {
+  if (bench_init()) {
+    return 1;
+  }
+  bench("aes_ccm_encrypt", bench_aes_ccm_encrypt, 16, 16L << 20);
+  bench("aes_ccm_decrypt", bench_aes_ccm_decrypt, 16, 16L << 20);
+  return 0;
+}
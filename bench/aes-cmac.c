@@ -0,0 +1,40 @@
+/*
+ * bench/aes-cmac.c: benchmarks for ../aes-cmac.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/bench/aes-cmac.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../aes.h"
+#include "../aes-cmac.h"
+#include "bench.h"
+
+static struct aes_cmac_key key;
+
+static void bench_aes_cmac(unsigned char *output, const unsigned char *input, int length) {
+  aes_cmac(output, &key, input, length);
+}
+
+/* The input as 8 messages of length / 8 bytes */
+static void bench_aes_cmac_many(unsigned char *output, const unsigned char *input, int length) {
+  const void *messages[8];
+  int lengths[8], i;
+
+  for (i = 0; i < 8; i++) {
+    messages[i] = input + i * (length / 8);
+    lengths[i] = length / 8;
+  }
+  aes_cmac_many(output, &key, messages, lengths, 8);
+}
+
+int main(int argc, char **argv) {
+  if (bench_init()) {
+    return 1;
+  }
+  aes_cmac_set_key(&key, bench_key);
+  bench("aes_cmac", bench_aes_cmac, 16, 16L << 20);
+  bench("aes_cmac_many", bench_aes_cmac_many, 128, 16L << 20);
+  return 0;
+}
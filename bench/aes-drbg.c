@@ -0,0 +1,49 @@
+/*
+ * bench/aes-drbg.c: benchmarks for ../aes-drbg.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/bench/aes-drbg.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../aes.h"
+#include "../aes-drbg.h"
+#include "bench.h"
+
+static struct aes_drbg drbg;
+
+/* Fixed entropy input, as only the time of the reseeds matters here */
+static int bench_entropy(void *arg, void *buffer, int length) {
+  int i;
+
+  for (i = 0; i < length; i++) {
+    ((unsigned char *)buffer)[i] = bench_key[i % 16];
+  }
+  return 0;
+}
+
+/* length bytes of random output (the input is not used), from the buffer */
+static void bench_aes_drbg_generate(unsigned char *output, const unsigned char *input, int length) {
+  aes_drbg_generate(&drbg, output, length);
+}
+
+/* length bytes of random output, in Generate requests of up to AES_DRBG_MAX_REQUEST bytes */
+static void bench_aes_drbg_request(unsigned char *output, const unsigned char *input, int length) {
+  int n;
+
+  for (; length > 0; length -= n, output += n) {
+    n = length < AES_DRBG_MAX_REQUEST ? length : AES_DRBG_MAX_REQUEST;
+    aes_drbg_request(&drbg, output, n, 0, 0);
+  }
+}
+
+int main(int argc, char **argv) {
+  if (bench_init()) {
+    return 1;
+  }
+  aes_drbg_init(&drbg, bench_entropy, 0, 0, 0, 1L << 20);
+  bench("aes_drbg_generate", bench_aes_drbg_generate, 16, 16L << 20);
+  bench("aes_drbg_request", bench_aes_drbg_request, 16, 16L << 20);
+  return 0;
+}
@@ -0,0 +1,30 @@
+/*
+ * bench/aes-gcm.c: benchmarks for ../aes-gcm.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/bench/aes-gcm.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../aes.h"
+#include "../aes-gcm.h"
+#include "bench.h"
+
+static void bench_aes_gcm_encrypt(unsigned char *output, const unsigned char *input, int length) {
+  aes_gcm_encrypt(output, output + length, bench_key, input, length, NULL, 0, bench_key);
+}
+
+/* With no tag to check (tag_length 0), the tag is computed and the ciphertext decrypted */
+static void bench_aes_gcm_decrypt(unsigned char *output, const unsigned char *input, int length) {
+  aes_gcm_decrypt(output, bench_key, input, length, NULL, 0, output + length, 0, bench_key);
+}
+
+int main(int argc, char **argv) {
+  if (bench_init()) {
+    return 1;
+  }
+  bench("aes_gcm_encrypt", bench_aes_gcm_encrypt, 16, 16L << 20);
+  bench("aes_gcm_decrypt", bench_aes_gcm_decrypt, 16, 16L << 20);
+  return 0;
+}
@@ -0,0 +1,25 @@
+/*
+ * bench/aes-kw.c: benchmarks for ../aes-kw.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/bench/aes-kw.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../aes.h"
+#include "../aes-decrypt.h"
+#include "../aes-kw.h"
+#include "bench.h"
+
+static void bench_aes_kw(unsigned char *output, const unsigned char *input, int length) {
+  aes_kw(output, input, length / 8, bench_key);
+}
+
+int main(int argc, char **argv) {
+  if (bench_init()) {
+    return 1;
+  }
+  bench("aes_kw", bench_aes_kw, 16, 16L << 20);
+  return 0;
+}
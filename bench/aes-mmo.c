@@ -0,0 +1,24 @@
+/*
+ * bench/aes-mmo.c: benchmarks for ../aes-mmo.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/bench/aes-mmo.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../aes.h"
+#include "../aes-mmo.h"
+#include "bench.h"
+
+static void bench_aes_mmo(unsigned char *output, const unsigned char *input, int length) {
+  aes_mmo(output, input, length);
+}
+
+int main(int argc, char **argv) {
+  if (bench_init()) {
+    return 1;
+  }
+  bench("aes_mmo", bench_aes_mmo, 16, 16L << 20);
+  return 0;
+}
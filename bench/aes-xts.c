@@ -0,0 +1,40 @@
+/*
+ * bench/aes-xts.c: benchmarks for ../aes-xts.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/bench/aes-xts.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../aes.h"
+#include "../aes-decrypt.h"
+#include "../aes-xts.h"
+#include "bench.h"
+
+static struct aes_xts_key key;
+
+/* The input as one sector */
+static void bench_aes_xts_encrypt(unsigned char *output, const unsigned char *input, int length) {
+  aes_xts_encrypt(output, input, length, bench_key, &key);
+}
+
+/* The input as sectors of 512 bytes */
+static void bench_aes_xts_encrypt_sectors(unsigned char *output, const unsigned char *input, int length) {
+  aes_xts_encrypt_sectors(output, input, 512, length / 512, bench_key, &key);
+}
+
+static void bench_aes_xts_decrypt_sectors(unsigned char *output, const unsigned char *input, int length) {
+  aes_xts_decrypt_sectors(output, input, 512, length / 512, bench_key, &key);
+}
+
+int main(int argc, char **argv) {
+  if (bench_init()) {
+    return 1;
+  }
+  aes_xts_set_key(&key, bench_key, bench_key + 8);
+  bench("aes_xts_encrypt", bench_aes_xts_encrypt, 16, 16L << 20);
+  bench("aes_xts_encrypt_sectors", bench_aes_xts_encrypt_sectors, 512, 16L << 20);
+  bench("aes_xts_decrypt_sectors", bench_aes_xts_decrypt_sectors, 512, 16L << 20);
+  return 0;
+}
@@ -0,0 +1,31 @@
+/*
+ * bench/aes.c: benchmarks for ../aes.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/bench/aes.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../aes.h"
+#include "bench.h"
+
+static struct aes_key key;
+
+static void bench_aes_encrypt(unsigned char *output, const unsigned char *input, int length) {
+  aes_encrypt(output, input, bench_key);
+}
+
+static void bench_aes_encrypt_blocks(unsigned char *output, const unsigned char *input, int length) {
+  aes_encrypt_blocks(output, input, length / 16, &key);
+}
+
+int main(int argc, char **argv) {
+  if (bench_init()) {
+    return 1;
+  }
+  aes_set_key(&key, bench_key);
+  bench("aes_encrypt", bench_aes_encrypt, 16, 16);
+  bench("aes_encrypt_blocks", bench_aes_encrypt_blocks, 16, 16L << 20);
+  return 0;
+}
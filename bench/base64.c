@@ -0,0 +1,23 @@
+/*
+ * bench/base64.c: benchmarks for ../base64.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/bench/base64.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../base64.h"
+#include "bench.h"
+
+static void bench_base64_encode(unsigned char *output, const unsigned char *input, int length) {
+  base64_encode(output, input, length);
+}
+
+int main(int argc, char **argv) {
+  if (bench_init()) {
+    return 1;
+  }
+  bench("base64_encode", bench_base64_encode, 16, 16L << 20);
+  return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * bench/bench.h: micro-benchmark harness for the bench programs
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/bench/bench.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Measures the time of a function over message sizes from 16 bytes (or more)
+ * to 16 MiB, in steps of 4x, with the data in the cache (warm) and not in the
+ * cache (cold), and prints one line of comma-separated values per size and
+ * mode, in the columns printed by bench/run.sh:
+ * name,bytes,cache,calls,ns_per_call,ns_per_byte,cycles_per_byte,mb_per_s
+ *
+ * Warm: every call has the same input and output buffers, which stay in the
+ * cache after the first call (for the sizes that fit).
+ * Cold: every call has new input and output buffers, taken in turn from a
+ * 256 MiB pool, larger than the last level caches, so that the data of a
+ * call has been evicted by the time it comes around again.
+ *
+ * The time is the processor time measured with clock(), over as many calls
+ * as it takes to reach BENCH_SECONDS (default 0.1). The cycles are those of
+ * the time stamp counter on x86 processors with GCC or Clang (reference
+ * cycles at the nominal frequency, not core cycles with turbo), or empty.
+ *
+ * Environment variables:
+ * BENCH_MAX: largest message size in bytes (default 16777216)
+ * BENCH_SECONDS: minimum time of each measurement (default 0.1)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_POOL (256L << 20)
+
+/*
+ * Function to measure.
+ * output: pointer to 2 * length + 64 bytes of memory for the output
+ * input: pointer to length bytes of input data
+ * length: number of bytes of input data
+ */
+typedef void (*bench_function)(unsigned char *output, const unsigned char *input, int length);
+
+static unsigned char *bench_pool;
+static long bench_max = 16L << 20;
+static double bench_seconds = 0.1;
+
+/* A 16-byte key, nonce or IV for the benchmarks */
+static const unsigned char bench_key[16] = {
+  0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f
+};
+
+/*
+ * Returns the time stamp counter, or 0 where there is none.
+ */
+static double bench_cycles(void) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  return (double)__builtin_ia32_rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/*
+ * Measures the function with messages of length bytes, and prints the results.
+ * name: name of the function in the results
+ * f: the function to measure
+ * length: number of bytes of the messages
+ * cold: nonzero to measure with data not in the cache
+ */
+static void bench_run(const char *name, bench_function f, int length, int cold) {
+  long stride, offset, calls, i;
+  double seconds, cycles;
+  clock_t t;
+
+  stride = ((long)length * 3 + 64 + 4095) & ~4095L;  /* input and output */
+  offset = 0;
+  f(bench_pool + length, bench_pool, length);  /* warm up the code and data */
+  for (calls = 1; ; calls *= 2) {
+    cycles = bench_cycles();
+    t = clock();
+    for (i = 0; i < calls; i++) {
+      if (cold) {
+        offset += stride;
+        if (offset + stride > BENCH_POOL) {
+          offset = 0;
+        }
+      }
+      f(bench_pool + offset + length, bench_pool + offset, length);
+    }
+    seconds = (double)(clock() - t) / CLOCKS_PER_SEC;
+    cycles = bench_cycles() - cycles;
+    if (seconds >= bench_seconds) {
+      break;
+    }
+  }
+
+  printf("%s,%d,%s,%ld,%.1f,%.3f,", name, length, cold ? "cold" : "warm", calls,
+         seconds * 1e9 / calls, seconds * 1e9 / calls / length);
+  if (cycles > 0) {
+    printf("%.3f", cycles / calls / length);
+  }
+  printf(",%.1f\n", length * (double)calls / seconds / 1e6);
+  fflush(stdout);
+}
+
+/*
+ * Measures the function with messages of each size, warm and cold.
+ * name: name of the function in the results
+ * f: the function to measure
+ * min: smallest number of bytes of the messages
+ * max: largest number of bytes of the messages (up to BENCH_MAX)
+ */
+static void bench(const char *name, bench_function f, long min, long max) {
+  long length;
+
+  for (length = min; length <= max && length <= bench_max; length *= 4) {
+    bench_run(name, f, (int)length, 0);
+    bench_run(name, f, (int)length, 1);
+  }
+}
+
+/*
+ * Reads the environment variables and allocates the pool of data.
+ * Returns 0 on success, or -1 if there is not enough memory.
+ */
+static int bench_init(void) {
+  const char *s;
+  long i;
+
+  if ((s = getenv("BENCH_MAX")) != NULL) {
+    bench_max = atol(s);
+  }
+  if ((s = getenv("BENCH_SECONDS")) != NULL) {
+    bench_seconds = atof(s);
+  }
+  bench_pool = (unsigned char *)malloc(BENCH_POOL);
+  if (!bench_pool) {
+    fputs("bench_init() failed to allocate memory\n", stderr);
+    return -1;
+  }
+  for (i = 0; i < BENCH_POOL; i++) {
+    bench_pool[i] = (unsigned char)(i * 7 + (i >> 12));
+  }
+  return 0;
+}
@@ -0,0 +1,8 @@
+#!/bin/sh
+# Usage: [BENCH_MAX=bytes] [BENCH_SECONDS=seconds] sh bench/run.sh bench/*.c
+set -e
+echo name,bytes,cache,calls,ns_per_call,ns_per_byte,cycles_per_byte,mb_per_s
+for c in $*; do
+	gcc -Wall -Werror -Wno-unused-function -ansi -pedantic -O2 $c
+	./a.out
+done
@@ -0,0 +1,23 @@
+/*
+ * bench/sha1.c: benchmarks for ../sha1.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/bench/sha1.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../sha1.h"
+#include "bench.h"
+
+static void bench_sha1(unsigned char *output, const unsigned char *input, int length) {
+  sha1(output, input, length);
+}
+
+int main(int argc, char **argv) {
+  if (bench_init()) {
+    return 1;
+  }
+  bench("sha1", bench_sha1, 16, 16L << 20);
+  return 0;
+}
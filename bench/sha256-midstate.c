@@ -0,0 +1,59 @@
+/*
+ * bench/sha256-midstate.c: benchmarks for ../sha256-midstate.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/bench/sha256-midstate.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../sha256.h"
+#include "../sha256-midstate.h"
+#include "bench.h"
+
+/* The input as 32-byte messages, hashed with sha256 */
+static void bench_sha256_of_32(unsigned char *output, const unsigned char *input, int length) {
+  int i;
+
+  for (i = 0; i + 32 <= length; i += 32) {
+    sha256(output + i, input + i, 32);
+  }
+}
+
+/* The input as 32-byte messages */
+static void bench_sha256_32(unsigned char *output, const unsigned char *input, int length) {
+  int i;
+
+  for (i = 0; i + 32 <= length; i += 32) {
+    sha256_32(output + i, input + i);
+  }
+}
+
+/* The input as 64-byte messages, hashed with sha256 */
+static void bench_sha256_of_64(unsigned char *output, const unsigned char *input, int length) {
+  int i;
+
+  for (i = 0; i + 64 <= length; i += 64) {
+    sha256(output + i / 2, input + i, 64);
+  }
+}
+
+/* The input as 64-byte messages (as the nodes of a Merkle tree) */
+static void bench_sha256_64(unsigned char *output, const unsigned char *input, int length) {
+  int i;
+
+  for (i = 0; i + 64 <= length; i += 64) {
+    sha256_64(output + i / 2, input + i);
+  }
+}
+
+int main(int argc, char **argv) {
+  if (bench_init()) {
+    return 1;
+  }
+  bench("sha256_of_32", bench_sha256_of_32, 32, 16L << 20);
+  bench("sha256_32", bench_sha256_32, 32, 16L << 20);
+  bench("sha256_of_64", bench_sha256_of_64, 64, 16L << 20);
+  bench("sha256_64", bench_sha256_64, 64, 16L << 20);
+  return 0;
+}
@@ -0,0 +1,23 @@
+/*
+ * bench/sha256.c: benchmarks for ../sha256.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/bench/sha256.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../sha256.h"
+#include "bench.h"
+
+static void bench_sha256(unsigned char *output, const unsigned char *input, int length) {
+  sha256(output, input, length);
+}
+
+int main(int argc, char **argv) {
+  if (bench_init()) {
+    return 1;
+  }
+  bench("sha256", bench_sha256, 16, 16L << 20);
+  return 0;
+}
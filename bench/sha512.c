@@ -0,0 +1,32 @@
+/*
+ * bench/sha512.c: benchmarks for ../sha512.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/bench/sha512.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../sha512.h"
+#include "bench.h"
+
+static void bench_sha512(unsigned char *output, const unsigned char *input, int length) {
+  sha512(output, input, length);
+}
+
+/* The portable compression function, on pairs of 32-bit words */
+static void bench_sha512_generic(unsigned char *output, const unsigned char *input, int length) {
+  unsigned h[16] = {0};
+
+  sha512_compress_generic(h, input, length / 128);
+  output[0] = (unsigned char)h[0];
+}
+
+int main(int argc, char **argv) {
+  if (bench_init()) {
+    return 1;
+  }
+  bench("sha512", bench_sha512, 16, 16L << 20);
+  bench("sha512_compress_generic", bench_sha512_generic, 128, 16L << 20);
+  return 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * crumbs-cpu.h: processor feature detection for the accelerated code paths
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/crumbs-cpu.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Detects the processor features used by the accelerated code paths of the
+ * other headers (aes.h, aes-decrypt.h, aes-gcm.h, aes-xts.h, base64.h, sha1.h,
+ * sha256.h, sha256-midstate.h, sha512.h and the multi-buffer headers), once
+ * for all of them, and caches the result.
+ * Each header includes it, so it only needs to be copied along with them.
+ *
+ * Every function that has accelerated implementations checks the features
+ * it needs with crumbs_cpu_has on each call (a load and a well predicted
+ * branch) and calls the fastest implementation, or the portable one.
+ *
+ * The features can be restricted, to pin a code path for tests and
+ * benchmarks, with a mask of the CRUMBS_CPU_* bits below:
+ * - at compile time, by defining the CRUMBS_CPU macro (as -DCRUMBS_CPU=0x0f)
+ * - at run time, with the CRUMBS_CPU environment variable (as CRUMBS_CPU=0
+ *   for the portable code only), read along with the detection
+ * Defining CRUMBS_GENERIC leaves out all the accelerated code at compile time.
+ *
+ * The detection needs GCC or Clang (or a compatible compiler), on x86
+ * (CPUID and XGETBV) or AArch64 (where NEON is always available).
+ *
+ * References:
+ * [SDM] Intel 64 and IA-32 Architectures Software Developer's Manual,
+ *       Volume 2A, CPUID - CPU Identification
+ */
+
+#ifndef CRUMBS_CPU_H
+#define CRUMBS_CPU_H
+
+#define CRUMBS_CPU_AESNI 0x01
+#define CRUMBS_CPU_PCLMUL 0x02
+#define CRUMBS_CPU_SSSE3 0x04
+#define CRUMBS_CPU_SSE41 0x08
+#define CRUMBS_CPU_AVX2 0x10
+#define CRUMBS_CPU_SHANI 0x20
+#define CRUMBS_CPU_NEON 0x40
+
+#ifndef CRUMBS_CPU
+#define CRUMBS_CPU 0x7f
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(CRUMBS_GENERIC)
+#define CRUMBS_CPU_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#include <stdlib.h>
+#elif defined(__GNUC__) && defined(__aarch64__) && !defined(CRUMBS_GENERIC)
+#define CRUMBS_CPU_ARM
+#include <arm_neon.h>
+#include <stdlib.h>
+#endif
+
+#if defined(CRUMBS_CPU_X86) || defined(CRUMBS_CPU_ARM)
+/*
+ * Returns the CRUMBS_CPU_* bits of the features of the processor,
+ * restricted by the CRUMBS_CPU macro and environment variable.
+ * The detection is done only on the first call.
+ */
+static int crumbs_cpu(void) {
+  static int features = -1;
+  const char *mask;
+  int f;
+#ifdef CRUMBS_CPU_X86
+  unsigned eax, ebx, ecx, edx, max;
+#endif
+
+  if (features < 0) {
+    f = 0;
+#ifdef CRUMBS_CPU_X86
+    max = __get_cpuid_max(0, 0);
+    if (max >= 1) {
+      __cpuid(1, eax, ebx, ecx, edx);
+      f |= (ecx >> 25 & 1) ? CRUMBS_CPU_AESNI : 0;
+      f |= (ecx >> 1 & 1) ? CRUMBS_CPU_PCLMUL : 0;
+      f |= (ecx >> 9 & 1) ? CRUMBS_CPU_SSSE3 : 0;
+      f |= (ecx >> 19 & 1) ? CRUMBS_CPU_SSE41 : 0;
+      if (max >= 7) {
+        if (ecx >> 27 & 1) {  /* OSXSAVE */
+          __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+          if ((eax & 6) == 6) {  /* the OS saves the XMM and YMM registers */
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+            f |= (ebx >> 5 & 1) ? CRUMBS_CPU_AVX2 : 0;
+          }
+        }
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        f |= (ebx >> 29 & 1) ? CRUMBS_CPU_SHANI : 0;
+      }
+    }
+#else
+    f = CRUMBS_CPU_NEON;
+#endif
+    f &= CRUMBS_CPU;
+    mask = getenv("CRUMBS_CPU");
+    if (mask) {
+      f &= (int)strtol(mask, NULL, 0);
+    }
+    features = f;
+  }
+  return features;
+}
+
+/*
+ * Returns nonzero if the processor has all the features, CRUMBS_CPU_* bits.
+ */
+__attribute__((unused))
+static int crumbs_cpu_has(int features) {
+  return (crumbs_cpu() & features) == features;
+}
+#endif
+
+#endif
@@ -0,0 +1,329 @@
+/*
+ * git-object.h: Git object identifiers
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/git-object.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Computes the object IDs of git objects, which are the SHA-1 (or SHA-256)
+ * message digests of the object header "<type> <length>\0" followed by the
+ * object data, without concatenating the header and the data in memory.
+ *
+ * The git_object_*_many functions compute the IDs of many objects at once,
+ * keeping 8 objects in flight in the lanes of sha1-mb.h or sha256-mb.h.
+ *
+ * Uses the functions in sha1.h, sha1-mb.h, sha256.h and sha256-mb.h,
+ * so you need to include those too:
+ * #include "sha1.h"
+ * #include "sha1-mb.h"
+ * #include "sha256.h"
+ * #include "sha256-mb.h"
+ * #include "git-object.h"
+ *
+ * References:
+ * [GIT] Git Internals - Git Objects, Pro Git, 2nd edition, section 10.2
+ *       https://git-scm.com/book/en/v2/Git-Internals-Git-Objects
+ */
+
+/*
+ * An object for the git_object_*_many functions.
+ * type: null-terminated object type ("blob", "tree", "commit" or "tag")
+ * data: pointer to the object data
+ * length: number of bytes of the object data
+ */
+struct git_object {
+  const char *type;
+  const void *data;
+  int length;
+};
+
+/*
+ * Internal function that formats the object header "<type> <length>\0".
+ * header: pointer to memory to store the header, at least strlen(type) + 12 bytes
+ * type: null-terminated object type
+ * length: number of bytes of the object data
+ * Returns the number of bytes of the header, including the null terminator.
+ */
+static int git_object_header(char *header, const char *type, int length) {
+  char digits[10];
+  int i, n;
+
+  for (n = 0; type[n]; n++) {
+    header[n] = type[n];
+  }
+  header[n++] = ' ';
+  i = 0;
+  do {
+    digits[i++] = '0' + length % 10;
+    length /= 10;
+  } while (length > 0);
+  while (i > 0) {
+    header[n++] = digits[--i];
+  }
+  header[n++] = '\0';
+  return n;
+}
+
+/*
+ * Adds the object header "<type> <length>\0" to an incremental SHA-1
+ * computation, to be followed by sha1_update calls with the object data
+ * (useful for objects that are not in memory all at once).
+ * ctx: pointer to a context just initialized with sha1_init
+ * type: null-terminated object type ("blob", "tree", "commit" or "tag")
+ * length: number of bytes of the object data
+ */
+static void git_object_sha1_header(struct sha1_context *ctx, const char *type, int length) {
+  char header[32];
+
+  sha1_update(ctx, header, git_object_header(header, type, length));
+}
+
+/*
+ * Adds the object header "<type> <length>\0" to an incremental SHA-256
+ * computation, to be followed by sha256_update calls with the object data.
+ * ctx: pointer to a context just initialized with sha256_init
+ * type: null-terminated object type ("blob", "tree", "commit" or "tag")
+ * length: number of bytes of the object data
+ */
+static void git_object_sha256_header(struct sha256_context *ctx, const char *type, int length) {
+  char header[32];
+
+  sha256_update(ctx, header, git_object_header(header, type, length));
+}
+
+/*
+ * Computes the SHA-1 object ID of a git object.
+ * id: pointer to 20 bytes to store the object ID
+ * type: null-terminated object type ("blob", "tree", "commit" or "tag")
+ * data: pointer to the object data
+ * length: number of bytes of the object data
+ */
+static void git_object_sha1(void *id, const char *type, const void *data, int length) {
+  struct sha1_context ctx;
+
+  sha1_init(&ctx);
+  git_object_sha1_header(&ctx, type, length);
+  sha1_update(&ctx, data, length);
+  sha1_final(&ctx, id);
+}
+
+/*
+ * Computes the SHA-256 object ID of a git object.
+ * id: pointer to 32 bytes to store the object ID
+ * type: null-terminated object type ("blob", "tree", "commit" or "tag")
+ * data: pointer to the object data
+ * length: number of bytes of the object data
+ */
+static void git_object_sha256(void *id, const char *type, const void *data, int length) {
+  struct sha256_context ctx;
+
+  sha256_init(&ctx);
+  git_object_sha256_header(&ctx, type, length);
+  sha256_update(&ctx, data, length);
+  sha256_final(&ctx, id);
+}
+
+/*
+ * Computes the SHA-1 object IDs of many git objects.
+ * ids: pointer to count * 20 bytes to store the object IDs, in order
+ * objects: pointer to the objects
+ * count: number of objects
+ *
+ * Each lane of sha1_compress_x8 hashes one object: the header and the
+ * start of the data are hashed with sha1_update up to a block boundary,
+ * then the lanes compress whole blocks directly from the object data,
+ * and each object is finished with sha1_update/sha1_final when it has
+ * less than a block left, freeing its lane for the next object.
+ */
+static void git_object_sha1_many(void *ids, const struct git_object *objects, int count) {
+  struct sha1_context ctx[8];
+  unsigned h[5][8];  /* intermediate hash values of the lanes */
+  const void *blocks[8];
+  const unsigned char *p[8];  /* next block of each lane */
+  int remaining[8];  /* bytes of data left to hash in each lane */
+  int object[8];  /* index of the object in each lane, or -1 if idle */
+  int busy, last, next;
+  int i, l, n;
+
+  for (l = 0; l < 8; l++) {
+    object[l] = -1;
+  }
+  next = 0;
+  for (;;) {
+    busy = 0;
+    last = 0;
+    for (l = 0; l < 8; l++) {
+      /* Finish the object in this lane when it has less than a block left */
+      if (object[l] >= 0 && remaining[l] < 64) {
+        sha1_update(&ctx[l], p[l], remaining[l]);
+        sha1_final(&ctx[l], (unsigned char *)ids + object[l] * 20);
+        object[l] = -1;
+      }
+      /* Start the next object in an idle lane, and check it again */
+      if (object[l] < 0 && next < count) {
+        object[l] = next++;
+        sha1_init(&ctx[l]);
+        git_object_sha1_header(&ctx[l], objects[object[l]].type, objects[object[l]].length);
+        n = 64 - (ctx[l].length[0] & 63);
+        if (n > objects[object[l]].length) {
+          n = objects[object[l]].length;
+        }
+        sha1_update(&ctx[l], objects[object[l]].data, n);
+        p[l] = (const unsigned char *)objects[object[l]].data + n;
+        remaining[l] = objects[object[l]].length - n;
+        l--;
+        continue;
+      }
+      if (object[l] >= 0) {
+        busy++;
+        last = l;
+      }
+    }
+    if (busy == 0) {
+      break;
+    }
+    if (busy == 1 && next == count) {
+      /* Hash the last object on its own rather than along with idle lanes */
+      sha1_update(&ctx[last], p[last], remaining[last]);
+      p[last] += remaining[last];
+      remaining[last] = 0;
+      continue;
+    }
+
+    /* Compress whole blocks until a lane has less than a block left */
+    n = 0x7fffffff;
+    for (l = 0; l < 8; l++) {
+      blocks[l] = 0;
+      if (object[l] >= 0) {
+        if (remaining[l] / 64 < n) {
+          n = remaining[l] / 64;
+        }
+        for (i = 0; i < 5; i++) {
+          h[i][l] = ctx[l].h[i];
+        }
+      }
+    }
+    for (i = 0; i < n; i++) {
+      for (l = 0; l < 8; l++) {
+        if (object[l] >= 0) {
+          blocks[l] = p[l] + i * 64;
+        }
+      }
+      sha1_compress_x8(h, blocks);
+    }
+    for (l = 0; l < 8; l++) {
+      if (object[l] >= 0) {
+        for (i = 0; i < 5; i++) {
+          ctx[l].h[i] = h[i][l];
+        }
+        p[l] += n * 64;
+        remaining[l] -= n * 64;
+        ctx[l].length[0] += n * 64;
+      }
+    }
+  }
+}
+
+/*
+ * Computes the SHA-256 object IDs of many git objects.
+ * ids: pointer to count * 32 bytes to store the object IDs, in order
+ * objects: pointer to the objects
+ * count: number of objects
+ *
+ * Each lane of sha256_compress_x8 hashes one object: the header and the
+ * start of the data are hashed with sha256_update up to a block boundary,
+ * then the lanes compress whole blocks directly from the object data,
+ * and each object is finished with sha256_update/sha256_final when it has
+ * less than a block left, freeing its lane for the next object.
+ */
+static void git_object_sha256_many(void *ids, const struct git_object *objects, int count) {
+  struct sha256_context ctx[8];
+  unsigned h[8][8];  /* intermediate hash values of the lanes */
+  const void *blocks[8];
+  const unsigned char *p[8];  /* next block of each lane */
+  int remaining[8];  /* bytes of data left to hash in each lane */
+  int object[8];  /* index of the object in each lane, or -1 if idle */
+  int busy, last, next;
+  int i, l, n;
+
+  for (l = 0; l < 8; l++) {
+    object[l] = -1;
+  }
+  next = 0;
+  for (;;) {
+    busy = 0;
+    last = 0;
+    for (l = 0; l < 8; l++) {
+      /* Finish the object in this lane when it has less than a block left */
+      if (object[l] >= 0 && remaining[l] < 64) {
+        sha256_update(&ctx[l], p[l], remaining[l]);
+        sha256_final(&ctx[l], (unsigned char *)ids + object[l] * 32);
+        object[l] = -1;
+      }
+      /* Start the next object in an idle lane, and check it again */
+      if (object[l] < 0 && next < count) {
+        object[l] = next++;
+        sha256_init(&ctx[l]);
+        git_object_sha256_header(&ctx[l], objects[object[l]].type, objects[object[l]].length);
+        n = 64 - (ctx[l].length[0] & 63);
+        if (n > objects[object[l]].length) {
+          n = objects[object[l]].length;
+        }
+        sha256_update(&ctx[l], objects[object[l]].data, n);
+        p[l] = (const unsigned char *)objects[object[l]].data + n;
+        remaining[l] = objects[object[l]].length - n;
+        l--;
+        continue;
+      }
+      if (object[l] >= 0) {
+        busy++;
+        last = l;
+      }
+    }
+    if (busy == 0) {
+      break;
+    }
+    if (busy == 1 && next == count) {
+      /* Hash the last object on its own rather than along with idle lanes */
+      sha256_update(&ctx[last], p[last], remaining[last]);
+      p[last] += remaining[last];
+      remaining[last] = 0;
+      continue;
+    }
+
+    /* Compress whole blocks until a lane has less than a block left */
+    n = 0x7fffffff;
+    for (l = 0; l < 8; l++) {
+      blocks[l] = 0;
+      if (object[l] >= 0) {
+        if (remaining[l] / 64 < n) {
+          n = remaining[l] / 64;
+        }
+        for (i = 0; i < 8; i++) {
+          h[i][l] = ctx[l].h[i];
+        }
+      }
+    }
+    for (i = 0; i < n; i++) {
+      for (l = 0; l < 8; l++) {
+        if (object[l] >= 0) {
+          blocks[l] = p[l] + i * 64;
+        }
+      }
+      sha256_compress_x8(h, blocks);
+    }
+    for (l = 0; l < 8; l++) {
+      if (object[l] >= 0) {
+        for (i = 0; i < 8; i++) {
+          ctx[l].h[i] = h[i][l];
+        }
+        p[l] += n * 64;
+        remaining[l] -= n * 64;
+        ctx[l].length[0] += n * 64;
+      }
+    }
+  }
+}
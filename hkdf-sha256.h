@@ -0,0 +1,96 @@
+/*
+ * hkdf-sha256.h: HMAC-based Extract-and-Expand Key Derivation Function with SHA-256
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/hkdf-sha256.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Implements HKDF with HMAC-SHA256.
+ *
+ * The expand step takes the pseudorandom key prepared as an HMAC-SHA256 key
+ * (see hmac_sha256_set_key), so that deriving several keys from the same
+ * PRK, for example with different info strings, does not hash the
+ * ipad and opad blocks again.
+ *
+ * Uses the functions in sha256.h and hmac-sha256.h, so you need to include those too:
+ * #include "sha256.h"
+ * #include "hmac-sha256.h"
+ * #include "hkdf-sha256.h"
+ *
+ * References:
+ * [RFC5869] HMAC-based Extract-and-Expand Key Derivation Function (HKDF), May 2010
+ */
+
+/*
+ * Computes the HKDF-Extract step.
+ * prk: pointer to 32 bytes of memory to store the pseudorandom key
+ * salt: pointer to the salt (may be NULL if salt_length is 0)
+ * salt_length: number of bytes of the salt
+ * ikm: pointer to the input keying material
+ * ikm_length: number of bytes of the input keying material
+ *
+ * [RFC5869] 2.2 Step 1: Extract
+ */
+static void hkdf_sha256_extract(void *prk, const void *salt, int salt_length, const void *ikm, int ikm_length) {
+  struct hmac_sha256_key key;
+
+  /* An absent salt is 32 zero bytes, the same HMAC key as an empty one */
+  hmac_sha256_set_key(&key, salt, salt_length);
+  hmac_sha256(prk, &key, ikm, ikm_length);
+}
+
+/*
+ * Computes the HKDF-Expand step.
+ * okm: pointer to okm_length bytes of memory to store the output keying material
+ * okm_length: number of bytes of the output keying material (at most 255 * 32)
+ * prk: pointer to the pseudorandom key, prepared with hmac_sha256_set_key
+ * info: pointer to the context and application specific information
+ * info_length: number of bytes of info
+ *
+ * [RFC5869] 2.3 Step 2: Expand
+ */
+static void hkdf_sha256_expand(void *okm, int okm_length, const struct hmac_sha256_key *prk, const void *info, int info_length) {
+  struct hmac_sha256_context ctx;
+  unsigned char t[32];
+  unsigned char n;
+  int i, j;
+
+  /* T(n) = HMAC-Hash(PRK, T(n-1) | info | n), T(0) = empty string */
+  for (i = 0, n = 1; i < okm_length; i += 32, n++) {
+    hmac_sha256_init(&ctx, prk);
+    if (n > 1) {
+      hmac_sha256_update(&ctx, t, 32);
+    }
+    hmac_sha256_update(&ctx, info, info_length);
+    hmac_sha256_update(&ctx, &n, 1);
+    hmac_sha256_final(&ctx, t);
+    for (j = 0; j < 32 && i + j < okm_length; j++) {
+      ((unsigned char *)okm)[i + j] = t[j];
+    }
+  }
+}
+
+/*
+ * Derives keying material with HKDF-SHA256 (extract then expand).
+ * okm: pointer to okm_length bytes of memory to store the output keying material
+ * okm_length: number of bytes of the output keying material (at most 255 * 32)
+ * salt: pointer to the salt (may be NULL if salt_length is 0)
+ * salt_length: number of bytes of the salt
+ * ikm: pointer to the input keying material
+ * ikm_length: number of bytes of the input keying material
+ * info: pointer to the context and application specific information
+ * info_length: number of bytes of info
+ *
+ * [RFC5869] 2. HMAC-based Key Derivation Function (HKDF)
+ */
+static void hkdf_sha256(void *okm, int okm_length, const void *salt, int salt_length, const void *ikm, int ikm_length, const void *info, int info_length) {
+  struct hmac_sha256_key key;
+  unsigned char prk[32];
+
+  hkdf_sha256_extract(prk, salt, salt_length, ikm, ikm_length);
+  hmac_sha256_set_key(&key, prk, 32);
+  hkdf_sha256_expand(okm, okm_length, &key, info, info_length);
+}
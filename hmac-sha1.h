@@ -0,0 +1,168 @@
+/*
+ * hmac-sha1.h: Keyed-Hash Message Authentication Code with SHA-1 (HMAC-SHA1)
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/hmac-sha1.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Implements HMAC-SHA1, both as the one-shot hmac_sha1 function and as
+ * the incremental hmac_sha1_init, hmac_sha1_update and hmac_sha1_final
+ * functions.
+ *
+ * The key is prepared once with hmac_sha1_set_key, which compresses the
+ * (K xor ipad) and (K xor opad) blocks and keeps the resulting intermediate
+ * hash values, so that each MAC only compresses the message blocks plus one
+ * final block for the outer hash, without allocating or copying buffers.
+ *
+ * Uses the functions in sha1.h, so you need to include that too:
+ * #include "sha1.h"
+ * #include "hmac-sha1.h"
+ *
+ * References:
+ * [HMAC] The Keyed-Hash Message Authentication Code (HMAC),
+ *        FIPS PUB 198-1, Jul 2008
+ *        http://nvlpubs.nist.gov/nistpubs/FIPS/NIST.FIPS.198-1.pdf
+ * [RFC2202] Test Cases for HMAC-MD5 and HMAC-SHA-1, Sep 1997
+ */
+
+/*
+ * A prepared HMAC-SHA1 key.
+ * inner: SHA-1 intermediate hash value after the (K0 xor ipad) block
+ * outer: SHA-1 intermediate hash value after the (K0 xor opad) block
+ */
+struct hmac_sha1_key {
+  unsigned inner[5];
+  unsigned outer[5];
+};
+
+/*
+ * Context of an incremental HMAC-SHA1 computation.
+ * inner: the inner hash computation, H((K0 xor ipad) || text)
+ * outer: SHA-1 intermediate hash value after the (K0 xor opad) block
+ */
+struct hmac_sha1_context {
+  struct sha1_context inner;
+  unsigned outer[5];
+};
+
+/*
+ * Prepares an HMAC-SHA1 key.
+ * key: pointer to the prepared key to initialize
+ * secret: pointer to the secret key K
+ * length: number of bytes of the secret key
+ *
+ * [HMAC] 4. HMAC Specification, steps 1 to 3 and 7
+ */
+static void hmac_sha1_set_key(struct hmac_sha1_key *key, const void *secret, int length) {
+  struct sha1_context ctx;
+  unsigned char k0[64];
+  int i;
+
+  /* Steps 1-3: K0 = K, or H(K), padded with zeros to 64 bytes */
+  if (length > 64) {
+    sha1(k0, secret, length);
+    length = 20;
+  } else {
+    for (i = 0; i < length; i++) {
+      k0[i] = ((const unsigned char *)secret)[i];
+    }
+  }
+  for (i = length; i < 64; i++) {
+    k0[i] = 0;
+  }
+
+  /* Step 4: K0 xor ipad */
+  for (i = 0; i < 64; i++) {
+    k0[i] ^= 0x36;
+  }
+  sha1_init(&ctx);
+  sha1_compress(ctx.h, k0, 1);
+  for (i = 0; i < 5; i++) {
+    key->inner[i] = ctx.h[i];
+  }
+
+  /* Step 7: K0 xor opad (0x36 ^ 0x6a = 0x5c) */
+  for (i = 0; i < 64; i++) {
+    k0[i] ^= 0x6a;
+  }
+  sha1_init(&ctx);
+  sha1_compress(ctx.h, k0, 1);
+  for (i = 0; i < 5; i++) {
+    key->outer[i] = ctx.h[i];
+  }
+}
+
+/*
+ * Starts an incremental HMAC-SHA1 computation.
+ * ctx: pointer to the context to initialize
+ * key: pointer to the key prepared with hmac_sha1_set_key
+ */
+static void hmac_sha1_init(struct hmac_sha1_context *ctx, const struct hmac_sha1_key *key) {
+  int i;
+
+  for (i = 0; i < 5; i++) {
+    ctx->inner.h[i] = key->inner[i];
+    ctx->outer[i] = key->outer[i];
+  }
+  ctx->inner.length[0] = 64;  /* the (K0 xor ipad) block */
+  ctx->inner.length[1] = 0;
+}
+
+/*
+ * Adds a part of the message to an incremental HMAC-SHA1 computation.
+ * ctx: pointer to the context
+ * data: pointer to the next part of the message
+ * length: number of bytes of the part of the message
+ */
+static void hmac_sha1_update(struct hmac_sha1_context *ctx, const void *data, int length) {
+  sha1_update(&ctx->inner, data, length);
+}
+
+/*
+ * Finishes an incremental HMAC-SHA1 computation.
+ * ctx: pointer to the context
+ * mac: pointer to 20 bytes (160 bits) of memory to store the MAC
+ *
+ * [HMAC] 4. HMAC Specification, steps 6, 8 and 9
+ */
+static void hmac_sha1_final(struct hmac_sha1_context *ctx, void *mac) {
+  unsigned char block[64];
+  int i;
+
+  /* Step 6: H((K0 xor ipad) || text) */
+  sha1_final(&ctx->inner, block);
+
+  /* Steps 8-9: H((K0 xor opad) || H((K0 xor ipad) || text)), a single padded block */
+  block[20] = 0x80;
+  for (i = 21; i < 62; i++) {
+    block[i] = 0;
+  }
+  block[62] = (64 + 20) * 8 >> 8;
+  block[63] = (64 + 20) * 8 & 0xff;
+  sha1_compress(ctx->outer, block, 1);
+
+  for (i = 0; i < 5; i++) {
+    ((unsigned char *)mac)[i * 4 + 0] = ctx->outer[i] >> 24;
+    ((unsigned char *)mac)[i * 4 + 1] = ctx->outer[i] >> 16;
+    ((unsigned char *)mac)[i * 4 + 2] = ctx->outer[i] >> 8;
+    ((unsigned char *)mac)[i * 4 + 3] = ctx->outer[i];
+  }
+}
+
+/*
+ * Computes the HMAC-SHA1 of a message.
+ * mac: pointer to 20 bytes (160 bits) of memory to store the MAC
+ * key: pointer to the key prepared with hmac_sha1_set_key
+ * message: pointer to the message
+ * length: number of bytes of the message
+ */
+static void hmac_sha1(void *mac, const struct hmac_sha1_key *key, const void *message, int length) {
+  struct hmac_sha1_context ctx;
+
+  hmac_sha1_init(&ctx, key);
+  hmac_sha1_update(&ctx, message, length);
+  hmac_sha1_final(&ctx, mac);
+}
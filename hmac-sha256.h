@@ -0,0 +1,169 @@
+/*
+ * hmac-sha256.h: Keyed-Hash Message Authentication Code with SHA-256 (HMAC-SHA256)
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/hmac-sha256.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Implements HMAC-SHA256, both as the one-shot hmac_sha256 function and as
+ * the incremental hmac_sha256_init, hmac_sha256_update and hmac_sha256_final
+ * functions.
+ *
+ * The key is prepared once with hmac_sha256_set_key, which compresses the
+ * (K xor ipad) and (K xor opad) blocks and keeps the resulting intermediate
+ * hash values, so that each MAC only compresses the message blocks plus one
+ * final block for the outer hash, without allocating or copying buffers.
+ *
+ * Uses the functions in sha256.h, so you need to include that too:
+ * #include "sha256.h"
+ * #include "hmac-sha256.h"
+ *
+ * References:
+ * [HMAC] The Keyed-Hash Message Authentication Code (HMAC),
+ *        FIPS PUB 198-1, Jul 2008
+ *        http://nvlpubs.nist.gov/nistpubs/FIPS/NIST.FIPS.198-1.pdf
+ * [RFC4231] Identifiers and Test Vectors for HMAC-SHA-224, HMAC-SHA-256,
+ *           HMAC-SHA-384, and HMAC-SHA-512, Dec 2005
+ */
+
+/*
+ * A prepared HMAC-SHA256 key.
+ * inner: SHA-256 intermediate hash value after the (K0 xor ipad) block
+ * outer: SHA-256 intermediate hash value after the (K0 xor opad) block
+ */
+struct hmac_sha256_key {
+  unsigned inner[8];
+  unsigned outer[8];
+};
+
+/*
+ * Context of an incremental HMAC-SHA256 computation.
+ * inner: the inner hash computation, H((K0 xor ipad) || text)
+ * outer: SHA-256 intermediate hash value after the (K0 xor opad) block
+ */
+struct hmac_sha256_context {
+  struct sha256_context inner;
+  unsigned outer[8];
+};
+
+/*
+ * Prepares an HMAC-SHA256 key.
+ * key: pointer to the prepared key to initialize
+ * secret: pointer to the secret key K
+ * length: number of bytes of the secret key
+ *
+ * [HMAC] 4. HMAC Specification, steps 1 to 3 and 7
+ */
+static void hmac_sha256_set_key(struct hmac_sha256_key *key, const void *secret, int length) {
+  struct sha256_context ctx;
+  unsigned char k0[64];
+  int i;
+
+  /* Steps 1-3: K0 = K, or H(K), padded with zeros to 64 bytes */
+  if (length > 64) {
+    sha256(k0, secret, length);
+    length = 32;
+  } else {
+    for (i = 0; i < length; i++) {
+      k0[i] = ((const unsigned char *)secret)[i];
+    }
+  }
+  for (i = length; i < 64; i++) {
+    k0[i] = 0;
+  }
+
+  /* Step 4: K0 xor ipad */
+  for (i = 0; i < 64; i++) {
+    k0[i] ^= 0x36;
+  }
+  sha256_init(&ctx);
+  sha256_compress(ctx.h, k0, 1);
+  for (i = 0; i < 8; i++) {
+    key->inner[i] = ctx.h[i];
+  }
+
+  /* Step 7: K0 xor opad (0x36 ^ 0x6a = 0x5c) */
+  for (i = 0; i < 64; i++) {
+    k0[i] ^= 0x6a;
+  }
+  sha256_init(&ctx);
+  sha256_compress(ctx.h, k0, 1);
+  for (i = 0; i < 8; i++) {
+    key->outer[i] = ctx.h[i];
+  }
+}
+
+/*
+ * Starts an incremental HMAC-SHA256 computation.
+ * ctx: pointer to the context to initialize
+ * key: pointer to the key prepared with hmac_sha256_set_key
+ */
+static void hmac_sha256_init(struct hmac_sha256_context *ctx, const struct hmac_sha256_key *key) {
+  int i;
+
+  for (i = 0; i < 8; i++) {
+    ctx->inner.h[i] = key->inner[i];
+    ctx->outer[i] = key->outer[i];
+  }
+  ctx->inner.length[0] = 64;  /* the (K0 xor ipad) block */
+  ctx->inner.length[1] = 0;
+}
+
+/*
+ * Adds a part of the message to an incremental HMAC-SHA256 computation.
+ * ctx: pointer to the context
+ * data: pointer to the next part of the message
+ * length: number of bytes of the part of the message
+ */
+static void hmac_sha256_update(struct hmac_sha256_context *ctx, const void *data, int length) {
+  sha256_update(&ctx->inner, data, length);
+}
+
+/*
+ * Finishes an incremental HMAC-SHA256 computation.
+ * ctx: pointer to the context
+ * mac: pointer to 32 bytes (256 bits) of memory to store the MAC
+ *
+ * [HMAC] 4. HMAC Specification, steps 6, 8 and 9
+ */
+static void hmac_sha256_final(struct hmac_sha256_context *ctx, void *mac) {
+  unsigned char block[64];
+  int i;
+
+  /* Step 6: H((K0 xor ipad) || text) */
+  sha256_final(&ctx->inner, block);
+
+  /* Steps 8-9: H((K0 xor opad) || H((K0 xor ipad) || text)), a single padded block */
+  block[32] = 0x80;
+  for (i = 33; i < 62; i++) {
+    block[i] = 0;
+  }
+  block[62] = (64 + 32) * 8 >> 8;
+  block[63] = (64 + 32) * 8 & 0xff;
+  sha256_compress(ctx->outer, block, 1);
+
+  for (i = 0; i < 8; i++) {
+    ((unsigned char *)mac)[i * 4 + 0] = ctx->outer[i] >> 24;
+    ((unsigned char *)mac)[i * 4 + 1] = ctx->outer[i] >> 16;
+    ((unsigned char *)mac)[i * 4 + 2] = ctx->outer[i] >> 8;
+    ((unsigned char *)mac)[i * 4 + 3] = ctx->outer[i];
+  }
+}
+
+/*
+ * Computes the HMAC-SHA256 of a message.
+ * mac: pointer to 32 bytes (256 bits) of memory to store the MAC
+ * key: pointer to the key prepared with hmac_sha256_set_key
+ * message: pointer to the message
+ * length: number of bytes of the message
+ */
+static void hmac_sha256(void *mac, const struct hmac_sha256_key *key, const void *message, int length) {
+  struct hmac_sha256_context ctx;
+
+  hmac_sha256_init(&ctx, key);
+  hmac_sha256_update(&ctx, message, length);
+  hmac_sha256_final(&ctx, mac);
+}
@@ -0,0 +1,161 @@
+/*
+ * pbkdf2-sha256.h: Password-Based Key Derivation Function 2 with HMAC-SHA256
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/pbkdf2-sha256.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Implements PBKDF2 with HMAC-SHA256 as the pseudorandom function.
+ *
+ * The password is prepared once as an HMAC-SHA256 key, and the salt is
+ * hashed once into a context that is reused for every block of the derived
+ * key. Each iteration U(j) = HMAC(P, U(j-1)) then costs exactly two
+ * compressions of a block holding the 32-byte U(j-1) followed by the fixed
+ * SHA-256 padding, which is written only once.
+ * When the derived key has 3 or more 32-byte blocks, up to 8 of them are
+ * iterated together in the lanes of sha256-mb.h.
+ *
+ * Uses the functions in sha256.h, sha256-mb.h and hmac-sha256.h,
+ * so you need to include those too:
+ * #include "sha256.h"
+ * #include "sha256-mb.h"
+ * #include "hmac-sha256.h"
+ * #include "pbkdf2-sha256.h"
+ *
+ * References:
+ * [RFC8018] PKCS #5: Password-Based Cryptography Specification Version 2.1,
+ *           section 5.2 PBKDF2, Jan 2017
+ */
+
+/*
+ * Internal function that stores 8 hash value words in big-endian order.
+ * output: pointer to 32 bytes of memory to store the words
+ * h: pointer to the first word
+ * stride: distance between consecutive words in h
+ */
+static void pbkdf2_sha256_store(unsigned char *output, const unsigned *h, int stride) {
+  int i;
+
+  for (i = 0; i < 8; i++) {
+    output[i * 4 + 0] = h[i * stride] >> 24;
+    output[i * 4 + 1] = h[i * stride] >> 16;
+    output[i * 4 + 2] = h[i * stride] >> 8;
+    output[i * 4 + 3] = h[i * stride];
+  }
+}
+
+/*
+ * Derives a key from a password with PBKDF2-HMAC-SHA256.
+ * dk: pointer to dk_length bytes of memory to store the derived key
+ * dk_length: number of bytes of the derived key
+ * password: pointer to the password
+ * password_length: number of bytes of the password
+ * salt: pointer to the salt
+ * salt_length: number of bytes of the salt
+ * iterations: iteration count (c)
+ *
+ * [RFC8018] 5.2 PBKDF2
+ */
+static void pbkdf2_sha256(void *dk, int dk_length, const void *password, int password_length, const void *salt, int salt_length, int iterations) {
+  struct hmac_sha256_key key;
+  struct hmac_sha256_context salted, ctx;
+  unsigned char u[8][64];  /* U(j) of each block, followed by the SHA-256 padding */
+  unsigned char t[8][32];  /* T(i) of each block */
+  unsigned h[8][8];  /* intermediate hash values, one block per lane */
+  const void *blocks[8];
+  unsigned char index[4];
+  int i, j, k, l, lanes;
+
+  hmac_sha256_set_key(&key, password, password_length);
+  hmac_sha256_init(&salted, &key);
+  hmac_sha256_update(&salted, salt, salt_length);
+
+  /* The 32-byte U(j-1) is the message of both hashes after the 64-byte pad block */
+  for (l = 0; l < 8; l++) {
+    u[l][32] = 0x80;
+    for (k = 33; k < 62; k++) {
+      u[l][k] = 0;
+    }
+    u[l][62] = (64 + 32) * 8 >> 8;
+    u[l][63] = (64 + 32) * 8 & 0xff;
+  }
+
+  for (i = 0; i * 32 < dk_length; i += lanes) {
+    lanes = (dk_length - i * 32 + 31) / 32;
+    if (lanes > 8) {
+      lanes = 8;
+    }
+
+    /* U(1) = PRF(P, S || INT(i)) */
+    for (l = 0; l < lanes; l++) {
+      index[0] = (i + l + 1) >> 24;
+      index[1] = (i + l + 1) >> 16;
+      index[2] = (i + l + 1) >> 8;
+      index[3] = (i + l + 1);
+      ctx = salted;
+      hmac_sha256_update(&ctx, index, 4);
+      hmac_sha256_final(&ctx, u[l]);
+      for (k = 0; k < 32; k++) {
+        t[l][k] = u[l][k];
+      }
+    }
+
+    /* U(j) = PRF(P, U(j-1)), T(i) = U(1) xor U(2) xor ... xor U(c) */
+    if (lanes < 3) {
+      for (l = 0; l < lanes; l++) {
+        for (j = 1; j < iterations; j++) {
+          for (k = 0; k < 8; k++) {
+            h[0][k] = key.inner[k];
+          }
+          sha256_compress(h[0], u[l], 1);
+          pbkdf2_sha256_store(u[l], h[0], 1);
+          for (k = 0; k < 8; k++) {
+            h[0][k] = key.outer[k];
+          }
+          sha256_compress(h[0], u[l], 1);
+          pbkdf2_sha256_store(u[l], h[0], 1);
+          for (k = 0; k < 32; k++) {
+            t[l][k] ^= u[l][k];
+          }
+        }
+      }
+    } else {
+      for (l = 0; l < 8; l++) {
+        blocks[l] = l < lanes ? u[l] : 0;
+      }
+      for (j = 1; j < iterations; j++) {
+        for (k = 0; k < 8; k++) {
+          for (l = 0; l < 8; l++) {
+            h[k][l] = key.inner[k];
+          }
+        }
+        sha256_compress_x8(h, blocks);
+        for (l = 0; l < lanes; l++) {
+          pbkdf2_sha256_store(u[l], &h[0][l], 8);
+        }
+        for (k = 0; k < 8; k++) {
+          for (l = 0; l < 8; l++) {
+            h[k][l] = key.outer[k];
+          }
+        }
+        sha256_compress_x8(h, blocks);
+        for (l = 0; l < lanes; l++) {
+          pbkdf2_sha256_store(u[l], &h[0][l], 8);
+          for (k = 0; k < 32; k++) {
+            t[l][k] ^= u[l][k];
+          }
+        }
+      }
+    }
+
+    /* DK = T(1) || T(2) || ... || T(l) truncated to dk_length bytes */
+    for (l = 0; l < lanes; l++) {
+      for (k = 0; k < 32 && (i + l) * 32 + k < dk_length; k++) {
+        ((unsigned char *)dk)[(i + l) * 32 + k] = t[l][k];
+      }
+    }
+  }
+}
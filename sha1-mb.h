@@ -0,0 +1,152 @@
+/*
+ * sha1-mb.h: Multi-buffer Secure Hash Algorithm 1 (SHA-1)
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/sha1-mb.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Implements the SHA-1 compression function on 8 independent messages
+ * at once, one message per lane, for hashing many messages in parallel.
+ *
+ * Every step is written as a loop over the 8 lanes, which compilers turn
+ * into SIMD instructions (two 4-lane SSE2 vectors on x86-64, or a single
+ * 8-lane vector when AVX2 is enabled). On processors with the SHA extensions
+ * the lanes are instead compressed one after the other with sha1.h's
+ * SHA-NI kernel, which is faster than the SIMD lanes.
+ *
+ * Uses the sha1_compress function in sha1.h, so you need to include that too:
+ * #include "sha1.h"
+ * #include "sha1-mb.h"
+ *
+ * References:
+ * [SHS] Secure Hash Standard (FIPS PUB 180-4), Aug 2015
+ *       http://nvlpubs.nist.gov/nistpubs/FIPS/NIST.FIPS.180-4.pdf
+ * [MB] Processing Multiple Buffers in Parallel to Increase Performance
+ *      on Intel Architecture Processors, Guilford et al., Intel, Jul 2010
+ */
+
+/*
+ * Updates 8 intermediate hash values with one 64-byte message block each.
+ * h: the intermediate hash value words, h[i][lane] is word i of a lane
+ * blocks: pointers to the 64-byte message block of each lane,
+ *         or NULL for an idle lane (whose hash value is left unchanged)
+ *
+ * [SHS] 6.1.2 SHA-1 Hash Computation
+ */
+static void sha1_compress_x8(unsigned h[5][8], const void **blocks) {
+  unsigned w[80][8];  /* message schedules */
+  unsigned a[8], b[8], c[8], d[8], e[8];  /* working variables */
+  unsigned tmp, x;
+  const unsigned char zero[64] = {0};
+  const unsigned char *m;
+  int l, t;
+
+#ifdef SHA1_SHANI
+  if (crumbs_cpu_has(SHA1_SHANI_FEATURES)) {
+    unsigned hl[5];
+
+    for (l = 0; l < 8; l++) {
+      if (blocks[l]) {
+        for (t = 0; t < 5; t++) {
+          hl[t] = h[t][l];
+        }
+        sha1_compress_shani(hl, blocks[l], 1);
+        for (t = 0; t < 5; t++) {
+          h[t][l] = hl[t];
+        }
+      }
+    }
+    return;
+  }
+#endif
+
+  /*
+   * 1. Prepare the message schedule W:
+   * For t = 0 to 15
+   *    Wt = M(i)t
+   * For t = 16 to 79
+   *    Wt = ROTL1(W(t-3) ^ W(t-8) ^ W(t-14) ^ W(t-16)
+   */
+  for (l = 0; l < 8; l++) {
+    m = blocks[l] ? (const unsigned char *)blocks[l] : zero;
+    for (t = 0; t < 16; t++) {
+      w[t][l] = (unsigned)m[t*4] << 24 | m[t*4+1] << 16 | m[t*4+2] << 8 | m[t*4+3];
+    }
+  }
+  for (t = 16; t < 80; t++) {
+    for (l = 0; l < 8; l++) {
+      x = w[t-3][l] ^ w[t-8][l] ^ w[t-14][l] ^ w[t-16][l];
+      w[t][l] = x << 1 | x >> 31;
+    }
+  }
+
+  /* 2. Initialize the five working variables */
+  for (l = 0; l < 8; l++) {
+    a[l] = h[0][l];
+    b[l] = h[1][l];
+    c[l] = h[2][l];
+    d[l] = h[3][l];
+    e[l] = h[4][l];
+  }
+
+  /*
+   * 3. (transform the working variables)
+   * T = ROTL5(a) + ft(b,c,d) + e + Kt + Wt
+   * [SHS] 4.1.1 SHA-1 Functions, [SHS] 4.2.1 SHA-1 Constants
+   */
+  for (t = 0; t < 20; t++) {
+    for (l = 0; l < 8; l++) {
+      tmp = (a[l] << 5 | a[l] >> 27) + ((b[l] & c[l]) ^ (~b[l] & d[l])) + e[l] + 0x5a827999 + w[t][l];
+      e[l] = d[l];
+      d[l] = c[l];
+      c[l] = b[l] << 30 | b[l] >> 2;
+      b[l] = a[l];
+      a[l] = tmp;
+    }
+  }
+  for (; t < 40; t++) {
+    for (l = 0; l < 8; l++) {
+      tmp = (a[l] << 5 | a[l] >> 27) + (b[l] ^ c[l] ^ d[l]) + e[l] + 0x6ed9eba1 + w[t][l];
+      e[l] = d[l];
+      d[l] = c[l];
+      c[l] = b[l] << 30 | b[l] >> 2;
+      b[l] = a[l];
+      a[l] = tmp;
+    }
+  }
+  for (; t < 60; t++) {
+    for (l = 0; l < 8; l++) {
+      tmp = (a[l] << 5 | a[l] >> 27) + ((b[l] & c[l]) ^ (b[l] & d[l]) ^ (c[l] & d[l])) + e[l] + 0x8f1bbcdc + w[t][l];
+      e[l] = d[l];
+      d[l] = c[l];
+      c[l] = b[l] << 30 | b[l] >> 2;
+      b[l] = a[l];
+      a[l] = tmp;
+    }
+  }
+  for (; t < 80; t++) {
+    for (l = 0; l < 8; l++) {
+      tmp = (a[l] << 5 | a[l] >> 27) + (b[l] ^ c[l] ^ d[l]) + e[l] + 0xca62c1d6 + w[t][l];
+      e[l] = d[l];
+      d[l] = c[l];
+      c[l] = b[l] << 30 | b[l] >> 2;
+      b[l] = a[l];
+      a[l] = tmp;
+    }
+  }
+
+  /* 4. Compute the ith intermediate hash values H(i) of the busy lanes */
+  for (l = 0; l < 8; l++) {
+    if (!blocks[l]) {
+      continue;
+    }
+    h[0][l] += a[l];
+    h[1][l] += b[l];
+    h[2][l] += c[l];
+    h[3][l] += d[l];
+    h[4][l] += e[l];
+  }
+}
@@ -8,69 +8,64 @@
  */
 
 /*
- * Computes the SHA-1 message digest of a message.
- * digest: pointer to 20 bytes (160 bits) to store the SHA-1 message digest
- * message: pointer to the input message
- * length: number of bytes of the input message
+ * Implements the SHA-1 hash function, both as the one-shot sha1 function
+ * (and sha1_v, for a message in a list of fragments)
+ * and as the incremental sha1_init, sha1_update and sha1_final functions.
+ *
+ * On x86 processors, when compiled with GCC or Clang, the blocks are
+ * compressed with the SHA extensions (SHA-NI) if the processor has them.
+ *
+ * The processor features are detected with crumbs-cpu.h, which needs to be
+ * in the same directory (and where the code paths can be pinned).
  *
  * References:
  * [SHS] Secure Hash Standard (FIPS PUB 180-4), Aug 2015
  *       http://nvlpubs.nist.gov/nistpubs/FIPS/NIST.FIPS.180-4.pdf
+ * [SHANI] Intel SHA Extensions, Gulley et al., Intel, Jul 2013
  */
-static void sha1(void *digest, const void *message, int length) {
-  unsigned char pad[64];  /* padded block */
+
+#include "crumbs-cpu.h"
+
+#ifdef CRUMBS_CPU_X86
+#define SHA1_SHANI
+#define SHA1_SHANI_FEATURES (CRUMBS_CPU_SHANI | CRUMBS_CPU_SSSE3 | CRUMBS_CPU_SSE41)
+#endif
+
+/*
+ * Context of an incremental SHA-1 computation.
+ * h: the intermediate hash value words
+ * block: the bytes of the current partial block
+ * length: number of bytes hashed so far (length[0] low word, length[1] high word)
+ */
+struct sha1_context {
+  unsigned h[5];
+  unsigned char block[64];
+  unsigned length[2];
+};
+
+/*
+ * Portable implementation of the SHA-1 compression function.
+ * h: pointer to the 5 intermediate hash value words to update
+ * blocks: pointer to count * 64 bytes of message blocks
+ * count: number of 64-byte message blocks
+ *
+ * [SHS] 6.1.2 SHA-1 Hash Computation
+ */
+static void sha1_compress_generic(unsigned *h, const void *blocks, int count) {
   unsigned w[16];  /* message schedule (ring buffer for a total of 80 elements) */
-  unsigned h[5];  /* hash value words */
   unsigned a, b, c, d, e;  /* working variables */
-  unsigned tmp, ft, kt, wt, wtr;
-  unsigned char *m;
-  int i, j, t;
-
-  /* [SHS] 5.3 Setting the Initial Hash Value H(0), 5.3.1 SHA-1 */
-  h[0] = 0x67452301;
-  h[1] = 0xefcdab89;
-  h[2] = 0x98badcfe;
-  h[3] = 0x10325476;
-  h[4] = 0xc3d2e1f0;
-
-  /* [SHS] 6.1.2 SHA-1 Hash Computation */
-  for (i = 0; i - 9 < length; i += 64) {  /* min pad = 9 bytes (0x80 + 64-bit length) */
-    m = (unsigned char *)message + i;
-    if (i > length - 64) {
-      /* [SHS] 5.1 Padding the Message, 5.1.1 SHA-1, SHA-224 and SHA-256 */
-      for (j = 0; j < length - i; j++) {
-        pad[j] = m[j];
-      }
-      if (i + j == length) {
-        pad[j++] = 0x80;
-      }
-      if (j > 56) {  /* penultimate block */
-        while (j < 64) {
-          pad[j++] = 0;
-        }
-      } else {  /* last block */
-        while (j < 56) {
-          pad[j++] = 0;
-        }
-        pad[56] = 0;  /* length >> 53; */
-        pad[57] = 0;  /* length >> 45; */
-        pad[58] = 0;  /* length >> 37; */
-        pad[59] = length >> 29;
-        pad[60] = length >> 21;
-        pad[61] = length >> 13;
-        pad[62] = length >> 5;
-        pad[63] = length << 3;
-      }
-      m = pad;
-    }
+  unsigned tmp, wt, wtr;
+  const unsigned char *m;
+  int t;
 
+  for (m = (const unsigned char *)blocks; count > 0; count--, m += 64) {
     /*
      * 1. Prepare the message schedule W (part 1):
      * For t = 0 to 15
      *    Wt = M(i)t
      */
     for (t = 0; t < 16; t++) {
-      w[t] = m[t*4] << 24 | m[t*4+1] << 16 | m[t*4+2] << 8 | m[t*4+3];
+      w[t] = (unsigned)m[t*4] << 24 | m[t*4+1] << 16 | m[t*4+2] << 8 | m[t*4+3];
     }
 
     /* 2. Initialize the five working variables */
@@ -80,36 +75,55 @@ static void sha1(void *digest, const void *message, int length) {
     d = h[3];
     e = h[4];
 
-    /* 3. (transform the working variables) */
-    for (t = 0; t < 80; t++) {
-      /*
-       * 1. Prepare the message schedule W (part 2):
-       * For t = 16 to 79
-       *    Wt = ROTL1(W(t-3) ^ W(t-8) ^ W(t-14) ^ W(t-16)
-       */
+    /*
+     * 3. (transform the working variables)
+     * T = ROTL5(a) + ft(b,c,d) + e + Kt + Wt
+     * [SHS] 4.1.1 SHA-1 Functions, [SHS] 4.2.1 SHA-1 Constants
+     *
+     * The 80 rounds are split in four loops of 20 rounds, one for each
+     * ft and Kt, so that no round has to select them.
+     * Each round also prepares the message schedule W (part 2) 16 rounds ahead:
+     * For t = 16 to 79
+     *    Wt = ROTL1(W(t-3) ^ W(t-8) ^ W(t-14) ^ W(t-16)
+     */
+    for (t = 0; t < 20; t++) {
       wt = w[t & 15];
-      wtr = w[(t-3) & 15] ^ w[(t-8) & 15] ^ w[(t-14) & 15] ^ wt;
+      wtr = w[(t+13) & 15] ^ w[(t+8) & 15] ^ w[(t+2) & 15] ^ wt;
       w[t & 15] = wtr << 1 | wtr >> 31;
-
-      /*
-       * T = ROTL5(a) + ft(b,c,d) + e + Kt + Wt
-       * [SHS] 4.1.1 SHA-1 Functions, [SHS] 4.2.1 SHA-1 Constants
-       */
-      if (t < 20) {
-        ft = (b & c) ^ (~b & d);
-        kt = 0x5a827999;
-      } else if (t < 40) {
-        ft = b ^ c ^ d;
-        kt = 0x6ed9eba1;
-      } else if (t < 60) {
-        ft = (b & c) ^ (b & d) ^ (c & d);
-        kt = 0x8f1bbcdc;
-      } else { /* if (t < 80) */
-        ft = b ^ c ^ d;
-        kt = 0xca62c1d6;
-      }
-      tmp = (a << 5 | a >> 27) + ft + e + kt + wt;
-
+      tmp = (a << 5 | a >> 27) + ((b & c) ^ (~b & d)) + e + 0x5a827999 + wt;
+      e = d;
+      d = c;
+      c = b << 30 | b >> 2;
+      b = a;
+      a = tmp;
+    }
+    for (; t < 40; t++) {
+      wt = w[t & 15];
+      wtr = w[(t+13) & 15] ^ w[(t+8) & 15] ^ w[(t+2) & 15] ^ wt;
+      w[t & 15] = wtr << 1 | wtr >> 31;
+      tmp = (a << 5 | a >> 27) + (b ^ c ^ d) + e + 0x6ed9eba1 + wt;
+      e = d;
+      d = c;
+      c = b << 30 | b >> 2;
+      b = a;
+      a = tmp;
+    }
+    for (; t < 60; t++) {
+      wt = w[t & 15];
+      wtr = w[(t+13) & 15] ^ w[(t+8) & 15] ^ w[(t+2) & 15] ^ wt;
+      w[t & 15] = wtr << 1 | wtr >> 31;
+      tmp = (a << 5 | a >> 27) + ((b & c) ^ (b & d) ^ (c & d)) + e + 0x8f1bbcdc + wt;
+      e = d;
+      d = c;
+      c = b << 30 | b >> 2;
+      b = a;
+      a = tmp;
+    }
+    for (; t < 80; t++) {
+      wt = w[t & 15];
+      wtr = w[(t+13) & 15] ^ w[(t+8) & 15] ^ w[(t+2) & 15] ^ wt;
+      w[t & 15] = wtr << 1 | wtr >> 31;
+      tmp = (a << 5 | a >> 27) + (b ^ c ^ d) + e + 0xca62c1d6 + wt;
       e = d;
       d = c;
       c = b << 30 | b >> 2;
@@ -124,12 +138,344 @@ static void sha1(void *digest, const void *message, int length) {
     h[3] += d;
     h[4] += e;
   }
+}
+
+#ifdef SHA1_SHANI
+/*
+ * Implementation of the SHA-1 compression function with the SHA extensions.
+ * Same parameters as sha1_compress_generic.
+ *
+ * Each sha1rnds4 instruction performs 4 rounds, sha1nexte computes the
+ * next value of e, and sha1msg1/sha1msg2 compute the message schedule.
+ * The message words are kept in reverse order (W0 in the highest lane).
+ *
+ * [SHANI] SHA-1 New Instructions
+ */
+__attribute__((target("sha,ssse3,sse4.1")))
+static void sha1_compress_shani(unsigned *h, const void *blocks, int count) {
+  const __m128i mask = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  __m128i abcd, abcd_save, e0, e0_save, e1;
+  __m128i msg0, msg1, msg2, msg3;
+  const unsigned char *m;
+
+  abcd = _mm_loadu_si128((const __m128i *)(const void *)h);
+  abcd = _mm_shuffle_epi32(abcd, 0x1b);
+  e0 = _mm_set_epi32(h[4], 0, 0, 0);
+
+  for (m = (const unsigned char *)blocks; count > 0; count--, m += 64) {
+    abcd_save = abcd;
+    e0_save = e0;
+
+    /* Rounds 0-3 */
+    msg0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(const void *)(m + 0)), mask);
+    e0 = _mm_add_epi32(e0, msg0);
+    e1 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+    /* Rounds 4-7 */
+    msg1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(const void *)(m + 16)), mask);
+    e1 = _mm_sha1nexte_epu32(e1, msg1);
+    e0 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+    msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+
+    /* Rounds 8-11 */
+    msg2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(const void *)(m + 32)), mask);
+    e0 = _mm_sha1nexte_epu32(e0, msg2);
+    e1 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+    msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+    msg0 = _mm_xor_si128(msg0, msg2);
+
+    /* Rounds 12-15 */
+    msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(const void *)(m + 48)), mask);
+    e1 = _mm_sha1nexte_epu32(e1, msg3);
+    e0 = abcd;
+    msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+    msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+    msg1 = _mm_xor_si128(msg1, msg3);
+
+    /* Rounds 16-19 */
+    e0 = _mm_sha1nexte_epu32(e0, msg0);
+    e1 = abcd;
+    msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+    msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+    msg2 = _mm_xor_si128(msg2, msg0);
+
+    /* Rounds 20-23 */
+    e1 = _mm_sha1nexte_epu32(e1, msg1);
+    e0 = abcd;
+    msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+    msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+    msg3 = _mm_xor_si128(msg3, msg1);
+
+    /* Rounds 24-27 */
+    e0 = _mm_sha1nexte_epu32(e0, msg2);
+    e1 = abcd;
+    msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 1);
+    msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+    msg0 = _mm_xor_si128(msg0, msg2);
+
+    /* Rounds 28-31 */
+    e1 = _mm_sha1nexte_epu32(e1, msg3);
+    e0 = abcd;
+    msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+    msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+    msg1 = _mm_xor_si128(msg1, msg3);
+
+    /* Rounds 32-35 */
+    e0 = _mm_sha1nexte_epu32(e0, msg0);
+    e1 = abcd;
+    msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 1);
+    msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+    msg2 = _mm_xor_si128(msg2, msg0);
+
+    /* Rounds 36-39 */
+    e1 = _mm_sha1nexte_epu32(e1, msg1);
+    e0 = abcd;
+    msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+    msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+    msg3 = _mm_xor_si128(msg3, msg1);
+
+    /* Rounds 40-43 */
+    e0 = _mm_sha1nexte_epu32(e0, msg2);
+    e1 = abcd;
+    msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+    msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+    msg0 = _mm_xor_si128(msg0, msg2);
+
+    /* Rounds 44-47 */
+    e1 = _mm_sha1nexte_epu32(e1, msg3);
+    e0 = abcd;
+    msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 2);
+    msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+    msg1 = _mm_xor_si128(msg1, msg3);
+
+    /* Rounds 48-51 */
+    e0 = _mm_sha1nexte_epu32(e0, msg0);
+    e1 = abcd;
+    msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+    msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+    msg2 = _mm_xor_si128(msg2, msg0);
+
+    /* Rounds 52-55 */
+    e1 = _mm_sha1nexte_epu32(e1, msg1);
+    e0 = abcd;
+    msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 2);
+    msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+    msg3 = _mm_xor_si128(msg3, msg1);
+
+    /* Rounds 56-59 */
+    e0 = _mm_sha1nexte_epu32(e0, msg2);
+    e1 = abcd;
+    msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+    msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+    msg0 = _mm_xor_si128(msg0, msg2);
+
+    /* Rounds 60-63 */
+    e1 = _mm_sha1nexte_epu32(e1, msg3);
+    e0 = abcd;
+    msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+    msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+    msg1 = _mm_xor_si128(msg1, msg3);
+
+    /* Rounds 64-67 */
+    e0 = _mm_sha1nexte_epu32(e0, msg0);
+    e1 = abcd;
+    msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+    msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+    msg2 = _mm_xor_si128(msg2, msg0);
+
+    /* Rounds 68-71 */
+    e1 = _mm_sha1nexte_epu32(e1, msg1);
+    e0 = abcd;
+    msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+    msg3 = _mm_xor_si128(msg3, msg1);
+
+    /* Rounds 72-75 */
+    e0 = _mm_sha1nexte_epu32(e0, msg2);
+    e1 = abcd;
+    msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+
+    /* Rounds 76-79 */
+    e1 = _mm_sha1nexte_epu32(e1, msg3);
+    e0 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+
+    /* Compute the ith intermediate hash value H(i) */
+    e0 = _mm_sha1nexte_epu32(e0, e0_save);
+    abcd = _mm_add_epi32(abcd, abcd_save);
+  }
+
+  abcd = _mm_shuffle_epi32(abcd, 0x1b);
+  _mm_storeu_si128((__m128i *)(void *)h, abcd);
+  h[4] = _mm_extract_epi32(e0, 3);
+}
+#endif
+
+/*
+ * Updates the intermediate hash value with count 64-byte message blocks,
+ * using the fastest implementation available on the processor.
+ * h: pointer to the 5 intermediate hash value words to update
+ * blocks: pointer to count * 64 bytes of message blocks
+ * count: number of 64-byte message blocks
+ */
+static void sha1_compress(unsigned *h, const void *blocks, int count) {
+#ifdef SHA1_SHANI
+  if (crumbs_cpu_has(SHA1_SHANI_FEATURES)) {
+    sha1_compress_shani(h, blocks, count);
+    return;
+  }
+#endif
+  sha1_compress_generic(h, blocks, count);
+}
+
+/*
+ * Starts an incremental SHA-1 computation.
+ * ctx: pointer to the context to initialize
+ *
+ * [SHS] 5.3 Setting the Initial Hash Value H(0), 5.3.1 SHA-1
+ */
+static void sha1_init(struct sha1_context *ctx) {
+  ctx->h[0] = 0x67452301;
+  ctx->h[1] = 0xefcdab89;
+  ctx->h[2] = 0x98badcfe;
+  ctx->h[3] = 0x10325476;
+  ctx->h[4] = 0xc3d2e1f0;
+  ctx->length[0] = 0;
+  ctx->length[1] = 0;
+}
+
+/*
+ * Adds a part of the message to an incremental SHA-1 computation.
+ * The message can be split at any byte boundary.
+ * ctx: pointer to the context
+ * data: pointer to the next part of the message
+ * length: number of bytes of the part of the message
+ */
+static void sha1_update(struct sha1_context *ctx, const void *data, int length) {
+  const unsigned char *p;
+  int i, n;
+
+  p = (const unsigned char *)data;
+  n = ctx->length[0] & 63;  /* bytes in the partial block */
+  ctx->length[0] += length;
+  if (ctx->length[0] < (unsigned)length) {
+    ctx->length[1]++;
+  }
+
+  /* Complete the partial block */
+  if (n > 0) {
+    for (i = 0; n < 64 && i < length; i++) {
+      ctx->block[n++] = p[i];
+    }
+    if (n < 64) {
+      return;
+    }
+    sha1_compress(ctx->h, ctx->block, 1);
+    p += i;
+    length -= i;
+  }
+
+  /* Process the full blocks directly from the message */
+  if (length >= 64) {
+    sha1_compress(ctx->h, p, length / 64);
+    p += length & ~63;
+    length &= 63;
+  }
+
+  /* Keep the remaining bytes for the next call */
+  for (i = 0; i < length; i++) {
+    ctx->block[i] = p[i];
+  }
+}
+
+/*
+ * Finishes an incremental SHA-1 computation.
+ * ctx: pointer to the context
+ * digest: pointer to 20 bytes (160 bits) to store the SHA-1 message digest
+ *
+ * [SHS] 5.1 Padding the Message, 5.1.1 SHA-1, SHA-224 and SHA-256
+ */
+static void sha1_final(struct sha1_context *ctx, void *digest) {
+  unsigned hi, lo;  /* message length in bits */
+  int i, n;
+
+  hi = ctx->length[1] << 3 | ctx->length[0] >> 29;
+  lo = ctx->length[0] << 3;
+
+  n = ctx->length[0] & 63;
+  ctx->block[n++] = 0x80;
+  if (n > 56) {  /* penultimate block */
+    while (n < 64) {
+      ctx->block[n++] = 0;
+    }
+    sha1_compress(ctx->h, ctx->block, 1);
+    n = 0;
+  }
+  while (n < 56) {  /* last block */
+    ctx->block[n++] = 0;
+  }
+  ctx->block[56] = hi >> 24;
+  ctx->block[57] = hi >> 16;
+  ctx->block[58] = hi >> 8;
+  ctx->block[59] = hi;
+  ctx->block[60] = lo >> 24;
+  ctx->block[61] = lo >> 16;
+  ctx->block[62] = lo >> 8;
+  ctx->block[63] = lo;
+  sha1_compress(ctx->h, ctx->block, 1);
 
   /* Store the resulting 160-bit message digest */
   for (i = 0; i < 5; i++) {
-    ((unsigned char *)digest)[i * 4 + 0] = h[i] >> 24;
-    ((unsigned char *)digest)[i * 4 + 1] = h[i] >> 16;
-    ((unsigned char *)digest)[i * 4 + 2] = h[i] >> 8;
-    ((unsigned char *)digest)[i * 4 + 3] = h[i];
+    ((unsigned char *)digest)[i * 4 + 0] = ctx->h[i] >> 24;
+    ((unsigned char *)digest)[i * 4 + 1] = ctx->h[i] >> 16;
+    ((unsigned char *)digest)[i * 4 + 2] = ctx->h[i] >> 8;
+    ((unsigned char *)digest)[i * 4 + 3] = ctx->h[i];
   }
 }
+
+/*
+ * Computes the SHA-1 message digest of a message in a list of fragments
+ * (as with writev), without copying them into a contiguous buffer.
+ * digest: pointer to 20 bytes (160 bits) to store the SHA-1 message digest
+ * parts: pointers to the fragments of the input message
+ * lengths: number of bytes of each fragment
+ * count: number of fragments
+ */
+static void sha1_v(void *digest, const void **parts, const int *lengths, int count) {
+  struct sha1_context ctx;
+  int i;
+
+  sha1_init(&ctx);
+  for (i = 0; i < count; i++) {
+    sha1_update(&ctx, parts[i], lengths[i]);
+  }
+  sha1_final(&ctx, digest);
+}
+
+/*
+ * Computes the SHA-1 message digest of a message.
+ * digest: pointer to 20 bytes (160 bits) to store the SHA-1 message digest
+ * message: pointer to the input message
+ * length: number of bytes of the input message
+ */
+static void sha1(void *digest, const void *message, int length) {
+  sha1_v(digest, &message, &length, 1);
+}
@@ -0,0 +1,69 @@
+/*
+ * sha256-base64.h: base 64 encoded SHA-256 digests for HTTP headers
+ *
+ * https://github.com/andrebdo/c-crumbs/sha256-base64.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Finishes an incremental SHA-256 computation (started with sha256_init and
+ * fed with sha256_update as the message is produced) by storing the base 64
+ * encoded message digest straight into the caller's buffer, for example a
+ * header being formatted, either bare or as a Digest header value or ETag.
+ * None of the functions store a null terminator.
+ *
+ * Uses the functions in sha256.h and base64.h, so you need to include those too:
+ * #include "sha256.h"
+ * #include "base64.h"
+ * #include "sha256-base64.h"
+ *
+ * References:
+ * [RFC3230] Instance Digests in HTTP, 4.3.2 Digest
+ * [RFC9110] HTTP Semantics, 8.8.3 ETag
+ */
+
+/*
+ * Finishes an incremental SHA-256 computation with a base 64 encoded digest.
+ * ctx: pointer to the context
+ * output: pointer to 44 bytes of memory to store the base 64 encoded SHA-256 digest
+ * Returns the number of bytes stored in output, always 44.
+ */
+static int sha256_base64_final(struct sha256_context *ctx, void *output) {
+  unsigned char digest[32];
+
+  sha256_final(ctx, digest);
+  return base64_encode(output, digest, 32);
+}
+
+/*
+ * Finishes an incremental SHA-256 computation with a digest header value:
+ * "sha-256=" followed by the base 64 encoded digest.
+ * ctx: pointer to the context
+ * output: pointer to 52 bytes of memory to store the header value
+ * Returns the number of bytes stored in output, always 52.
+ */
+static int sha256_digest_final(struct sha256_context *ctx, void *output) {
+  const char prefix[8] = { 's', 'h', 'a', '-', '2', '5', '6', '=' };
+  int i;
+
+  for (i = 0; i < 8; i++) {
+    ((char *)output)[i] = prefix[i];
+  }
+  return 8 + sha256_base64_final(ctx, (char *)output + 8);
+}
+
+/*
+ * Finishes an incremental SHA-256 computation with a strong entity tag:
+ * the base 64 encoded digest in double quotes.
+ * ctx: pointer to the context
+ * output: pointer to 46 bytes of memory to store the entity tag
+ * Returns the number of bytes stored in output, always 46.
+ */
+static int sha256_etag_final(struct sha256_context *ctx, void *output) {
+  ((char *)output)[0] = '"';
+  sha256_base64_final(ctx, (char *)output + 1);
+  ((char *)output)[45] = '"';
+  return 46;
+}
@@ -0,0 +1,144 @@
+/*
+ * sha256-mb.h: Multi-buffer Secure Hash Algorithm 256 (SHA-256)
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/sha256-mb.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Implements the SHA-256 compression function on 8 independent messages
+ * at once, one message per lane, for hashing many messages in parallel.
+ *
+ * Every step is written as a loop over the 8 lanes, which compilers turn
+ * into SIMD instructions (two 4-lane SSE2 vectors on x86-64, or a single
+ * 8-lane vector when AVX2 is enabled). Without SIMD, the 8 lanes are still
+ * 8 independent dependency chains for the processor to overlap.
+ *
+ * When sha256.h is included before it, on processors with the SHA extensions
+ * the lanes are instead compressed one after the other with sha256.h's
+ * SHA-NI kernel, which is faster than the SIMD lanes.
+ *
+ * References:
+ * [SHS] Secure Hash Standard (FIPS PUB 180-4), Aug 2015
+ *       http://nvlpubs.nist.gov/nistpubs/FIPS/NIST.FIPS.180-4.pdf
+ * [MB] Processing Multiple Buffers in Parallel to Increase Performance
+ *      on Intel Architecture Processors, Guilford et al., Intel, Jul 2010
+ */
+
+/*
+ * Updates 8 intermediate hash values with one 64-byte message block each.
+ * h: the intermediate hash value words, h[i][lane] is word i of a lane
+ * blocks: pointers to the 64-byte message block of each lane,
+ *         or NULL for an idle lane (whose hash value is left unchanged)
+ *
+ * [SHS] 6.2.2 SHA-256 Hash Computation
+ */
+static void sha256_compress_x8(unsigned h[8][8], const void **blocks) {
+  /* [SHS] 4.2.2 SHA-224 and SHA-256 Constants */
+  const unsigned k[64] = {
+    0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
+    0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
+    0xe49b69c1,0xefbe4786,0x0fc19dc6,0x240ca1cc,0x2de92c6f,0x4a7484aa,0x5cb0a9dc,0x76f988da,
+    0x983e5152,0xa831c66d,0xb00327c8,0xbf597fc7,0xc6e00bf3,0xd5a79147,0x06ca6351,0x14292967,
+    0x27b70a85,0x2e1b2138,0x4d2c6dfc,0x53380d13,0x650a7354,0x766a0abb,0x81c2c92e,0x92722c85,
+    0xa2bfe8a1,0xa81a664b,0xc24b8b70,0xc76c51a3,0xd192e819,0xd6990624,0xf40e3585,0x106aa070,
+    0x19a4c116,0x1e376c08,0x2748774c,0x34b0bcb5,0x391c0cb3,0x4ed8aa4a,0x5b9cca4f,0x682e6ff3,
+    0x748f82ee,0x78a5636f,0x84c87814,0x8cc70208,0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
+  };
+  unsigned w[64][8];  /* message schedules */
+  unsigned a[8], b[8], c[8], d[8], e[8], f[8], g[8], hh[8];  /* working variables */
+  unsigned t1, t2, x, y;
+  const unsigned char zero[64] = {0};
+  const unsigned char *m;
+  int l, t;
+
+#ifdef SHA256_SHANI
+  if (crumbs_cpu_has(SHA256_SHANI_FEATURES)) {
+    unsigned hl[8];
+
+    for (l = 0; l < 8; l++) {
+      if (blocks[l]) {
+        for (t = 0; t < 8; t++) {
+          hl[t] = h[t][l];
+        }
+        sha256_compress_shani(hl, blocks[l], 1);
+        for (t = 0; t < 8; t++) {
+          h[t][l] = hl[t];
+        }
+      }
+    }
+    return;
+  }
+#endif
+
+  /*
+   * 1. Prepare the message schedule W:
+   * For t = 0 to 15
+   *    Wt = M(i)t
+   * For t = 16 to 63
+   *    Wt = SSIG1(W(t-2)) + W(t-7) + SSIG0(t-15) + W(t-16)
+   */
+  for (l = 0; l < 8; l++) {
+    m = blocks[l] ? (const unsigned char *)blocks[l] : zero;
+    for (t = 0; t < 16; t++) {
+      w[t][l] = (unsigned)m[t*4] << 24 | m[t*4+1] << 16 | m[t*4+2] << 8 | m[t*4+3];
+    }
+  }
+  for (t = 16; t < 64; t++) {
+    for (l = 0; l < 8; l++) {
+      x = w[t-2][l];
+      y = w[t-15][l];
+      w[t][l] = ((x>>17)^(x<<15) ^ (x>>19)^(x<<13) ^ (x>>10)) + w[t-7][l]
+              + ((y>>7)^(y<<25) ^ (y>>18)^(y<<14) ^ (y>>3)) + w[t-16][l];
+    }
+  }
+
+  /* 2. Initialize the eight working variables */
+  for (l = 0; l < 8; l++) {
+    a[l] = h[0][l];
+    b[l] = h[1][l];
+    c[l] = h[2][l];
+    d[l] = h[3][l];
+    e[l] = h[4][l];
+    f[l] = h[5][l];
+    g[l] = h[6][l];
+    hh[l] = h[7][l];
+  }
+
+  /* 3. (transform the working variables) */
+  for (t = 0; t < 64; t++) {
+    for (l = 0; l < 8; l++) {
+      /* T1 = h + BSIG1(e) + CH(e,f,g) + Kt + Wt */
+      t1 = hh[l] + ((e[l]>>6)^(e[l]<<26)^(e[l]>>11)^(e[l]<<21)^(e[l]>>25)^(e[l]<<7))
+         + ((e[l]&f[l])^(~e[l]&g[l])) + k[t] + w[t][l];
+      /* T2 = BSIG0(a) + MAJ(a,b,c) */
+      t2 = ((a[l]>>2)^(a[l]<<30)^(a[l]>>13)^(a[l]<<19)^(a[l]>>22)^(a[l]<<10))
+         + ((a[l]&b[l])^(a[l]&c[l])^(b[l]&c[l]));
+      hh[l] = g[l];
+      g[l] = f[l];
+      f[l] = e[l];
+      e[l] = d[l] + t1;
+      d[l] = c[l];
+      c[l] = b[l];
+      b[l] = a[l];
+      a[l] = t1 + t2;
+    }
+  }
+
+  /* 4. Compute the ith intermediate hash values H(i) of the busy lanes */
+  for (l = 0; l < 8; l++) {
+    if (!blocks[l]) {
+      continue;
+    }
+    h[0][l] += a[l];
+    h[1][l] += b[l];
+    h[2][l] += c[l];
+    h[3][l] += d[l];
+    h[4][l] += e[l];
+    h[5][l] += f[l];
+    h[6][l] += g[l];
+    h[7][l] += hh[l];
+  }
+}
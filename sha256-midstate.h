@@ -0,0 +1,242 @@
+/*
+ * sha256-midstate.h: SHA-256 midstates and messages of 32 and 64 bytes
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/sha256-midstate.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Speeds up two frequent kinds of SHA-256 computations:
+ *
+ * Messages that start with a fixed prefix (a domain separation tag, a
+ * protocol header, an HMAC pad): sha256_midstate gets the intermediate hash
+ * value (the midstate) after the whole blocks of the prefix, once, and
+ * sha256_resume starts each computation from it, so that the prefix is not
+ * hashed again.
+ *
+ * Messages of exactly 32 bytes (a digest, as in double SHA-256) or 64 bytes
+ * (two digests, as the nodes of Merkle trees): sha256_32 and sha256_64 skip
+ * the context and the padding code. The 32-byte message and its padding fit
+ * in one block, whose last 8 words (the padding) are constants. The 64-byte
+ * message is followed by a whole block of padding, the same for all the
+ * messages, so its message schedule (plus the round constants) is
+ * precomputed, and only its rounds remain (about 3/4 of a compression).
+ *
+ * Uses the functions in sha256.h, so you need to include that too:
+ * #include "sha256.h"
+ * #include "sha256-midstate.h"
+ *
+ * References:
+ * [SHS] Secure Hash Standard (FIPS PUB 180-4), Aug 2015
+ *       http://nvlpubs.nist.gov/nistpubs/FIPS/NIST.FIPS.180-4.pdf
+ * [SHANI] Intel SHA Extensions, Gulley et al., Intel, Jul 2013
+ */
+
+/*
+ * The message schedule Wt plus the round constant Kt of the padding block
+ * of a 64-byte message: 0x80, zeros, and the length 512 bits.
+ */
+static const unsigned sha256_pad64_wk[64] = {
+  0xc28a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
+  0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf374,
+  0x649b69c1,0xf0fe4786,0x0fe1edc6,0x240cf254,0x4fe9346f,0x6cc984be,0x61b9411e,0x16f988fa,
+  0xf2c65152,0xa88e5a6d,0xb019fc65,0xb9d99ec7,0x9a1231c3,0xe70eeaa0,0xfdb1232b,0xc7353eb0,
+  0x3069bad5,0xcb976d5f,0x5a0f118f,0xdc1eeefd,0x0a35b689,0xde0b7a04,0x58f4ca9d,0xe15d5b16,
+  0x007f3e86,0x37088980,0xa507ea32,0x6fab9537,0x17406110,0x0d8cd6f1,0xcdaa3b6d,0xc0bbbe37,
+  0x83613bda,0xdb48a363,0x0b02e931,0x6fd15ca7,0x521afaca,0x31338431,0x6ed41a95,0x6d437890,
+  0xc39c91f2,0x9eccabbd,0xb5c9a0e6,0x532fb63c,0xd2c741c6,0x07237ea3,0xa4954b68,0x4c191d76
+};
+
+/*
+ * Portable implementation of the 64 rounds of the SHA-256 compression
+ * function, for one block with a precomputed message schedule.
+ * h: pointer to the 8 intermediate hash value words to update
+ * wk: pointer to the 64 words Wt + Kt of the block
+ *
+ * [SHS] 6.2.2 SHA-256 Hash Computation, steps 2 to 4
+ */
+static void sha256_rounds_generic(unsigned *h, const unsigned *wk) {
+  unsigned a, b, c, d, e, f, g, h7;  /* working variables */
+  unsigned t1, t2;
+  int t;
+
+  a = h[0];
+  b = h[1];
+  c = h[2];
+  d = h[3];
+  e = h[4];
+  f = h[5];
+  g = h[6];
+  h7 = h[7];
+  for (t = 0; t < 64; t++) {
+    /* T1 = h + BSIG1(e) + CH(e,f,g) + Kt + Wt */
+    t1 = h7 + ((e>>6)^(e<<26)^(e>>11)^(e<<21)^(e>>25)^(e<<7)) + ((e&f)^(~e&g)) + wk[t];
+    /* T2 = BSIG0(a) + MAJ(a,b,c) */
+    t2 = ((a>>2)^(a<<30)^(a>>13)^(a<<19)^(a>>22)^(a<<10)) + ((a&b)^(a&c)^(b&c));
+    h7 = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  h[0] += a;
+  h[1] += b;
+  h[2] += c;
+  h[3] += d;
+  h[4] += e;
+  h[5] += f;
+  h[6] += g;
+  h[7] += h7;
+}
+
+#ifdef SHA256_SHANI
+/*
+ * Implementation of the 64 rounds of the SHA-256 compression function
+ * with the SHA extensions, for one block with a precomputed message schedule.
+ * Same parameters as sha256_rounds_generic.
+ *
+ * [SHANI] SHA-256 New Instructions
+ */
+__attribute__((target("sha,ssse3,sse4.1")))
+static void sha256_rounds_shani(unsigned *h, const unsigned *wk) {
+  __m128i state0, state1, state0_save, state1_save, msg, tmp;
+  int t;
+
+  tmp = _mm_loadu_si128((const __m128i *)(const void *)h);  /* DCBA */
+  state1 = _mm_loadu_si128((const __m128i *)(const void *)(h + 4));  /* HGFE */
+  tmp = _mm_shuffle_epi32(tmp, 0xb1);  /* CDAB */
+  state1 = _mm_shuffle_epi32(state1, 0x1b);  /* EFGH */
+  state0 = _mm_alignr_epi8(tmp, state1, 8);  /* ABEF */
+  state1 = _mm_blend_epi16(state1, tmp, 0xf0);  /* CDGH */
+  state0_save = state0;
+  state1_save = state1;
+
+  for (t = 0; t < 64; t += 4) {
+    msg = _mm_loadu_si128((const __m128i *)(const void *)(wk + t));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+  }
+  state0 = _mm_add_epi32(state0, state0_save);
+  state1 = _mm_add_epi32(state1, state1_save);
+
+  tmp = _mm_shuffle_epi32(state0, 0x1b);  /* FEBA */
+  state1 = _mm_shuffle_epi32(state1, 0xb1);  /* DCHG */
+  state0 = _mm_blend_epi16(tmp, state1, 0xf0);  /* DCBA */
+  state1 = _mm_alignr_epi8(state1, tmp, 8);  /* HGFE */
+  _mm_storeu_si128((__m128i *)(void *)h, state0);
+  _mm_storeu_si128((__m128i *)(void *)(h + 4), state1);
+}
+#endif
+
+/*
+ * Updates the intermediate hash value with one block with a precomputed
+ * message schedule, using the fastest implementation available on the processor.
+ * h: pointer to the 8 intermediate hash value words to update
+ * wk: pointer to the 64 words Wt + Kt of the block
+ */
+static void sha256_rounds(unsigned *h, const unsigned *wk) {
+#ifdef SHA256_SHANI
+  if (crumbs_cpu_has(SHA256_SHANI_FEATURES)) {
+    sha256_rounds_shani(h, wk);
+    return;
+  }
+#endif
+  sha256_rounds_generic(h, wk);
+}
+
+/*
+ * Gets the midstate of an incremental SHA-256 computation: the intermediate
+ * hash value after the whole blocks hashed so far.
+ * ctx: pointer to the context, after a multiple of 64 bytes
+ * h: pointer to 8 words of memory to store the intermediate hash value
+ * Returns the number of 64-byte blocks hashed so far, or -1 if the number of
+ * bytes is not a multiple of 64 (a partial block is not in the midstate)
+ * or the number of blocks does not fit in an int.
+ */
+static int sha256_midstate(const struct sha256_context *ctx, unsigned *h) {
+  int i;
+
+  if ((ctx->length[0] & 63) || ctx->length[1] >> 5) {
+    return -1;
+  }
+  for (i = 0; i < 8; i++) {
+    h[i] = ctx->h[i];
+  }
+  return (int)(ctx->length[1] << 26 | ctx->length[0] >> 6);
+}
+
+/*
+ * Starts an incremental SHA-256 computation from a midstate,
+ * as if the blocks before it had just been hashed.
+ * ctx: pointer to the context to initialize
+ * h: pointer to the 8 words of the midstate, from sha256_midstate
+ * blocks: number of 64-byte blocks before the midstate, from sha256_midstate
+ */
+static void sha256_resume(struct sha256_context *ctx, const unsigned *h, int blocks) {
+  int i;
+
+  for (i = 0; i < 8; i++) {
+    ctx->h[i] = h[i];
+  }
+  ctx->length[0] = (unsigned)blocks << 6;
+  ctx->length[1] = (unsigned)blocks >> 26;
+}
+
+/*
+ * Stores the SHA-256 message digest.
+ * digest: pointer to 32 bytes (256 bits) of memory to store the message digest
+ * h: pointer to the 8 words of the final hash value
+ */
+static void sha256_store(void *digest, const unsigned *h) {
+  int i;
+
+  for (i = 0; i < 8; i++) {
+    ((unsigned char *)digest)[i * 4 + 0] = h[i] >> 24;
+    ((unsigned char *)digest)[i * 4 + 1] = h[i] >> 16;
+    ((unsigned char *)digest)[i * 4 + 2] = h[i] >> 8;
+    ((unsigned char *)digest)[i * 4 + 3] = h[i];
+  }
+}
+
+/*
+ * Computes the SHA-256 message digest of a 32-byte message.
+ * digest: pointer to 32 bytes (256 bits) of memory to store the SHA-256 message digest
+ * message: pointer to the 32-byte input message
+ * The digest and message may point to the same memory (for double SHA-256).
+ */
+static void sha256_32(void *digest, const void *message) {
+  unsigned char block[64] = {
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0x80,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0  /* 256 bits */
+  };
+  struct sha256_context ctx;
+  int i;
+
+  for (i = 0; i < 32; i++) {
+    block[i] = ((const unsigned char *)message)[i];
+  }
+  sha256_init(&ctx);
+  sha256_compress(ctx.h, block, 1);
+  sha256_store(digest, ctx.h);
+}
+
+/*
+ * Computes the SHA-256 message digest of a 64-byte message.
+ * digest: pointer to 32 bytes (256 bits) of memory to store the SHA-256 message digest
+ * message: pointer to the 64-byte input message
+ * The digest and message may point to the same memory.
+ */
+static void sha256_64(void *digest, const void *message) {
+  struct sha256_context ctx;
+
+  sha256_init(&ctx);
+  sha256_compress(ctx.h, message, 1);
+  sha256_rounds(ctx.h, sha256_pad64_wk);
+  sha256_store(digest, ctx.h);
+}
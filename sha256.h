@@ -8,94 +8,87 @@
  */
 
 /*
- * Computes the SHA-256 message digest of a message.
- * digest: pointer to 32 bytes (256 bits) of memory to store the SHA-256 message digest
- * message: pointer to the input message
- * length: number of bytes of the input message
+ * Implements the SHA-256 hash function, both as the one-shot sha256 function
+ * (and sha256_v, for a message in a list of fragments)
+ * and as the incremental sha256_init, sha256_update and sha256_final functions.
+ *
+ * On x86 processors, when compiled with GCC or Clang, the blocks are
+ * compressed with the SHA extensions (SHA-NI) if the processor has them.
+ *
+ * The processor features are detected with crumbs-cpu.h, which needs to be
+ * in the same directory (and where the code paths can be pinned).
  *
  * References:
  * [SHS] Secure Hash Standard (FIPS PUB 180-4), Aug 2015
  *       http://nvlpubs.nist.gov/nistpubs/FIPS/NIST.FIPS.180-4.pdf
+ * [SHANI] Intel SHA Extensions, Gulley et al., Intel, Jul 2013
  */
-static void sha256(void *digest, const void *message, int length) {
-  /* [SHS] 4.2.2 SHA-224 and SHA-256 Constants */
-  const unsigned k[64] = {
-    0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
-    0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
-    0xe49b69c1,0xefbe4786,0x0fc19dc6,0x240ca1cc,0x2de92c6f,0x4a7484aa,0x5cb0a9dc,0x76f988da,
-    0x983e5152,0xa831c66d,0xb00327c8,0xbf597fc7,0xc6e00bf3,0xd5a79147,0x06ca6351,0x14292967,
-    0x27b70a85,0x2e1b2138,0x4d2c6dfc,0x53380d13,0x650a7354,0x766a0abb,0x81c2c92e,0x92722c85,
-    0xa2bfe8a1,0xa81a664b,0xc24b8b70,0xc76c51a3,0xd192e819,0xd6990624,0xf40e3585,0x106aa070,
-    0x19a4c116,0x1e376c08,0x2748774c,0x34b0bcb5,0x391c0cb3,0x4ed8aa4a,0x5b9cca4f,0x682e6ff3,
-    0x748f82ee,0x78a5636f,0x84c87814,0x8cc70208,0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
-  };
-  unsigned char pad[64];  /* padded block */
+
+#include "crumbs-cpu.h"
+
+#ifdef CRUMBS_CPU_X86
+#define SHA256_SHANI
+#define SHA256_SHANI_FEATURES (CRUMBS_CPU_SHANI | CRUMBS_CPU_SSSE3 | CRUMBS_CPU_SSE41)
+#endif
+
+/*
+ * Context of an incremental SHA-256 computation.
+ * h: the intermediate hash value words
+ * block: the bytes of the current partial block
+ * length: number of bytes hashed so far (length[0] low word, length[1] high word)
+ */
+struct sha256_context {
+  unsigned h[8];
+  unsigned char block[64];
+  unsigned length[2];
+};
+
+/* [SHS] 4.2.2 SHA-224 and SHA-256 Constants */
+static const unsigned sha256_k[64] = {
+  0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
+  0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
+  0xe49b69c1,0xefbe4786,0x0fc19dc6,0x240ca1cc,0x2de92c6f,0x4a7484aa,0x5cb0a9dc,0x76f988da,
+  0x983e5152,0xa831c66d,0xb00327c8,0xbf597fc7,0xc6e00bf3,0xd5a79147,0x06ca6351,0x14292967,
+  0x27b70a85,0x2e1b2138,0x4d2c6dfc,0x53380d13,0x650a7354,0x766a0abb,0x81c2c92e,0x92722c85,
+  0xa2bfe8a1,0xa81a664b,0xc24b8b70,0xc76c51a3,0xd192e819,0xd6990624,0xf40e3585,0x106aa070,
+  0x19a4c116,0x1e376c08,0x2748774c,0x34b0bcb5,0x391c0cb3,0x4ed8aa4a,0x5b9cca4f,0x682e6ff3,
+  0x748f82ee,0x78a5636f,0x84c87814,0x8cc70208,0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
+};
+
+/*
+ * Portable implementation of the SHA-256 compression function.
+ * h: pointer to the 8 intermediate hash value words to update
+ * blocks: pointer to count * 64 bytes of message blocks
+ * count: number of 64-byte message blocks
+ *
+ * [SHS] 6.2.2 SHA-256 Hash Computation
+ */
+static void sha256_compress_generic(unsigned *h, const void *blocks, int count) {
   unsigned w[16];  /* message schedule (ring buffer for a total of 64 elements) */
-  unsigned h0, h1, h2, h3, h4, h5, h6, h7;  /* hash value words */
-  unsigned a, b, c, d, e, f, g, h;  /* working variables */
+  unsigned a, b, c, d, e, f, g, h7;  /* working variables */
   unsigned t1, t2, wt, wt2, wt7, wt15, ssig0wt15, ssig1wt2;
   const unsigned char *m;
-  int i, j, t;
-
-  /* [SHS] 5.3 Setting the Initial Hash Value H(0), 5.3.3 SHA-256 */
-  h0 = 0x6a09e667;
-  h1 = 0xbb67ae85;
-  h2 = 0x3c6ef372;
-  h3 = 0xa54ff53a;
-  h4 = 0x510e527f;
-  h5 = 0x9b05688c;
-  h6 = 0x1f83d9ab;
-  h7 = 0x5be0cd19;
-
-  /* [SHS] 6.2.2 SHA-256 Hash Computation */
-  for (i = 0; i - 9 < length; i += 64) {  /* min pad = 9 bytes (0x80 + 64-bit length) */
-    m = (unsigned char *)message + i;
-    if (i > length - 64) {
-      /* [SHS] 5.1 Padding the Message, 5.1.1 SHA-1, SHA-224 and SHA-256 */
-      for (j = 0; j < length - i; j++) {
-        pad[j] = m[j];
-      }
-      if (i + j == length) {
-        pad[j++] = 0x80;
-      }
-      if (j > 56) {  /* penultimate block */
-        while (j < 64) {
-          pad[j++] = 0;
-        }
-      } else {  /* last block */
-        while (j < 56) {
-          pad[j++] = 0;
-        }
-        pad[56] = 0;  /* length >> 53; */
-        pad[57] = 0;  /* length >> 45; */
-        pad[58] = 0;  /* length >> 37; */
-        pad[59] = length >> 29;
-        pad[60] = length >> 21;
-        pad[61] = length >> 13;
-        pad[62] = length >> 5;
-        pad[63] = length << 3;
-      }
-      m = pad;
-    }
+  int t;
 
+  for (m = (const unsigned char *)blocks; count > 0; count--, m += 64) {
     /*
      * 1. Prepare the message schedule W (part 1):
      * For t = 0 to 15
      *    Wt = M(i)t
      */
     for (t = 0; t < 16; t++) {
-      w[t] = m[t*4] << 24 | m[t*4+1] << 16 | m[t*4+2] << 8 | m[t*4+3];
+      w[t] = (unsigned)m[t*4] << 24 | m[t*4+1] << 16 | m[t*4+2] << 8 | m[t*4+3];
     }
 
     /* 2. Initialize the eight working variables */
-    a = h0;
-    b = h1;
-    c = h2;
-    d = h3;
-    e = h4;
-    f = h5;
-    g = h6;
-    h = h7;
+    a = h[0];
+    b = h[1];
+    c = h[2];
+    d = h[3];
+    e = h[4];
+    f = h[5];
+    g = h[6];
+    h7 = h[7];
 
     /* 3. (transform the working variables) */
     for (t = 0; t < 64; t++) {
@@ -113,10 +106,10 @@ static void sha256(void *digest, const void *message, int length) {
       w[t & 15] = ssig1wt2 + wt7 + ssig0wt15 + wt;
 
       /* T1 = h + BSIG1(e) + CH(e,f,g) + Kt + Wt */
-      t1 = h + ((e>>6)^(e<<26)^(e>>11)^(e<<21)^(e>>25)^(e<<7)) + ((e&f)^(~e&g)) + k[t] + wt;
+      t1 = h7 + ((e>>6)^(e<<26)^(e>>11)^(e<<21)^(e>>25)^(e<<7)) + ((e&f)^(~e&g)) + sha256_k[t] + wt;
       /* T2 = BSIG0(a) + MAJ(a,b,c) */
       t2 = ((a>>2)^(a<<30)^(a>>13)^(a<<19)^(a>>22)^(a<<10)) + ((a&b)^(a&c)^(b&c));
-      h = g;
+      h7 = g;
       g = f;
       f = e;
       e = d + t1;
@@ -127,47 +120,358 @@ static void sha256(void *digest, const void *message, int length) {
     }
 
     /* 4. Compute the ith intermediate hash value H(i) */
-    h0 += a;
-    h1 += b;
-    h2 += c;
-    h3 += d;
-    h4 += e;
-    h5 += f;
-    h6 += g;
-    h7 += h;
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+    h[5] += f;
+    h[6] += g;
+    h[7] += h7;
+  }
+}
+
+#ifdef SHA256_SHANI
+/*
+ * Implementation of the SHA-256 compression function with the SHA extensions.
+ * Same parameters as sha256_compress_generic.
+ *
+ * Each sha256rnds2 instruction performs 2 rounds on the working variables
+ * kept as ABEF and CDGH, and sha256msg1/sha256msg2 compute the message
+ * schedule, 4 words at a time.
+ *
+ * [SHANI] SHA-256 New Instructions
+ */
+__attribute__((target("sha,ssse3,sse4.1")))
+static void sha256_compress_shani(unsigned *h, const void *blocks, int count) {
+  const __m128i mask = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+  __m128i state0, state1, state0_save, state1_save, msg, tmp;
+  __m128i msg0, msg1, msg2, msg3;
+  const unsigned char *m;
+
+  tmp = _mm_loadu_si128((const __m128i *)(const void *)h);  /* DCBA */
+  state1 = _mm_loadu_si128((const __m128i *)(const void *)(h + 4));  /* HGFE */
+  tmp = _mm_shuffle_epi32(tmp, 0xb1);  /* CDAB */
+  state1 = _mm_shuffle_epi32(state1, 0x1b);  /* EFGH */
+  state0 = _mm_alignr_epi8(tmp, state1, 8);  /* ABEF */
+  state1 = _mm_blend_epi16(state1, tmp, 0xf0);  /* CDGH */
+
+  for (m = (const unsigned char *)blocks; count > 0; count--, m += 64) {
+    state0_save = state0;
+    state1_save = state1;
+
+    /* Rounds 0-3 */
+    msg0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(const void *)(m + 0)), mask);
+    msg = _mm_add_epi32(msg0, _mm_loadu_si128((const __m128i *)(const void *)(sha256_k + 0)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+    /* Rounds 4-7 */
+    msg1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(const void *)(m + 16)), mask);
+    msg = _mm_add_epi32(msg1, _mm_loadu_si128((const __m128i *)(const void *)(sha256_k + 4)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+
+    /* Rounds 8-11 */
+    msg2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(const void *)(m + 32)), mask);
+    msg = _mm_add_epi32(msg2, _mm_loadu_si128((const __m128i *)(const void *)(sha256_k + 8)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+
+    /* Rounds 12-15 */
+    msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(const void *)(m + 48)), mask);
+    msg = _mm_add_epi32(msg3, _mm_loadu_si128((const __m128i *)(const void *)(sha256_k + 12)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    tmp = _mm_alignr_epi8(msg3, msg2, 4);
+    msg0 = _mm_add_epi32(msg0, tmp);
+    msg0 = _mm_sha256msg2_epu32(msg0, msg3);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    msg2 = _mm_sha256msg1_epu32(msg2, msg3);
+
+    /* Rounds 16-19 */
+    msg = _mm_add_epi32(msg0, _mm_loadu_si128((const __m128i *)(const void *)(sha256_k + 16)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    tmp = _mm_alignr_epi8(msg0, msg3, 4);
+    msg1 = _mm_add_epi32(msg1, tmp);
+    msg1 = _mm_sha256msg2_epu32(msg1, msg0);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    msg3 = _mm_sha256msg1_epu32(msg3, msg0);
+
+    /* Rounds 20-23 */
+    msg = _mm_add_epi32(msg1, _mm_loadu_si128((const __m128i *)(const void *)(sha256_k + 20)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    tmp = _mm_alignr_epi8(msg1, msg0, 4);
+    msg2 = _mm_add_epi32(msg2, tmp);
+    msg2 = _mm_sha256msg2_epu32(msg2, msg1);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+
+    /* Rounds 24-27 */
+    msg = _mm_add_epi32(msg2, _mm_loadu_si128((const __m128i *)(const void *)(sha256_k + 24)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    tmp = _mm_alignr_epi8(msg2, msg1, 4);
+    msg3 = _mm_add_epi32(msg3, tmp);
+    msg3 = _mm_sha256msg2_epu32(msg3, msg2);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+
+    /* Rounds 28-31 */
+    msg = _mm_add_epi32(msg3, _mm_loadu_si128((const __m128i *)(const void *)(sha256_k + 28)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    tmp = _mm_alignr_epi8(msg3, msg2, 4);
+    msg0 = _mm_add_epi32(msg0, tmp);
+    msg0 = _mm_sha256msg2_epu32(msg0, msg3);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    msg2 = _mm_sha256msg1_epu32(msg2, msg3);
+
+    /* Rounds 32-35 */
+    msg = _mm_add_epi32(msg0, _mm_loadu_si128((const __m128i *)(const void *)(sha256_k + 32)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    tmp = _mm_alignr_epi8(msg0, msg3, 4);
+    msg1 = _mm_add_epi32(msg1, tmp);
+    msg1 = _mm_sha256msg2_epu32(msg1, msg0);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    msg3 = _mm_sha256msg1_epu32(msg3, msg0);
+
+    /* Rounds 36-39 */
+    msg = _mm_add_epi32(msg1, _mm_loadu_si128((const __m128i *)(const void *)(sha256_k + 36)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    tmp = _mm_alignr_epi8(msg1, msg0, 4);
+    msg2 = _mm_add_epi32(msg2, tmp);
+    msg2 = _mm_sha256msg2_epu32(msg2, msg1);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+
+    /* Rounds 40-43 */
+    msg = _mm_add_epi32(msg2, _mm_loadu_si128((const __m128i *)(const void *)(sha256_k + 40)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    tmp = _mm_alignr_epi8(msg2, msg1, 4);
+    msg3 = _mm_add_epi32(msg3, tmp);
+    msg3 = _mm_sha256msg2_epu32(msg3, msg2);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+
+    /* Rounds 44-47 */
+    msg = _mm_add_epi32(msg3, _mm_loadu_si128((const __m128i *)(const void *)(sha256_k + 44)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    tmp = _mm_alignr_epi8(msg3, msg2, 4);
+    msg0 = _mm_add_epi32(msg0, tmp);
+    msg0 = _mm_sha256msg2_epu32(msg0, msg3);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    msg2 = _mm_sha256msg1_epu32(msg2, msg3);
+
+    /* Rounds 48-51 */
+    msg = _mm_add_epi32(msg0, _mm_loadu_si128((const __m128i *)(const void *)(sha256_k + 48)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    tmp = _mm_alignr_epi8(msg0, msg3, 4);
+    msg1 = _mm_add_epi32(msg1, tmp);
+    msg1 = _mm_sha256msg2_epu32(msg1, msg0);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    msg3 = _mm_sha256msg1_epu32(msg3, msg0);
+
+    /* Rounds 52-55 */
+    msg = _mm_add_epi32(msg1, _mm_loadu_si128((const __m128i *)(const void *)(sha256_k + 52)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    tmp = _mm_alignr_epi8(msg1, msg0, 4);
+    msg2 = _mm_add_epi32(msg2, tmp);
+    msg2 = _mm_sha256msg2_epu32(msg2, msg1);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+    /* Rounds 56-59 */
+    msg = _mm_add_epi32(msg2, _mm_loadu_si128((const __m128i *)(const void *)(sha256_k + 56)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    tmp = _mm_alignr_epi8(msg2, msg1, 4);
+    msg3 = _mm_add_epi32(msg3, tmp);
+    msg3 = _mm_sha256msg2_epu32(msg3, msg2);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+    /* Rounds 60-63 */
+    msg = _mm_add_epi32(msg3, _mm_loadu_si128((const __m128i *)(const void *)(sha256_k + 60)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+    /* Compute the ith intermediate hash value H(i) */
+    state0 = _mm_add_epi32(state0, state0_save);
+    state1 = _mm_add_epi32(state1, state1_save);
+  }
+
+  tmp = _mm_shuffle_epi32(state0, 0x1b);  /* FEBA */
+  state1 = _mm_shuffle_epi32(state1, 0xb1);  /* DCHG */
+  state0 = _mm_blend_epi16(tmp, state1, 0xf0);  /* DCBA */
+  state1 = _mm_alignr_epi8(state1, tmp, 8);  /* HGFE */
+  _mm_storeu_si128((__m128i *)(void *)h, state0);
+  _mm_storeu_si128((__m128i *)(void *)(h + 4), state1);
+}
+#endif
+
+/*
+ * Updates the intermediate hash value with count 64-byte message blocks,
+ * using the fastest implementation available on the processor.
+ * h: pointer to the 8 intermediate hash value words to update
+ * blocks: pointer to count * 64 bytes of message blocks
+ * count: number of 64-byte message blocks
+ */
+static void sha256_compress(unsigned *h, const void *blocks, int count) {
+#ifdef SHA256_SHANI
+  if (crumbs_cpu_has(SHA256_SHANI_FEATURES)) {
+    sha256_compress_shani(h, blocks, count);
+    return;
+  }
+#endif
+  sha256_compress_generic(h, blocks, count);
+}
+
+/*
+ * Starts an incremental SHA-256 computation.
+ * ctx: pointer to the context to initialize
+ *
+ * [SHS] 5.3 Setting the Initial Hash Value H(0), 5.3.3 SHA-256
+ */
+static void sha256_init(struct sha256_context *ctx) {
+  ctx->h[0] = 0x6a09e667;
+  ctx->h[1] = 0xbb67ae85;
+  ctx->h[2] = 0x3c6ef372;
+  ctx->h[3] = 0xa54ff53a;
+  ctx->h[4] = 0x510e527f;
+  ctx->h[5] = 0x9b05688c;
+  ctx->h[6] = 0x1f83d9ab;
+  ctx->h[7] = 0x5be0cd19;
+  ctx->length[0] = 0;
+  ctx->length[1] = 0;
+}
+
+/*
+ * Adds a part of the message to an incremental SHA-256 computation.
+ * The message can be split at any byte boundary.
+ * ctx: pointer to the context
+ * data: pointer to the next part of the message
+ * length: number of bytes of the part of the message
+ */
+static void sha256_update(struct sha256_context *ctx, const void *data, int length) {
+  const unsigned char *p;
+  int i, n;
+
+  p = (const unsigned char *)data;
+  n = ctx->length[0] & 63;  /* bytes in the partial block */
+  ctx->length[0] += length;
+  if (ctx->length[0] < (unsigned)length) {
+    ctx->length[1]++;
   }
 
+  /* Complete the partial block */
+  if (n > 0) {
+    for (i = 0; n < 64 && i < length; i++) {
+      ctx->block[n++] = p[i];
+    }
+    if (n < 64) {
+      return;
+    }
+    sha256_compress(ctx->h, ctx->block, 1);
+    p += i;
+    length -= i;
+  }
+
+  /* Process the full blocks directly from the message */
+  if (length >= 64) {
+    sha256_compress(ctx->h, p, length / 64);
+    p += length & ~63;
+    length &= 63;
+  }
+
+  /* Keep the remaining bytes for the next call */
+  for (i = 0; i < length; i++) {
+    ctx->block[i] = p[i];
+  }
+}
+
+/*
+ * Finishes an incremental SHA-256 computation.
+ * ctx: pointer to the context
+ * digest: pointer to 32 bytes (256 bits) of memory to store the SHA-256 message digest
+ *
+ * [SHS] 5.1 Padding the Message, 5.1.1 SHA-1, SHA-224 and SHA-256
+ */
+static void sha256_final(struct sha256_context *ctx, void *digest) {
+  unsigned hi, lo;  /* message length in bits */
+  int i, n;
+
+  hi = ctx->length[1] << 3 | ctx->length[0] >> 29;
+  lo = ctx->length[0] << 3;
+
+  n = ctx->length[0] & 63;
+  ctx->block[n++] = 0x80;
+  if (n > 56) {  /* penultimate block */
+    while (n < 64) {
+      ctx->block[n++] = 0;
+    }
+    sha256_compress(ctx->h, ctx->block, 1);
+    n = 0;
+  }
+  while (n < 56) {  /* last block */
+    ctx->block[n++] = 0;
+  }
+  ctx->block[56] = hi >> 24;
+  ctx->block[57] = hi >> 16;
+  ctx->block[58] = hi >> 8;
+  ctx->block[59] = hi;
+  ctx->block[60] = lo >> 24;
+  ctx->block[61] = lo >> 16;
+  ctx->block[62] = lo >> 8;
+  ctx->block[63] = lo;
+  sha256_compress(ctx->h, ctx->block, 1);
+
   /* Store the resulting 256-bit message digest */
-  ((unsigned char *)digest)[0] = h0 >> 24;
-  ((unsigned char *)digest)[1] = h0 >> 16;
-  ((unsigned char *)digest)[2] = h0 >> 8;
-  ((unsigned char *)digest)[3] = h0;
-  ((unsigned char *)digest)[4] = h1 >> 24;
-  ((unsigned char *)digest)[5] = h1 >> 16;
-  ((unsigned char *)digest)[6] = h1 >> 8;
-  ((unsigned char *)digest)[7] = h1;
-  ((unsigned char *)digest)[8] = h2 >> 24;
-  ((unsigned char *)digest)[9] = h2 >> 16;
-  ((unsigned char *)digest)[10] = h2 >> 8;
-  ((unsigned char *)digest)[11] = h2;
-  ((unsigned char *)digest)[12] = h3 >> 24;
-  ((unsigned char *)digest)[13] = h3 >> 16;
-  ((unsigned char *)digest)[14] = h3 >> 8;
-  ((unsigned char *)digest)[15] = h3;
-  ((unsigned char *)digest)[16] = h4 >> 24;
-  ((unsigned char *)digest)[17] = h4 >> 16;
-  ((unsigned char *)digest)[18] = h4 >> 8;
-  ((unsigned char *)digest)[19] = h4;
-  ((unsigned char *)digest)[20] = h5 >> 24;
-  ((unsigned char *)digest)[21] = h5 >> 16;
-  ((unsigned char *)digest)[22] = h5 >> 8;
-  ((unsigned char *)digest)[23] = h5;
-  ((unsigned char *)digest)[24] = h6 >> 24;
-  ((unsigned char *)digest)[25] = h6 >> 16;
-  ((unsigned char *)digest)[26] = h6 >> 8;
-  ((unsigned char *)digest)[27] = h6;
-  ((unsigned char *)digest)[28] = h7 >> 24;
-  ((unsigned char *)digest)[29] = h7 >> 16;
-  ((unsigned char *)digest)[30] = h7 >> 8;
-  ((unsigned char *)digest)[31] = h7;
+  for (i = 0; i < 8; i++) {
+    ((unsigned char *)digest)[i * 4 + 0] = ctx->h[i] >> 24;
+    ((unsigned char *)digest)[i * 4 + 1] = ctx->h[i] >> 16;
+    ((unsigned char *)digest)[i * 4 + 2] = ctx->h[i] >> 8;
+    ((unsigned char *)digest)[i * 4 + 3] = ctx->h[i];
+  }
+}
+
+/*
+ * Computes the SHA-256 message digest of a message in a list of fragments
+ * (as with writev), without copying them into a contiguous buffer.
+ * digest: pointer to 32 bytes (256 bits) of memory to store the SHA-256 message digest
+ * parts: pointers to the fragments of the input message
+ * lengths: number of bytes of each fragment
+ * count: number of fragments
+ */
+static void sha256_v(void *digest, const void **parts, const int *lengths, int count) {
+  struct sha256_context ctx;
+  int i;
+
+  sha256_init(&ctx);
+  for (i = 0; i < count; i++) {
+    sha256_update(&ctx, parts[i], lengths[i]);
+  }
+  sha256_final(&ctx, digest);
+}
+
+/*
+ * Computes the SHA-256 message digest of a message.
+ * digest: pointer to 32 bytes (256 bits) of memory to store the SHA-256 message digest
+ * message: pointer to the input message
+ * length: number of bytes of the input message
+ */
+static void sha256(void *digest, const void *message, int length) {
+  sha256_v(digest, &message, &length, 1);
 }
@@ -0,0 +1,180 @@
+/*
+ * sha512-mb.h: Multi-buffer Secure Hash Algorithm 512 (SHA-512)
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/sha512-mb.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Implements the SHA-512 compression function on 4 independent messages
+ * at once, one message per lane, for hashing many messages in parallel
+ * (with SHA-512, SHA-384 or SHA-512/256, which only differ in the initial
+ * hash values and the length of the digest).
+ *
+ * On x86-64 processors with AVX2, when compiled with GCC or Clang, every
+ * step is written as a loop over the 4 lanes of 64-bit words, which the
+ * compiler turns into one 4-lane AVX2 vector. Otherwise, the lanes are
+ * compressed one after the other with sha512_compress.
+ *
+ * Uses the functions in sha512.h, so you need to include that too:
+ * #include "sha512.h"
+ * #include "sha512-mb.h"
+ *
+ * The processor features are detected with crumbs-cpu.h, which needs to be
+ * in the same directory (and where the code paths can be pinned).
+ *
+ * References:
+ * [SHS] Secure Hash Standard (FIPS PUB 180-4), Aug 2015
+ *       http://nvlpubs.nist.gov/nistpubs/FIPS/NIST.FIPS.180-4.pdf
+ * [MB] Processing Multiple Buffers in Parallel to Increase Performance
+ *      on Intel Architecture Processors, Guilford et al., Intel, Jul 2010
+ */
+
+#include "crumbs-cpu.h"
+
+#if defined(SHA512_WORD64) && defined(CRUMBS_CPU_X86)
+#define SHA512_AVX2
+#endif
+
+#ifdef SHA512_AVX2
+/*
+ * Internal function that updates 4 intermediate hash values with one
+ * 128-byte message block each, in the lanes of AVX2 vectors.
+ * h: the intermediate hash value words, h[i][lane] is word i of a lane
+ *    (as in sha512_compress, pairs of 32-bit words, the high word first)
+ * blocks: pointers to the 128-byte message block of each lane,
+ *         or NULL for an idle lane (whose hash value is left unchanged)
+ *
+ * [SHS] 6.4.2 SHA-512 Hash Computation
+ */
+__attribute__((target("avx2")))
+static void sha512_compress_x4_avx2(unsigned h[16][4], const void **blocks) {
+  unsigned long w[80][4];  /* message schedules */
+  unsigned long a[4], b[4], c[4], d[4], e[4], f[4], g[4], hh[4];  /* working variables */
+  unsigned long k, t1, t2, x, y;
+  const unsigned char zero[128] = {0};
+  const unsigned char *m;
+  int l, t;
+
+  /*
+   * 1. Prepare the message schedule W:
+   * For t = 0 to 15
+   *    Wt = M(i)t
+   * For t = 16 to 79
+   *    Wt = SSIG1(W(t-2)) + W(t-7) + SSIG0(t-15) + W(t-16)
+   */
+  for (l = 0; l < 4; l++) {
+    m = blocks[l] ? (const unsigned char *)blocks[l] : zero;
+    for (t = 0; t < 16; t++) {
+      w[t][l] = (unsigned long)m[t*8] << 56 | (unsigned long)m[t*8+1] << 48 |
+                (unsigned long)m[t*8+2] << 40 | (unsigned long)m[t*8+3] << 32 |
+                (unsigned long)m[t*8+4] << 24 | (unsigned long)m[t*8+5] << 16 |
+                (unsigned long)m[t*8+6] << 8 | m[t*8+7];
+    }
+  }
+  for (t = 16; t < 80; t++) {
+    for (l = 0; l < 4; l++) {
+      x = w[t-2][l];
+      y = w[t-15][l];
+      w[t][l] = ((x>>19)^(x<<45) ^ (x>>61)^(x<<3) ^ (x>>6)) + w[t-7][l]
+              + ((y>>1)^(y<<63) ^ (y>>8)^(y<<56) ^ (y>>7)) + w[t-16][l];
+    }
+  }
+
+  /* 2. Initialize the eight working variables */
+  for (l = 0; l < 4; l++) {
+    a[l] = (unsigned long)h[0][l] << 32 | h[1][l];
+    b[l] = (unsigned long)h[2][l] << 32 | h[3][l];
+    c[l] = (unsigned long)h[4][l] << 32 | h[5][l];
+    d[l] = (unsigned long)h[6][l] << 32 | h[7][l];
+    e[l] = (unsigned long)h[8][l] << 32 | h[9][l];
+    f[l] = (unsigned long)h[10][l] << 32 | h[11][l];
+    g[l] = (unsigned long)h[12][l] << 32 | h[13][l];
+    hh[l] = (unsigned long)h[14][l] << 32 | h[15][l];
+  }
+
+  /* 3. (transform the working variables) */
+  for (t = 0; t < 80; t++) {
+    k = (unsigned long)sha512_k[t*2] << 32 | sha512_k[t*2+1];
+    for (l = 0; l < 4; l++) {
+      /* T1 = h + BSIG1(e) + CH(e,f,g) + Kt + Wt */
+      t1 = hh[l] + ((e[l]>>14)^(e[l]<<50)^(e[l]>>18)^(e[l]<<46)^(e[l]>>41)^(e[l]<<23))
+         + ((e[l]&f[l])^(~e[l]&g[l])) + k + w[t][l];
+      /* T2 = BSIG0(a) + MAJ(a,b,c) */
+      t2 = ((a[l]>>28)^(a[l]<<36)^(a[l]>>34)^(a[l]<<30)^(a[l]>>39)^(a[l]<<25))
+         + ((a[l]&b[l])^(a[l]&c[l])^(b[l]&c[l]));
+      hh[l] = g[l];
+      g[l] = f[l];
+      f[l] = e[l];
+      e[l] = d[l] + t1;
+      d[l] = c[l];
+      c[l] = b[l];
+      b[l] = a[l];
+      a[l] = t1 + t2;
+    }
+  }
+
+  /* 4. Compute the ith intermediate hash values H(i) of the busy lanes */
+  for (l = 0; l < 4; l++) {
+    if (!blocks[l]) {
+      continue;
+    }
+    a[l] += (unsigned long)h[0][l] << 32 | h[1][l];
+    b[l] += (unsigned long)h[2][l] << 32 | h[3][l];
+    c[l] += (unsigned long)h[4][l] << 32 | h[5][l];
+    d[l] += (unsigned long)h[6][l] << 32 | h[7][l];
+    e[l] += (unsigned long)h[8][l] << 32 | h[9][l];
+    f[l] += (unsigned long)h[10][l] << 32 | h[11][l];
+    g[l] += (unsigned long)h[12][l] << 32 | h[13][l];
+    hh[l] += (unsigned long)h[14][l] << 32 | h[15][l];
+    h[0][l] = (unsigned)(a[l] >> 32);
+    h[1][l] = (unsigned)a[l];
+    h[2][l] = (unsigned)(b[l] >> 32);
+    h[3][l] = (unsigned)b[l];
+    h[4][l] = (unsigned)(c[l] >> 32);
+    h[5][l] = (unsigned)c[l];
+    h[6][l] = (unsigned)(d[l] >> 32);
+    h[7][l] = (unsigned)d[l];
+    h[8][l] = (unsigned)(e[l] >> 32);
+    h[9][l] = (unsigned)e[l];
+    h[10][l] = (unsigned)(f[l] >> 32);
+    h[11][l] = (unsigned)f[l];
+    h[12][l] = (unsigned)(g[l] >> 32);
+    h[13][l] = (unsigned)g[l];
+    h[14][l] = (unsigned)(hh[l] >> 32);
+    h[15][l] = (unsigned)hh[l];
+  }
+}
+#endif
+
+/*
+ * Updates 4 intermediate hash values with one 128-byte message block each.
+ * h: the intermediate hash value words, h[i][lane] is word i of a lane
+ *    (as in sha512_compress, pairs of 32-bit words, the high word first)
+ * blocks: pointers to the 128-byte message block of each lane,
+ *         or NULL for an idle lane (whose hash value is left unchanged)
+ */
+static void sha512_compress_x4(unsigned h[16][4], const void **blocks) {
+  unsigned hl[16];
+  int i, l;
+
+#ifdef SHA512_AVX2
+  if (crumbs_cpu_has(CRUMBS_CPU_AVX2)) {
+    sha512_compress_x4_avx2(h, blocks);
+    return;
+  }
+#endif
+  for (l = 0; l < 4; l++) {
+    if (blocks[l]) {
+      for (i = 0; i < 16; i++) {
+        hl[i] = h[i][l];
+      }
+      sha512_compress(hl, blocks[l], 1);
+      for (i = 0; i < 16; i++) {
+        h[i][l] = hl[i];
+      }
+    }
+  }
+}
@@ -0,0 +1,574 @@
+/*
+ * sha512.h: Secure Hash Algorithms 512, 384 and 512/256 (SHA-512, SHA-384, SHA-512/256)
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/sha512.h
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Implements the SHA-512 hash function and its variants SHA-384 and
+ * SHA-512/256 (SHA-512 with other initial hash values, and the digest
+ * truncated to 48 or 32 bytes), both as the one-shot sha512, sha384 and
+ * sha512_256 functions (and sha512_v, for a message in a list of fragments)
+ * and as the incremental sha512_init (sha384_init, sha512_256_init),
+ * sha512_update and sha512_final (sha384_final, sha512_256_final) functions.
+ *
+ * SHA-512 works on 64-bit words, and so compresses 128-byte blocks in 80
+ * rounds that cost about as much each as the 64 rounds of SHA-256 on 64-byte
+ * blocks: on 64-bit processors, it hashes long messages faster than SHA-256
+ * (without the SHA extensions, which only SHA-256 has on most processors).
+ *
+ * ANSI C has no 64-bit integer type, so the words are kept as pairs of
+ * 32-bit words (the high word first), and the portable compression function
+ * works on the pairs. When compiled with GCC or Clang for x86-64 or AArch64
+ * (where unsigned long has 64 bits), the blocks are compressed on 64-bit
+ * words instead, unless the code paths are pinned to the portable code with
+ * CRUMBS_CPU=0 (or CRUMBS_GENERIC).
+ *
+ * The processor is checked with crumbs-cpu.h, which needs to be in the same
+ * directory (and where the code paths can be pinned).
+ *
+ * References:
+ * [SHS] Secure Hash Standard (FIPS PUB 180-4), Aug 2015
+ *       http://nvlpubs.nist.gov/nistpubs/FIPS/NIST.FIPS.180-4.pdf
+ */
+
+#include "crumbs-cpu.h"
+
+#if (defined(CRUMBS_CPU_X86) || defined(CRUMBS_CPU_ARM)) && defined(__LP64__)
+#define SHA512_WORD64
+#endif
+
+/*
+ * Context of an incremental SHA-512 (or SHA-384 or SHA-512/256) computation.
+ * h: the intermediate hash value words, as pairs of 32-bit words (high word first)
+ * block: the bytes of the current partial block
+ * length: number of bytes hashed so far (length[0] low word, length[1] high word)
+ */
+struct sha512_context {
+  unsigned h[16];
+  unsigned char block[128];
+  unsigned length[2];
+};
+
+/* [SHS] 4.2.3 SHA-384, SHA-512, SHA-512/224 and SHA-512/256 Constants, as pairs of 32-bit words */
+static const unsigned sha512_k[160] = {
+  0x428a2f98,0xd728ae22,0x71374491,0x23ef65cd,0xb5c0fbcf,0xec4d3b2f,0xe9b5dba5,0x8189dbbc,
+  0x3956c25b,0xf348b538,0x59f111f1,0xb605d019,0x923f82a4,0xaf194f9b,0xab1c5ed5,0xda6d8118,
+  0xd807aa98,0xa3030242,0x12835b01,0x45706fbe,0x243185be,0x4ee4b28c,0x550c7dc3,0xd5ffb4e2,
+  0x72be5d74,0xf27b896f,0x80deb1fe,0x3b1696b1,0x9bdc06a7,0x25c71235,0xc19bf174,0xcf692694,
+  0xe49b69c1,0x9ef14ad2,0xefbe4786,0x384f25e3,0x0fc19dc6,0x8b8cd5b5,0x240ca1cc,0x77ac9c65,
+  0x2de92c6f,0x592b0275,0x4a7484aa,0x6ea6e483,0x5cb0a9dc,0xbd41fbd4,0x76f988da,0x831153b5,
+  0x983e5152,0xee66dfab,0xa831c66d,0x2db43210,0xb00327c8,0x98fb213f,0xbf597fc7,0xbeef0ee4,
+  0xc6e00bf3,0x3da88fc2,0xd5a79147,0x930aa725,0x06ca6351,0xe003826f,0x14292967,0x0a0e6e70,
+  0x27b70a85,0x46d22ffc,0x2e1b2138,0x5c26c926,0x4d2c6dfc,0x5ac42aed,0x53380d13,0x9d95b3df,
+  0x650a7354,0x8baf63de,0x766a0abb,0x3c77b2a8,0x81c2c92e,0x47edaee6,0x92722c85,0x1482353b,
+  0xa2bfe8a1,0x4cf10364,0xa81a664b,0xbc423001,0xc24b8b70,0xd0f89791,0xc76c51a3,0x0654be30,
+  0xd192e819,0xd6ef5218,0xd6990624,0x5565a910,0xf40e3585,0x5771202a,0x106aa070,0x32bbd1b8,
+  0x19a4c116,0xb8d2d0c8,0x1e376c08,0x5141ab53,0x2748774c,0xdf8eeb99,0x34b0bcb5,0xe19b48a8,
+  0x391c0cb3,0xc5c95a63,0x4ed8aa4a,0xe3418acb,0x5b9cca4f,0x7763e373,0x682e6ff3,0xd6b2b8a3,
+  0x748f82ee,0x5defb2fc,0x78a5636f,0x43172f60,0x84c87814,0xa1f0ab72,0x8cc70208,0x1a6439ec,
+  0x90befffa,0x23631e28,0xa4506ceb,0xde82bde9,0xbef9a3f7,0xb2c67915,0xc67178f2,0xe372532b,
+  0xca273ece,0xea26619c,0xd186b8c7,0x21c0c207,0xeada7dd6,0xcde0eb1e,0xf57d4f7f,0xee6ed178,
+  0x06f067aa,0x72176fba,0x0a637dc5,0xa2c898a6,0x113f9804,0xbef90dae,0x1b710b35,0x131c471b,
+  0x28db77f5,0x23047d84,0x32caab7b,0x40c72493,0x3c9ebe0a,0x15c9bebc,0x431d67c4,0x9c100d4c,
+  0x4cc5d4be,0xcb3e42b6,0x597f299c,0xfc657e2a,0x5fcb6fab,0x3ad6faec,0x6c44198c,0x4a475817
+};
+
+/*
+ * Portable implementation of the SHA-512 compression function,
+ * on 64-bit words as pairs of 32-bit words.
+ * h: pointer to the 16 words of the 8 intermediate hash value words to update
+ * blocks: pointer to count * 128 bytes of message blocks
+ * count: number of 128-byte message blocks
+ *
+ * [SHS] 6.4.2 SHA-512 Hash Computation
+ */
+static void sha512_compress_generic(unsigned *h, const void *blocks, int count) {
+  unsigned w[32];  /* message schedule (ring buffer for a total of 80 elements, high and low words) */
+  unsigned ah, al, bh, bl, ch, cl, dh, dl, eh, el, fh, fl, gh, gl, hh, hl;  /* working variables */
+  unsigned t1h, t1l, t2h, t2l, xh, xl, yh, yl;
+  const unsigned char *m;
+  int t;
+
+  for (m = (const unsigned char *)blocks; count > 0; count--, m += 128) {
+    /*
+     * 1. Prepare the message schedule W (part 1):
+     * For t = 0 to 15
+     *    Wt = M(i)t
+     */
+    for (t = 0; t < 32; t++) {
+      w[t] = (unsigned)m[t*4] << 24 | m[t*4+1] << 16 | m[t*4+2] << 8 | m[t*4+3];
+    }
+
+    /* 2. Initialize the eight working variables */
+    ah = h[0];
+    al = h[1];
+    bh = h[2];
+    bl = h[3];
+    ch = h[4];
+    cl = h[5];
+    dh = h[6];
+    dl = h[7];
+    eh = h[8];
+    el = h[9];
+    fh = h[10];
+    fl = h[11];
+    gh = h[12];
+    gl = h[13];
+    hh = h[14];
+    hl = h[15];
+
+    /* 3. (transform the working variables) */
+    for (t = 0; t < 80; t++) {
+      if (t >= 16) {
+        /*
+         * 1. Prepare the message schedule W (part 2):
+         * For t = 16 to 79
+         *    Wt = SSIG1(W(t-2)) + W(t-7) + SSIG0(t-15) + W(t-16)
+         */
+        xh = w[((t-2) & 15) * 2];
+        xl = w[((t-2) & 15) * 2 + 1];
+        yh = w[((t-15) & 15) * 2];
+        yl = w[((t-15) & 15) * 2 + 1];
+        /* W(t-16) + SSIG1(W(t-2)), with SSIG1(x) = ROTR19(x) ^ ROTR61(x) ^ SHR6(x) */
+        t1l = w[(t & 15) * 2 + 1];
+        t1h = w[(t & 15) * 2];
+        t2l = (xl>>19 | xh<<13) ^ (xh>>29 | xl<<3) ^ (xl>>6 | xh<<26);
+        t2h = (xh>>19 | xl<<13) ^ (xl>>29 | xh<<3) ^ (xh>>6);
+        t1l += t2l;
+        t1h += t2h + (t1l < t2l);
+        /* + W(t-7) */
+        t2l = w[((t-7) & 15) * 2 + 1];
+        t2h = w[((t-7) & 15) * 2];
+        t1l += t2l;
+        t1h += t2h + (t1l < t2l);
+        /* + SSIG0(W(t-15)), with SSIG0(x) = ROTR1(x) ^ ROTR8(x) ^ SHR7(x) */
+        t2l = (yl>>1 | yh<<31) ^ (yl>>8 | yh<<24) ^ (yl>>7 | yh<<25);
+        t2h = (yh>>1 | yl<<31) ^ (yh>>8 | yl<<24) ^ (yh>>7);
+        t1l += t2l;
+        t1h += t2h + (t1l < t2l);
+        w[(t & 15) * 2] = t1h;
+        w[(t & 15) * 2 + 1] = t1l;
+      }
+
+      /* T1 = h + BSIG1(e) + CH(e,f,g) + Kt + Wt, with BSIG1(e) = ROTR14(e) ^ ROTR18(e) ^ ROTR41(e) */
+      t1l = hl;
+      t1h = hh;
+      t2l = (el>>14 | eh<<18) ^ (el>>18 | eh<<14) ^ (eh>>9 | el<<23);
+      t2h = (eh>>14 | el<<18) ^ (eh>>18 | el<<14) ^ (el>>9 | eh<<23);
+      t1l += t2l;
+      t1h += t2h + (t1l < t2l);
+      t2l = (el&fl) ^ (~el&gl);
+      t2h = (eh&fh) ^ (~eh&gh);
+      t1l += t2l;
+      t1h += t2h + (t1l < t2l);
+      t2l = sha512_k[t*2+1];
+      t2h = sha512_k[t*2];
+      t1l += t2l;
+      t1h += t2h + (t1l < t2l);
+      t2l = w[(t & 15) * 2 + 1];
+      t2h = w[(t & 15) * 2];
+      t1l += t2l;
+      t1h += t2h + (t1l < t2l);
+
+      /* T2 = BSIG0(a) + MAJ(a,b,c), with BSIG0(a) = ROTR28(a) ^ ROTR34(a) ^ ROTR39(a) */
+      t2l = (al>>28 | ah<<4) ^ (ah>>2 | al<<30) ^ (ah>>7 | al<<25);
+      t2h = (ah>>28 | al<<4) ^ (al>>2 | ah<<30) ^ (al>>7 | ah<<25);
+      xl = (al&bl) ^ (al&cl) ^ (bl&cl);
+      xh = (ah&bh) ^ (ah&ch) ^ (bh&ch);
+      t2l += xl;
+      t2h += xh + (t2l < xl);
+
+      hh = gh;
+      hl = gl;
+      gh = fh;
+      gl = fl;
+      fh = eh;
+      fl = el;
+      el = dl + t1l;  /* e = d + T1 */
+      eh = dh + t1h + (el < t1l);
+      dh = ch;
+      dl = cl;
+      ch = bh;
+      cl = bl;
+      bh = ah;
+      bl = al;
+      al = t1l + t2l;  /* a = T1 + T2 */
+      ah = t1h + t2h + (al < t2l);
+    }
+
+    /* 4. Compute the ith intermediate hash value H(i) */
+    h[1] += al;
+    h[0] += ah + (h[1] < al);
+    h[3] += bl;
+    h[2] += bh + (h[3] < bl);
+    h[5] += cl;
+    h[4] += ch + (h[5] < cl);
+    h[7] += dl;
+    h[6] += dh + (h[7] < dl);
+    h[9] += el;
+    h[8] += eh + (h[9] < el);
+    h[11] += fl;
+    h[10] += fh + (h[11] < fl);
+    h[13] += gl;
+    h[12] += gh + (h[13] < gl);
+    h[15] += hl;
+    h[14] += hh + (h[15] < hl);
+  }
+}
+
+#ifdef SHA512_WORD64
+/*
+ * Implementation of the SHA-512 compression function on 64-bit words
+ * (unsigned long), for 64-bit processors.
+ * h: pointer to the 16 words of the 8 intermediate hash value words to update
+ * blocks: pointer to count * 128 bytes of message blocks
+ * count: number of 128-byte message blocks
+ *
+ * [SHS] 6.4.2 SHA-512 Hash Computation
+ */
+static void sha512_compress_64(unsigned *h, const void *blocks, int count) {
+  unsigned long s[8];
+  unsigned long w[80];  /* message schedule */
+  unsigned long a, b, c, d, e, f, g, h7;  /* working variables */
+  unsigned long t1, t2, wt2, wt15;
+  const unsigned char *m;
+  int i, t;
+
+  for (i = 0; i < 8; i++) {
+    s[i] = (unsigned long)h[i*2] << 32 | h[i*2+1];
+  }
+
+  for (m = (const unsigned char *)blocks; count > 0; count--, m += 128) {
+    /*
+     * 1. Prepare the message schedule W (whole before the rounds, which is
+     * faster here than a ring buffer of 16 words updated in the rounds):
+     * For t = 0 to 15
+     *    Wt = M(i)t
+     * For t = 16 to 79
+     *    Wt = SSIG1(W(t-2)) + W(t-7) + SSIG0(t-15) + W(t-16)
+     */
+    for (t = 0; t < 16; t++) {
+      w[t] = (unsigned long)m[t*8] << 56 | (unsigned long)m[t*8+1] << 48 |
+             (unsigned long)m[t*8+2] << 40 | (unsigned long)m[t*8+3] << 32 |
+             (unsigned long)m[t*8+4] << 24 | (unsigned long)m[t*8+5] << 16 |
+             (unsigned long)m[t*8+6] << 8 | m[t*8+7];
+    }
+    for (t = 16; t < 80; t++) {
+      wt2 = w[t-2];
+      wt15 = w[t-15];
+      w[t] = ((wt2>>19)^(wt2<<45) ^ (wt2>>61)^(wt2<<3) ^ (wt2>>6)) + w[t-7]
+           + ((wt15>>1)^(wt15<<63) ^ (wt15>>8)^(wt15<<56) ^ (wt15>>7)) + w[t-16];
+    }
+
+    /* 2. Initialize the eight working variables */
+    a = s[0];
+    b = s[1];
+    c = s[2];
+    d = s[3];
+    e = s[4];
+    f = s[5];
+    g = s[6];
+    h7 = s[7];
+
+    /* 3. (transform the working variables) */
+    for (t = 0; t < 80; t++) {
+      /* T1 = h + BSIG1(e) + CH(e,f,g) + Kt + Wt */
+      t1 = h7 + ((e>>14)^(e<<50)^(e>>18)^(e<<46)^(e>>41)^(e<<23)) + ((e&f)^(~e&g))
+         + ((unsigned long)sha512_k[t*2] << 32 | sha512_k[t*2+1]) + w[t];
+      /* T2 = BSIG0(a) + MAJ(a,b,c) */
+      t2 = ((a>>28)^(a<<36)^(a>>34)^(a<<30)^(a>>39)^(a<<25)) + ((a&b)^(a&c)^(b&c));
+      h7 = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+
+    /* 4. Compute the ith intermediate hash value H(i) */
+    s[0] += a;
+    s[1] += b;
+    s[2] += c;
+    s[3] += d;
+    s[4] += e;
+    s[5] += f;
+    s[6] += g;
+    s[7] += h7;
+  }
+
+  for (i = 0; i < 8; i++) {
+    h[i*2] = (unsigned)(s[i] >> 32);
+    h[i*2+1] = (unsigned)s[i];
+  }
+}
+#endif
+
+/*
+ * Updates the intermediate hash value with count 128-byte message blocks,
+ * using the fastest implementation available.
+ * h: pointer to the 16 words of the 8 intermediate hash value words to update
+ * blocks: pointer to count * 128 bytes of message blocks
+ * count: number of 128-byte message blocks
+ */
+static void sha512_compress(unsigned *h, const void *blocks, int count) {
+#ifdef SHA512_WORD64
+  /* No feature is needed, but CRUMBS_CPU=0 pins the portable code */
+  if (crumbs_cpu()) {
+    sha512_compress_64(h, blocks, count);
+    return;
+  }
+#endif
+  sha512_compress_generic(h, blocks, count);
+}
+
+/*
+ * Starts an incremental computation with an initial hash value.
+ * ctx: pointer to the context to initialize
+ * iv: pointer to the 16 words of the initial hash value
+ */
+static void sha512_start(struct sha512_context *ctx, const unsigned *iv) {
+  int i;
+
+  for (i = 0; i < 16; i++) {
+    ctx->h[i] = iv[i];
+  }
+  ctx->length[0] = 0;
+  ctx->length[1] = 0;
+}
+
+/*
+ * Starts an incremental SHA-512 computation.
+ * ctx: pointer to the context to initialize
+ *
+ * [SHS] 5.3 Setting the Initial Hash Value H(0), 5.3.5 SHA-512
+ */
+static void sha512_init(struct sha512_context *ctx) {
+  const unsigned iv[16] = {
+    0x6a09e667,0xf3bcc908,0xbb67ae85,0x84caa73b,0x3c6ef372,0xfe94f82b,0xa54ff53a,0x5f1d36f1,
+    0x510e527f,0xade682d1,0x9b05688c,0x2b3e6c1f,0x1f83d9ab,0xfb41bd6b,0x5be0cd19,0x137e2179
+  };
+
+  sha512_start(ctx, iv);
+}
+
+/*
+ * Starts an incremental SHA-384 computation,
+ * continued with sha512_update and finished with sha384_final.
+ * ctx: pointer to the context to initialize
+ *
+ * [SHS] 5.3 Setting the Initial Hash Value H(0), 5.3.4 SHA-384
+ */
+static void sha384_init(struct sha512_context *ctx) {
+  const unsigned iv[16] = {
+    0xcbbb9d5d,0xc1059ed8,0x629a292a,0x367cd507,0x9159015a,0x3070dd17,0x152fecd8,0xf70e5939,
+    0x67332667,0xffc00b31,0x8eb44a87,0x68581511,0xdb0c2e0d,0x64f98fa7,0x47b5481d,0xbefa4fa4
+  };
+
+  sha512_start(ctx, iv);
+}
+
+/*
+ * Starts an incremental SHA-512/256 computation,
+ * continued with sha512_update and finished with sha512_256_final.
+ * ctx: pointer to the context to initialize
+ *
+ * [SHS] 5.3 Setting the Initial Hash Value H(0), 5.3.6.2 SHA-512/256
+ */
+static void sha512_256_init(struct sha512_context *ctx) {
+  const unsigned iv[16] = {
+    0x22312194,0xfc2bf72c,0x9f555fa3,0xc84c64c2,0x2393b86b,0x6f53b151,0x96387719,0x5940eabd,
+    0x96283ee2,0xa88effe3,0xbe5e1e25,0x53863992,0x2b0199fc,0x2c85b8aa,0x0eb72ddc,0x81c52ca2
+  };
+
+  sha512_start(ctx, iv);
+}
+
+/*
+ * Adds a part of the message to an incremental SHA-512 (or SHA-384 or
+ * SHA-512/256) computation. The message can be split at any byte boundary.
+ * ctx: pointer to the context
+ * data: pointer to the next part of the message
+ * length: number of bytes of the part of the message
+ */
+static void sha512_update(struct sha512_context *ctx, const void *data, int length) {
+  const unsigned char *p;
+  int i, n;
+
+  p = (const unsigned char *)data;
+  n = ctx->length[0] & 127;  /* bytes in the partial block */
+  ctx->length[0] += length;
+  if (ctx->length[0] < (unsigned)length) {
+    ctx->length[1]++;
+  }
+
+  /* Complete the partial block */
+  if (n > 0) {
+    for (i = 0; n < 128 && i < length; i++) {
+      ctx->block[n++] = p[i];
+    }
+    if (n < 128) {
+      return;
+    }
+    sha512_compress(ctx->h, ctx->block, 1);
+    p += i;
+    length -= i;
+  }
+
+  /* Process the full blocks directly from the message */
+  if (length >= 128) {
+    sha512_compress(ctx->h, p, length / 128);
+    p += length & ~127;
+    length &= 127;
+  }
+
+  /* Keep the remaining bytes for the next call */
+  for (i = 0; i < length; i++) {
+    ctx->block[i] = p[i];
+  }
+}
+
+/*
+ * Finishes an incremental computation, and stores the first bytes of the
+ * final hash value.
+ * ctx: pointer to the context
+ * digest: pointer to size bytes of memory to store the message digest
+ * size: number of bytes of the message digest, a multiple of 4 up to 64
+ *
+ * [SHS] 5.1 Padding the Message, 5.1.2 SHA-384, SHA-512, SHA-512/224 and SHA-512/256
+ */
+static void sha512_finish(struct sha512_context *ctx, void *digest, int size) {
+  unsigned hi, mid, lo;  /* message length in bits (the 128-bit field has 3 words set) */
+  int i, n;
+
+  hi = ctx->length[1] >> 29;
+  mid = ctx->length[1] << 3 | ctx->length[0] >> 29;
+  lo = ctx->length[0] << 3;
+
+  n = ctx->length[0] & 127;
+  ctx->block[n++] = 0x80;
+  if (n > 112) {  /* penultimate block */
+    while (n < 128) {
+      ctx->block[n++] = 0;
+    }
+    sha512_compress(ctx->h, ctx->block, 1);
+    n = 0;
+  }
+  while (n < 116) {  /* last block */
+    ctx->block[n++] = 0;
+  }
+  ctx->block[116] = hi >> 24;
+  ctx->block[117] = hi >> 16;
+  ctx->block[118] = hi >> 8;
+  ctx->block[119] = hi;
+  ctx->block[120] = mid >> 24;
+  ctx->block[121] = mid >> 16;
+  ctx->block[122] = mid >> 8;
+  ctx->block[123] = mid;
+  ctx->block[124] = lo >> 24;
+  ctx->block[125] = lo >> 16;
+  ctx->block[126] = lo >> 8;
+  ctx->block[127] = lo;
+  sha512_compress(ctx->h, ctx->block, 1);
+
+  /* Store the leftmost bits of the final hash value */
+  for (i = 0; i < size / 4; i++) {
+    ((unsigned char *)digest)[i * 4 + 0] = ctx->h[i] >> 24;
+    ((unsigned char *)digest)[i * 4 + 1] = ctx->h[i] >> 16;
+    ((unsigned char *)digest)[i * 4 + 2] = ctx->h[i] >> 8;
+    ((unsigned char *)digest)[i * 4 + 3] = ctx->h[i];
+  }
+}
+
+/*
+ * Finishes an incremental SHA-512 computation.
+ * ctx: pointer to the context
+ * digest: pointer to 64 bytes (512 bits) of memory to store the SHA-512 message digest
+ */
+static void sha512_final(struct sha512_context *ctx, void *digest) {
+  sha512_finish(ctx, digest, 64);
+}
+
+/*
+ * Finishes an incremental SHA-384 computation.
+ * ctx: pointer to the context, started with sha384_init
+ * digest: pointer to 48 bytes (384 bits) of memory to store the SHA-384 message digest
+ *
+ * [SHS] 6.5 SHA-384
+ */
+static void sha384_final(struct sha512_context *ctx, void *digest) {
+  sha512_finish(ctx, digest, 48);
+}
+
+/*
+ * Finishes an incremental SHA-512/256 computation.
+ * ctx: pointer to the context, started with sha512_256_init
+ * digest: pointer to 32 bytes (256 bits) of memory to store the SHA-512/256 message digest
+ *
+ * [SHS] 6.7 SHA-512/256
+ */
+static void sha512_256_final(struct sha512_context *ctx, void *digest) {
+  sha512_finish(ctx, digest, 32);
+}
+
+/*
+ * Computes the SHA-512 message digest of a message in a list of fragments
+ * (as with writev), without copying them into a contiguous buffer.
+ * digest: pointer to 64 bytes (512 bits) of memory to store the SHA-512 message digest
+ * parts: pointers to the fragments of the input message
+ * lengths: number of bytes of each fragment
+ * count: number of fragments
+ */
+static void sha512_v(void *digest, const void **parts, const int *lengths, int count) {
+  struct sha512_context ctx;
+  int i;
+
+  sha512_init(&ctx);
+  for (i = 0; i < count; i++) {
+    sha512_update(&ctx, parts[i], lengths[i]);
+  }
+  sha512_final(&ctx, digest);
+}
+
+/*
+ * Computes the SHA-512 message digest of a message.
+ * digest: pointer to 64 bytes (512 bits) of memory to store the SHA-512 message digest
+ * message: pointer to the input message
+ * length: number of bytes of the input message
+ */
+static void sha512(void *digest, const void *message, int length) {
+  sha512_v(digest, &message, &length, 1);
+}
+
+/*
+ * Computes the SHA-384 message digest of a message.
+ * digest: pointer to 48 bytes (384 bits) of memory to store the SHA-384 message digest
+ * message: pointer to the input message
+ * length: number of bytes of the input message
+ */
+static void sha384(void *digest, const void *message, int length) {
+  struct sha512_context ctx;
+
+  sha384_init(&ctx);
+  sha512_update(&ctx, message, length);
+  sha384_final(&ctx, digest);
+}
+
+/*
+ * Computes the SHA-512/256 message digest of a message.
+ * digest: pointer to 32 bytes (256 bits) of memory to store the SHA-512/256 message digest
+ * message: pointer to the input message
+ * length: number of bytes of the input message
+ */
+static void sha512_256(void *digest, const void *message, int length) {
+  struct sha512_context ctx;
+
+  sha512_256_init(&ctx);
+  sha512_update(&ctx, message, length);
+  sha512_256_final(&ctx, digest);
+}
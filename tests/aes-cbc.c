@@ -0,0 +1,157 @@
+/*
+ * tests/aes-cbc.c: tests for ../aes-cbc.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/tests/aes-cbc.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../aes.h"
+#include "../aes-decrypt.h"
+#include "../aes-cbc.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Tests the aes_ecb and aes_cbc functions with the examples in
+ * [MODES] Appendix F, F.1.1 ECB-AES128 and F.2.1 CBC-AES128,
+ * the PKCS#7 padding against the OpenSSL command-line tool,
+ * and long, in-place and split messages against aes_encrypt.
+ */
+int main(int argc, char **argv) {
+  const unsigned char k[16] = {
+    0x2b,0x7e,0x15,0x16,0x28,0xae,0xd2,0xa6,0xab,0xf7,0x15,0x88,0x09,0xcf,0x4f,0x3c
+  };
+  const unsigned char iv[16] = {
+    0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f
+  };
+  const unsigned char plaintext[64] = {
+    0x6b,0xc1,0xbe,0xe2,0x2e,0x40,0x9f,0x96,0xe9,0x3d,0x7e,0x11,0x73,0x93,0x17,0x2a,
+    0xae,0x2d,0x8a,0x57,0x1e,0x03,0xac,0x9c,0x9e,0xb7,0x6f,0xac,0x45,0xaf,0x8e,0x51,
+    0x30,0xc8,0x1c,0x46,0xa3,0x5c,0xe4,0x11,0xe5,0xfb,0xc1,0x19,0x1a,0x0a,0x52,0xef,
+    0xf6,0x9f,0x24,0x45,0xdf,0x4f,0x9b,0x17,0xad,0x2b,0x41,0x7b,0xe6,0x6c,0x37,0x10
+  };
+  const unsigned char ecb[64] = {
+    0x3a,0xd7,0x7b,0xb4,0x0d,0x7a,0x36,0x60,0xa8,0x9e,0xca,0xf3,0x24,0x66,0xef,0x97,
+    0xf5,0xd3,0xd5,0x85,0x03,0xb9,0x69,0x9d,0xe7,0x85,0x89,0x5a,0x96,0xfd,0xba,0xaf,
+    0x43,0xb1,0xcd,0x7f,0x59,0x8e,0xce,0x23,0x88,0x1b,0x00,0xe3,0xed,0x03,0x06,0x88,
+    0x7b,0x0c,0x78,0x5e,0x27,0xe8,0xad,0x3f,0x82,0x23,0x20,0x71,0x04,0x72,0x5d,0xd4
+  };
+  const unsigned char cbc[64] = {
+    0x76,0x49,0xab,0xac,0x81,0x19,0xb2,0x46,0xce,0xe9,0x8e,0x9b,0x12,0xe9,0x19,0x7d,
+    0x50,0x86,0xcb,0x9b,0x50,0x72,0x19,0xee,0x95,0xdb,0x11,0x3a,0x91,0x76,0x78,0xb2,
+    0x73,0xbe,0xd6,0xb8,0xe3,0xc1,0x74,0x3b,0x71,0x16,0xe6,0x9e,0x22,0x22,0x95,0x16,
+    0x3f,0xf1,0xca,0xa1,0x68,0x1f,0xac,0x09,0x12,0x0e,0xca,0x30,0x75,0x86,0xe1,0xa7
+  };
+  /* openssl enc -aes-128-cbc of the first 20 bytes of the plaintext */
+  const unsigned char padded[32] = {
+    0x76,0x49,0xab,0xac,0x81,0x19,0xb2,0x46,0xce,0xe9,0x8e,0x9b,0x12,0xe9,0x19,0x7d,
+    0x2e,0x01,0x3f,0x89,0x04,0x72,0xd8,0x22,0x17,0xb1,0x7f,0x45,0xf6,0xe7,0xf5,0x39
+  };
+  static unsigned char data[1000], expected[1024], output[1024];
+  struct aes_key key;
+  unsigned char x[16];
+  int i, j, n, length;
+
+  aes_set_key(&key, k);
+
+  /* F.1.1 ECB-AES128 */
+  aes_ecb_encrypt(output, plaintext, 64, &key);
+  if (memcmp(output, ecb, 64)) {
+    fputs("aes_ecb_encrypt() failed\n", stderr);
+    return 1;
+  }
+  aes_ecb_decrypt(output, output, 64, &key);
+  if (memcmp(output, plaintext, 64)) {
+    fputs("aes_ecb_decrypt() failed\n", stderr);
+    return 1;
+  }
+
+  /* F.2.1 CBC-AES128, whole and continued block by block */
+  memcpy(x, iv, 16);
+  aes_cbc_encrypt_blocks(output, x, plaintext, 64, &key);
+  if (memcmp(output, cbc, 64) || memcmp(x, cbc + 48, 16)) {
+    fputs("aes_cbc_encrypt_blocks() failed\n", stderr);
+    return 1;
+  }
+  memcpy(x, iv, 16);
+  for (i = 0; i < 64; i += 16) {
+    aes_cbc_decrypt_blocks(output + i, x, cbc + i, 16, &key);
+  }
+  if (memcmp(output, plaintext, 64) || memcmp(x, cbc + 48, 16)) {
+    fputs("aes_cbc_decrypt_blocks() failed\n", stderr);
+    return 1;
+  }
+
+  /* PKCS#7 padding */
+  if (aes_cbc_encrypt(output, iv, plaintext, 20, &key) != 32 || memcmp(output, padded, 32)) {
+    fputs("aes_cbc_encrypt() failed\n", stderr);
+    return 1;
+  }
+  if (aes_cbc_decrypt(output, iv, padded, 32, &key) != 20 || memcmp(output, plaintext, 20)) {
+    fputs("aes_cbc_decrypt() failed\n", stderr);
+    return 1;
+  }
+
+  /* Lengths within and across the chunks of 32 blocks, in place, against aes_encrypt */
+  for (i = 0; i < 1000; i++) {
+    data[i] = (unsigned char)(i * 11 + 1);
+  }
+  for (length = 0; length <= 1000; length += length < 40 ? 1 : 37) {
+    memcpy(x, iv, 16);
+    memcpy(expected, data, length);
+    n = (length / 16 + 1) * 16;
+    for (i = length; i < n; i++) {
+      expected[i] = (unsigned char)(n - length);
+    }
+    for (i = 0; i < n; i += 16) {
+      for (j = 0; j < 16; j++) {
+        x[j] ^= expected[i + j];
+      }
+      aes_encrypt(x, x, k);
+      memcpy(expected + i, x, 16);
+    }
+
+    memcpy(output, data, length);
+    if (aes_cbc_encrypt(output, iv, output, length, &key) != n || memcmp(output, expected, n)) {
+      fprintf(stderr, "aes_cbc_encrypt() failed for length %d\n", length);
+      return 1;
+    }
+    if (aes_cbc_decrypt(output, iv, output, n, &key) != length || memcmp(output, data, length)) {
+      fprintf(stderr, "aes_cbc_decrypt() failed for length %d\n", length);
+      return 1;
+    }
+  }
+
+  /* Invalid lengths and paddings */
+  if (aes_cbc_decrypt(output, iv, padded, 0, &key) != -1 || aes_cbc_decrypt(output, iv, padded, 31, &key) != -1) {
+    fputs("aes_cbc_decrypt() failed with an invalid length\n", stderr);
+    return 1;
+  }
+  for (i = 0; i <= 17; i++) {
+    /* Last blocks of 16 bytes i, with the byte j altered (or none for j = 16) */
+    for (j = 0; j <= 16; j++) {
+      memset(x, i, 16);
+      if (j < 16) {
+        x[j] ^= 0x80;
+      }
+      memcpy(expected, iv, 16);
+      aes_cbc_encrypt_blocks(output, expected, x, 16, &key);
+      n = aes_cbc_decrypt(output, iv, output, 16, &key);
+      if (n != (i >= 1 && i <= 16 && (j < 16 - i || j == 16) ? 16 - i : -1)) {
+        fprintf(stderr, "aes_cbc_decrypt() failed with the padding %d altered at %d\n", i, j);
+        return 1;
+      }
+    }
+  }
+
+  /* Decrypt what aes_decrypt_block decrypts */
+  aes_decrypt_block(x, ecb, &key);
+  if (memcmp(x, plaintext, 16)) {
+    fputs("aes_decrypt_block() failed\n", stderr);
+    return 1;
+  }
+
+  return 0;
+}
@@ -143,6 +143,56 @@ int main(int argc, char **argv) {
       fputs("aes_ccm_decrypt() payload failed CCM example 3\n", stderr);
       return 1;
     }
+
+    /* In place: the payload and then the MAC in the same buffer */
+    memcpy(x, payload, sizeof(payload));
+    aes_ccm_encrypt(x, 8, nonce, sizeof(nonce), ad, sizeof(ad), x, sizeof(payload), key);
+    if (memcmp(x, ciphertext, sizeof(ciphertext))) {
+      fputs("aes_ccm_encrypt() in place failed CCM example 3\n", stderr);
+      return 1;
+    }
+    if (aes_ccm_decrypt(x, 8, nonce, sizeof(nonce), ad, sizeof(ad), x, sizeof(ciphertext), key)) {
+      fputs("aes_ccm_decrypt() in place tag failed CCM example 3\n", stderr);
+      return 1;
+    }
+    if (memcmp(x, payload, sizeof(payload))) {
+      fputs("aes_ccm_decrypt() in place payload failed CCM example 3\n", stderr);
+      return 1;
+    }
+
+    /* In 3 fragments (payload of 7 + 10 + 7 bytes, ciphertext of 20 + 1 + 11) */
+    {
+      const void *in[3];
+      void *out[3];
+      const int payload_lengths[3] = {7, 10, 7}, ciphertext_lengths[3] = {20, 1, 11};
+      unsigned char y[sizeof(ciphertext)];
+
+      in[0] = payload;
+      in[1] = payload + 7;
+      in[2] = payload + 17;
+      out[0] = y;
+      out[1] = y + 20;
+      out[2] = y + 21;
+      aes_ccm_encrypt_v(out, ciphertext_lengths, 8, nonce, sizeof(nonce), ad, sizeof(ad), in, payload_lengths, 3, key);
+      if (memcmp(y, ciphertext, sizeof(ciphertext))) {
+        fputs("aes_ccm_encrypt_v() failed CCM example 3\n", stderr);
+        return 1;
+      }
+      in[0] = ciphertext;
+      in[1] = ciphertext + 20;
+      in[2] = ciphertext + 21;
+      out[0] = x;
+      out[1] = x + 7;
+      out[2] = x + 17;
+      if (aes_ccm_decrypt_v(out, payload_lengths, 8, nonce, sizeof(nonce), ad, sizeof(ad), in, ciphertext_lengths, 3, key)) {
+        fputs("aes_ccm_decrypt_v() tag failed CCM example 3\n", stderr);
+        return 1;
+      }
+      if (memcmp(x, payload, sizeof(payload))) {
+        fputs("aes_ccm_decrypt_v() payload failed CCM example 3\n", stderr);
+        return 1;
+      }
+    }
   }
 
   /* [CCM] C.4 Example 4 */
@@ -0,0 +1,120 @@
+/*
+ * tests/aes-cmac.c: tests for ../aes-cmac.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/tests/aes-cmac.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../aes.h"
+#include "../aes-cmac.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Tests the aes_cmac functions with the test vectors in
+ * [RFC4493] The AES-CMAC Algorithm, section 4. Test Vectors,
+ * and the incremental and batch functions against them.
+ */
+int main(int argc, char **argv) {
+  const unsigned char k[16] = {
+    0x2b,0x7e,0x15,0x16,0x28,0xae,0xd2,0xa6,0xab,0xf7,0x15,0x88,0x09,0xcf,0x4f,0x3c
+  };
+  const unsigned char k1[16] = {
+    0xfb,0xee,0xd6,0x18,0x35,0x71,0x33,0x66,0x7c,0x85,0xe0,0x8f,0x72,0x36,0xa8,0xde
+  };
+  const unsigned char k2[16] = {
+    0xf7,0xdd,0xac,0x30,0x6a,0xe2,0x66,0xcc,0xf9,0x0b,0xc1,0x1e,0xe4,0x6d,0x51,0x3b
+  };
+  const unsigned char m[64] = {
+    0x6b,0xc1,0xbe,0xe2,0x2e,0x40,0x9f,0x96,0xe9,0x3d,0x7e,0x11,0x73,0x93,0x17,0x2a,
+    0xae,0x2d,0x8a,0x57,0x1e,0x03,0xac,0x9c,0x9e,0xb7,0x6f,0xac,0x45,0xaf,0x8e,0x51,
+    0x30,0xc8,0x1c,0x46,0xa3,0x5c,0xe4,0x11,0xe5,0xfb,0xc1,0x19,0x1a,0x0a,0x52,0xef,
+    0xf6,0x9f,0x24,0x45,0xdf,0x4f,0x9b,0x17,0xad,0x2b,0x41,0x7b,0xe6,0x6c,0x37,0x10
+  };
+  const struct {
+    int length;
+    unsigned char mac[16];
+  } vectors[] = {
+    { /* Example 1: len = 0 */
+      0, {0xbb,0x1d,0x69,0x29,0xe9,0x59,0x37,0x28,0x7f,0xa3,0x7d,0x12,0x9b,0x75,0x67,0x46}
+    },{ /* Example 2: len = 16 */
+      16, {0x07,0x0a,0x16,0xb4,0x6b,0x4d,0x41,0x44,0xf7,0x9b,0xdd,0x9d,0xd0,0x4a,0x28,0x7c}
+    },{ /* Example 3: len = 40 */
+      40, {0xdf,0xa6,0x67,0x47,0xde,0x9a,0xe6,0x30,0x30,0xca,0x32,0x61,0x14,0x97,0xc8,0x27}
+    },{ /* Example 4: len = 64 */
+      64, {0x51,0xf0,0xbe,0xbf,0x7e,0x3b,0x9d,0x92,0xfc,0x49,0x74,0x17,0x79,0x36,0x3c,0xfe}
+    }
+  };
+  static unsigned char data[1000], macs[30 * 16];
+  struct aes_cmac_key key;
+  struct aes_cmac_context ctx;
+  unsigned char mac[16];
+  const void *messages[30];
+  int lengths[30];
+  int i, j, n;
+
+  /* Subkey generation */
+  aes_cmac_set_key(&key, k);
+  if (memcmp(key.k1, k1, 16) || memcmp(key.k2, k2, 16)) {
+    fputs("aes_cmac_set_key() failed\n", stderr);
+    return 1;
+  }
+
+  for (i = 0; i < (int)(sizeof(vectors) / sizeof(vectors[0])); i++) {
+    aes_cmac(mac, &key, m, vectors[i].length);
+    if (memcmp(mac, vectors[i].mac, 16)) {
+      fprintf(stderr, "aes_cmac() failed for example %d\n", i + 1);
+      return 1;
+    }
+
+    /* The message split anywhere, in parts of n bytes */
+    for (n = 1; n <= 17; n++) {
+      aes_cmac_init(&ctx, &key);
+      for (j = 0; j < vectors[i].length; j += n) {
+        aes_cmac_update(&ctx, m + j, vectors[i].length - j < n ? vectors[i].length - j : n);
+      }
+      aes_cmac_update(&ctx, m, 0);
+      aes_cmac_final(&ctx, mac);
+      if (memcmp(mac, vectors[i].mac, 16)) {
+        fprintf(stderr, "aes_cmac_update() failed for example %d in parts of %d bytes\n", i + 1, n);
+        return 1;
+      }
+    }
+
+    /* Batches of the same message, with all the lanes */
+    for (j = 0; j < 9; j++) {
+      messages[j] = m;
+      lengths[j] = vectors[i].length;
+    }
+    aes_cmac_many(macs, &key, messages, lengths, 9);
+    for (j = 0; j < 9; j++) {
+      if (memcmp(macs + j * 16, vectors[i].mac, 16)) {
+        fprintf(stderr, "aes_cmac_many() failed for example %d\n", i + 1);
+        return 1;
+      }
+    }
+  }
+
+  /* Batches of messages of different lengths, against aes_cmac */
+  for (i = 0; i < 1000; i++) {
+    data[i] = (unsigned char)(i * 13 + 5);
+  }
+  for (i = 0; i < 30; i++) {
+    messages[i] = data + i * 7;
+    lengths[i] = (i * 37) % 200;
+  }
+  for (n = 0; n <= 30; n++) {
+    aes_cmac_many(macs, &key, messages, lengths, n);
+    for (i = 0; i < n; i++) {
+      aes_cmac(mac, &key, messages[i], lengths[i]);
+      if (memcmp(macs + i * 16, mac, 16)) {
+        fprintf(stderr, "aes_cmac_many() failed for message %d of %d\n", i, n);
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * tests/aes-decrypt.c: tests for ../aes-decrypt.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/tests/aes-decrypt.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../aes.h"
+#include "../aes-decrypt.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Tests the aes_decrypt_block function with the example values in
+ * [AES] Advanced Encryption Standard (AES), FIPS 197, Nov 26 2001.
+ *       http://csrc.nist.gov/publications/fips/fips197/fips-197.pdf
+ */
+int main(int argc, char **argv) {
+  const struct {
+    unsigned char plaintext[16];
+    unsigned char key[16];
+    unsigned char ciphertext[16];
+  } vectors[] = {
+    { /* [AES] Appendix B Cipher Example */
+      {0x32,0x43,0xf6,0xa8,0x88,0x5a,0x30,0x8d,0x31,0x31,0x98,0xa2,0xe0,0x37,0x07,0x34},
+      {0x2b,0x7e,0x15,0x16,0x28,0xae,0xd2,0xa6,0xab,0xf7,0x15,0x88,0x09,0xcf,0x4f,0x3c},
+      {0x39,0x25,0x84,0x1d,0x02,0xdc,0x09,0xfb,0xdc,0x11,0x85,0x97,0x19,0x6a,0x0b,0x32}
+    },{ /* [AES] Appendix C Example Vectors C.1 AES-128 (Nk=4, Nr=10) */
+      {0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xdd,0xee,0xff},
+      {0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f},
+      {0x69,0xc4,0xe0,0xd8,0x6a,0x7b,0x04,0x30,0xd8,0xcd,0xb7,0x80,0x70,0xb4,0xc5,0x5a}
+    }
+  };
+  struct aes_key key;
+  unsigned char block[16], plaintext[16];
+  unsigned i;
+
+  for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+    aes_set_key(&key, vectors[i].key);
+    aes_decrypt_block(plaintext, vectors[i].ciphertext, &key);
+    if (memcmp(plaintext, vectors[i].plaintext, 16)) {
+      fprintf(stderr, "aes_decrypt_block() failed for test vector %u\n", i);
+      return 1;
+    }
+  }
+
+  /* Decrypt what aes_encrypt encrypts, in place */
+  for (i = 0; i < 16; i++) {
+    block[i] = i * 37;
+  }
+  for (i = 0; i < 100; i++) {
+    memcpy(plaintext, block, 16);
+    aes_encrypt(block, block, vectors[0].ciphertext);
+    aes_set_key(&key, vectors[0].ciphertext);
+    aes_decrypt_block(block, block, &key);
+    if (memcmp(block, plaintext, 16)) {
+      fprintf(stderr, "aes_decrypt_block() failed for block %u\n", i);
+      return 1;
+    }
+    block[i % 16] ^= plaintext[(i + 1) % 16] + 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * tests/aes-drbg.c: tests for ../aes-drbg.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/tests/aes-drbg.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../aes.h"
+#include "../aes-drbg.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Entropy input 0, 1, 2, ..., continued on each call */
+static int counting(void *arg, void *buffer, int length) {
+  int *next = (int *)arg, i;
+
+  for (i = 0; i < length; i++) {
+    ((unsigned char *)buffer)[i] = (unsigned char)(*next)++;
+  }
+  return 0;
+}
+
+/* Entropy source that fails */
+static int failing(void *arg, void *buffer, int length) {
+  return -1;
+}
+
+/*
+ * Tests the aes_drbg functions with outputs of the OpenSSL CTR-DRBG
+ * (AES-128-CTR, without derivation function) from the same entropy input,
+ * personalization string and additional input, and the buffered bytes
+ * against the unbuffered requests.
+ */
+int main(int argc, char **argv) {
+  unsigned char personalization[32], additional[32];
+  const unsigned char expected[3][64] = {
+    { /* first request */
+      0xfc,0x72,0xe7,0x0a,0x71,0x3f,0xff,0xd9,0x30,0xc4,0xbc,0x3d,0xce,0x9e,0x53,0x19,
+      0xec,0x08,0xf7,0xa9,0x96,0x67,0x9c,0x6c,0x95,0xc2,0xd5,0x2f,0x6b,0xc2,0xdf,0xf1,
+      0x01,0xbd,0xd0,0x82,0x8a,0xfa,0x1b,0x70,0xa4,0x75,0x94,0x01,0xb0,0x35,0xaa,0x10,
+      0xb5,0xfa,0x90,0x92,0x92,0x80,0x34,0x19,0xe2,0x7c,0x68,0x14,0xfd,0x91,0xec,0x39
+    },{ /* with additional input */
+      0x9d,0xca,0x28,0x43,0x47,0xaa,0xde,0xe0,0x3a,0x95,0xd3,0xc0,0x7c,0x77,0x41,0x9a,
+      0x51,0x62,0x5b,0x00,0xb4,0x8a,0x87,0x00,0xdc,0x85,0x50,0x5e,0x2c,0x3d,0x77,0x5a,
+      0x3e,0x10,0xf5,0x6e,0x83,0xf0,0x9c,0x1e,0x69,0x94,0x06,0xc9,0x1f,0x2c,0xe8,0x8b,
+      0xd1,0xc1,0xde,0x4f,0x17,0x11,0xb5,0xae,0x92,0x4e,0xf0,0x22,0xab,0x83,0xc3,0x96
+    },{ /* after a reseed */
+      0x1f,0xbe,0xbf,0x5a,0xa3,0x87,0x54,0x6b,0x4b,0xb0,0xbd,0x91,0x02,0xe6,0xed,0x32,
+      0xdd,0x9b,0x1f,0xac,0xd9,0xad,0x58,0x44,0x63,0x75,0x15,0x43,0x0f,0x17,0xb5,0x1c,
+      0xb5,0x01,0x53,0xa2,0x33,0xdc,0x05,0x8b,0xa5,0xbf,0xc1,0xfa,0x68,0x4e,0x2a,0x47,
+      0x94,0x28,0x0c,0x25,0x41,0xf3,0x31,0x10,0x10,0xf8,0x90,0x4f,0x98,0xbd,0x6a,0x89
+    }
+  };
+  static unsigned char x[3 * AES_DRBG_MAX_REQUEST], y[3 * AES_DRBG_MAX_REQUEST];
+  struct aes_drbg drbg, copy;
+  int i, n, next;
+
+  for (i = 0; i < 32; i++) {
+    personalization[i] = (unsigned char)(0x80 + i);
+    additional[i] = (unsigned char)(0xa0 + i);
+  }
+
+  next = 0;
+  if (aes_drbg_init(&drbg, counting, &next, personalization, 32, 1000) ||
+      aes_drbg_request(&drbg, x, 64, NULL, 0) || memcmp(x, expected[0], 64)) {
+    fputs("aes_drbg_request() failed\n", stderr);
+    return 1;
+  }
+  if (aes_drbg_request(&drbg, x, 64, additional, 32) || memcmp(x, expected[1], 64)) {
+    fputs("aes_drbg_request() failed with additional input\n", stderr);
+    return 1;
+  }
+  next = 0;  /* the same entropy input again */
+  if (aes_drbg_reseed(&drbg, NULL, 0) || aes_drbg_request(&drbg, x, 64, NULL, 0) || memcmp(x, expected[2], 64)) {
+    fputs("aes_drbg_reseed() failed\n", stderr);
+    return 1;
+  }
+
+  /* Instantiation: V = CIPH_0(0...02) xor the last 16 bytes of the entropy input */
+  memset(x, 0, 32);
+  x[15] = 2;
+  aes_encrypt(x, x, x + 16);
+  for (i = 0; i < 16; i++) {
+    x[i] ^= (unsigned char)(16 + i);
+  }
+  next = 0;
+  aes_drbg_init(&drbg, counting, &next, NULL, 0, 1000);
+  if (memcmp(drbg.v, x, 16)) {
+    fputs("aes_drbg_init() failed\n", stderr);
+    return 1;
+  }
+
+  /* The counter carried across the 32-bit words: V + 1 and V + 2 after V = 00ff...ff */
+  memset(drbg.v, 0xff, 16);
+  drbg.v[0] = 0;
+  aes_set_key(&drbg.key, personalization);
+  aes_drbg_request(&drbg, x, 32, NULL, 0);
+  memset(y, 0, 32);
+  y[0] = y[16] = 1;
+  y[31] = 1;
+  aes_encrypt(y, y, personalization);
+  aes_encrypt(y + 16, y + 16, personalization);
+  if (memcmp(x, y, 32)) {
+    fputs("aes_drbg_request() failed to carry the counter\n", stderr);
+    return 1;
+  }
+
+  /* The reseed interval: the second request reseeds, which changes the output */
+  next = 0;
+  aes_drbg_init(&drbg, counting, &next, personalization, 32, 1);
+  aes_drbg_request(&drbg, x, 64, NULL, 0);
+  aes_drbg_request(&drbg, x, 64, NULL, 0);
+  if (next != 64) {
+    fputs("aes_drbg_request() failed to reseed\n", stderr);
+    return 1;
+  }
+  next = 0;
+  aes_drbg_init(&drbg, counting, &next, personalization, 32, 1);
+  aes_drbg_request(&drbg, x, 64, NULL, 0);
+  drbg.entropy = failing;
+  if (!aes_drbg_request(&drbg, x, 64, NULL, 0) || !aes_drbg_generate(&drbg, x, 1) ||
+      !aes_drbg_init(&drbg, failing, NULL, NULL, 0, 1)) {
+    fputs("aes_drbg_request() failed with a failing entropy source\n", stderr);
+    return 1;
+  }
+
+  /* Buffered requests of all sizes are the unbuffered requests of
+     AES_DRBG_BUFFER bytes, in order, with the same reseeds */
+  next = 0;
+  aes_drbg_init(&drbg, counting, &next, NULL, 0, 3);
+  copy = drbg;
+  for (i = 0, n = 0; i < 8 * AES_DRBG_BUFFER; i += n, n = (n * 7 + 1) % 300) {
+    if (n > 8 * AES_DRBG_BUFFER - i) {
+      n = 8 * AES_DRBG_BUFFER - i;
+    }
+    if (aes_drbg_generate(&drbg, x + i, n)) {
+      fputs("aes_drbg_generate() failed\n", stderr);
+      return 1;
+    }
+  }
+  next = 32;  /* after the entropy input of the instantiation */
+  for (i = 0; i < 8 * AES_DRBG_BUFFER; i += AES_DRBG_BUFFER) {
+    aes_drbg_request(&copy, y + i, AES_DRBG_BUFFER, NULL, 0);
+  }
+  if (memcmp(x, y, 8 * AES_DRBG_BUFFER) || memcmp(drbg.v, copy.v, 16) || drbg.available != 0) {
+    fputs("aes_drbg_generate() differs from aes_drbg_request()\n", stderr);
+    return 1;
+  }
+
+  /* Large requests go directly to the output, in requests of up to AES_DRBG_MAX_REQUEST bytes */
+  next = 0;
+  aes_drbg_init(&drbg, counting, &next, NULL, 0, 5);
+  copy = drbg;
+  aes_drbg_generate(&drbg, x, 2 * AES_DRBG_MAX_REQUEST + 100);
+  next = 32;
+  aes_drbg_request(&copy, y, AES_DRBG_MAX_REQUEST, NULL, 0);
+  aes_drbg_request(&copy, y + AES_DRBG_MAX_REQUEST, AES_DRBG_MAX_REQUEST, NULL, 0);
+  aes_drbg_request(&copy, y + 2 * AES_DRBG_MAX_REQUEST, AES_DRBG_BUFFER, NULL, 0);
+  if (memcmp(x, y, 2 * AES_DRBG_MAX_REQUEST + 100) || aes_drbg_request(&copy, y, AES_DRBG_MAX_REQUEST + 1, NULL, 0) != -1) {
+    fputs("aes_drbg_generate() failed for a large request\n", stderr);
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * tests/aes-gcm-stream.c: tests for ../aes-gcm-stream.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/tests/aes-gcm-stream.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../aes.h"
+#include "../aes-gcm.h"
+#include "../aes-gcm-stream.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Tests the aes_gcm_stream_* functions: the segments against aes_gcm_encrypt
+ * with the IVs of the format, reads of ranges against the plaintext, and
+ * altered, reordered and truncated messages.
+ */
+int main(int argc, char **argv) {
+  const unsigned char key[16] = {
+    0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c,
+    0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08
+  };
+  const unsigned char nonce[7] = {0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb};
+  const int lengths[] = {0, 1, 63, 64, 65, 128, 1000};
+  static unsigned char plaintext[1000], sealed[1000 + 12 + 16 * 16], expected[1000 + 16], output[1000];
+  unsigned char iv[12];
+  int i, j, k, n, length, sealed_length, offset;
+
+  for (i = 0; i < 1000; i++) {
+    plaintext[i] = (unsigned char)(i * 7 + 3);
+  }
+
+  for (k = 0; k < (int)(sizeof(lengths) / sizeof(lengths[0])); k++) {
+    length = lengths[k];
+    sealed_length = aes_gcm_stream_seal(sealed, 64, nonce, plaintext, length, key);
+    if (sealed_length != aes_gcm_stream_sealed_length(length, 64) ||
+        aes_gcm_stream_length(sealed, sealed_length) != length) {
+      fprintf(stderr, "aes_gcm_stream_seal() length failed for length %d\n", length);
+      return 1;
+    }
+
+    /* Each segment: nonce prefix || index || last, with the header as the AAD */
+    for (i = 0; i == 0 || i * 64 < length; i++) {
+      n = length - i * 64 < 64 ? length - i * 64 : 64;
+      memcpy(iv, nonce, 7);
+      iv[7] = 0;
+      iv[8] = 0;
+      iv[9] = 0;
+      iv[10] = (unsigned char)i;
+      iv[11] = (i + 1) * 64 >= length;
+      aes_gcm_encrypt(expected, expected + n, iv, plaintext + i * 64, n, sealed, 12, key);
+      if (memcmp(sealed + 12 + i * 80, expected, n + 16)) {
+        fprintf(stderr, "aes_gcm_stream_seal() segment %d failed for length %d\n", i, length);
+        return 1;
+      }
+      if (aes_gcm_stream_open_segment(output, sealed, i, iv[11], sealed + 12 + i * 80, n + 16, key) ||
+          memcmp(output, plaintext + i * 64, n)) {
+        fprintf(stderr, "aes_gcm_stream_open_segment() segment %d failed for length %d\n", i, length);
+        return 1;
+      }
+    }
+
+    /* Ranges at all the offsets, with lengths within and across segments */
+    for (offset = 0; offset <= length; offset++) {
+      for (n = 0; offset + n <= length && n <= 150; n += n < 20 ? 1 : 13) {
+        if (aes_gcm_stream_read(output, sealed, sealed_length, offset, n, key) ||
+            memcmp(output, plaintext + offset, n)) {
+          fprintf(stderr, "aes_gcm_stream_read() failed for length %d at %d + %d\n", length, offset, n);
+          return 1;
+        }
+      }
+    }
+    if (!aes_gcm_stream_read(output, sealed, sealed_length, length, 1, key)) {
+      fprintf(stderr, "aes_gcm_stream_read() past the end failed for length %d\n", length);
+      return 1;
+    }
+  }
+
+  /* Altered byte in segment 5 (of 16): only the ranges with it fail */
+  sealed_length = aes_gcm_stream_seal(sealed, 64, nonce, plaintext, 1000, key);
+  sealed[12 + 5 * 80 + 33] ^= 0x10;
+  if (!aes_gcm_stream_read(output, sealed, sealed_length, 5 * 64 + 60, 1, key) ||
+      !aes_gcm_stream_read(output, sealed, sealed_length, 0, 1000, key) ||
+      aes_gcm_stream_read(output, sealed, sealed_length, 6 * 64, 100, key) ||
+      !aes_gcm_stream_open_segment(output, sealed, 5, 0, sealed + 12 + 5 * 80, 80, key)) {
+    fputs("aes_gcm_stream_read() failed with an altered segment\n", stderr);
+    return 1;
+  }
+  sealed[12 + 5 * 80 + 33] ^= 0x10;
+
+  /* Segments 2 and 3 swapped */
+  memcpy(output, sealed + 12 + 2 * 80, 80);
+  memcpy(sealed + 12 + 2 * 80, sealed + 12 + 3 * 80, 80);
+  memcpy(sealed + 12 + 3 * 80, output, 80);
+  if (!aes_gcm_stream_read(output, sealed, sealed_length, 2 * 64, 1, key) ||
+      !aes_gcm_stream_read(output, sealed, sealed_length, 3 * 64, 1, key)) {
+    fputs("aes_gcm_stream_read() failed with swapped segments\n", stderr);
+    return 1;
+  }
+  aes_gcm_stream_seal(sealed, 64, nonce, plaintext, 1000, key);
+
+  /* Truncated at a segment boundary: the new last segment is not marked as last */
+  j = sealed_length - (1000 - 15 * 64 + 16);
+  if (aes_gcm_stream_length(sealed, j) != 15 * 64 ||
+      !aes_gcm_stream_read(output, sealed, j, 15 * 64 - 1, 1, key) ||
+      !aes_gcm_stream_read(output, sealed, j, 15 * 64, 0, key) ||
+      aes_gcm_stream_read(output, sealed, j, 0, 64, key)) {
+    fputs("aes_gcm_stream_read() failed with a truncated message\n", stderr);
+    return 1;
+  }
+
+  /* Truncated within a tag, and an altered header */
+  if (aes_gcm_stream_length(sealed, 12 + 15) != -1 || aes_gcm_stream_length(sealed, 12 + 80 + 15) != -1) {
+    fputs("aes_gcm_stream_length() failed with a truncated tag\n", stderr);
+    return 1;
+  }
+  sealed[3] = 65;
+  if (!aes_gcm_stream_read(output, sealed, aes_gcm_stream_sealed_length(1000, 65), 0, 1, key)) {
+    fputs("aes_gcm_stream_read() failed with an altered header\n", stderr);
+    return 1;
+  }
+
+  return 0;
+}
@@ -65,6 +65,9 @@ int main(int argc, char **argv) {
   };
   unsigned char text[64];
   unsigned char tag[16];
+  unsigned char packet[64 + 16];  /* for in-place operation */
+  void *parts[3];  /* 3 fragments: 5 bytes, 21 bytes and the rest */
+  int lengths[3];
   unsigned i;
 
   for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
@@ -88,6 +91,40 @@ int main(int argc, char **argv) {
       fprintf(stderr, "aes_gcm_decrypt() plaintext failed for test vector %u\n", i);
       return 1;
     }
+
+    /* In place, with the tag right after the ciphertext */
+    memcpy(packet, plaintext, v->plaintext_length);
+    aes_gcm_encrypt(packet, packet + v->plaintext_length, iv, packet, v->plaintext_length, aad, v->aad_length, key);
+    if (memcmp(packet, ciphertext, v->plaintext_length) ||
+        memcmp(packet + v->plaintext_length, v->tag, v->tag_length)) {
+      fprintf(stderr, "aes_gcm_encrypt() in place failed for test vector %u\n", i);
+      return 1;
+    }
+    if (aes_gcm_decrypt(packet, iv, packet, v->plaintext_length, aad, v->aad_length,
+                        packet + v->plaintext_length, v->tag_length, key) ||
+        memcmp(packet, plaintext, v->plaintext_length)) {
+      fprintf(stderr, "aes_gcm_decrypt() in place failed for test vector %u\n", i);
+      return 1;
+    }
+
+    /* In 3 fragments, in place */
+    lengths[0] = v->plaintext_length < 5 ? v->plaintext_length : 5;
+    lengths[1] = v->plaintext_length < 26 ? v->plaintext_length - lengths[0] : 21;
+    lengths[2] = v->plaintext_length - lengths[0] - lengths[1];
+    parts[0] = packet;
+    parts[1] = packet + lengths[0];
+    parts[2] = packet + lengths[0] + lengths[1];
+    memcpy(packet, plaintext, v->plaintext_length);
+    aes_gcm_encrypt_v(parts, lengths, tag, iv, (const void **)parts, lengths, 3, aad, v->aad_length, key);
+    if (memcmp(packet, ciphertext, v->plaintext_length) || memcmp(tag, v->tag, v->tag_length)) {
+      fprintf(stderr, "aes_gcm_encrypt_v() failed for test vector %u\n", i);
+      return 1;
+    }
+    if (aes_gcm_decrypt_v(parts, lengths, iv, (const void **)parts, lengths, 3, aad, v->aad_length, v->tag, v->tag_length, key) ||
+        memcmp(packet, plaintext, v->plaintext_length)) {
+      fprintf(stderr, "aes_gcm_decrypt_v() failed for test vector %u\n", i);
+      return 1;
+    }
   }
 
   return 0;
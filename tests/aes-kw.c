@@ -8,13 +8,16 @@
  */
 
 #include "../aes.h"
+#include "../aes-decrypt.h"
 #include "../aes-kw.h"
 #include <stdio.h>
 #include <string.h>
 
 /*
- * Tests the aes_kw function with the example values in RFC3394:
- * Test Vectors 4.1 Wrap 128 bits of Key Data with a 128-bit KEK.
+ * Tests the aes_kw* functions with the example values in RFC3394:
+ * Test Vectors 4.1 Wrap 128 bits of Key Data with a 128-bit KEK,
+ * and with values computed with OpenSSL (id-aes128-wrap, id-aes128-wrap-pad)
+ * for 128-bit KEKs, which RFC5649 has no examples for.
  */
 int main(int argc, char **argv) {
   const unsigned char key[16] = {
@@ -30,7 +33,31 @@ int main(int argc, char **argv) {
     0xae, 0xf3, 0x4b, 0xd8, 0xfb, 0x5a, 0x7b, 0x82,
     0x9d, 0x3e, 0x86, 0x23, 0x71, 0xd2, 0xcf, 0xe5
   };
-  unsigned char x[sizeof(ciphertext)];
+  const struct { char plaintext[28]; int ciphertext_length; unsigned char ciphertext[40]; } kwp[] = {
+    { "abc", 16, {
+      0xe6,0x61,0x94,0x4e,0xcf,0x16,0x6c,0x3e,0x44,0xc5,0xc3,0x84,0x75,0x8b,0x00,0x91 } },
+    { "abcdefgh", 16, {
+      0xe5,0x6b,0x36,0x2d,0x2c,0x66,0xd0,0x4e,0x16,0xe3,0xd5,0xdb,0xce,0xe1,0xc9,0xef } },
+    { "abcdefghi", 24, {
+      0x2c,0x8a,0x0b,0xf7,0xdc,0x51,0xbb,0x93,0x8f,0x19,0xe1,0x97,0xcf,0xa0,0xdc,0x13,
+      0xfe,0x7e,0xd5,0x44,0x3a,0x4c,0xd9,0x0c } },
+    { "0123456789abcdefghijklmnopq", 40, {
+      0x5c,0x5e,0xac,0x7c,0x68,0xf8,0x35,0x35,0x78,0xe6,0xde,0xa1,0x9e,0xf7,0x62,0xed,
+      0xdd,0x8c,0xd9,0x62,0x0a,0x89,0x9d,0x64,0xda,0xd2,0x9b,0x23,0x18,0xd8,0x86,0x6b,
+      0x38,0xff,0xc3,0x7d,0x62,0x6c,0x2f,0x75 } },
+  };
+  /* First and last 8 bytes of the wrapping of 400 (or 397) bytes (i * 7 + 1) */
+  const unsigned char kw400[16] = {
+    0x09,0xa9,0x72,0x25,0xfc,0xa1,0x70,0x7e,0x65,0xc5,0xfc,0xb8,0xdb,0x4d,0xeb,0xdf
+  };
+  const unsigned char kwp397[16] = {
+    0x94,0xe4,0x85,0xa6,0xe6,0x19,0xe2,0x21,0x77,0x32,0xf2,0x46,0xbf,0x25,0xca,0x5b
+  };
+  static unsigned char big[400], x[408], y[408], many[12 * 40];
+  struct aes_key expanded;
+  int results[12];
+  unsigned i;
+  int n;
 
   aes_kw(x, plaintext, sizeof(plaintext) / 8, key);
   if (memcmp(x, ciphertext, sizeof(ciphertext))) {
@@ -38,5 +65,89 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  aes_set_key(&expanded, key);
+  if (aes_kw_unwrap(y, ciphertext, 2, &expanded) != 0 || memcmp(y, plaintext, 16)) {
+    fputs("aes_kw_unwrap() failed\n", stderr);
+    return 1;
+  }
+  memcpy(x, ciphertext, sizeof(ciphertext));
+  x[23] ^= 1;
+  if (aes_kw_unwrap(y, x, 2, &expanded) != -1 || y[0] || y[15]) {
+    fputs("aes_kw_unwrap() accepted a modified ciphertext\n", stderr);
+    return 1;
+  }
+
+  /* More than 42 blocks, so that t no longer fits in a byte */
+  for (i = 0; i < sizeof(big); i++) {
+    big[i] = i * 7 + 1;
+  }
+  aes_kw_wrap(x, big, 50, &expanded);
+  if (memcmp(x, kw400, 8) || memcmp(x + 400, kw400 + 8, 8)) {
+    fputs("aes_kw_wrap() failed for 50 blocks\n", stderr);
+    return 1;
+  }
+  if (aes_kw_unwrap(y, x, 50, &expanded) != 0 || memcmp(y, big, 400)) {
+    fputs("aes_kw_unwrap() failed for 50 blocks\n", stderr);
+    return 1;
+  }
+  if (aes_kwp_wrap(x, big, 397, &expanded) != 408 || memcmp(x, kwp397, 8) || memcmp(x + 400, kwp397 + 8, 8)) {
+    fputs("aes_kwp_wrap() failed for 397 bytes\n", stderr);
+    return 1;
+  }
+  if (aes_kwp_unwrap(y, x, 408, &expanded) != 397 || memcmp(y, big, 397)) {
+    fputs("aes_kwp_unwrap() failed for 397 bytes\n", stderr);
+    return 1;
+  }
+
+  for (i = 0; i < sizeof(kwp) / sizeof(kwp[0]); i++) {
+    n = aes_kwp_wrap(x, kwp[i].plaintext, strlen(kwp[i].plaintext), &expanded);
+    if (n != kwp[i].ciphertext_length || memcmp(x, kwp[i].ciphertext, n)) {
+      fprintf(stderr, "aes_kwp_wrap() failed for test vector %u\n", i);
+      return 1;
+    }
+    n = aes_kwp_unwrap(y, kwp[i].ciphertext, kwp[i].ciphertext_length, &expanded);
+    if (n != (int)strlen(kwp[i].plaintext) || memcmp(y, kwp[i].plaintext, n)) {
+      fprintf(stderr, "aes_kwp_unwrap() failed for test vector %u\n", i);
+      return 1;
+    }
+    memcpy(x, kwp[i].ciphertext, kwp[i].ciphertext_length);
+    x[i] ^= 0x80;
+    if (aes_kwp_unwrap(y, x, kwp[i].ciphertext_length, &expanded) != -1 ||
+        aes_kwp_unwrap(y, x, kwp[i].ciphertext_length - 1, &expanded) != -1) {
+      fprintf(stderr, "aes_kwp_unwrap() accepted a modified ciphertext %u\n", i);
+      return 1;
+    }
+  }
+
+  /* Wrap and unwrap 12 keys of 32 bytes at once, as if one by one */
+  aes_kw_wrap_many(many, big, 4, 12, &expanded);
+  for (i = 0; i < 12; i++) {
+    aes_kw_wrap(x, big + i * 32, 4, &expanded);
+    if (memcmp(x, many + i * 40, 40)) {
+      fprintf(stderr, "aes_kw_wrap_many() failed for key %u\n", i);
+      return 1;
+    }
+  }
+  many[9 * 40 + 39] ^= 1;
+  if (aes_kw_unwrap_many(y, many, 4, 12, &expanded, results) != 1) {
+    fputs("aes_kw_unwrap_many() failed\n", stderr);
+    return 1;
+  }
+  for (i = 0; i < 12; i++) {
+    if (i == 9 ? results[i] != -1 || y[i * 32] || y[i * 32 + 31] :
+        results[i] != 0 || memcmp(y + i * 32, big + i * 32, 32)) {
+      fprintf(stderr, "aes_kw_unwrap_many() failed for key %u\n", i);
+      return 1;
+    }
+  }
+
+  /* A single padded block is encrypted as is: AIV | P */
+  memcpy(x, "\xa6\x59\x59\xa6\x00\x00\x00\x03" "abc\0\0\0\0\0", 16);
+  aes_encrypt(x, x, key);
+  if (memcmp(x, kwp[0].ciphertext, 16)) {
+    fputs("aes_kwp_wrap() differs from aes_encrypt() for one block\n", stderr);
+    return 1;
+  }
+
   return 0;
 }
@@ -15,11 +15,15 @@
 /*
  * Tests the aes_mmo function with the example values in the
  * ZigBee specification, document 05-3474-21, Aug 2015,
- * section C.5 Cryptographic Hash Function.
+ * section C.5 Cryptographic Hash Function,
+ * and the incremental and batch functions against it.
  */
 int main(int argc, char **argv) {
-  unsigned char x[16];
-  unsigned i;
+  struct aes_mmo_context ctx;
+  unsigned char x[16], y[16], digests[21 * 16];
+  const void *messages[21];
+  int lengths[21];
+  unsigned i, j, k;
 
   /* C.5.1 Test Vector Set 1 */
   {
@@ -105,5 +109,71 @@ int main(int argc, char **argv) {
     }
   }
 
+  /* Incremental computation of test vector 5, one byte at a time */
+  {
+    unsigned char m[8201];
+    const unsigned char h[] = {0x72,0xc9,0xb1,0x5e,0x17,0x8a,0xa8,0x43,0xe4,0xa1,0x6c,0x58,0xe3,0x36,0x43,0xa3};
+
+    aes_mmo_init(&ctx);
+    for (i = 0; i < sizeof(m); i++) {
+      m[i] = i;
+      aes_mmo_update(&ctx, m + i, 1);
+    }
+    aes_mmo_final(&ctx, x);
+    if (memcmp(x, h, 16)) {
+      fputs("aes_mmo_update() failed test vector 5\n", stderr);
+      return 1;
+    }
+  }
+
+  /* Incremental computations around the 8192-byte length encoding change */
+  {
+    unsigned char m[8220];
+
+    for (i = 0; i < sizeof(m); i++) {
+      m[i] = i * 7;
+    }
+    for (i = 8160; i <= sizeof(m); i++) {
+      aes_mmo(x, m, i);
+      for (j = 1; j < 40; j += 3) {
+        aes_mmo_init(&ctx);
+        for (k = 0; k < i; k += j) {
+          aes_mmo_update(&ctx, m + k, k + j < i ? j : i - k);
+        }
+        aes_mmo_final(&ctx, y);
+        if (memcmp(x, y, 16)) {
+          fprintf(stderr, "aes_mmo_update() failed for length %u in parts of %u\n", i, j);
+          return 1;
+        }
+      }
+    }
+  }
+
+  /* Batches of messages of different lengths, including 0 and over 8192 bytes */
+  {
+    static unsigned char m[8300];
+
+    for (i = 0; i < sizeof(m); i++) {
+      m[i] = i * 11;
+    }
+    for (k = 0; k <= 21; k++) {
+      for (j = 0; j < k; j++) {
+        messages[j] = m + j;
+        lengths[j] = (j * 37 + k * 5) % 50;
+        if (j % 5 == 3) {
+          lengths[j] += 8150 + k;
+        }
+      }
+      aes_mmo_many(digests, messages, lengths, k);
+      for (j = 0; j < k; j++) {
+        aes_mmo(x, messages[j], lengths[j]);
+        if (memcmp(x, digests + j * 16, 16)) {
+          fprintf(stderr, "aes_mmo_many() failed for message %u of %u\n", j, k);
+          return 1;
+        }
+      }
+    }
+  }
+
   return 0;
 }
@@ -0,0 +1,186 @@
+/*
+ * tests/aes-xts.c: tests for ../aes-xts.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/tests/aes-xts.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../aes.h"
+#include "../aes-decrypt.h"
+#include "../aes-xts.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Reference XTS-AES-128 encryption of one block with the tweak t,
+ * which is then multiplied by alpha one byte at a time.
+ */
+static void reference_block(unsigned char *output, const unsigned char *input, unsigned char *t, const unsigned char *key1) {
+  unsigned char carry;
+  int i;
+
+  for (i = 0; i < 16; i++) {
+    output[i] = input[i] ^ t[i];
+  }
+  aes_encrypt(output, output, key1);
+  for (i = 0; i < 16; i++) {
+    output[i] ^= t[i];
+  }
+  carry = t[15] >> 7;
+  for (i = 15; i > 0; i--) {
+    t[i] = (unsigned char)(t[i] << 1 | t[i - 1] >> 7);
+  }
+  t[0] = (unsigned char)(t[0] << 1 ^ (carry ? 0x87 : 0));
+}
+
+/*
+ * Reference XTS-AES-128 encryption of one sector, block by block, with aes_encrypt.
+ */
+static void reference(unsigned char *output, const unsigned char *input, int length, const unsigned char *sector,
+                      const unsigned char *key1, const unsigned char *key2) {
+  unsigned char t[16], x[16];
+  int i, j, m, r;
+
+  aes_encrypt(t, sector, key2);
+  m = length / 16;
+  r = length % 16;
+  for (j = 0; j < m; j++) {
+    reference_block(output + j * 16, input + j * 16, t, key1);
+  }
+  if (r) {  /* ciphertext stealing, with T_m */
+    for (i = 0; i < 16; i++) {
+      x[i] = i < r ? input[m * 16 + i] : output[(m - 1) * 16 + i];
+    }
+    for (i = 0; i < r; i++) {
+      output[m * 16 + i] = output[(m - 1) * 16 + i];
+    }
+    reference_block(output + (m - 1) * 16, x, t, key1);
+  }
+}
+
+/*
+ * Tests the aes_xts functions with test vectors in
+ * [XTS] Annex B (Vectors 2, 15 and 18), checked with OpenSSL,
+ * and the sectors of all lengths against a reference implementation.
+ */
+int main(int argc, char **argv) {
+  const struct {
+    unsigned char key1[16];
+    unsigned char key2[16];
+    unsigned char sector[16];
+    int length;
+    unsigned char plaintext[32];
+    unsigned char ciphertext[32];
+  } vectors[] = {
+    { /* Vector 2 */
+      {0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11,0x11},
+      {0x22,0x22,0x22,0x22,0x22,0x22,0x22,0x22,0x22,0x22,0x22,0x22,0x22,0x22,0x22,0x22},
+      {0x33,0x33,0x33,0x33,0x33},
+      32,
+      {0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,
+       0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44,0x44},
+      {0xc4,0x54,0x18,0x5e,0x6a,0x16,0x93,0x6e,0x39,0x33,0x40,0x38,0xac,0xef,0x83,0x8b,
+       0xfb,0x18,0x6f,0xff,0x74,0x80,0xad,0xc4,0x28,0x93,0x82,0xec,0xd6,0xd3,0x94,0xf0}
+    },{ /* Vector 15 */
+      {0xff,0xfe,0xfd,0xfc,0xfb,0xfa,0xf9,0xf8,0xf7,0xf6,0xf5,0xf4,0xf3,0xf2,0xf1,0xf0},
+      {0xbf,0xbe,0xbd,0xbc,0xbb,0xba,0xb9,0xb8,0xb7,0xb6,0xb5,0xb4,0xb3,0xb2,0xb1,0xb0},
+      {0x9a,0x78,0x56,0x34,0x12},
+      17,
+      {0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f,0x10},
+      {0x6c,0x16,0x25,0xdb,0x46,0x71,0x52,0x2d,0x3d,0x75,0x99,0x60,0x1d,0xe7,0xca,0x09,0xed}
+    },{ /* Vector 18 */
+      {0xff,0xfe,0xfd,0xfc,0xfb,0xfa,0xf9,0xf8,0xf7,0xf6,0xf5,0xf4,0xf3,0xf2,0xf1,0xf0},
+      {0xbf,0xbe,0xbd,0xbc,0xbb,0xba,0xb9,0xb8,0xb7,0xb6,0xb5,0xb4,0xb3,0xb2,0xb1,0xb0},
+      {0x9a,0x78,0x56,0x34,0x12},
+      20,
+      {0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f,
+       0x10,0x11,0x12,0x13},
+      {0x9d,0x84,0xc8,0x13,0xf7,0x19,0xaa,0x2c,0x7b,0xe3,0xf6,0x61,0x71,0xc7,0xc5,0xc2,
+       0xed,0xbf,0x9d,0xac}
+    }
+  };
+  const unsigned char *key1 = vectors[1].key1, *key2 = vectors[1].key2;
+  static unsigned char data[20 * 600], expected[20 * 600], output[20 * 600];
+  unsigned char sector[16], x[16];
+  struct aes_xts_key key;
+  int i, j, length, count;
+
+  for (i = 0; i < (int)(sizeof(vectors) / sizeof(vectors[0])); i++) {
+    aes_xts_set_key(&key, vectors[i].key1, vectors[i].key2);
+    if (aes_xts_encrypt(output, vectors[i].plaintext, vectors[i].length, vectors[i].sector, &key) ||
+        memcmp(output, vectors[i].ciphertext, vectors[i].length)) {
+      fprintf(stderr, "aes_xts_encrypt() failed for test vector %d\n", i);
+      return 1;
+    }
+    if (aes_xts_decrypt(output, output, vectors[i].length, vectors[i].sector, &key) ||
+        memcmp(output, vectors[i].plaintext, vectors[i].length)) {
+      fprintf(stderr, "aes_xts_decrypt() failed for test vector %d\n", i);
+      return 1;
+    }
+  }
+  if (aes_xts_encrypt(output, data, 15, sector, &key) != -1 || aes_xts_decrypt(output, data, 15, sector, &key) != -1) {
+    fputs("aes_xts_encrypt() failed for a sector shorter than a block\n", stderr);
+    return 1;
+  }
+
+  /* Sectors of all the lengths, within and across runs of 32 blocks, in place */
+  aes_xts_set_key(&key, key1, key2);
+  for (i = 0; i < (int)sizeof(data); i++) {
+    data[i] = (unsigned char)(i * 7 + 1);
+  }
+  memset(sector, 0, 16);
+  for (length = 16; length <= 600; length += length < 40 ? 1 : 17) {
+    sector[0] = (unsigned char)length;
+    reference(expected, data, length, sector, key1, key2);
+    memcpy(output, data, length);
+    if (aes_xts_encrypt(output, output, length, sector, &key) || memcmp(output, expected, length)) {
+      fprintf(stderr, "aes_xts_encrypt() failed for length %d\n", length);
+      return 1;
+    }
+    if (aes_xts_decrypt(output, output, length, sector, &key) || memcmp(output, data, length)) {
+      fprintf(stderr, "aes_xts_decrypt() failed for length %d\n", length);
+      return 1;
+    }
+  }
+
+  /* Consecutive sectors, with the sector number carried across bytes */
+  for (count = 0; count <= 20; count++) {
+    for (length = 16; length <= 600; length += length < 32 ? 1 : 97) {
+      memset(sector, 0xff, 16);
+      sector[0] = 0xf7;
+      sector[15] = 0;
+      for (j = 0; j < count; j++) {
+        memcpy(x, sector, 16);
+        x[0] = (unsigned char)(x[0] + j);
+        for (i = 1; i < 15; i++) {
+          x[i] = (unsigned char)(j > 8 ? 0 : 0xff);
+        }
+        x[15] = j > 8;
+        reference(expected + j * length, data + j * length, length, x, key1, key2);
+      }
+      if (aes_xts_encrypt_sectors(output, data, length, count, sector, &key) ||
+          memcmp(output, expected, count * length)) {
+        fprintf(stderr, "aes_xts_encrypt_sectors() failed for %d sectors of %d bytes\n", count, length);
+        return 1;
+      }
+      if (aes_xts_decrypt_sectors(output, output, length, count, sector, &key) ||
+          memcmp(output, data, count * length)) {
+        fprintf(stderr, "aes_xts_decrypt_sectors() failed for %d sectors of %d bytes\n", count, length);
+        return 1;
+      }
+    }
+  }
+
+  /* aes_decrypt_block undoes the encryption of the tweak */
+  aes_set_key(&key.key1, key2);
+  aes_encrypt(x, sector, key2);
+  aes_decrypt_block(x, x, &key.key1);
+  if (memcmp(x, sector, 16)) {
+    fputs("aes_decrypt_block() failed\n", stderr);
+    return 1;
+  }
+
+  return 0;
+}
@@ -12,7 +12,7 @@
 #include <string.h>
 
 /*
- * Tests the aes_encrypt function with the example values in
+ * Tests the aes_encrypt, aes_encrypt_block and aes_encrypt_keys functions with the example values in
  * [AES] Advanced Encryption Standard (AES), FIPS 197, Nov 26 2001.
  *       http://csrc.nist.gov/publications/fips/fips197/fips-197.pdf
  */
@@ -32,8 +32,9 @@ int main(int argc, char **argv) {
       {0x69,0xc4,0xe0,0xd8,0x6a,0x7b,0x04,0x30,0xd8,0xcd,0xb7,0x80,0x70,0xb4,0xc5,0x5a}
     }
   };
-  unsigned char ciphertext[16];
-  unsigned i;
+  struct aes_key key;
+  unsigned char ciphertext[16], keys[19 * 16], blocks[19 * 16];
+  unsigned i, j, n;
 
   for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
     aes_encrypt(ciphertext, vectors[i].plaintext, vectors[i].key);
@@ -41,6 +42,30 @@ int main(int argc, char **argv) {
       fprintf(stderr, "aes_encrypt() failed for test vector %u\n", i);
       return 1;
     }
+    aes_set_key(&key, vectors[i].key);
+    memcpy(ciphertext, vectors[i].plaintext, 16);
+    aes_encrypt_block(ciphertext, ciphertext, &key);
+    if (memcmp(ciphertext, vectors[i].ciphertext, 16)) {
+      fprintf(stderr, "aes_encrypt_block() failed for test vector %u\n", i);
+      return 1;
+    }
+  }
+
+  /* Blocks with a different key each, in place of the keys, in every lane */
+  for (n = 1; n <= 19; n++) {
+    for (j = 0; j < n; j++) {
+      i = (j * 7 + n) % 2;
+      memcpy(keys + j * 16, vectors[i].key, 16);
+      memcpy(blocks + j * 16, vectors[i].plaintext, 16);
+    }
+    aes_encrypt_keys(keys, blocks, keys, n);
+    for (j = 0; j < n; j++) {
+      i = (j * 7 + n) % 2;
+      if (memcmp(keys + j * 16, vectors[i].ciphertext, 16)) {
+        fprintf(stderr, "aes_encrypt_keys() failed for block %u of %u\n", j, n);
+        return 1;
+      }
+    }
   }
 
   return 0;
@@ -0,0 +1,384 @@
+/*
+ * tests/backends.c: differential tests of the accelerated code paths
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/tests/backends.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../aes.h"
+#include "../aes-decrypt.h"
+#include "../aes-gcm.h"
+#include "../base64.h"
+#include "../sha1.h"
+#include "../sha1-mb.h"
+#include "../sha256.h"
+#include "../sha256-mb.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Checks that the functions that dispatch to the accelerated implementations
+ * (AES-NI, SHA-NI, SSSE3, AVX2, NEON, multi-buffer), which are the ones
+ * available on the processor running the test, return the same results as
+ * the portable reference implementations, bit for bit, on random inputs:
+ * message lengths (with all the lengths up to MAX_LENGTH), buffer
+ * alignments, in-place operation, keys, AAD and tag lengths, split points
+ * of incremental hashing and of lists of fragments, and corrupted base 64
+ * characters.
+ *
+ * Each case is derived from an array of bytes: 32 bytes of parameters
+ * followed by the message. The cases come from a pseudorandom generator,
+ * or from libFuzzer when compiled with CRUMBS_FUZZ and -fsanitize=fuzzer:
+ * clang -g -O1 -fsanitize=fuzzer,address -DCRUMBS_FUZZ tests/backends.c
+ *
+ * Compiled with CRUMBS_GENERIC (as tests/run.sh also does), the portable
+ * code is checked against itself, for the consistency of the references.
+ */
+
+#define MAX_LENGTH 1100
+
+static unsigned char expected[MAX_LENGTH * 2], actual[MAX_LENGTH * 2], other[MAX_LENGTH * 2];
+static unsigned char scratch[MAX_LENGTH * 2];
+
+static int fail(const char *function, int length) {
+  fprintf(stderr, "%s() differs from the reference for length %d\n", function, length);
+  return -1;
+}
+
+/*
+ * Checks aes_encrypt_blocks, aes_encrypt_keys and aes_decrypt_blocks
+ * against aes_encrypt_generic and aes_decrypt_generic.
+ */
+static int check_aes(const unsigned char *m, int length, int offset, const unsigned char *key) {
+  struct aes_key expanded, k;
+  int i, n;
+
+  n = length / 16;
+  aes_set_key(&expanded, key);
+  for (i = 0; i < n; i++) {
+    aes_encrypt_generic(expected + i * 16, m + i * 16, &expanded);
+  }
+  aes_encrypt_blocks(actual + offset, m, n, &expanded);
+  if (memcmp(actual + offset, expected, n * 16)) {
+    return fail("aes_encrypt_blocks", length);
+  }
+  memcpy(actual + offset, m, n * 16);
+  aes_encrypt_blocks(actual + offset, actual + offset, n, &expanded);
+  if (memcmp(actual + offset, expected, n * 16)) {
+    return fail("aes_encrypt_blocks (in place)", length);
+  }
+
+  for (i = 0; i < n; i++) {
+    aes_decrypt_generic(other + i * 16, expected + i * 16, &expanded);
+  }
+  if (memcmp(other, m, n * 16)) {
+    return fail("aes_decrypt_generic", length);
+  }
+  aes_decrypt_blocks(actual + offset, expected, n, &expanded);
+  if (memcmp(actual + offset, m, n * 16)) {
+    return fail("aes_decrypt_blocks", length);
+  }
+  aes_decrypt_block(actual + offset, expected, &expanded);
+  if (n > 0 && memcmp(actual + offset, m, 16)) {
+    return fail("aes_decrypt_block", length);
+  }
+
+  /* Each message block with the previous ciphertext block as the key */
+  for (i = 0; i < n; i++) {
+    memcpy(scratch + i * 16, expected + (i + n - 1) % n * 16, 16);
+    aes_set_key(&k, scratch + i * 16);
+    aes_encrypt_generic(other + i * 16, m + i * 16, &k);
+  }
+  memcpy(actual + offset, m, n * 16);
+  aes_encrypt_keys(actual + offset, actual + offset, scratch, n);
+  if (memcmp(actual + offset, other, n * 16)) {
+    return fail("aes_encrypt_keys", length);
+  }
+  return 0;
+}
+
+/*
+ * Checks aes_gcm_mul against aes_gcm_mul_generic on the blocks of the message,
+ * aes_gcm_encrypt against the counter mode with aes_encrypt_generic,
+ * and aes_gcm_decrypt with the tag truncated to tag_length bytes, or altered.
+ */
+static int check_gcm(const unsigned char *m, int length, int offset, const unsigned char *key,
+    const unsigned char *iv, int aad_length, int tag_length, int flip) {
+  struct aes_key expanded;
+  unsigned char cb[16], y[16], tag[16];
+  int i, j;
+
+  for (i = 0; i + 32 <= length; i += 16) {
+    memcpy(y, m + i, 16);
+    memcpy(tag, m + i, 16);
+    aes_gcm_mul_generic(y, m + i + 16);
+    aes_gcm_mul(tag, m + i + 16);
+    if (memcmp(y, tag, 16)) {
+      return fail("aes_gcm_mul", length);
+    }
+  }
+
+  /* [GCM] 6.5 GCTR Function with CB1 = inc32(J0), J0 = IV || 0^31 || 1 */
+  aes_set_key(&expanded, key);
+  for (i = 0; i < length; i += 16) {
+    memcpy(cb, iv, 12);
+    cb[12] = (i / 16 + 2) >> 24;
+    cb[13] = (i / 16 + 2) >> 16;
+    cb[14] = (i / 16 + 2) >> 8;
+    cb[15] = (i / 16 + 2);
+    aes_encrypt_generic(y, cb, &expanded);
+    for (j = 0; j < 16 && i + j < length; j++) {
+      expected[i + j] = m[i + j] ^ y[j];
+    }
+  }
+  aes_gcm_encrypt(actual + offset, tag, iv, m, length, m, aad_length, key);
+  if (memcmp(actual + offset, expected, length)) {
+    return fail("aes_gcm_encrypt", length);
+  }
+  if (aes_gcm_decrypt(other + offset, iv, actual + offset, length, m, aad_length, tag, tag_length, key) ||
+      memcmp(other + offset, m, length)) {
+    return fail("aes_gcm_decrypt", length);
+  }
+  if (tag_length > 0) {
+    tag[flip % tag_length] ^= 1 << (flip & 7);
+    if (!aes_gcm_decrypt(other, iv, actual + offset, length, m, aad_length, tag, tag_length, key)) {
+      return fail("aes_gcm_decrypt (altered tag)", length);
+    }
+  }
+  return 0;
+}
+
+/*
+ * Checks sha1_compress and sha256_compress against the generic functions,
+ * the multi-buffer functions against the generic ones with idle lanes, and
+ * the incremental functions split at a point against the one-shot ones.
+ */
+static int check_sha(const unsigned char *m, int length, int split, int idle) {
+  struct sha1_context ctx1;
+  struct sha256_context ctx256;
+  unsigned h[8], g[8], h5[5][8], h8[8][8];
+  const void *blocks[8];
+  int i, l;
+
+  for (i = 0; i < 5; i++) {
+    h[i] = g[i] = 0x12345678 * (i + 1) + split;
+  }
+  sha1_compress_generic(h, m, length / 64);
+  sha1_compress(g, m, length / 64);
+  if (memcmp(h, g, sizeof(unsigned) * 5)) {
+    return fail("sha1_compress", length);
+  }
+  for (i = 0; i < 8; i++) {
+    h[i] = g[i] = 0x87654321 * (i + 1) + split;
+  }
+  sha256_compress_generic(h, m, length / 64);
+  sha256_compress(g, m, length / 64);
+  if (memcmp(h, g, sizeof(unsigned) * 8)) {
+    return fail("sha256_compress", length);
+  }
+
+  sha1(expected, m, length);
+  sha1_init(&ctx1);
+  sha1_update(&ctx1, m, split);
+  sha1_update(&ctx1, m + split, length - split);
+  sha1_final(&ctx1, actual);
+  if (memcmp(actual, expected, 20)) {
+    return fail("sha1_update", length);
+  }
+  sha256(expected, m, length);
+  sha256_init(&ctx256);
+  sha256_update(&ctx256, m, split);
+  sha256_update(&ctx256, m + split, length - split);
+  sha256_final(&ctx256, actual);
+  if (memcmp(actual, expected, 32)) {
+    return fail("sha256_update", length);
+  }
+
+  /* Lane l compresses the block at m + l * 8, unless bit l of idle is set */
+  if (length < 7 * 8 + 64) {
+    return 0;
+  }
+  for (l = 0; l < 8; l++) {
+    blocks[l] = (idle >> l & 1) ? NULL : m + l * 8;
+    for (i = 0; i < 8; i++) {
+      h8[i][l] = 0x9abcdef0 * (i + 1) + l;
+      if (i < 5) {
+        h5[i][l] = h8[i][l];
+      }
+    }
+  }
+  sha1_compress_x8(h5, blocks);
+  sha256_compress_x8(h8, blocks);
+  for (l = 0; l < 8; l++) {
+    for (i = 0; i < 8; i++) {
+      h[i] = g[i] = 0x9abcdef0 * (i + 1) + l;
+    }
+    if (blocks[l]) {
+      sha1_compress_generic(h, blocks[l], 1);
+      sha256_compress_generic(g, blocks[l], 1);
+    }
+    for (i = 0; i < 8; i++) {
+      if ((i < 5 && h5[i][l] != h[i]) || h8[i][l] != g[i]) {
+        return fail(i < 5 && h5[i][l] != h[i] ? "sha1_compress_x8" : "sha256_compress_x8", length);
+      }
+    }
+  }
+  return 0;
+}
+
+/*
+ * Checks base64_encode against the encoding of one 3-byte group at a time
+ * (which never reaches the SIMD code), and base64_decode on the encoded
+ * data with the character at position at replaced by c against the
+ * decoding of one 4-character group at a time.
+ */
+static int check_base64(const unsigned char *m, int length, int offset, int at, int c) {
+  int i, j, n, k, valid;
+
+  n = base64_encode(actual + offset, m, length);
+  for (i = 0, k = 0; i < length; i += 3) {
+    k += base64_encode(expected + k, m + i, length - i < 3 ? length - i : 3);
+  }
+  if (n != k || memcmp(actual + offset, expected, n)) {
+    return fail("base64_encode", length);
+  }
+  if (base64_decode(other + offset, actual + offset, n) != length || memcmp(other + offset, m, length)) {
+    return fail("base64_decode", length);
+  }
+  if (n == 0) {
+    return 0;
+  }
+
+  expected[at % n] = (unsigned char)c;
+  valid = 1;
+  for (i = 0, k = 0; i < n && valid; i += 4, k += j) {
+    j = base64_decode(other + k, expected + i, 4);
+    if (j < 0 || (i + 4 < n && j < 3)) {  /* or padding before the last group */
+      valid = 0;
+    }
+  }
+  memcpy(actual + offset, expected, n);
+  i = base64_decode(scratch + offset, actual + offset, n);
+  if ((i >= 0) != valid || (valid && (i != k || memcmp(scratch + offset, other, k)))) {
+    return fail("base64_decode (altered character)", length);
+  }
+  return 0;
+}
+
+/*
+ * Checks the functions on lists of fragments (aes_gcm_encrypt_v,
+ * aes_gcm_decrypt_v, sha1_v and sha256_v) against the contiguous ones,
+ * with the message split in 3 fragments at the points a and b, and the
+ * output at other points.
+ */
+static int check_v(const unsigned char *m, int length, int a, int b, const unsigned char *key, const unsigned char *iv) {
+  const void *in[3];
+  void *out[3];
+  int in_lengths[3], out_lengths[3];
+  unsigned char tag[16], tag_v[16];
+
+  if (a > b) {
+    return check_v(m, length, b, a, key, iv);
+  }
+  in[0] = m;
+  in[1] = m + a;
+  in[2] = m + b;
+  in_lengths[0] = a;
+  in_lengths[1] = b - a;
+  in_lengths[2] = length - b;
+  out[0] = actual;
+  out[1] = actual + (length - b);
+  out[2] = actual + (length - a);
+  out_lengths[0] = length - b;
+  out_lengths[1] = b - a;
+  out_lengths[2] = a;
+
+  sha1(expected, m, length);
+  sha1_v(actual, in, in_lengths, 3);
+  if (memcmp(actual, expected, 20)) {
+    return fail("sha1_v", length);
+  }
+  sha256(expected, m, length);
+  sha256_v(actual, in, in_lengths, 3);
+  if (memcmp(actual, expected, 32)) {
+    return fail("sha256_v", length);
+  }
+
+  aes_gcm_encrypt(expected, tag, iv, m, length, m, a, key);
+  aes_gcm_encrypt_v(out, out_lengths, tag_v, iv, in, in_lengths, 3, m, a, key);
+  if (memcmp(actual, expected, length) || memcmp(tag, tag_v, 16)) {
+    return fail("aes_gcm_encrypt_v", length);
+  }
+  in[0] = actual;
+  in[1] = actual + (length - b);
+  in[2] = actual + (length - a);
+  if (aes_gcm_decrypt_v(out, out_lengths, iv, in, out_lengths, 3, m, a, tag, 16, key) || memcmp(actual, m, length)) {
+    return fail("aes_gcm_decrypt_v (in place)", length);
+  }
+  return 0;
+}
+
+/*
+ * Checks all the functions with a case derived from size bytes of data.
+ * Returns 0 on success, or -1 (with a message) on the first difference.
+ */
+static int check(const unsigned char *data, int size) {
+  unsigned char p[32];
+  const unsigned char *m;
+  int i, length;
+
+  for (i = 0; i < 32; i++) {
+    p[i] = i < size ? data[i] : 0;
+  }
+  m = data + (size < 32 ? size : 32);
+  length = size < 32 ? 0 : size - 32;
+  if (length > MAX_LENGTH) {
+    length = MAX_LENGTH;
+  }
+
+  /* key: p[0..15], iv: p[16..27], offsets and other parameters: p[28..31] */
+  return check_aes(m, length, p[28] & 15, p) ||
+         check_gcm(m, length, p[29] & 15, p, p + 16, p[30] % (length + 1), p[31] % 17, p[28] | p[29] << 8) ||
+         check_sha(m, length, (p[28] | p[29] << 8) % (length + 1), p[30]) ||
+         check_base64(m, length, p[31] & 15, p[29] | p[30] << 8, p[31] & 1 ? '=' : p[28]) ||
+         check_v(m, length, (p[28] | p[30] << 8) % (length + 1), (p[29] | p[31] << 8) % (length + 1), p, p + 16) ? -1 : 0;
+}
+
+#ifdef CRUMBS_FUZZ
+/* libFuzzer entry point */
+#ifdef __cplusplus
+extern "C"
+#endif
+int LLVMFuzzerTestOneInput(const unsigned char *data, size_t size) {
+  if (check(data, size < 32 + MAX_LENGTH ? (int)size : 32 + MAX_LENGTH)) {
+    abort();
+  }
+  return 0;
+}
+#else
+/*
+ * Runs the checks with all the message lengths up to MAX_LENGTH bytes, then
+ * with random lengths, all with pseudorandom bytes from a fixed seed.
+ */
+int main(int argc, char **argv) {
+  static unsigned char data[32 + MAX_LENGTH];
+  unsigned long seed = 1;
+  int i, j, size;
+
+  for (i = 0; i < MAX_LENGTH + 400; i++) {
+    for (j = 0; j < 32 + MAX_LENGTH; j++) {
+      seed = (seed * 1103515245 + 12345) & 0xffffffff;
+      data[j] = (unsigned char)(seed >> 16);
+    }
+    size = i <= MAX_LENGTH ? 32 + i : (int)(32 + seed % (MAX_LENGTH + 1));
+    if (check(data, size)) {
+      fprintf(stderr, "case %d failed\n", i);
+      return 1;
+    }
+  }
+  return 0;
+}
+#endif
@@ -0,0 +1,154 @@
+/*
+ * tests/base64-stream.c: tests for ../base64-stream.h
+ *
+ * https://github.com/andrebdo/c-crumbs/tests/base64-stream.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../base64.h"
+#include "../base64-stream.h"
+#include <stdio.h>
+#include <string.h>
+
+static unsigned char input[5000], decoded[5000];
+static char encoded[7000], expected[7000];
+
+/*
+ * Encodes the input in chunks of varying sizes, starting with the given size.
+ * Returns the number of bytes of the encoded data.
+ */
+static int encode_chunks(int options, int length, int chunk) {
+  struct base64_context ctx;
+  int i, n;
+
+  base64_encode_init(&ctx, options);
+  for (i = 0, n = 0; i < length; i += chunk, chunk = chunk * 7 % 251 + 1) {
+    n += base64_encode_update(&ctx, encoded + n, input + i, i + chunk < length ? chunk : length - i);
+  }
+  return n + base64_encode_final(&ctx, encoded + n);
+}
+
+/*
+ * Decodes the encoded data in chunks of varying sizes, starting with the given size.
+ * Returns the number of bytes of the decoded data, or -1 on error.
+ */
+static int decode_chunks(int options, const char *data, int length, int chunk) {
+  struct base64_context ctx;
+  int i, k, n;
+
+  base64_decode_init(&ctx, options);
+  for (i = 0, n = 0; i < length; i += chunk, chunk = chunk * 7 % 251 + 1) {
+    k = base64_decode_update(&ctx, decoded + n, data + i, i + chunk < length ? chunk : length - i);
+    if (k < 0) {
+      return -1;
+    }
+    n += k;
+  }
+  k = base64_decode_final(&ctx, decoded + n);
+  return k < 0 ? -1 : n + k;
+}
+
+/*
+ * Tests the incremental base 64 functions against base64_encode and
+ * base64_decode, and with the example values in [RFC4648] 9, 10.
+ */
+int main(int argc, char **argv) {
+  const char *invalid[] = {
+    "Zg=", "Zm9vY", "Zg==Zg==", "Zg==\r\nZg", "Zm9v=", "Zh==", "Zm-v", "Zm\r\n9v",
+  };
+  int lengths[] = { 0, 1, 2, 3, 4, 56, 57, 58, 113, 114, 1000, 4999, 5000 };
+  int chunks[] = { 1, 2, 3, 5, 64, 5000 };
+  unsigned i, j, x;
+  int k, l, n, m;
+
+  for (x = 0; x < 256; x++) {
+    for (i = 0; i < 64 && base64url_alphabet[i] != x; i++) {
+    }
+    if (base64url_values[x] != (i < 64 ? i : 255)) {
+      fprintf(stderr, "base64url_values[%u] is wrong\n", x);
+      return 1;
+    }
+  }
+
+  for (i = 0, x = 1; i < sizeof(input); i++) {
+    x = x * 1103515245 + 12345;
+    input[i] = x >> 16;
+  }
+
+  for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+    l = lengths[i];
+    for (j = 0; j < sizeof(chunks) / sizeof(chunks[0]); j++) {
+      /* Standard encoding */
+      n = base64_encode(expected, input, l);
+      if (encode_chunks(0, l, chunks[j]) != n || memcmp(encoded, expected, n)) {
+        fprintf(stderr, "base64_encode_update() failed for length %d chunk %d\n", l, chunks[j]);
+        return 1;
+      }
+      if (decode_chunks(0, encoded, n, chunks[j]) != l || memcmp(decoded, input, l)) {
+        fprintf(stderr, "base64_decode_update() failed for length %d chunk %d\n", l, chunks[j]);
+        return 1;
+      }
+
+      /* base64url without padding: replace the characters and strip the padding */
+      for (k = 0; k < n; k++) {
+        expected[k] = expected[k] == '+' ? '-' : expected[k] == '/' ? '_' : expected[k];
+      }
+      while (n > 0 && expected[n - 1] == '=') {
+        n--;
+      }
+      if (encode_chunks(BASE64_URL | BASE64_NO_PADDING, l, chunks[j]) != n || memcmp(encoded, expected, n)) {
+        fprintf(stderr, "base64url encoding failed for length %d chunk %d\n", l, chunks[j]);
+        return 1;
+      }
+      if (decode_chunks(BASE64_URL | BASE64_NO_PADDING, encoded, n, chunks[j]) != l || memcmp(decoded, input, l)) {
+        fprintf(stderr, "base64url decoding failed for length %d chunk %d\n", l, chunks[j]);
+        return 1;
+      }
+
+      /* MIME: insert CRLF after each 76 characters except at the end */
+      n = base64_encode(encoded, input, l);
+      for (k = 0, m = 0; k < n; k++) {
+        if (k > 0 && k % 76 == 0) {
+          expected[m++] = '\r';
+          expected[m++] = '\n';
+        }
+        expected[m++] = encoded[k];
+      }
+      if (encode_chunks(BASE64_MIME, l, chunks[j]) != m || memcmp(encoded, expected, m)) {
+        fprintf(stderr, "MIME encoding failed for length %d chunk %d\n", l, chunks[j]);
+        return 1;
+      }
+      if (decode_chunks(BASE64_MIME, encoded, m, chunks[j]) != l || memcmp(decoded, input, l)) {
+        fprintf(stderr, "MIME decoding failed for length %d chunk %d\n", l, chunks[j]);
+        return 1;
+      }
+    }
+  }
+
+  /* [RFC4648] 9: the same bits in the URL alphabet, padded or not */
+  if (decode_chunks(BASE64_URL, "FPucA9l-", 8, 1) != 6 || memcmp(decoded, "\x14\xfb\x9c\x03\xd9\x7e", 6) ||
+      decode_chunks(BASE64_URL | BASE64_NO_PADDING, "FPucAw", 6, 5) != 4 || memcmp(decoded, "\x14\xfb\x9c\x03", 4) ||
+      decode_chunks(BASE64_URL, "FPucAw==", 8, 5) != 4 ||
+      decode_chunks(BASE64_URL, "FPucA9l+", 8, 3) != -1 ||
+      decode_chunks(BASE64_NO_PADDING, "FPucAw==", 8, 8) != -1 ||
+      decode_chunks(BASE64_NO_PADDING, "FPucA", 5, 8) != -1 ||
+      decode_chunks(BASE64_MIME, "Zm9v\r\nYmFy\r\n", 12, 1) != 6 || memcmp(decoded, "foobar", 6)) {
+    fprintf(stderr, "base64url/MIME decoding failed for the [RFC4648] examples\n");
+    return 1;
+  }
+
+  /* Invalid data must be rejected, wherever the chunks are split */
+  for (i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    for (j = 1; j < 5; j++) {
+      if (decode_chunks(0, invalid[i], strlen(invalid[i]), j) != -1 ||
+          (i < 3 && base64_decode(decoded, invalid[i], strlen(invalid[i])) != -1)) {
+        fprintf(stderr, "invalid data %u accepted with chunk %u\n", i, j);
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
@@ -12,8 +12,8 @@
 #include <string.h>
 
 /*
- * Tests the base64_encode function with the example values in
- * [RFC4648] The Base16, Base32, and Base64 Data Encodings.
+ * Tests the base64_encode and base64_decode functions with the example
+ * values in [RFC4648] The Base16, Base32, and Base64 Data Encodings.
  */
 int main(int argc, char **argv) {
   const struct { char input[7]; char output[9]; } vectors[] = {
@@ -30,8 +30,24 @@ int main(int argc, char **argv) {
     { "fooba", "Zm9vYmE=" },
     { "foobar", "Zm9vYmFy" },
   };
+  const char *invalid[] = {
+    "Zg=", "Zm9vY", "Zg===", "=Zm9", "Z===", "Zm=v", "Zm9v=g==",
+    "Zh==", "Zm9=", "Zm 9v", "Zm9v\n", "Zm-v", "Zm_v", "Zm9\xff",
+  };
   char output[sizeof(vectors[0].output)];
-  unsigned i;
+  static unsigned char input[1000], decoded[1000];
+  static char encoded[1336], expected[1336];
+  unsigned i, j, x;
+  int n;
+
+  for (x = 0; x < 256; x++) {
+    for (i = 0; i < 64 && base64_alphabet[i] != x; i++) {
+    }
+    if (base64_values[x] != (i < 64 ? i : 255)) {
+      fprintf(stderr, "base64_values[%u] is wrong\n", x);
+      return 1;
+    }
+  }
 
   for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
     unsigned n = base64_encode(output, vectors[i].input, strlen(vectors[i].input));
@@ -43,6 +59,63 @@ int main(int argc, char **argv) {
       fprintf(stderr, "base64_encode() output failed for test vector %u\n", i);
       return 1;
     }
+    if (base64_decode(output, vectors[i].output, n) != (int)strlen(vectors[i].input) ||
+        memcmp(output, vectors[i].input, strlen(vectors[i].input))) {
+      fprintf(stderr, "base64_decode() failed for test vector %u\n", i);
+      return 1;
+    }
+  }
+
+  for (i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    if (base64_decode(output, invalid[i], strlen(invalid[i])) != -1) {
+      fprintf(stderr, "base64_decode() accepted invalid input %u\n", i);
+      return 1;
+    }
+  }
+
+  /*
+   * Checks the SIMD paths, used for longer inputs, against the encoding
+   * of the same input one 3-byte group (or final partial group) at a time.
+   */
+  for (i = 0, x = 1; i < sizeof(input); i++) {
+    x = x * 1103515245 + 12345;
+    input[i] = x >> 16;
+  }
+  for (i = 0; i <= sizeof(input); i = i < 200 ? i + 1 : i + 37) {
+    for (j = 0; j < i; j += 3) {
+      base64_encode(expected + j / 3 * 4, input + j, i - j < 3 ? i - j : 3);
+    }
+    if (base64_encode(encoded, input, i) != (int)(i + 2) / 3 * 4) {
+      fprintf(stderr, "base64_encode() return value failed for length %u\n", i);
+      return 1;
+    }
+    if (memcmp(encoded, expected, (i + 2) / 3 * 4)) {
+      fprintf(stderr, "base64_encode() output failed for length %u\n", i);
+      return 1;
+    }
+    n = base64_decode(decoded, encoded, (i + 2) / 3 * 4);
+    if (n != (int)i || memcmp(decoded, input, i)) {
+      fprintf(stderr, "base64_decode() failed for length %u\n", i);
+      return 1;
+    }
+  }
+
+  /* An invalid character anywhere must be detected, also by the SIMD paths */
+  n = base64_encode(encoded, input, sizeof(input));
+  for (i = 0; i < (unsigned)n; i += 7) {
+    for (j = 0; j < 4; j++) {
+      x = encoded[i];
+      encoded[i] = "=.-\x80"[j];
+      if (base64_decode(decoded, encoded, n) != -1) {
+        fprintf(stderr, "base64_decode() accepted invalid character at %u\n", i);
+        return 1;
+      }
+      encoded[i] = x;
+    }
+  }
+  if (base64_decode(decoded, encoded, n) != (int)sizeof(input)) {
+    fprintf(stderr, "base64_decode() failed after invalid characters\n");
+    return 1;
   }
 
   return 0;
@@ -0,0 +1,121 @@
+/*
+ * tests/git-object.c: tests for ../git-object.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/tests/git-object.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../sha1.h"
+#include "../sha1-mb.h"
+#include "../sha256.h"
+#include "../sha256-mb.h"
+#include "../git-object.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Tests the git_object_* functions with the IDs computed by
+ * git hash-object (with --object-format=sha1 and sha256),
+ * against sha1/sha256 on the concatenated header and data,
+ * and the git_object_*_many functions against git_object_sha1/sha256.
+ */
+int main(int argc, char **argv) {
+  const struct {
+    const char *data;
+    unsigned char sha1[20];
+    unsigned char sha256[32];
+  } vectors[] = {
+    { /* git hash-object /dev/null */
+      "",
+      {0xe6,0x9d,0xe2,0x9b,0xb2,0xd1,0xd6,0x43,0x4b,0x8b,0x29,0xae,0x77,0x5a,0xd8,0xc2,
+       0xe4,0x8c,0x53,0x91},
+      {0x47,0x3a,0x0f,0x4c,0x3b,0xe8,0xa9,0x36,0x81,0xa2,0x67,0xe3,0xb1,0xe9,0xa7,0xdc,
+       0xda,0x11,0x85,0x43,0x6f,0xe1,0x41,0xf7,0x74,0x91,0x20,0xa3,0x03,0x72,0x18,0x13}
+    },{ /* echo 'hello world' | git hash-object --stdin */
+      "hello world\n",
+      {0x3b,0x18,0xe5,0x12,0xdb,0xa7,0x9e,0x4c,0x83,0x00,0xdd,0x08,0xae,0xb3,0x7f,0x8e,
+       0x72,0x8b,0x8d,0xad},
+      {0x0b,0xd6,0x90,0x98,0xbd,0x9b,0x9c,0xc5,0x93,0x4a,0x61,0x0a,0xb6,0x5d,0xa4,0x29,
+       0xb5,0x25,0x36,0x11,0x47,0xfa,0xa7,0xb5,0xb9,0x22,0x91,0x9e,0x9a,0x23,0x14,0x3d}
+    }
+  };
+  static unsigned char data[100000];
+  static struct git_object objects[300];
+  static unsigned char ids[300 * 32];
+  unsigned char id[32];
+  unsigned i;
+
+  for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+    git_object_sha1(id, "blob", vectors[i].data, strlen(vectors[i].data));
+    if (memcmp(id, vectors[i].sha1, 20)) {
+      fprintf(stderr, "git_object_sha1() failed for test vector %u\n", i);
+      return 1;
+    }
+    git_object_sha256(id, "blob", vectors[i].data, strlen(vectors[i].data));
+    if (memcmp(id, vectors[i].sha256, 32)) {
+      fprintf(stderr, "git_object_sha256() failed for test vector %u\n", i);
+      return 1;
+    }
+  }
+
+  /* The same IDs as hashing the concatenated header and data */
+  {
+    static char object[64 + sizeof(data)];
+    unsigned char digest[32];
+    int n;
+
+    for (i = 0; i < sizeof(data); i++) {
+      data[i] = i * 31 + (i >> 8);
+    }
+    for (i = 0; i < sizeof(data); i = i * 3 + 1) {
+      n = sprintf(object, "commit %u", i) + 1;
+      memcpy(object + n, data, i);
+      sha1(digest, object, n + i);
+      git_object_sha1(id, "commit", data, i);
+      if (memcmp(id, digest, 20)) {
+        fprintf(stderr, "git_object_sha1() failed for length %u\n", i);
+        return 1;
+      }
+      sha256(digest, object, n + i);
+      git_object_sha256(id, "commit", data, i);
+      if (memcmp(id, digest, 32)) {
+        fprintf(stderr, "git_object_sha256() failed for length %u\n", i);
+        return 1;
+      }
+    }
+  }
+
+  /* Objects of many sizes, with a few large ones among them */
+  for (i = 0; i < sizeof(objects) / sizeof(objects[0]); i++) {
+    objects[i].type = i % 3 ? "blob" : "tree";
+    objects[i].data = data + i * 7;
+    objects[i].length = i % 50 == 7 ? 90000 : (i * 97) % 1500;
+  }
+
+  for (i = 0; i <= sizeof(objects) / sizeof(objects[0]); i += 100) {
+    unsigned count = i ? i : 1;
+    unsigned j;
+
+    git_object_sha1_many(ids, objects, count);
+    for (j = 0; j < count; j++) {
+      git_object_sha1(id, objects[j].type, objects[j].data, objects[j].length);
+      if (memcmp(id, ids + j * 20, 20)) {
+        fprintf(stderr, "git_object_sha1_many() failed for object %u of %u\n", j, count);
+        return 1;
+      }
+    }
+
+    git_object_sha256_many(ids, objects, count);
+    for (j = 0; j < count; j++) {
+      git_object_sha256(id, objects[j].type, objects[j].data, objects[j].length);
+      if (memcmp(id, ids + j * 32, 32)) {
+        fprintf(stderr, "git_object_sha256_many() failed for object %u of %u\n", j, count);
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
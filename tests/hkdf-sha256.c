@@ -0,0 +1,87 @@
+/*
+ * tests/hkdf-sha256.c: tests for ../hkdf-sha256.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/tests/hkdf-sha256.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../sha256.h"
+#include "../hmac-sha256.h"
+#include "../hkdf-sha256.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Tests the hkdf_sha256 functions with the test vectors in
+ * [RFC5869] HMAC-based Extract-and-Expand Key Derivation Function (HKDF),
+ *           Appendix A. Test Vectors.
+ */
+int main(int argc, char **argv) {
+  const unsigned char ikm[22] = {
+    0x0b,0x0b,0x0b,0x0b,0x0b,0x0b,0x0b,0x0b,0x0b,0x0b,0x0b,0x0b,0x0b,0x0b,0x0b,0x0b,
+    0x0b,0x0b,0x0b,0x0b,0x0b,0x0b
+  };
+  const unsigned char salt[13] = {
+    0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c
+  };
+  const unsigned char info[10] = {
+    0xf0,0xf1,0xf2,0xf3,0xf4,0xf5,0xf6,0xf7,0xf8,0xf9
+  };
+  const struct {
+    int salt_length;
+    int info_length;
+    unsigned char prk[32];
+    unsigned char okm[42];
+  } vectors[] = {
+    { /* A.1. Test Case 1 */
+      13, 10,
+      {
+       0x07,0x77,0x09,0x36,0x2c,0x2e,0x32,0xdf,0x0d,0xdc,0x3f,0x0d,0xc4,0x7b,0xba,0x63,
+       0x90,0xb6,0xc7,0x3b,0xb5,0x0f,0x9c,0x31,0x22,0xec,0x84,0x4a,0xd7,0xc2,0xb3,0xe5
+      },{
+       0x3c,0xb2,0x5f,0x25,0xfa,0xac,0xd5,0x7a,0x90,0x43,0x4f,0x64,0xd0,0x36,0x2f,0x2a,
+       0x2d,0x2d,0x0a,0x90,0xcf,0x1a,0x5a,0x4c,0x5d,0xb0,0x2d,0x56,0xec,0xc4,0xc5,0xbf,
+       0x34,0x00,0x72,0x08,0xd5,0xb8,0x87,0x18,0x58,0x65
+      }
+    },{ /* A.3. Test Case 3 */
+      0, 0,
+      {
+       0x19,0xef,0x24,0xa3,0x2c,0x71,0x7b,0x16,0x7f,0x33,0xa9,0x1d,0x6f,0x64,0x8b,0xdf,
+       0x96,0x59,0x67,0x76,0xaf,0xdb,0x63,0x77,0xac,0x43,0x4c,0x1c,0x29,0x3c,0xcb,0x04
+      },{
+       0x8d,0xa4,0xe7,0x75,0xa5,0x63,0xc1,0x8f,0x71,0x5f,0x80,0x2a,0x06,0x3c,0x5a,0x31,
+       0xb8,0xa1,0x1f,0x5c,0x5e,0xe1,0x87,0x9e,0xc3,0x45,0x4e,0x5f,0x3c,0x73,0x8d,0x2d,
+       0x9d,0x20,0x13,0x95,0xfa,0xa4,0xb6,0x1a,0x96,0xc8
+      }
+    }
+  };
+  struct hmac_sha256_key key;
+  unsigned char prk[32];
+  unsigned char okm[42];
+  unsigned i;
+
+  for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+    hkdf_sha256_extract(prk, salt, vectors[i].salt_length, ikm, sizeof(ikm));
+    if (memcmp(prk, vectors[i].prk, 32)) {
+      fprintf(stderr, "hkdf_sha256_extract() failed for test vector %u\n", i);
+      return 1;
+    }
+
+    hmac_sha256_set_key(&key, prk, 32);
+    hkdf_sha256_expand(okm, sizeof(okm), &key, info, vectors[i].info_length);
+    if (memcmp(okm, vectors[i].okm, sizeof(okm))) {
+      fprintf(stderr, "hkdf_sha256_expand() failed for test vector %u\n", i);
+      return 1;
+    }
+
+    hkdf_sha256(okm, sizeof(okm), salt, vectors[i].salt_length, ikm, sizeof(ikm), info, vectors[i].info_length);
+    if (memcmp(okm, vectors[i].okm, sizeof(okm))) {
+      fprintf(stderr, "hkdf_sha256() failed for test vector %u\n", i);
+      return 1;
+    }
+  }
+
+  return 0;
+}
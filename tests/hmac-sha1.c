@@ -0,0 +1,73 @@
+/*
+ * tests/hmac-sha1.c: tests for ../hmac-sha1.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/tests/hmac-sha1.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../sha1.h"
+#include "../hmac-sha1.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Tests the hmac_sha1 functions with the test vectors in
+ * [RFC2202] Test Cases for HMAC-MD5 and HMAC-SHA-1, section 3.
+ */
+int main(int argc, char **argv) {
+  static unsigned char long_key[80];  /* 80 bytes of 0xaa */
+  const struct {
+    const void *key;
+    int key_length;
+    const char *data;
+    unsigned char mac[20];
+  } vectors[] = {
+    { /* test_case = 1 */
+      "\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b", 20,
+      "Hi There",
+      {0xb6,0x17,0x31,0x86,0x55,0x05,0x72,0x64,0xe2,0x8b,0xc0,0xb6,0xfb,0x37,0x8c,0x8e,
+       0xf1,0x46,0xbe,0x00}
+    },{ /* test_case = 2 */
+      "Jefe", 4,
+      "what do ya want for nothing?",
+      {0xef,0xfc,0xdf,0x6a,0xe5,0xeb,0x2f,0xa2,0xd2,0x74,0x16,0xd5,0xf1,0x84,0xdf,0x9c,
+       0x25,0x9a,0x7c,0x79}
+    },{ /* test_case = 6 */
+      long_key, sizeof(long_key),
+      "Test Using Larger Than Block-Size Key - Hash Key First",
+      {0xaa,0x4a,0xe5,0xe1,0x52,0x72,0xd0,0x0e,0x95,0x70,0x56,0x37,0xce,0x8a,0x3b,0x55,
+       0xed,0x40,0x21,0x12}
+    }
+  };
+  struct hmac_sha1_key key;
+  struct hmac_sha1_context ctx;
+  unsigned char mac[20];
+  unsigned i, j;
+
+  memset(long_key, 0xaa, sizeof(long_key));
+
+  for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+    hmac_sha1_set_key(&key, vectors[i].key, vectors[i].key_length);
+
+    hmac_sha1(mac, &key, vectors[i].data, strlen(vectors[i].data));
+    if (memcmp(mac, vectors[i].mac, 20)) {
+      fprintf(stderr, "hmac_sha1() failed for test vector %u\n", i);
+      return 1;
+    }
+
+    /* The prepared key can be reused, and the message split anywhere */
+    hmac_sha1_init(&ctx, &key);
+    for (j = 0; j < strlen(vectors[i].data); j++) {
+      hmac_sha1_update(&ctx, vectors[i].data + j, 1);
+    }
+    hmac_sha1_final(&ctx, mac);
+    if (memcmp(mac, vectors[i].mac, 20)) {
+      fprintf(stderr, "hmac_sha1_update() failed for test vector %u\n", i);
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,74 @@
+/*
+ * tests/hmac-sha256.c: tests for ../hmac-sha256.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/tests/hmac-sha256.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../sha256.h"
+#include "../hmac-sha256.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Tests the hmac_sha256 functions with the test vectors in
+ * [RFC4231] Identifiers and Test Vectors for HMAC-SHA-224, HMAC-SHA-256,
+ *           HMAC-SHA-384, and HMAC-SHA-512, section 4. Test Vectors.
+ */
+int main(int argc, char **argv) {
+  static unsigned char long_key[131];  /* 131 bytes of 0xaa */
+  const struct {
+    const void *key;
+    int key_length;
+    const char *data;
+    unsigned char mac[32];
+  } vectors[] = {
+    { /* 4.2. Test Case 1 */
+      "\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b", 20,
+      "Hi There",
+      {0xb0,0x34,0x4c,0x61,0xd8,0xdb,0x38,0x53,0x5c,0xa8,0xaf,0xce,0xaf,0x0b,0xf1,0x2b,
+       0x88,0x1d,0xc2,0x00,0xc9,0x83,0x3d,0xa7,0x26,0xe9,0x37,0x6c,0x2e,0x32,0xcf,0xf7}
+    },{ /* 4.3. Test Case 2 */
+      "Jefe", 4,
+      "what do ya want for nothing?",
+      {0x5b,0xdc,0xc1,0x46,0xbf,0x60,0x75,0x4e,0x6a,0x04,0x24,0x26,0x08,0x95,0x75,0xc7,
+       0x5a,0x00,0x3f,0x08,0x9d,0x27,0x39,0x83,0x9d,0xec,0x58,0xb9,0x64,0xec,0x38,0x43}
+    },{ /* 4.7. Test Case 6 */
+      long_key, sizeof(long_key),
+      "Test Using Larger Than Block-Size Key - Hash Key First",
+      {0x60,0xe4,0x31,0x59,0x1e,0xe0,0xb6,0x7f,0x0d,0x8a,0x26,0xaa,0xcb,0xf5,0xb7,0x7f,
+       0x8e,0x0b,0xc6,0x21,0x37,0x28,0xc5,0x14,0x05,0x46,0x04,0x0f,0x0e,0xe3,0x7f,0x54}
+    }
+  };
+  struct hmac_sha256_key key;
+  struct hmac_sha256_context ctx;
+  unsigned char mac[32];
+  unsigned i, j;
+
+  memset(long_key, 0xaa, sizeof(long_key));
+
+  for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+    hmac_sha256_set_key(&key, vectors[i].key, vectors[i].key_length);
+
+    hmac_sha256(mac, &key, vectors[i].data, strlen(vectors[i].data));
+    if (memcmp(mac, vectors[i].mac, 32)) {
+      fprintf(stderr, "hmac_sha256() failed for test vector %u\n", i);
+      return 1;
+    }
+
+    /* The prepared key can be reused, and the message split anywhere */
+    hmac_sha256_init(&ctx, &key);
+    for (j = 0; j < strlen(vectors[i].data); j++) {
+      hmac_sha256_update(&ctx, vectors[i].data + j, 1);
+    }
+    hmac_sha256_final(&ctx, mac);
+    if (memcmp(mac, vectors[i].mac, 32)) {
+      fprintf(stderr, "hmac_sha256_update() failed for test vector %u\n", i);
+      return 1;
+    }
+  }
+
+  return 0;
+}
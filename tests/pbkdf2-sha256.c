@@ -0,0 +1,100 @@
+/*
+ * tests/pbkdf2-sha256.c: tests for ../pbkdf2-sha256.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/tests/pbkdf2-sha256.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../sha256.h"
+#include "../sha256-mb.h"
+#include "../hmac-sha256.h"
+#include "../pbkdf2-sha256.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Tests the pbkdf2_sha256 function with the test vectors in
+ * [RFC7914] The scrypt Password-Based Key Derivation Function,
+ *           section 11. Test Vectors for PBKDF2 with HMAC-SHA-256,
+ * and a 300-byte derived key (10 blocks, 8 of them in parallel lanes)
+ * computed with Python's hashlib.pbkdf2_hmac.
+ */
+int main(int argc, char **argv) {
+  const struct {
+    const char *password;
+    const char *salt;
+    int iterations;
+    int dk_length;
+    unsigned char dk[300];
+  } vectors[] = {
+    { /* [RFC7914] 11. first vector */
+      "passwd", "salt", 1, 64,
+      {
+       0x55,0xac,0x04,0x6e,0x56,0xe3,0x08,0x9f,0xec,0x16,0x91,0xc2,0x25,0x44,0xb6,0x05,
+       0xf9,0x41,0x85,0x21,0x6d,0xde,0x04,0x65,0xe6,0x8b,0x9d,0x57,0xc2,0x0d,0xac,0xbc,
+       0x49,0xca,0x9c,0xcc,0xf1,0x79,0xb6,0x45,0x99,0x16,0x64,0xb3,0x9d,0x77,0xef,0x31,
+       0x7c,0x71,0xb8,0x45,0xb1,0xe3,0x0b,0xd5,0x09,0x11,0x20,0x41,0xd3,0xa1,0x97,0x83
+      }
+    },{ /* [RFC7914] 11. second vector */
+      "Password", "NaCl", 80000, 64,
+      {
+       0x4d,0xdc,0xd8,0xf6,0x0b,0x98,0xbe,0x21,0x83,0x0c,0xee,0x5e,0xf2,0x27,0x01,0xf9,
+       0x64,0x1a,0x44,0x18,0xd0,0x4c,0x04,0x14,0xae,0xff,0x08,0x87,0x6b,0x34,0xab,0x56,
+       0xa1,0xd4,0x25,0xa1,0x22,0x58,0x33,0x54,0x9a,0xdb,0x84,0x1b,0x51,0xc9,0xb3,0x17,
+       0x6a,0x27,0x2b,0xde,0xbb,0xa1,0xd0,0x78,0x47,0x8f,0x62,0xb3,0x97,0xf3,0x3c,0x8d
+      }
+    },{ /* hashlib.pbkdf2_hmac('sha256', b'password', b'saltSALT...', 1000, 300) */
+      "password", "saltSALTsaltSALTsaltSALTsaltSALTsalt", 1000, 300,
+      {
+       0x0a,0x2e,0x06,0xd0,0x8b,0xd6,0x47,0x75,0x70,0x5e,0x19,0x7f,0x3c,0x99,0x3a,0x0a,
+       0xc9,0x53,0x29,0x8c,0xc9,0x10,0x6b,0x19,0x4f,0x46,0x5c,0x26,0xeb,0x8b,0x57,0x09,
+       0x05,0x7f,0x07,0x6f,0x31,0x0b,0x14,0xe9,0x34,0x9e,0xc0,0x8f,0xa7,0x21,0x6f,0xfc,
+       0x26,0xb3,0x60,0x1f,0xd1,0x1c,0x08,0x3c,0x8c,0xda,0x54,0x44,0x57,0x5c,0x1c,0xa3,
+       0x85,0x1f,0x21,0x48,0x08,0xa1,0x51,0x19,0xb5,0xda,0xa9,0x4f,0xa3,0xe6,0x57,0x31,
+       0x9e,0x20,0xd2,0xf9,0xd9,0x76,0x95,0xdf,0xda,0x62,0x1c,0xce,0xe5,0x8e,0x3a,0xa0,
+       0x51,0x07,0xb3,0x5d,0x03,0x04,0x31,0x82,0x7b,0x4a,0x5c,0x70,0xf6,0xfa,0x4d,0x6d,
+       0xfa,0x7b,0xb3,0xc0,0xfe,0x05,0xbd,0xf7,0xd7,0xe2,0xfb,0xc1,0xd3,0x91,0x39,0xbb,
+       0xf1,0xd3,0xe1,0x24,0x99,0x18,0x37,0x5b,0x37,0x89,0x19,0xb7,0x85,0x0a,0x84,0xfc,
+       0x20,0xdd,0xef,0xe8,0x3a,0x02,0x51,0x8d,0xa9,0xa1,0x78,0x21,0x5f,0xfe,0xf5,0xda,
+       0xf9,0x08,0x41,0x81,0x60,0xf8,0xc0,0x28,0x9f,0xb1,0x41,0xcf,0x58,0xba,0x9d,0x57,
+       0xc1,0xc9,0x9d,0x55,0x08,0xad,0xa4,0x7c,0xd7,0x38,0x94,0xc9,0xb5,0xb7,0x2b,0x22,
+       0x9e,0x1f,0x1e,0x75,0x31,0x4b,0x83,0x0f,0x13,0xe9,0x6f,0x24,0x1e,0x03,0x2b,0x17,
+       0xa5,0xb2,0xee,0x7e,0x8b,0x41,0xed,0x13,0x2f,0x76,0xc5,0xd5,0x05,0x38,0x9a,0x92,
+       0xa7,0x8e,0x46,0xd1,0x16,0x2b,0x00,0x8e,0x9a,0x90,0x20,0x48,0x53,0xc8,0x71,0x90,
+       0xc8,0x29,0x2d,0xff,0x77,0x95,0x21,0xbe,0xa8,0x9e,0x0b,0xbf,0xf0,0x6e,0xe9,0x7e,
+       0xd3,0x7d,0xd2,0xf9,0xaf,0x6d,0x86,0x4e,0x0c,0x76,0xfe,0xd6,0xfa,0xfd,0x28,0x55,
+       0x59,0x78,0xcb,0x41,0x8f,0x96,0x0f,0x1a,0x55,0xf5,0xda,0x77,0x1c,0x4b,0x51,0x78,
+       0x7f,0xc3,0xdb,0xdb,0x6b,0xe6,0xc1,0x72,0x56,0x5e,0x07,0x37
+      }
+    }
+  };
+  unsigned char dk[300];
+  unsigned i;
+
+  for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+    pbkdf2_sha256(dk, vectors[i].dk_length, vectors[i].password, strlen(vectors[i].password),
+                  vectors[i].salt, strlen(vectors[i].salt), vectors[i].iterations);
+    if (memcmp(dk, vectors[i].dk, vectors[i].dk_length)) {
+      fprintf(stderr, "pbkdf2_sha256() failed for test vector %u\n", i);
+      return 1;
+    }
+  }
+
+  /* With a single iteration, the first block is HMAC(P, S || INT(1)) */
+  {
+    struct hmac_sha256_key key;
+    unsigned char mac[32];
+
+    hmac_sha256_set_key(&key, "passwd", 6);
+    hmac_sha256(mac, &key, "salt\0\0\0\1", 8);
+    pbkdf2_sha256(dk, 32, "passwd", 6, "salt", 4, 1);
+    if (memcmp(dk, mac, 32)) {
+      fputs("pbkdf2_sha256() failed for a single iteration\n", stderr);
+      return 1;
+    }
+  }
+
+  return 0;
+}
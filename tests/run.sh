@@ -3,6 +3,10 @@ set -e
 for c in $*; do
 	gcc -Wall -Werror -ansi -pedantic -O2 $c
 	./a.out
+	CRUMBS_CPU=0 ./a.out
+	CRUMBS_CPU=0x0f ./a.out
+	gcc -Wall -Werror -ansi -pedantic -O2 -DCRUMBS_GENERIC $c
+	./a.out
 	g++ -Wall -Werror -O2 $c
 	./a.out
 done
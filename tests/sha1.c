@@ -12,7 +12,7 @@
 #include <string.h>
 
 /*
- * Tests the sha1 function with the SHA-1 values in
+ * Tests the sha1 functions with the SHA-1 values in
  * http://csrc.nist.gov/groups/ST/toolkit/documents/Examples/SHA_All.pdf
  */
 int main(int argc, char **argv) {
@@ -41,5 +41,63 @@ int main(int argc, char **argv) {
     }
   }
 
+  /* Incremental computation, one byte at a time */
+  for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+    struct sha1_context ctx;
+    unsigned j;
+
+    sha1_init(&ctx);
+    for (j = 0; j < strlen(vectors[i].message); j++) {
+      sha1_update(&ctx, vectors[i].message + j, 1);
+    }
+    sha1_final(&ctx, x);
+    if (memcmp(x, vectors[i].digest, sizeof(vectors[i].digest))) {
+      fprintf(stderr, "sha1_update() failed for test vector %u\n", i);
+      return 1;
+    }
+  }
+
+  /* Incremental computation of one million 'a' in chunks of varying size */
+  {
+    const unsigned char digest[20] = {
+      0x34,0xaa,0x97,0x3c, 0xd4,0xc4,0xda,0xa4, 0xf6,0x1e,0xeb,0x2b,
+      0xdb,0xad,0x27,0x31, 0x65,0x34,0x01,0x6f
+    };
+    struct sha1_context ctx;
+    char a[1000];
+    int n, total;
+
+    memset(a, 'a', sizeof(a));
+    sha1_init(&ctx);
+    for (total = 0, n = 1; total < 1000000; total += n, n = n % 991 + 7) {
+      if (n > 1000000 - total) {
+        n = 1000000 - total;
+      }
+      sha1_update(&ctx, a, n);
+    }
+    sha1_final(&ctx, x);
+    if (memcmp(x, digest, sizeof(digest))) {
+      fputs("sha1_update() failed for one million 'a'\n", stderr);
+      return 1;
+    }
+  }
+
+  /* The portable compression function must match the dispatched one */
+  {
+    unsigned h1[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+    unsigned h2[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+    unsigned char blocks[256];
+
+    for (i = 0; i < sizeof(blocks); i++) {
+      blocks[i] = i * 7 + 1;
+    }
+    sha1_compress(h1, blocks, 4);
+    sha1_compress_generic(h2, blocks, 4);
+    if (memcmp(h1, h2, sizeof(h1))) {
+      fputs("sha1_compress_generic() failed\n", stderr);
+      return 1;
+    }
+  }
+
   return 0;
 }
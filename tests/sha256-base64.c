@@ -0,0 +1,62 @@
+/*
+ * tests/sha256-base64.c: tests for ../sha256-base64.h
+ *
+ * https://github.com/andrebdo/c-crumbs/tests/sha256-base64.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../sha256.h"
+#include "../base64.h"
+#include "../sha256-base64.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Tests the sha256_*_final functions with a known digest header value
+ * of a JSON message, and with other messages compared with
+ * base64_encode of the sha256 digest.
+ */
+int main(int argc, char **argv) {
+  const char *messages[] = { "{\"hello\": \"world\"}", "", "hello world" };
+  struct sha256_context ctx;
+  unsigned char digest[32], decoded[33];
+  char output[53], expected[45];
+  unsigned i, j;
+
+  sha256_init(&ctx);
+  sha256_update(&ctx, "{\"hello\": ", 10);
+  sha256_update(&ctx, "\"world\"}", 8);
+  output[52] = 0;
+  if (sha256_digest_final(&ctx, output) != 52 ||
+      strcmp(output, "sha-256=X48E9qOokqqrvdts8nOJRJN3OWDUoyWxBf7kbu9DBPE=")) {
+    fprintf(stderr, "sha256_digest_final() failed for the JSON message\n");
+    return 1;
+  }
+
+  for (i = 0; i < sizeof(messages) / sizeof(messages[0]); i++) {
+    sha256(digest, messages[i], strlen(messages[i]));
+    base64_encode(expected, digest, 32);
+
+    sha256_init(&ctx);
+    for (j = 0; j < strlen(messages[i]); j++) {
+      sha256_update(&ctx, messages[i] + j, 1);
+    }
+    if (sha256_base64_final(&ctx, output) != 44 || memcmp(output, expected, 44) ||
+        base64_decode(decoded, output, 44) != 32 || memcmp(decoded, digest, 32)) {
+      fprintf(stderr, "sha256_base64_final() failed for message %u\n", i);
+      return 1;
+    }
+
+    sha256_init(&ctx);
+    sha256_update(&ctx, messages[i], strlen(messages[i]));
+    if (sha256_etag_final(&ctx, output) != 46 || output[0] != '"' || output[45] != '"' ||
+        memcmp(output + 1, expected, 44)) {
+      fprintf(stderr, "sha256_etag_final() failed for message %u\n", i);
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * tests/sha256-midstate.c: tests for ../sha256-midstate.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/tests/sha256-midstate.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../sha256.h"
+#include "../sha256-midstate.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Tests sha256_32 and sha256_64 with a double SHA-256 checked with the
+ * OpenSSL command-line tool and against sha256, and the midstates against
+ * sha256 of the whole messages.
+ */
+int main(int argc, char **argv) {
+  /* SHA-256(SHA-256("abc")) */
+  const unsigned char abc2[32] = {
+    0x4f,0x8b,0x42,0xc2,0x2d,0xd3,0x72,0x9b,0x51,0x9b,0xa6,0xf6,0x8d,0x2d,0xa7,0xcc,
+    0x5b,0x2d,0x60,0x6d,0x05,0xda,0xed,0x5a,0xd5,0x12,0x8c,0xc0,0x3e,0x6c,0x63,0x58
+  };
+  static unsigned char data[1000];
+  unsigned char x[64], y[32];
+  unsigned h[8], g[8];
+  struct sha256_context ctx;
+  int i, n, blocks;
+
+  for (i = 0; i < 1000; i++) {
+    data[i] = (unsigned char)(i * 7 + 3);
+  }
+
+  /* Double SHA-256, in place */
+  sha256(x, "abc", 3);
+  sha256_32(x, x);
+  if (memcmp(x, abc2, 32)) {
+    fputs("sha256_32() failed for double SHA-256\n", stderr);
+    return 1;
+  }
+
+  /* 32 and 64-byte messages at all the offsets, against sha256 */
+  for (i = 0; i < 1000 - 64; i += 13) {
+    sha256(y, data + i, 32);
+    sha256_32(x, data + i);
+    if (memcmp(x, y, 32)) {
+      fprintf(stderr, "sha256_32() failed at offset %d\n", i);
+      return 1;
+    }
+    sha256(y, data + i, 64);
+    memcpy(x, data + i, 64);
+    sha256_64(x, x);
+    if (memcmp(x, y, 32)) {
+      fprintf(stderr, "sha256_64() failed at offset %d\n", i);
+      return 1;
+    }
+  }
+
+  /* The rounds with a precomputed message schedule */
+  for (i = 0; i < 8; i++) {
+    h[i] = g[i] = 0x9abcdef0 * (unsigned)(i + 1);
+  }
+  sha256_rounds(h, sha256_pad64_wk);
+  sha256_rounds_generic(g, sha256_pad64_wk);
+  if (memcmp(h, g, sizeof(h))) {
+    fputs("sha256_rounds() differs from sha256_rounds_generic()\n", stderr);
+    return 1;
+  }
+
+  /* Prefixes of 0 to 3 blocks, then suffixes of 0 to 200 bytes */
+  for (blocks = 0; blocks <= 3; blocks++) {
+    sha256_init(&ctx);
+    sha256_update(&ctx, data, blocks * 64);
+    if (sha256_midstate(&ctx, h) != blocks) {
+      fprintf(stderr, "sha256_midstate() failed after %d blocks\n", blocks);
+      return 1;
+    }
+    for (n = 0; n <= 200; n += 7) {
+      sha256_resume(&ctx, h, blocks);
+      sha256_update(&ctx, data + blocks * 64, n);
+      sha256_final(&ctx, x);
+      sha256(y, data, blocks * 64 + n);
+      if (memcmp(x, y, 32)) {
+        fprintf(stderr, "sha256_resume() failed after %d blocks with %d bytes\n", blocks, n);
+        return 1;
+      }
+    }
+  }
+
+  /* No midstate within a block, and the largest numbers of blocks */
+  sha256_init(&ctx);
+  sha256_update(&ctx, data, 65);
+  if (sha256_midstate(&ctx, h) != -1) {
+    fputs("sha256_midstate() failed with a partial block\n", stderr);
+    return 1;
+  }
+  sha256_resume(&ctx, h, 0x7fffffff);
+  if (sha256_midstate(&ctx, g) != 0x7fffffff || memcmp(h, g, sizeof(h))) {
+    fputs("sha256_midstate() failed with 2^31 - 1 blocks\n", stderr);
+    return 1;
+  }
+  ctx.length[0] = 0;
+  ctx.length[1] = 32;  /* 2^31 blocks */
+  if (sha256_midstate(&ctx, g) != -1) {
+    fputs("sha256_midstate() failed with 2^31 blocks\n", stderr);
+    return 1;
+  }
+
+  return 0;
+}
@@ -12,7 +12,7 @@
 #include <string.h>
 
 /*
- * Tests the sha256 function with the SHA-256 values in
+ * Tests the sha256 functions with the SHA-256 values in
  * http://csrc.nist.gov/groups/ST/toolkit/documents/Examples/SHA_All.pdf
  */
 int main(int argc, char **argv) {
@@ -41,5 +41,46 @@ int main(int argc, char **argv) {
     }
   }
 
+  /* Incremental computation, one byte at a time */
+  for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+    struct sha256_context ctx;
+    unsigned j;
+
+    sha256_init(&ctx);
+    for (j = 0; j < strlen(vectors[i].message); j++) {
+      sha256_update(&ctx, vectors[i].message + j, 1);
+    }
+    sha256_final(&ctx, x);
+    if (memcmp(x, vectors[i].digest, 32)) {
+      fprintf(stderr, "sha256_update() failed for test vector %u\n", i);
+      return 1;
+    }
+  }
+
+  /* Incremental computation of one million 'a' in chunks of varying size */
+  {
+    const unsigned char digest[32] = {
+      0xcd,0xc7,0x6e,0x5c,0x99,0x14,0xfb,0x92,0x81,0xa1,0xc7,0xe2,0x84,0xd7,0x3e,0x67,
+      0xf1,0x80,0x9a,0x48,0xa4,0x97,0x20,0x0e,0x04,0x6d,0x39,0xcc,0xc7,0x11,0x2c,0xd0
+    };
+    struct sha256_context ctx;
+    char a[1000];
+    int n, total;
+
+    memset(a, 'a', sizeof(a));
+    sha256_init(&ctx);
+    for (total = 0, n = 1; total < 1000000; total += n, n = n % 991 + 7) {
+      if (n > 1000000 - total) {
+        n = 1000000 - total;
+      }
+      sha256_update(&ctx, a, n);
+    }
+    sha256_final(&ctx, x);
+    if (memcmp(x, digest, 32)) {
+      fputs("sha256_update() failed for one million 'a'\n", stderr);
+      return 1;
+    }
+  }
+
   return 0;
 }
@@ -0,0 +1,196 @@
+/*
+ * tests/sha512.c: tests for ../sha512.h
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/tests/sha512.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+#include "../sha512.h"
+#include "../sha512-mb.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Computes the digest of a variant (0 SHA-512, 1 SHA-384, 2 SHA-512/256) in parts of n bytes */
+static int digest_in_parts(unsigned char *digest, int variant, const void *message, int length, int n) {
+  struct sha512_context ctx;
+  int i;
+
+  if (variant == 0) {
+    sha512_init(&ctx);
+  } else if (variant == 1) {
+    sha384_init(&ctx);
+  } else {
+    sha512_256_init(&ctx);
+  }
+  for (i = 0; i < length; i += n) {
+    sha512_update(&ctx, (const char *)message + i, length - i < n ? length - i : n);
+  }
+  if (variant == 0) {
+    sha512_final(&ctx, digest);
+    return 64;
+  } else if (variant == 1) {
+    sha384_final(&ctx, digest);
+    return 48;
+  }
+  sha512_256_final(&ctx, digest);
+  return 32;
+}
+
+/*
+ * Tests the sha512 functions with the SHA-512, SHA-384 and SHA-512/256
+ * values in http://csrc.nist.gov/groups/ST/toolkit/documents/Examples/SHA_All.pdf
+ * (and the one million 'a' checked with the OpenSSL command-line tool),
+ * and the portable compression function against the one in use and
+ * against the multi-buffer one (../sha512-mb.h).
+ */
+int main(int argc, char **argv) {
+  const struct {
+    int variant;
+    const char *message;
+    unsigned char digest[64];
+  } vectors[] = {
+    { /* SHA-512, One block message sample */
+      0, "abc",
+      {0xdd,0xaf,0x35,0xa1,0x93,0x61,0x7a,0xba,0xcc,0x41,0x73,0x49,0xae,0x20,0x41,0x31,
+       0x12,0xe6,0xfa,0x4e,0x89,0xa9,0x7e,0xa2,0x0a,0x9e,0xee,0xe6,0x4b,0x55,0xd3,0x9a,
+       0x21,0x92,0x99,0x2a,0x27,0x4f,0xc1,0xa8,0x36,0xba,0x3c,0x23,0xa3,0xfe,0xeb,0xbd,
+       0x45,0x4d,0x44,0x23,0x64,0x3c,0xe8,0x0e,0x2a,0x9a,0xc9,0x4f,0xa5,0x4c,0xa4,0x9f}
+    },{ /* SHA-384, One block message sample */
+      1, "abc",
+      {0xcb,0x00,0x75,0x3f,0x45,0xa3,0x5e,0x8b,0xb5,0xa0,0x3d,0x69,0x9a,0xc6,0x50,0x07,
+       0x27,0x2c,0x32,0xab,0x0e,0xde,0xd1,0x63,0x1a,0x8b,0x60,0x5a,0x43,0xff,0x5b,0xed,
+       0x80,0x86,0x07,0x2b,0xa1,0xe7,0xcc,0x23,0x58,0xba,0xec,0xa1,0x34,0xc8,0x25,0xa7}
+    },{ /* SHA-512/256, One block message sample */
+      2, "abc",
+      {0x53,0x04,0x8e,0x26,0x81,0x94,0x1e,0xf9,0x9b,0x2e,0x29,0xb7,0x6b,0x4c,0x7d,0xab,
+       0xe4,0xc2,0xd0,0xc6,0x34,0xfc,0x6d,0x46,0xe0,0xe2,0xf1,0x31,0x07,0xe7,0xaf,0x23}
+    },{ /* SHA-512, Two block message sample */
+      0, "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+      "hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+      {0x8e,0x95,0x9b,0x75,0xda,0xe3,0x13,0xda,0x8c,0xf4,0xf7,0x28,0x14,0xfc,0x14,0x3f,
+       0x8f,0x77,0x79,0xc6,0xeb,0x9f,0x7f,0xa1,0x72,0x99,0xae,0xad,0xb6,0x88,0x90,0x18,
+       0x50,0x1d,0x28,0x9e,0x49,0x00,0xf7,0xe4,0x33,0x1b,0x99,0xde,0xc4,0xb5,0x43,0x3a,
+       0xc7,0xd3,0x29,0xee,0xb6,0xdd,0x26,0x54,0x5e,0x96,0xe5,0x5b,0x87,0x4b,0xe9,0x09}
+    },{ /* SHA-384, Two block message sample */
+      1, "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+      "hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+      {0x09,0x33,0x0c,0x33,0xf7,0x11,0x47,0xe8,0x3d,0x19,0x2f,0xc7,0x82,0xcd,0x1b,0x47,
+       0x53,0x11,0x1b,0x17,0x3b,0x3b,0x05,0xd2,0x2f,0xa0,0x80,0x86,0xe3,0xb0,0xf7,0x12,
+       0xfc,0xc7,0xc7,0x1a,0x55,0x7e,0x2d,0xb9,0x66,0xc3,0xe9,0xfa,0x91,0x74,0x60,0x39}
+    },{ /* SHA-512/256, Two block message sample */
+      2, "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+      "hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+      {0x39,0x28,0xe1,0x84,0xfb,0x86,0x90,0xf8,0x40,0xda,0x39,0x88,0x12,0x1d,0x31,0xbe,
+       0x65,0xcb,0x9d,0x3e,0xf8,0x3e,0xe6,0x14,0x6f,0xea,0xc8,0x61,0xe1,0x9b,0x56,0x3a}
+    }
+  };
+  const unsigned char million[3][64] = {
+    {0xe7,0x18,0x48,0x3d,0x0c,0xe7,0x69,0x64,0x4e,0x2e,0x42,0xc7,0xbc,0x15,0xb4,0x63,
+     0x8e,0x1f,0x98,0xb1,0x3b,0x20,0x44,0x28,0x56,0x32,0xa8,0x03,0xaf,0xa9,0x73,0xeb,
+     0xde,0x0f,0xf2,0x44,0x87,0x7e,0xa6,0x0a,0x4c,0xb0,0x43,0x2c,0xe5,0x77,0xc3,0x1b,
+     0xeb,0x00,0x9c,0x5c,0x2c,0x49,0xaa,0x2e,0x4e,0xad,0xb2,0x17,0xad,0x8c,0xc0,0x9b},
+    {0x9d,0x0e,0x18,0x09,0x71,0x64,0x74,0xcb,0x08,0x6e,0x83,0x4e,0x31,0x0a,0x4a,0x1c,
+     0xed,0x14,0x9e,0x9c,0x00,0xf2,0x48,0x52,0x79,0x72,0xce,0xc5,0x70,0x4c,0x2a,0x5b,
+     0x07,0xb8,0xb3,0xdc,0x38,0xec,0xc4,0xeb,0xae,0x97,0xdd,0xd8,0x7f,0x3d,0x89,0x85},
+    {0x9a,0x59,0xa0,0x52,0x93,0x01,0x87,0xa9,0x70,0x38,0xca,0xe6,0x92,0xf3,0x07,0x08,
+     0xaa,0x64,0x91,0x92,0x3e,0xf5,0x19,0x43,0x94,0xdc,0x68,0xd5,0x6c,0x74,0xfb,0x21}
+  };
+  static unsigned char data[10 * 128], a[1000000];
+  unsigned char x[64];
+  unsigned g[16], h[16], h4[16][4];
+  const void *parts[3], *blocks[4];
+  int lengths[3];
+  int i, l, n, size;
+
+  for (i = 0; i < (int)(sizeof(vectors) / sizeof(vectors[0])); i++) {
+    n = (int)strlen(vectors[i].message);
+    if (vectors[i].variant == 0) {
+      sha512(x, vectors[i].message, n);
+      size = 64;
+    } else if (vectors[i].variant == 1) {
+      sha384(x, vectors[i].message, n);
+      size = 48;
+    } else {
+      sha512_256(x, vectors[i].message, n);
+      size = 32;
+    }
+    if (memcmp(x, vectors[i].digest, size)) {
+      fprintf(stderr, "sha512() failed for test vector %d\n", i);
+      return 1;
+    }
+
+    /* Incremental computation, one byte at a time */
+    if (digest_in_parts(x, vectors[i].variant, vectors[i].message, n, 1) != size || memcmp(x, vectors[i].digest, size)) {
+      fprintf(stderr, "sha512_update() failed for test vector %d\n", i);
+      return 1;
+    }
+  }
+
+  /* Incremental computation of one million 'a' in parts of varying sizes */
+  memset(a, 'a', sizeof(a));
+  for (i = 0; i < 3; i++) {
+    size = digest_in_parts(x, i, a, 1000000, 1000 + i * 331);
+    if (memcmp(x, million[i], size)) {
+      fprintf(stderr, "sha512_update() failed for one million 'a' (variant %d)\n", i);
+      return 1;
+    }
+  }
+
+  /* A message in fragments */
+  parts[0] = a;
+  parts[1] = a + 100;
+  parts[2] = a + 300;
+  lengths[0] = 100;
+  lengths[1] = 200;
+  lengths[2] = 1000000 - 300;
+  sha512_v(x, parts, lengths, 3);
+  if (memcmp(x, million[0], 64)) {
+    fputs("sha512_v() failed\n", stderr);
+    return 1;
+  }
+
+  /* The portable compression function against the one in use, on blocks with carries in all the additions */
+  for (i = 0; i < 10 * 128; i++) {
+    data[i] = (unsigned char)(i * 97 + 13 + (i >> 7));
+  }
+  for (i = 0; i < 16; i++) {
+    g[i] = h[i] = 0xfedcba98 - (unsigned)i * 0x13579bdf;
+  }
+  for (n = 1; n <= 4; n++) {
+    sha512_compress_generic(g, data, n);
+    sha512_compress(h, data, n);
+  }
+  if (memcmp(g, h, sizeof(g))) {
+    fputs("sha512_compress_generic() differs from sha512_compress()\n", stderr);
+    return 1;
+  }
+
+  /* 4 lanes, with all the combinations of idle lanes */
+  for (n = 0; n < 16; n++) {
+    for (l = 0; l < 4; l++) {
+      blocks[l] = (n >> l & 1) ? NULL : data + l * 200 + n;
+      for (i = 0; i < 16; i++) {
+        h4[i][l] = 0x01234567 * (unsigned)(i + 1) + (unsigned)(l + n);
+      }
+    }
+    sha512_compress_x4(h4, blocks);
+    for (l = 0; l < 4; l++) {
+      for (i = 0; i < 16; i++) {
+        g[i] = 0x01234567 * (unsigned)(i + 1) + (unsigned)(l + n);
+      }
+      if (blocks[l]) {
+        sha512_compress_generic(g, blocks[l], 1);
+      }
+      for (i = 0; i < 16; i++) {
+        if (h4[i][l] != g[i]) {
+          fprintf(stderr, "sha512_compress_x4() failed for lane %d of %d\n", l, n);
+          return 1;
+        }
+      }
+    }
+  }
+
+  return 0;
+}
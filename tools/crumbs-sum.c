@@ -0,0 +1,652 @@
+/*
+ * tools/crumbs-sum.c: command-line tool to hash and seal files with the headers
+ *
+ * https://github.com/andrebdo/c-crumbs/blob/master/tools/crumbs-sum.c
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to UNLICENSE or http://unlicense.org
+ */
+
+/*
+ * Hashes files with SHA-256 (or SHA-1), printing and checking the same lines
+ * as sha256sum (or sha1sum), and seals files with aes-gcm-stream.h.
+ *
+ * Usage:
+ * crumbs-sum [-1] [-j threads] [-t] [file...]
+ *   prints the SHA-256 (or with -1, SHA-1) checksum of each file
+ *   (or of the standard input, with no file or -), as sha256sum
+ * crumbs-sum [-j threads] [-t] [--strict] -c [list...]
+ *   checks the checksums in the lists (SHA-256 or SHA-1, by their length),
+ *   as sha256sum -c: the improperly formatted lines are counted in a
+ *   warning, and only fail the check if no line of a list is valid
+ *   (or with --strict)
+ * crumbs-sum [-j threads] [-t] -s keyfile file...
+ *   seals each file into file.gcm with a random nonce prefix, in 64 KiB segments
+ * crumbs-sum -d keyfile file.gcm
+ *   opens (verifies and decrypts) a sealed file to the standard output,
+ *   stopping at the first segment that fails the verification
+ * The keyfile has the 16-byte AES key, raw or as 32 hexadecimal digits.
+ *
+ * The files are processed by as many threads as processors (or -j threads),
+ * each file by one thread, with the output in the order of the arguments.
+ * The regular files are mapped into memory with mmap, 64 MiB at a time,
+ * so that files larger than the memory are streamed through the incremental
+ * functions; other files (and the standard input) are read with read.
+ * With -t, the number of bytes and the throughput are printed at the end.
+ *
+ * The names with a backslash or a newline are escaped as by sha256sum: the
+ * line starts with a backslash, and the name has \\, \n (and \r) instead.
+ *
+ * Needs a POSIX system with threads:
+ * gcc -O2 -pthread -o crumbs-sum tools/crumbs-sum.c
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+/* The tool uses only some of the functions of the headers */
+#pragma GCC diagnostic ignored "-Wunused-function"
+
+#include "../aes.h"
+#include "../aes-gcm.h"
+#include "../aes-gcm-stream.h"
+#include "../sha1.h"
+#include "../sha256.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WINDOW (64L << 20)  /* bytes mapped at a time, a multiple of SEGMENT */
+#define SEGMENT 65536  /* bytes of plaintext in each sealed segment */
+
+enum mode { HASH, CHECK, SEAL };
+
+/* A file to process, and its result */
+struct job {
+  const char *name;
+  char expected[65];  /* checksum in a list (CHECK) */
+  char digest[65];  /* hexadecimal checksum */
+  int sha1;  /* SHA-1 instead of SHA-256 */
+  int error;  /* errno */
+  int done;
+};
+
+static enum mode mode = HASH;
+static struct job *jobs;
+static int job_count, next_job, malformed;
+static unsigned char key[16];
+static double total_bytes;  /* a double, to count past 2^32 in ANSI C */
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+
+/* Hashes length bytes with SHA-1 or SHA-256 */
+static void update(void *ctx, int sha1, const void *data, long length) {
+  if (sha1) {
+    sha1_update((struct sha1_context *)ctx, data, (int)length);
+  } else {
+    sha256_update((struct sha256_context *)ctx, data, (int)length);
+  }
+}
+
+/*
+ * Hashes a file (or the standard input for "-") into job->digest.
+ * Returns 0 on success, or an errno value.
+ */
+static int hash_file(struct job *job) {
+  union {
+    struct sha1_context sha1;
+    struct sha256_context sha256;
+  } ctx;
+  unsigned char digest[32], buffer[65536];
+  struct stat st;
+  off_t offset;
+  long n;
+  void *p;
+  int fd, i, error = 0;
+
+  fd = strcmp(job->name, "-") ? open(job->name, O_RDONLY) : 0;
+  if (fd < 0) {
+    return errno;
+  }
+  if (fstat(fd, &st)) {
+    error = errno;
+    if (fd != 0) {
+      close(fd);
+    }
+    return error;
+  }
+  if (job->sha1) {
+    sha1_init(&ctx.sha1);
+  } else {
+    sha256_init(&ctx.sha256);
+  }
+
+  offset = 0;
+  if (S_ISREG(st.st_mode) && st.st_size > 0) {
+    for (; offset < st.st_size; offset += n) {
+      n = st.st_size - offset < WINDOW ? (long)(st.st_size - offset) : WINDOW;
+      p = mmap(NULL, n, PROT_READ, MAP_PRIVATE, fd, offset);
+      if (p == MAP_FAILED) {
+        break;  /* read it instead */
+      }
+      posix_madvise(p, n, POSIX_MADV_SEQUENTIAL);
+      update(&ctx, job->sha1, p, n);
+      munmap(p, n);
+    }
+  }
+  if (offset == 0 || offset < st.st_size) {
+    if (offset > 0 && lseek(fd, offset, SEEK_SET) < 0) {
+      error = errno;
+    }
+    while (!error && (n = read(fd, buffer, sizeof(buffer))) != 0) {
+      if (n < 0) {
+        error = errno == EINTR ? 0 : errno;
+        continue;
+      }
+      update(&ctx, job->sha1, buffer, n);
+      offset += n;
+    }
+  }
+  if (fd != 0) {
+    close(fd);
+  }
+  if (error) {
+    return error;
+  }
+
+  if (job->sha1) {
+    sha1_final(&ctx.sha1, digest);
+  } else {
+    sha256_final(&ctx.sha256, digest);
+  }
+  for (i = 0; i < (job->sha1 ? 20 : 32); i++) {
+    sprintf(job->digest + i * 2, "%02x", digest[i]);
+  }
+  pthread_mutex_lock(&mutex);
+  total_bytes += offset;
+  pthread_mutex_unlock(&mutex);
+  return 0;
+}
+
+/* Writes length bytes, returns 0 on success, or an errno value */
+static int write_all(int fd, const unsigned char *data, long length) {
+  long n;
+
+  for (; length > 0; data += n, length -= n) {
+    n = write(fd, data, length);
+    if (n < 0) {
+      if (errno == EINTR) {
+        n = 0;
+        continue;
+      }
+      return errno;
+    }
+  }
+  return 0;
+}
+
+/*
+ * Seals a regular file into name.gcm with aes_gcm_stream_seal_segment.
+ * Returns 0 on success, or an errno value.
+ */
+static int seal_file(struct job *job) {
+  unsigned char header[AES_GCM_STREAM_HEADER], nonce[7];
+  unsigned char *sealed, *p;
+  struct stat st;
+  off_t offset;
+  long index, n, i, m;
+  char *name;
+  int fd, out, random, error = 0;
+
+  fd = open(job->name, O_RDONLY);
+  if (fd < 0) {
+    return errno;
+  }
+  if (fstat(fd, &st)) {
+    error = errno;
+    close(fd);
+    return error;
+  }
+  if (!S_ISREG(st.st_mode)) {
+    close(fd);
+    return EINVAL;
+  }
+  random = open("/dev/urandom", O_RDONLY);
+  if (random < 0) {
+    error = errno;
+  } else if ((n = read(random, nonce, 7)) != 7) {
+    error = n < 0 ? errno : EIO;  /* errno is not set by a short read */
+  }
+  if (random >= 0) {
+    close(random);
+  }
+  name = (char *)malloc(strlen(job->name) + 5);
+  sealed = (unsigned char *)malloc(WINDOW + WINDOW / SEGMENT * 16);
+  if (!error && (!name || !sealed)) {
+    error = ENOMEM;
+  }
+  out = -1;
+  if (!error) {
+    sprintf(name, "%s.gcm", job->name);
+    out = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (out < 0) {
+      error = errno;
+    }
+  }
+
+  if (!error) {
+    aes_gcm_stream_init(header, SEGMENT, nonce);
+    error = write_all(out, header, AES_GCM_STREAM_HEADER);
+  }
+  for (index = 0, offset = 0; !error && (index == 0 || offset < st.st_size); offset += n) {
+    n = st.st_size - offset < WINDOW ? (long)(st.st_size - offset) : WINDOW;
+    p = n > 0 ? (unsigned char *)mmap(NULL, n, PROT_READ, MAP_PRIVATE, fd, offset) : NULL;
+    if (p == MAP_FAILED) {
+      error = errno;
+      break;
+    }
+    if (n > 0) {
+      posix_madvise(p, n, POSIX_MADV_SEQUENTIAL);
+    }
+    for (i = 0, m = 0; i == 0 || i < n; i += SEGMENT, index++) {
+      m = n - i < SEGMENT ? n - i : SEGMENT;
+      aes_gcm_stream_seal_segment(sealed + i + i / SEGMENT * 16, header, (int)index,
+                                  offset + i + m == st.st_size, p + i, (int)m, key);
+    }
+    if (n > 0) {
+      munmap(p, n);
+    }
+    error = write_all(out, sealed, n + (n > 0 ? (n - 1) / SEGMENT + 1 : 1) * 16);
+  }
+  if (out >= 0 && close(out) && !error) {
+    error = errno;
+  }
+  if (error && out >= 0) {
+    unlink(name);
+  }
+  close(fd);
+  free(name);
+  free(sealed);
+  if (!error) {
+    pthread_mutex_lock(&mutex);
+    total_bytes += st.st_size;
+    pthread_mutex_unlock(&mutex);
+  }
+  return error;
+}
+
+/*
+ * Opens a sealed file to the standard output, one segment at a time.
+ * Returns 0 on success, -1 if a segment fails the verification or the
+ * file is not a sealed file, or an errno value.
+ */
+static int open_file(const char *name) {
+  unsigned char header[AES_GCM_STREAM_HEADER];
+  unsigned char *segment;
+  off_t size, segments, index, offset;
+  long segment_size, n, r;
+  struct stat st;
+  int fd, error = 0;
+
+  fd = open(name, O_RDONLY);
+  if (fd < 0) {
+    return errno;
+  }
+  if (fstat(fd, &st)) {
+    error = errno;
+    close(fd);
+    return error;
+  }
+  size = st.st_size - AES_GCM_STREAM_HEADER;
+  if (pread(fd, header, AES_GCM_STREAM_HEADER, 0) != AES_GCM_STREAM_HEADER ||
+      aes_gcm_stream_length(header, AES_GCM_STREAM_HEADER + 16) < 0 || size < 16) {
+    close(fd);
+    return -1;
+  }
+  segment_size = aes_gcm_stream_segment_size(header);
+  segments = (size - 1) / (segment_size + 16) + 1;
+  if (size - (segments - 1) * (segment_size + 16) < 16) {
+    close(fd);
+    return -1;
+  }
+  segment = (unsigned char *)malloc(segment_size + 16);
+  if (!segment) {
+    close(fd);
+    return ENOMEM;
+  }
+  for (index = 0; !error && index < segments; index++) {
+    offset = AES_GCM_STREAM_HEADER + index * (segment_size + 16);
+    n = index < segments - 1 ? segment_size + 16 : (long)(st.st_size - offset);
+    if ((r = pread(fd, segment, n, offset)) != n) {
+      error = r < 0 ? errno : EIO;  /* errno is not set by a short read */
+    } else if (aes_gcm_stream_open_segment(segment, header, (int)index, index == segments - 1, segment, (int)n, key)) {
+      error = -1;
+    } else {
+      error = write_all(1, segment, n - 16);
+      total_bytes += n - 16;
+    }
+  }
+  free(segment);
+  close(fd);
+  return error;
+}
+
+/* Takes the next job, until there are no more */
+static void *worker(void *arg) {
+  struct job *job;
+  int error;
+
+  for (;;) {
+    pthread_mutex_lock(&mutex);
+    job = next_job < job_count ? &jobs[next_job++] : NULL;
+    pthread_mutex_unlock(&mutex);
+    if (!job) {
+      return arg;
+    }
+    error = mode == SEAL ? seal_file(job) : hash_file(job);
+    pthread_mutex_lock(&mutex);
+    job->error = error;
+    job->done = 1;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&mutex);
+  }
+}
+
+/*
+ * Returns nonzero if a name is escaped, as by sha256sum: in the checksum
+ * lines if it has a backslash or a newline, in the check results if it has
+ * a newline.
+ */
+static int escaped(const char *name, int check) {
+  return name[strcspn(name, check ? "\n\r" : "\\\n\r")] != 0;
+}
+
+/* Prints a name with \\, \n and \r instead of a backslash, a newline and a carriage return */
+static void print_name(const char *name) {
+  for (; *name; name++) {
+    if (*name == '\\') {
+      fputs("\\\\", stdout);
+    } else if (*name == '\n') {
+      fputs("\\n", stdout);
+    } else if (*name == '\r') {
+      fputs("\\r", stdout);
+    } else {
+      putchar(*name);
+    }
+  }
+}
+
+/* Undoes print_name in place, returns 0 on success or -1 for an invalid escape */
+static int unescape(char *name) {
+  char *p = name;
+
+  for (; *name; name++) {
+    if (*name != '\\') {
+      *p++ = *name;
+    } else if (name[1] == '\\' || name[1] == 'n' || name[1] == 'r') {
+      name++;
+      *p++ = *name == '\\' ? '\\' : *name == 'n' ? '\n' : '\r';
+    } else {
+      return -1;
+    }
+  }
+  *p = 0;
+  return 0;
+}
+
+/*
+ * Adds the jobs of the lines of a checksum list ("checksum  name" or
+ * "checksum *name", after a backslash if the name is escaped), skipping the
+ * comments, and counts the improperly formatted lines in malformed.
+ * Returns 0 on success, or -1 if the list cannot be read or has no valid line.
+ */
+static int read_list(const char *list) {
+  static char line[4096 + 70];
+  struct job *job;
+  FILE *f;
+  char *p;
+  size_t n;
+  int valid = 0, invalid = 0, escape;
+
+  f = strcmp(list, "-") ? fopen(list, "r") : stdin;
+  if (!f) {
+    fprintf(stderr, "crumbs-sum: %s: %s\n", list, strerror(errno));
+    return -1;
+  }
+  while (fgets(line, sizeof(line), f)) {
+    n = strlen(line);
+    while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) {
+      line[--n] = 0;
+    }
+    if (line[0] == '#') {
+      continue;
+    }
+    escape = line[0] == '\\';
+    p = line + escape;
+    n = strspn(p, "0123456789abcdefABCDEF");
+    if ((n != 40 && n != 64) || p[n] != ' ' || (p[n + 1] != ' ' && p[n + 1] != '*') || !p[n + 2] ||
+        (escape && unescape(p + n + 2))) {
+      invalid++;
+      continue;
+    }
+    job = (struct job *)realloc(jobs, (job_count + 1) * sizeof(*jobs));
+    if (!job) {
+      fputs("crumbs-sum: out of memory\n", stderr);
+      exit(2);
+    }
+    jobs = job;
+    job += job_count++;
+    memset(job, 0, sizeof(*job));
+    memcpy(job->expected, p, n);
+    job->sha1 = n == 40;
+    job->name = strdup(p + n + 2);
+    if (!job->name) {
+      fputs("crumbs-sum: out of memory\n", stderr);
+      exit(2);
+    }
+    valid++;
+  }
+  if (f != stdin) {
+    fclose(f);
+  }
+  if (!valid) {
+    fprintf(stderr, "crumbs-sum: %s: no properly formatted checksum lines found\n", list);
+    return -1;
+  }
+  malformed += invalid;
+  return 0;
+}
+
+/* Reads the key, raw or in hexadecimal, returns 0 on success or -1 */
+static int read_key(const char *keyfile) {
+  unsigned char data[34];
+  unsigned x;
+  int fd, n, i;
+
+  fd = open(keyfile, O_RDONLY);
+  n = fd < 0 ? -1 : (int)read(fd, data, sizeof(data));
+  if (fd >= 0) {
+    close(fd);
+  }
+  if (n == 16) {
+    memcpy(key, data, 16);
+    return 0;
+  }
+  if (n >= 32 && n <= 34 && strspn((const char *)data, "0123456789abcdefABCDEF") >= 32) {
+    for (i = 0; i < 16; i++) {
+      sscanf((const char *)data + i * 2, "%2x", &x);
+      key[i] = (unsigned char)x;
+    }
+    return 0;
+  }
+  fprintf(stderr, "crumbs-sum: %s: not a 16-byte or 32-hex-digit key\n", keyfile);
+  return -1;
+}
+
+static double now(void) {
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+  static const char *stdin_name = "-";
+  pthread_t *threads;
+  const char *keyfile = NULL, *open_name = NULL;
+  int threads_count, started, sha1 = 0, timing = 0, strict = 0, failed = 0, mismatched = 0;
+  int i, c, error;
+  double start;
+
+  threads_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  for (i = c = 1; i < argc; i++) {  /* take out --strict, as getopt has no long options */
+    if (!strcmp(argv[i], "--")) {
+      break;
+    }
+    if (!strcmp(argv[i], "--strict")) {
+      strict = 1;
+    } else {
+      argv[c++] = argv[i];
+    }
+  }
+  for (; i < argc; i++) {
+    argv[c++] = argv[i];
+  }
+  argc = c;
+  argv[argc] = NULL;
+  while ((c = getopt(argc, argv, "1cd:j:s:t")) != -1) {
+    switch (c) {
+    case '1': sha1 = 1; break;
+    case 'c': mode = CHECK; break;
+    case 'd': open_name = optarg; keyfile = optarg; break;
+    case 'j': threads_count = atoi(optarg); break;
+    case 's': mode = SEAL; keyfile = optarg; break;
+    case 't': timing = 1; break;
+    default:
+      fputs("usage: crumbs-sum [-1] [-j threads] [-t] [--strict] [-c] [file...]\n"
+            "       crumbs-sum [-j threads] [-t] -s keyfile file...\n"
+            "       crumbs-sum -d keyfile file.gcm\n", stderr);
+      return 2;
+    }
+  }
+  if (threads_count < 1) {
+    threads_count = 1;
+  }
+  start = now();
+
+  if (keyfile && read_key(keyfile)) {
+    return 2;
+  }
+  if (open_name) {
+    if (optind + 1 != argc) {
+      fputs("crumbs-sum: -d takes one sealed file\n", stderr);
+      return 2;
+    }
+    error = open_file(argv[optind]);
+    if (error) {
+      fprintf(stderr, "crumbs-sum: %s: %s\n", argv[optind], error < 0 ? "verification failed" : strerror(error));
+      return 1;
+    }
+  } else {
+    /* The jobs: the files, or the lines of the lists */
+    if (mode == CHECK) {
+      for (i = optind; i < argc || i == optind; i++) {
+        if (read_list(i < argc ? argv[i] : stdin_name)) {
+          failed = 1;
+        }
+      }
+    } else {
+      job_count = optind < argc ? argc - optind : 1;
+      jobs = (struct job *)calloc(job_count, sizeof(*jobs));
+      if (!jobs) {
+        return 2;
+      }
+      for (i = 0; i < job_count; i++) {
+        jobs[i].name = optind < argc ? argv[optind + i] : stdin_name;
+        jobs[i].sha1 = sha1;
+      }
+    }
+
+    threads = (pthread_t *)malloc(threads_count * sizeof(*threads));
+    if (!threads) {
+      return 2;
+    }
+    for (started = 0; started < threads_count; started++) {
+      if (pthread_create(&threads[started], NULL, worker, NULL)) {
+        break;
+      }
+    }
+    if (started == 0) {
+      worker(NULL);  /* all the jobs on this thread */
+    }
+
+    /* Print the results in order, as they are done */
+    for (i = 0; i < job_count; i++) {
+      pthread_mutex_lock(&mutex);
+      while (!jobs[i].done) {
+        pthread_cond_wait(&cond, &mutex);
+      }
+      pthread_mutex_unlock(&mutex);
+      if (jobs[i].error) {
+        fprintf(stderr, "crumbs-sum: %s: %s\n", jobs[i].name, strerror(jobs[i].error));
+        failed = 1;
+        if (mode == CHECK) {
+          if (escaped(jobs[i].name, 1)) {
+            putchar('\\');
+            print_name(jobs[i].name);
+          } else {
+            fputs(jobs[i].name, stdout);
+          }
+          puts(": FAILED open or read");
+        }
+      } else if (mode == CHECK) {
+        c = strlen(jobs[i].expected);
+        for (error = 0; error < c; error++) {
+          jobs[i].expected[error] = jobs[i].expected[error] | 0x20;  /* lower case */
+        }
+        if (escaped(jobs[i].name, 1)) {
+          putchar('\\');
+          print_name(jobs[i].name);
+        } else {
+          fputs(jobs[i].name, stdout);
+        }
+        if (strcmp(jobs[i].expected, jobs[i].digest)) {
+          puts(": FAILED");
+          mismatched++;
+        } else {
+          puts(": OK");
+        }
+      } else if (mode == HASH) {
+        printf("%s%s  ", escaped(jobs[i].name, 0) ? "\\" : "", jobs[i].digest);
+        print_name(jobs[i].name);
+        putchar('\n');
+      }
+    }
+    for (i = 0; i < started; i++) {
+      pthread_join(threads[i], NULL);
+    }
+    fflush(stdout);  /* the results before the warnings */
+    if (malformed) {
+      fprintf(stderr, "crumbs-sum: WARNING: %d line%s improperly formatted\n", malformed, malformed > 1 ? "s are" : " is");
+      if (strict) {
+        failed = 1;
+      }
+    }
+    if (mismatched) {
+      fprintf(stderr, "crumbs-sum: WARNING: %d computed checksum%s did NOT match\n", mismatched, mismatched > 1 ? "s" : "");
+    }
+  }
+
+  if (timing) {
+    start = now() - start;
+    fprintf(stderr, "crumbs-sum: %.0f bytes in %.3f s, %.1f MB/s\n", total_bytes, start,
+            start > 0 ? total_bytes / start / 1e6 : 0.0);
+  }
+  return failed || mismatched;
+}